@@ -0,0 +1,354 @@
+// Cost of the image-editing entry points at every OV2640 frame size from QQVGA to UXGA, per source
+// format: the gray conversions, cropCenter, resizeRgbNearestNeighbor, JPEG decoding (the former
+// per-frame allocating decode, JpegDecoderContext and the 1:8 luma thumbnail) and buildGray96Frame in
+// the configured INFERENCE_INPUT_MODE. Frames are the esp32-camera outdoor sample picture resampled to
+// each size, with a little sensor noise, and JPEG-encoded with esp32-camera's jpge at 4:2:2 like the
+// sensor's own output. Pass frame size names (e.g. VGA UXGA) to run only those.
+#include "bench-json.h"
+#include "host-heap.h"
+#include "test-pictures.h"
+#include "define.h"
+#include "image-editing/editing.h"
+#include "image-editing/jpeg-decoder-context.h"
+#include "image-editing/pixel-kernels.h"
+#include "jpeg_decoder.h"
+#include "jpge.h"
+#include "esp_heap_caps.h"
+#include <algorithm>
+#include <cstring>
+#include <random>
+#include <vector>
+
+namespace {
+
+constexpr int kModelSide = 96;
+constexpr int kJpegQuality = 80;
+
+struct FrameSize {
+    const char* name;
+    int width;
+    int height;
+};
+
+const FrameSize kSizes[] = {
+    { "QQVGA", 160, 120 },  { "QVGA", 320, 240 },  { "CIF", 400, 296 },
+    { "VGA", 640, 480 },    { "SVGA", 800, 600 },  { "XGA", 1024, 768 },
+    { "HD", 1280, 720 },    { "SXGA", 1280, 1024 }, { "UXGA", 1600, 1200 },
+};
+
+struct RgbImage {
+    std::vector<uint8_t> pixels;
+    int width = 0;
+    int height = 0;
+};
+
+// One frame in every format capture_task can deliver.
+struct Frames {
+    std::vector<uint8_t> rgb888;
+    std::vector<uint16_t> rgb565;
+    std::vector<uint8_t> gray;
+    std::vector<uint8_t> jpeg;
+    int width = 0;
+    int height = 0;
+};
+
+RgbImage decodeScene()
+{
+    const std::vector<uint8_t> jpeg = loadTestPicture("test_outside.jpeg");
+    RgbImage scene;
+    if (jpeg.empty()) {
+        return scene;
+    }
+    JpegDecoderContext decoder(PlacedBuffer::JpegDecoder);
+    JpegDecodedImage image;
+    if (decoder.decode(jpeg.data(), jpeg.size(), JPEG_IMAGE_FORMAT_RGB888, JPEG_IMAGE_SCALE_0, &image) != ESP_OK) {
+        return scene;
+    }
+    scene.pixels.assign(image.data, image.data + image.len);
+    scene.width = image.width;
+    scene.height = image.height;
+    return scene;
+}
+
+// Bilinear resample of the scene to width x height plus +/-3 levels of noise, so larger frames are not
+// smoother (and more compressible) than a sensor's.
+RgbImage resampleScene(const RgbImage& scene, int width, int height, std::mt19937& rng)
+{
+    RgbImage out;
+    out.width = width;
+    out.height = height;
+    out.pixels.resize((size_t)width * height * 3);
+    std::uniform_int_distribution<int> noise(-3, 3);
+    for (int y = 0; y < height; y++) {
+        const float sy = std::clamp((y + 0.5f) * scene.height / height - 0.5f, 0.0f, (float)(scene.height - 1));
+        const int y0 = (int)sy;
+        const int y1 = std::min(y0 + 1, scene.height - 1);
+        const float fy = sy - y0;
+        for (int x = 0; x < width; x++) {
+            const float sx = std::clamp((x + 0.5f) * scene.width / width - 0.5f, 0.0f, (float)(scene.width - 1));
+            const int x0 = (int)sx;
+            const int x1 = std::min(x0 + 1, scene.width - 1);
+            const float fx = sx - x0;
+            for (int c = 0; c < 3; c++) {
+                auto at = [&](int px, int py) { return (float)scene.pixels[((size_t)py * scene.width + px) * 3 + c]; };
+                const float value = (at(x0, y0) * (1 - fx) + at(x1, y0) * fx) * (1 - fy) +
+                                    (at(x0, y1) * (1 - fx) + at(x1, y1) * fx) * fy;
+                out.pixels[((size_t)y * width + x) * 3 + c] = (uint8_t)std::clamp((int)(value + 0.5f) + noise(rng), 0, 255);
+            }
+        }
+    }
+    return out;
+}
+
+class VectorStream : public jpge::output_stream
+{
+public:
+    explicit VectorStream(std::vector<uint8_t>* out) : out_(out) {}
+
+    bool put_buf(const void* data, int len) override
+    {
+        if (data) {
+            out_->insert(out_->end(), (const uint8_t*)data, (const uint8_t*)data + len);
+        }
+        return true;
+    }
+
+    uint get_size() const override { return (uint)out_->size(); }
+
+private:
+    std::vector<uint8_t>* out_;
+};
+
+bool encodeJpeg(const RgbImage& image, std::vector<uint8_t>* jpeg)
+{
+    jpge::params params;
+    params.m_quality = kJpegQuality;
+    params.m_subsampling = jpge::H2V1;
+    VectorStream stream(jpeg);
+    jpge::jpeg_encoder encoder;
+    if (!encoder.init(&stream, image.width, image.height, 3, params)) {
+        return false;
+    }
+    for (int y = 0; y < image.height; y++) {
+        if (!encoder.process_scanline(image.pixels.data() + (size_t)y * image.width * 3)) {
+            return false;
+        }
+    }
+    const bool ok = encoder.process_scanline(nullptr);
+    encoder.deinit();
+    return ok;
+}
+
+bool makeFrames(const RgbImage& scene, const FrameSize& size, std::mt19937& rng, Frames* frames)
+{
+    const RgbImage image = resampleScene(scene, size.width, size.height, rng);
+    const size_t pixels = (size_t)size.width * size.height;
+    frames->width = size.width;
+    frames->height = size.height;
+    frames->rgb888 = image.pixels;
+    frames->rgb565.resize(pixels);
+    frames->gray.resize(pixels);
+    for (size_t i = 0; i < pixels; i++) {
+        const uint8_t* px = &image.pixels[i * 3];
+        frames->rgb565[i] = (uint16_t)(((px[0] >> 3) << 11) | ((px[1] >> 2) << 5) | (px[2] >> 3));
+    }
+    referenceRgb565ToGray(frames->rgb565.data(), frames->gray.data(), pixels);
+    frames->jpeg.clear();
+    return encodeJpeg(image, &frames->jpeg);
+}
+
+// The per-frame decode JpegDecoderContext replaced (allocatingDecodeCameraJpeg): heap output buffer and
+// esp_jpeg's own work area on every call. The component tjpgd built here needs a larger work area than
+// the ROM one, so it is allocated the same way instead of by esp_jpeg_decode().
+bool allocatingDecode(const Frames& frames)
+{
+    const size_t outLen = (size_t)frames.width * frames.height * 2;
+    uint8_t* out = (uint8_t*)heap_caps_malloc(outLen, MALLOC_CAP_SPIRAM);
+    uint8_t* work = (uint8_t*)heap_caps_malloc(kJpegGrayCropPoolBytes, MALLOC_CAP_DEFAULT);
+    bool ok = out && work;
+    if (ok) {
+        esp_jpeg_image_cfg_t cfg = {};
+        cfg.indata = (uint8_t*)frames.jpeg.data();
+        cfg.indata_size = frames.jpeg.size();
+        cfg.outbuf = out;
+        cfg.outbuf_size = outLen;
+        cfg.out_format = JPEG_IMAGE_FORMAT_RGB565;
+        cfg.out_scale = JPEG_IMAGE_SCALE_0;
+        cfg.advanced.working_buffer = work;
+        cfg.advanced.working_buffer_size = kJpegGrayCropPoolBytes;
+        esp_jpeg_image_output_t image = {};
+        ok = esp_jpeg_decode(&cfg, &image) == ESP_OK;
+        benchKeep(out[0]);
+    }
+    heap_caps_free(work);
+    heap_caps_free(out);
+    return ok;
+}
+
+FrameSnapshot snapshotOf(const uint8_t* data, size_t len, const Frames& frames, pixformat_t format)
+{
+    FrameSnapshot snapshot;
+    snapshot.data = data;
+    snapshot.len = len;
+    snapshot.width = (uint16_t)frames.width;
+    snapshot.height = (uint16_t)frames.height;
+    snapshot.format = format;
+    return snapshot;
+}
+
+const char* inputModeName()
+{
+    switch (INFERENCE_INPUT_MODE) {
+        case INFERENCE_INPUT_CENTER_CROP: return "center_crop";
+        case INFERENCE_INPUT_FULL_VIEW: return "full_view";
+        default: return "tiled";
+    }
+}
+
+class Runner
+{
+public:
+    Runner(BenchJson& json, int64_t minNs) : json_(json), minNs_(minNs) {}
+
+    // Times fn (returning false on failure) on frames of size and writes one result object.
+    template <typename Fn>
+    void run(const FrameSize& size, const char* format, const char* kernel, Fn fn)
+    {
+        bool ok = fn();     // also sizes any lazily grown buffers before allocations are counted
+        const HostHeapStats before = hostHeapStats();
+        ok = fn() && ok;
+        const uint64_t allocations = hostHeapStats().allocations - before.allocations;
+        const double ns = benchTimePerCall([&] { ok = fn() && ok; }, minNs_);
+        failures_ += ok ? 0 : 1;
+
+        json_.beginObject();
+        json_.member("frame", size.name);
+        json_.member("width", size.width);
+        json_.member("height", size.height);
+        json_.member("format", format);
+        json_.member("kernel", kernel);
+        json_.member("ok", ok);
+        json_.member("us_per_call", ns / 1000.0);
+        json_.member("frame_mpix_per_s", (double)size.width * size.height / ns * 1000.0);
+        json_.member("heap_allocations_per_call", allocations);
+        json_.endObject();
+    }
+
+    int failures() const { return failures_; }
+
+private:
+    BenchJson& json_;
+    int64_t minNs_;
+    int failures_ = 0;
+};
+
+bool selected(const FrameSize& size, int argc, char** argv)
+{
+    bool filtered = false;
+    for (int i = 1; i < argc; i++) {
+        if (argv[i][0] == '-') {
+            continue;
+        }
+        filtered = true;
+        if (strcmp(argv[i], size.name) == 0) {
+            return true;
+        }
+    }
+    return !filtered;
+}
+
+} // namespace
+
+int main(int argc, char** argv)
+{
+    const int64_t minNs = benchQuick(argc, argv) ? 0 : 200000000;
+    const RgbImage scene = decodeScene();
+    if (scene.pixels.empty()) {
+        fprintf(stderr, "cannot decode test_outside.jpeg from %s\n", HOST_TEST_PICTURES_DIR);
+        return 1;
+    }
+    std::mt19937 rng(2024);
+    JpegDecoderContext decoder(PlacedBuffer::JpegDecoder);
+
+    BenchJson json;
+    json.beginObject();
+    json.member("benchmark", "image_editing");
+    json.member("kernels", pixelKernelsName());
+    json.member("inference_input_mode", inputModeName());
+    json.member("model_input", kModelSide);
+    json.member("jpeg_quality", kJpegQuality);
+    Runner runner(json, minNs);
+    json.key("results").beginArray();
+    for (const FrameSize& size : kSizes) {
+        if (!selected(size, argc, argv)) {
+            continue;
+        }
+        Frames frames;
+        if (!makeFrames(scene, size, rng, &frames)) {
+            fprintf(stderr, "cannot encode the %s frame\n", size.name);
+            return 1;
+        }
+        const size_t pixels = (size_t)frames.width * frames.height;
+        std::vector<uint8_t> gray(pixels);
+        std::vector<uint8_t> rgb(pixels * 3);
+        std::vector<uint8_t> workspace(gray96WorkspaceBytes((uint16_t)frames.width, (uint16_t)frames.height));
+        std::vector<uint8_t> thumbnail(pixels / 64 + 1);
+        uint8_t model[kModelSide * kModelSide * 3];
+
+        runner.run(size, "rgb565", "convert_rgb565_to_gray", [&] {
+            convertRgb565ToGrayscale(frames.rgb565.data(), gray.data(), frames.width, frames.height);
+            benchKeep(gray[0]);
+            return true;
+        });
+        runner.run(size, "rgb888", "convert_rgb888_to_gray", [&] {
+            convertRgb888ToGrayscale(frames.rgb888.data(), gray.data(), frames.width, frames.height);
+            benchKeep(gray[0]);
+            return true;
+        });
+        runner.run(size, "gray", "convert_gray_to_rgb888", [&] {
+            convertGrayscaleToRgb888(frames.gray.data(), rgb.data(), frames.width, frames.height);
+            benchKeep(rgb[0]);
+            return true;
+        });
+        runner.run(size, "gray", "crop_center_96", [&] {
+            return cropCenter(frames.gray.data(), frames.width, frames.height, model, kModelSide, kModelSide, 1);
+        });
+        runner.run(size, "rgb888", "crop_center_96", [&] {
+            return cropCenter(frames.rgb888.data(), frames.width, frames.height, model, kModelSide, kModelSide, 3);
+        });
+        runner.run(size, "rgb888", "resize_rgb_nearest_96", [&] {
+            resizeRgbNearestNeighbor(frames.rgb888.data(), frames.width, frames.height, model, kModelSide, kModelSide);
+            benchKeep(model[0]);
+            return true;
+        });
+        runner.run(size, "jpeg", "decode_rgb565_allocating", [&] { return allocatingDecode(frames); });
+        runner.run(size, "jpeg", "decode_rgb565_context", [&] {
+            JpegDecodedImage image;
+            return decoder.decode(frames.jpeg.data(), frames.jpeg.size(), JPEG_IMAGE_FORMAT_RGB565, JPEG_IMAGE_SCALE_0,
+                                  &image) == ESP_OK;
+        });
+        runner.run(size, "jpeg", "luma_thumbnail_1_8", [&] {
+            uint16_t width = 0;
+            uint16_t height = 0;
+            return decodeJpegLumaThumbnail(decoder, frames.jpeg.data(), frames.jpeg.size(), thumbnail.data(),
+                                           thumbnail.size(), &width, &height);
+        });
+
+        const FrameSnapshot snapshots[] = {
+            snapshotOf(frames.gray.data(), pixels, frames, PIXFORMAT_GRAYSCALE),
+            snapshotOf((const uint8_t*)frames.rgb565.data(), pixels * 2, frames, PIXFORMAT_RGB565),
+            snapshotOf(frames.rgb888.data(), pixels * 3, frames, PIXFORMAT_RGB888),
+            snapshotOf(frames.jpeg.data(), frames.jpeg.size(), frames, PIXFORMAT_JPEG),
+        };
+        const char* const formats[] = { "gray", "rgb565", "rgb888", "jpeg" };
+        for (size_t i = 0; i < sizeof(snapshots) / sizeof(snapshots[0]); i++) {
+            runner.run(size, formats[i], "build_gray96_frame", [&] {
+                return buildGray96Frame(snapshots[i], workspace.data(), workspace.size(), model, kModelSide);
+            });
+        }
+    }
+    json.endArray();
+    json.endObject();
+    json.finish();
+    return runner.failures() == 0 ? 0 : 1;
+}
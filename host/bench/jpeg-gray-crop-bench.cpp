@@ -0,0 +1,147 @@
+// Per-frame latency and peak memory of the fused JPEG -> 96x96 luma crop (decodeJpegGrayCenterCrop)
+// against the path it replaced: allocatingDecodeCameraJpeg() decoding the whole frame to RGB565 in a
+// heap buffer, a full-frame gray conversion into the caller's workspace, then cropCenter(). Both run on
+// the esp32-camera sample JPEGs; the outputs are compared byte for byte.
+#include "bench-json.h"
+#include "host-heap.h"
+#include "test-pictures.h"
+#include "image-editing/editing.h"
+#include "image-editing/jpeg-gray-crop.h"
+#include "image-editing/pixel-kernels.h"
+#include "jpeg_decoder.h"
+#include "esp_heap_caps.h"
+#include <cstring>
+#include <vector>
+
+namespace {
+
+constexpr int kModelSide = 96;
+const char* const kPictures[] = { "test_inside.jpeg", "test_outside.jpeg", "testimg.jpeg" };
+
+// The former allocatingDecodeCameraJpeg() + PIXFORMAT_JPEG branch of buildGray96Frame(). On the device
+// esp_jpeg_decode() heap-allocates the 3100-byte ROM tjpgd work area per call; the component tjpgd
+// built here needs more, so the work area is allocated the same way at kJpegGrayCropPoolBytes.
+bool legacyGray96(const std::vector<uint8_t>& jpeg, uint16_t width, uint16_t height, uint8_t* workspace, uint8_t* gray96)
+{
+    const size_t rgb565Len = (size_t)width * height * 2;
+    uint8_t* rgb565 = (uint8_t*)heap_caps_malloc(rgb565Len, MALLOC_CAP_SPIRAM);
+    uint8_t* workArea = (uint8_t*)heap_caps_malloc(kJpegGrayCropPoolBytes, MALLOC_CAP_DEFAULT);
+    if (!rgb565 || !workArea) {
+        heap_caps_free(rgb565);
+        heap_caps_free(workArea);
+        return false;
+    }
+    esp_jpeg_image_cfg_t cfg = {};
+    cfg.indata = (uint8_t*)jpeg.data();
+    cfg.indata_size = jpeg.size();
+    cfg.outbuf = rgb565;
+    cfg.outbuf_size = rgb565Len;
+    cfg.out_format = JPEG_IMAGE_FORMAT_RGB565;
+    cfg.out_scale = JPEG_IMAGE_SCALE_0;
+    cfg.advanced.working_buffer = workArea;
+    cfg.advanced.working_buffer_size = kJpegGrayCropPoolBytes;
+    esp_jpeg_image_output_t out = {};
+    const bool decoded = esp_jpeg_decode(&cfg, &out) == ESP_OK;
+    heap_caps_free(workArea);
+    if (decoded) {
+        referenceRgb565ToGray((const uint16_t*)rgb565, workspace, (size_t)width * height);
+    }
+    const bool ok = decoded && cropCenter(workspace, width, height, gray96, kModelSide, kModelSide, 1);
+    heap_caps_free(rgb565);
+    return ok;
+}
+
+struct PathResult {
+    bool ok = true;
+    double usPerFrame = 0.0;
+    size_t heapPeakBytes = 0;       // heap_caps high-water mark above the baseline during the runs
+    uint64_t heapAllocations = 0;   // per frame
+};
+
+template <typename Fn>
+PathResult measure(Fn decode, uint32_t frames)
+{
+    PathResult result;
+    result.ok = decode();   // warm-up, not timed
+    hostHeapResetPeak();
+    const HostHeapStats before = hostHeapStats();
+    const int64_t startNs = benchNowNs();
+    for (uint32_t i = 0; i < frames && result.ok; i++) {
+        result.ok = decode();
+    }
+    const int64_t elapsedNs = benchNowNs() - startNs;
+    const HostHeapStats after = hostHeapStats();
+    result.usPerFrame = elapsedNs / 1000.0 / frames;
+    result.heapPeakBytes = after.peakBytes - before.liveBytes;
+    result.heapAllocations = (after.allocations - before.allocations) / frames;
+    return result;
+}
+
+void reportPath(BenchJson& json, const char* name, const PathResult& result, size_t scratchBytes)
+{
+    json.key(name).beginObject();
+    json.member("ok", result.ok);
+    json.member("us_per_frame", result.usPerFrame);
+    json.member("heap_allocations_per_frame", result.heapAllocations);
+    json.member("heap_peak_bytes", (uint64_t)result.heapPeakBytes);
+    json.member("caller_scratch_bytes", (uint64_t)scratchBytes);
+    json.member("peak_bytes", (uint64_t)(result.heapPeakBytes + scratchBytes));
+    json.endObject();
+}
+
+} // namespace
+
+int main(int argc, char** argv)
+{
+    const uint32_t frames = benchQuick(argc, argv) ? 3 : 300;
+    bool allOk = true;
+
+    BenchJson json;
+    json.beginObject();
+    json.member("benchmark", "jpeg_gray_crop");
+    json.member("frames_per_picture", frames);
+    json.member("crop", kModelSide);
+    json.key("results").beginArray();
+    for (const char* picture : kPictures) {
+        const std::vector<uint8_t> jpeg = loadTestPicture(picture);
+        uint16_t width = 0;
+        uint16_t height = 0;
+        if (jpeg.empty() || !readJpegDimensions(jpeg.data(), jpeg.size(), &width, &height)) {
+            fprintf(stderr, "cannot read %s from %s\n", picture, HOST_TEST_PICTURES_DIR);
+            return 1;
+        }
+
+        std::vector<uint8_t> workspace((size_t)width * height);
+        std::vector<uint8_t> pool(kJpegGrayCropPoolBytes);
+        uint8_t legacy[kModelSide * kModelSide];
+        uint8_t fused[kModelSide * kModelSide];
+        JpegGrayCropResult crop;
+
+        const PathResult legacyResult =
+            measure([&] { return legacyGray96(jpeg, width, height, workspace.data(), legacy); }, frames);
+        const PathResult fusedResult = measure(
+            [&] {
+                return decodeJpegGrayCenterCrop(jpeg.data(), jpeg.size(), fused, kModelSide, kModelSide, pool.data(),
+                                                pool.size(), &crop);
+            },
+            frames);
+        const bool identical = legacyResult.ok && fusedResult.ok && memcmp(legacy, fused, sizeof(fused)) == 0;
+        allOk = allOk && identical;
+
+        json.beginObject();
+        json.member("picture", picture);
+        json.member("width", (unsigned)width);
+        json.member("height", (unsigned)height);
+        json.member("identical", identical);
+        reportPath(json, "allocating_rgb565", legacyResult, workspace.size());
+        reportPath(json, "fused_crop", fusedResult, pool.size());
+        json.member("mcus_decoded", (uint64_t)crop.mcusDelivered);
+        json.member("mcus_total", (uint64_t)crop.mcusTotal);
+        json.member("speedup", legacyResult.usPerFrame / fusedResult.usPerFrame);
+        json.endObject();
+    }
+    json.endArray();
+    json.endObject();
+    json.finish();
+    return allOk ? 0 : 1;
+}
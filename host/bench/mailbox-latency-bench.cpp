@@ -0,0 +1,148 @@
+// Publish -> acquire latency of the frame mailbox (TripleBuffer + FrameMailboxManager) under pthreads.
+// The writer publishes lent frames at a fixed period; the reader either polls acquire() or blocks on its
+// task notification as the firmware consumers do. Prints a JSON latency histogram per mode.
+#include "bench-json.h"
+#include "fake-camera.h"
+#include "data-types/frame-mailbox.h"
+#include "freertos/task.h"
+#include <algorithm>
+#include <atomic>
+#include <thread>
+#include <vector>
+
+namespace {
+
+struct LatencyResult {
+    std::vector<int64_t> samplesNs;
+    uint32_t published = 0;
+    uint32_t torn = 0;
+};
+
+int64_t spinUntil(int64_t deadlineNs)
+{
+    int64_t now;
+    while ((now = benchNowNs()) < deadlineNs) {
+        std::this_thread::yield();
+    }
+    return now;
+}
+
+LatencyResult measure(bool blockingReader, uint32_t frames, int64_t periodNs)
+{
+    FrameMailbox mailbox;
+    FrameMailboxManager manager(&mailbox);
+    manager.initFrameMailbox("bench");
+    FakeCamera camera(FRAME_LENDER_SLOTS, 16 * 1024);
+    LatencyResult result;
+    result.samplesNs.reserve(frames);
+    std::atomic<bool> done{false};
+    std::atomic<TaskHandle_t> readerTask{nullptr};
+
+    std::thread reader([&] {
+        readerTask.store(xTaskGetCurrentTaskHandle());
+        while (!done.load(std::memory_order_acquire)) {
+            if (blockingReader) {
+                ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(10));
+            }
+            const FrameSnapshot* snapshot = manager.acquire();
+            if (!snapshot) {
+                std::this_thread::yield();
+                continue;
+            }
+            const int64_t latencyNs = benchNowNs() - snapshot->captureUs;
+            result.samplesNs.push_back(latencyNs);
+            if (!FakeCamera::matches(snapshot->data, 64, snapshot->seq)) {
+                result.torn++;
+            }
+            manager.release();
+        }
+    });
+    while (!readerTask.load()) {
+        std::this_thread::yield();
+    }
+    if (blockingReader) {
+        mailbox.consumerTaskHandle = readerTask.load();
+    }
+
+    int64_t next = benchNowNs();
+    for (uint32_t i = 0; i < frames; i++) {
+        next += periodNs;
+        // The pattern follows the mailbox's own numbering so the reader can check it against snapshot->seq.
+        FrameHandle frame = camera.capture(manager.getPublishedSeq() + 1);
+        if (!frame.isValid()) {
+            continue;
+        }
+        spinUntil(next);
+        // captureUs carries the publish time in nanoseconds here.
+        manager.publish(frame, 160, 120, PIXFORMAT_JPEG, benchNowNs());
+        result.published++;
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    done.store(true, std::memory_order_release);
+    if (blockingReader) {
+        xTaskNotifyGive(readerTask.load());
+    }
+    reader.join();
+    manager.flush();
+    return result;
+}
+
+void report(BenchJson& json, const char* mode, LatencyResult& result)
+{
+    std::vector<int64_t>& samples = result.samplesNs;
+    std::sort(samples.begin(), samples.end());
+    auto percentileUs = [&](double p) {
+        return samples.empty() ? 0.0 : samples[(size_t)(p * (samples.size() - 1))] / 1000.0;
+    };
+
+    json.beginObject();
+    json.member("mode", mode);
+    json.member("published", result.published);
+    json.member("acquired", samples.size());
+    json.member("torn_reads", result.torn);
+    json.member("p50_us", percentileUs(0.50));
+    json.member("p90_us", percentileUs(0.90));
+    json.member("p99_us", percentileUs(0.99));
+    json.member("max_us", percentileUs(1.0));
+    // Power-of-two microsecond buckets: le_us is the bucket's upper bound.
+    json.key("histogram").beginArray();
+    int64_t boundUs = 1;
+    size_t index = 0;
+    while (index < samples.size()) {
+        size_t count = 0;
+        while (index < samples.size() && samples[index] <= boundUs * 1000) {
+            count++;
+            index++;
+        }
+        if (count) {
+            json.beginObject().member("le_us", boundUs).member("count", count).endObject();
+        }
+        boundUs *= 2;
+    }
+    json.endArray();
+    json.endObject();
+}
+
+} // namespace
+
+int main(int argc, char** argv)
+{
+    const bool quick = benchQuick(argc, argv);
+    const uint32_t frames = quick ? 200 : 20000;
+    const int64_t periodNs = 100 * 1000;
+
+    LatencyResult polling = measure(false, frames, periodNs);
+    LatencyResult blocking = measure(true, frames, periodNs);
+
+    BenchJson json;
+    json.beginObject();
+    json.member("benchmark", "mailbox_latency");
+    json.member("period_us", periodNs / 1000);
+    json.key("results").beginArray();
+    report(json, "polling", polling);
+    report(json, "notify", blocking);
+    json.endArray();
+    json.endObject();
+    json.finish();
+    return polling.torn == 0 && blocking.torn == 0 ? 0 : 1;
+}
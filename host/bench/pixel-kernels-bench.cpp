@@ -0,0 +1,84 @@
+// Throughput of the reference and fixed-point pixel kernels (image-editing/pixel-kernels.h) on frames
+// of the sizes the firmware converts, as megapixels per second. Both sets are always built here, so
+// one run compares them regardless of PIXEL_KERNELS_REFERENCE.
+#include "bench-json.h"
+#include "image-editing/pixel-kernels.h"
+#include <random>
+#include <vector>
+
+namespace {
+
+struct FrameSize {
+    const char* name;
+    int width;
+    int height;
+};
+
+const FrameSize kSizes[] = {
+    { "QQVGA", 160, 120 },
+    { "QVGA", 320, 240 },
+    { "SVGA", 800, 600 },
+};
+
+void report(BenchJson& json, const char* kernel, const FrameSize& size, double referenceNs, double fixedNs)
+{
+    const double pixels = (double)size.width * size.height;
+    json.beginObject();
+    json.member("kernel", kernel);
+    json.member("frame", size.name);
+    json.member("reference_mpix_s", pixels / referenceNs * 1000.0);
+    json.member("fixed_mpix_s", pixels / fixedNs * 1000.0);
+    json.member("speedup", referenceNs / fixedNs);
+    json.endObject();
+}
+
+} // namespace
+
+int main(int argc, char** argv)
+{
+    const int64_t minNs = benchQuick(argc, argv) ? 1000000 : 200000000;
+    std::mt19937 rng(42);
+
+    BenchJson json;
+    json.beginObject();
+    json.member("benchmark", "pixel_kernels");
+    json.member("active", pixelKernelsName());
+    json.key("results").beginArray();
+    for (const FrameSize& size : kSizes) {
+        const size_t pixels = (size_t)size.width * size.height;
+        std::vector<uint16_t> rgb565(pixels);
+        std::vector<uint8_t> rgb888(pixels * 3);
+        std::vector<uint8_t> gray(pixels);
+        std::vector<uint8_t> out(pixels * 3);
+        for (uint16_t& pixel : rgb565) {
+            pixel = (uint16_t)rng();
+        }
+        for (uint8_t& byte : rgb888) {
+            byte = (uint8_t)rng();
+        }
+        for (uint8_t& byte : gray) {
+            byte = (uint8_t)rng();
+        }
+
+        report(json, "rgb565_to_gray", size,
+               benchTimePerCall([&] { referenceRgb565ToGray(rgb565.data(), gray.data(), pixels); benchKeep(gray[0]); }, minNs),
+               benchTimePerCall([&] { fixedRgb565ToGray(rgb565.data(), gray.data(), pixels); benchKeep(gray[0]); }, minNs));
+        report(json, "rgb888_to_gray", size,
+               benchTimePerCall([&] { referenceRgb888ToGray(rgb888.data(), gray.data(), pixels); benchKeep(gray[0]); }, minNs),
+               benchTimePerCall([&] { fixedRgb888ToGray(rgb888.data(), gray.data(), pixels); benchKeep(gray[0]); }, minNs));
+        report(json, "rgb888_via565_to_gray", size,
+               benchTimePerCall([&] { referenceRgb888Via565ToGray(rgb888.data(), gray.data(), pixels); benchKeep(gray[0]); }, minNs),
+               benchTimePerCall([&] { fixedRgb888Via565ToGray(rgb888.data(), gray.data(), pixels); benchKeep(gray[0]); }, minNs));
+        report(json, "gray_to_rgb888", size,
+               benchTimePerCall([&] { referenceGrayToRgb888(gray.data(), out.data(), pixels); benchKeep(out[0]); }, minNs),
+               benchTimePerCall([&] { fixedGrayToRgb888(gray.data(), out.data(), pixels); benchKeep(out[0]); }, minNs));
+        // Model input from the frame: the resize the firmware runs per inference.
+        report(json, "resize_rgb888_nearest_96", size,
+               benchTimePerCall([&] { referenceResizeRgb888Nearest(rgb888.data(), size.width, size.height, out.data(), 96, 96); benchKeep(out[0]); }, minNs),
+               benchTimePerCall([&] { fixedResizeRgb888Nearest(rgb888.data(), size.width, size.height, out.data(), 96, 96); benchKeep(out[0]); }, minNs));
+    }
+    json.endArray();
+    json.endObject();
+    json.finish();
+    return 0;
+}
@@ -0,0 +1,183 @@
+// Each preprocessFrame<Source, Geometry, Destination> specialization against the chained passes it
+// replaces: convertRgb565ToGrayscale / convertRgb888ToGrayscale into a full-frame workspace, then
+// cropCenter() or downscaleGray(), then a separate tensor encode loop. Reports ns per model input for
+// both and checks each fused output equals the two-pass result on a gray copy of the frame.
+#include "bench-json.h"
+#include "define.h"
+#include "image-editing/editing.h"
+#include "image-editing/gray-resample.h"
+#include "image-editing/preprocess-pipeline.h"
+#include <random>
+#include <vector>
+
+namespace {
+
+constexpr int kModelSide = 96;
+
+struct FrameSize {
+    const char* name;
+    int width;
+    int height;
+};
+
+const FrameSize kSizes[] = {
+    { "QQVGA", 160, 120 },
+    { "QVGA", 320, 240 },
+    { "VGA", 640, 480 },
+};
+
+template <class T> const char* typeName();
+template <> const char* typeName<Gray8Source>() { return "gray8"; }
+template <> const char* typeName<Rgb565Source>() { return "rgb565"; }
+template <> const char* typeName<Rgb888Source>() { return "rgb888"; }
+template <> const char* typeName<CenterCropGeometry>() { return "center_crop"; }
+template <> const char* typeName<AreaResizeGeometry>() { return "area_resize"; }
+template <> const char* typeName<Uint8Tensor>() { return "uint8"; }
+template <> const char* typeName<Int8Tensor>() { return "int8"; }
+template <> const char* typeName<Float32Tensor>() { return "float32"; }
+template <> const char* typeName<LutTensor>() { return "lut"; }
+
+struct Frame {
+    std::vector<uint8_t> pixels;    // camera layout of the source format
+    std::vector<uint8_t> luma;      // the same frame converted once, for the equality check
+    int width;
+    int height;
+};
+
+template <class Source>
+Frame makeFrame(const FrameSize& size, std::mt19937& rng)
+{
+    Frame frame;
+    frame.width = size.width;
+    frame.height = size.height;
+    const size_t pixels = (size_t)size.width * size.height;
+    frame.pixels.resize(pixels * Source::kBytesPerPixel);
+    for (uint8_t& byte : frame.pixels) {
+        byte = (uint8_t)rng();
+    }
+    frame.luma.resize(pixels);
+    for (size_t i = 0; i < pixels; i++) {
+        frame.luma[i] = Source::luma(frame.pixels.data() + i * Source::kBytesPerPixel);
+    }
+    return frame;
+}
+
+// The pre-template path: full-frame gray conversion, geometry on the gray frame, then encode.
+template <class Source, class Geometry, class Destination>
+bool chainedPasses(const Frame& frame, std::vector<uint8_t>& workspace, uint8_t* gray96,
+                   typename Destination::Element* dst, const Destination& destination)
+{
+    const uint8_t* gray = frame.pixels.data();
+    if (Source::kBytesPerPixel == 2) {
+        convertRgb565ToGrayscale((const uint16_t*)frame.pixels.data(), workspace.data(), frame.width, frame.height);
+        gray = workspace.data();
+    } else if (Source::kBytesPerPixel == 3) {
+        convertRgb888ToGrayscale(frame.pixels.data(), workspace.data(), frame.width, frame.height);
+        gray = workspace.data();
+    }
+    bool ok;
+    if (std::is_same<Geometry, CenterCropGeometry>::value) {
+        ok = cropCenter(gray, frame.width, frame.height, gray96, kModelSide, kModelSide, 1);
+    } else {
+        // Downscaled frames go to the back half of the workspace; the front may hold the converted frame.
+        const size_t lumaBytes = (size_t)frame.width * frame.height;
+        ok = downscaleGray(gray, frame.width, frame.height, workspace.data() + lumaBytes, workspace.size() - lumaBytes,
+                           gray96, kModelSide, kModelSide);
+    }
+    for (int i = 0; i < kModelSide * kModelSide; i++) {
+        dst[i] = destination.encode(gray96[i]);
+    }
+    return ok;
+}
+
+template <class Source, class Geometry, class Destination>
+void benchSpecialization(BenchJson& json, const FrameSize& size, const Frame& frame, const Destination& destination,
+                         int64_t minNs, bool* allOk)
+{
+    typedef typename Destination::Element Element;
+    std::vector<Element> fused(kModelSide * kModelSide);
+    std::vector<Element> twoPass(kModelSide * kModelSide);
+    std::vector<Element> chained(kModelSide * kModelSide);
+    std::vector<uint8_t> workspace((size_t)frame.width * frame.height * 2);
+    uint8_t gray96[kModelSide * kModelSide];
+
+    bool ok = preprocessFrame<Source, Geometry, Destination>(frame.pixels.data(), frame.width, frame.height,
+                                                             fused.data(), kModelSide, kModelSide, destination);
+    ok = ok && preprocessFrame<Gray8Source, Geometry, Destination>(frame.luma.data(), frame.width, frame.height,
+                                                                   twoPass.data(), kModelSide, kModelSide, destination);
+    const bool identical = ok && fused == twoPass;
+    *allOk = *allOk && identical;
+
+    const double fusedNs = benchTimePerCall(
+        [&] {
+            preprocessFrame<Source, Geometry, Destination>(frame.pixels.data(), frame.width, frame.height, fused.data(),
+                                                           kModelSide, kModelSide, destination);
+            benchKeep(fused[0]);
+        },
+        minNs);
+    const double chainedNs = benchTimePerCall(
+        [&] {
+            chainedPasses<Source, Geometry, Destination>(frame, workspace, gray96, chained.data(), destination);
+            benchKeep(chained[0]);
+        },
+        minNs);
+
+    json.beginObject();
+    json.member("frame", size.name);
+    json.member("source", typeName<Source>());
+    json.member("geometry", typeName<Geometry>());
+    json.member("destination", typeName<Destination>());
+    json.member("identical", identical);
+    json.member("fused_us", fusedNs / 1000.0);
+    json.member("chained_us", chainedNs / 1000.0);
+    json.member("speedup", chainedNs / fusedNs);
+    json.endObject();
+}
+
+template <class Source, class Geometry>
+void benchDestinations(BenchJson& json, const FrameSize& size, const Frame& frame, const uint8_t* lut, int64_t minNs,
+                       bool* allOk)
+{
+    benchSpecialization<Source, Geometry>(json, size, frame, Uint8Tensor(), minNs, allOk);
+    benchSpecialization<Source, Geometry>(json, size, frame, Int8Tensor(), minNs, allOk);
+    benchSpecialization<Source, Geometry>(json, size, frame, Float32Tensor(), minNs, allOk);
+    benchSpecialization<Source, Geometry>(json, size, frame, LutTensor{ lut }, minNs, allOk);
+}
+
+template <class Source>
+void benchSource(BenchJson& json, const FrameSize& size, std::mt19937& rng, const uint8_t* lut, int64_t minNs,
+                 bool* allOk)
+{
+    const Frame frame = makeFrame<Source>(size, rng);
+    benchDestinations<Source, CenterCropGeometry>(json, size, frame, lut, minNs, allOk);
+    benchDestinations<Source, AreaResizeGeometry>(json, size, frame, lut, minNs, allOk);
+}
+
+} // namespace
+
+int main(int argc, char** argv)
+{
+    const int64_t minNs = benchQuick(argc, argv) ? 200000 : 100000000;
+    std::mt19937 rng(7);
+    uint8_t lut[256];
+    for (int i = 0; i < 256; i++) {
+        lut[i] = (uint8_t)(i ^ 0x80);   // uint8 luma to int8 bit patterns, zero point -128
+    }
+    bool allOk = true;
+
+    BenchJson json;
+    json.beginObject();
+    json.member("benchmark", "preprocess_pipeline");
+    json.member("model_input", kModelSide);
+    json.member("kernels", pixelKernelsName());
+    json.key("results").beginArray();
+    for (const FrameSize& size : kSizes) {
+        benchSource<Gray8Source>(json, size, rng, lut, minNs, &allOk);
+        benchSource<Rgb565Source>(json, size, rng, lut, minNs, &allOk);
+        benchSource<Rgb888Source>(json, size, rng, lut, minNs, &allOk);
+    }
+    json.endArray();
+    json.endObject();
+    json.finish();
+    return allOk ? 0 : 1;
+}
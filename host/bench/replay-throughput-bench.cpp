@@ -0,0 +1,215 @@
+// Post-capture pipeline throughput without a sensor: the esp32-camera sample JPEGs are injected into an
+// InjectedFrameStore and replayed through its ReplayFrameSource, exactly as after POST /frames/inject.
+// "sequential" runs acquire -> buildGray96Frame on one thread, twice, and checks both runs produce the
+// same model inputs; "mailbox" runs capture_task's publish and the inference consumer on two threads.
+#include "bench-json.h"
+#include "test-pictures.h"
+#include "data-types/frame-mailbox.h"
+#include "frame-source/injected-frame-store.h"
+#include "image-editing/editing.h"
+#include <atomic>
+#include <cstring>
+#include <thread>
+
+namespace {
+
+constexpr size_t kModelSide = 96;
+const char* const kPictures[] = { "test_inside.jpeg", "test_outside.jpeg", "testimg.jpeg" };
+
+struct PassResult {
+    uint32_t frames = 0;
+    uint32_t failures = 0;
+    int64_t elapsedNs = 0;
+    uint64_t digest = 1469598103934665603ull;  // FNV-1a over every model input, in order
+};
+
+void addToDigest(uint64_t* digest, const uint8_t* data, size_t len)
+{
+    for (size_t i = 0; i < len; i++) {
+        *digest = (*digest ^ data[i]) * 1099511628211ull;
+    }
+}
+
+bool injectPictures(InjectedFrameStore& store)
+{
+    for (const char* picture : kPictures) {
+        const std::vector<uint8_t> jpeg = loadTestPicture(picture);
+        uint16_t width = 0;
+        uint16_t height = 0;
+        uint8_t* slot = jpeg.empty() ? nullptr : store.reserve(jpeg.size());
+        if (!slot || !readJpegDimensions(jpeg.data(), jpeg.size(), &width, &height)) {
+            return false;
+        }
+        memcpy(slot, jpeg.data(), jpeg.size());
+        store.commit(width, height, PIXFORMAT_JPEG);
+    }
+    return true;
+}
+
+// Workspace for the largest injected frame.
+std::vector<uint8_t> makeWorkspace()
+{
+    return std::vector<uint8_t>(gray96WorkspaceBytes(480, 320));
+}
+
+bool preprocess(const FrameSnapshot& snapshot, std::vector<uint8_t>& workspace, uint8_t* gray96)
+{
+    return buildGray96Frame(snapshot, workspace.data(), workspace.size(), gray96, kModelSide);
+}
+
+FrameSnapshot toSnapshot(SourceFrame& frame, uint32_t seq)
+{
+    FrameSnapshot snapshot;
+    snapshot.data = frame.handle.data();
+    snapshot.len = frame.handle.len();
+    snapshot.width = frame.width;
+    snapshot.height = frame.height;
+    snapshot.format = frame.format;
+    snapshot.seq = seq;
+    snapshot.handle = std::move(frame.handle);
+    return snapshot;
+}
+
+PassResult runSequential(ReplayFrameSource& source, uint32_t frames)
+{
+    std::vector<uint8_t> workspace = makeWorkspace();
+    uint8_t gray96[kModelSide * kModelSide];
+    PassResult result;
+
+    source.onActivate();
+    const int64_t startNs = benchNowNs();
+    for (uint32_t seq = 1; seq <= frames; seq++) {
+        SourceFrame frame;
+        if (source.acquire(&frame) != FrameAcquireResult::Ok) {
+            result.failures++;
+            continue;
+        }
+        const FrameSnapshot snapshot = toSnapshot(frame, seq);
+        if (!preprocess(snapshot, workspace, gray96)) {
+            result.failures++;
+            continue;
+        }
+        addToDigest(&result.digest, gray96, sizeof(gray96));
+        result.frames++;
+    }
+    result.elapsedNs = benchNowNs() - startNs;
+    source.onDeactivate();
+    return result;
+}
+
+struct MailboxResult {
+    PassResult consumer;
+    uint32_t published = 0;
+    uint32_t noSlot = 0;
+};
+
+// capture_task's loop (acquire, publish) against an inference consumer woken by task notification.
+MailboxResult runMailbox(ReplayFrameSource& source, uint32_t frames)
+{
+    FrameMailbox mailbox;
+    FrameMailboxManager manager(&mailbox);
+    manager.initFrameMailbox("inference");
+    MailboxResult result;
+    std::atomic<bool> done{false};
+    std::atomic<TaskHandle_t> consumerTask{nullptr};
+
+    std::thread consumer([&] {
+        std::vector<uint8_t> workspace = makeWorkspace();
+        uint8_t gray96[kModelSide * kModelSide];
+        consumerTask.store(xTaskGetCurrentTaskHandle());
+        while (true) {
+            ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(10));
+            const FrameSnapshot* snapshot = manager.acquire();
+            if (!snapshot) {
+                if (done.load(std::memory_order_acquire)) {
+                    break;
+                }
+                continue;
+            }
+            if (preprocess(*snapshot, workspace, gray96)) {
+                result.consumer.frames++;
+            } else {
+                result.consumer.failures++;
+            }
+            manager.release();
+        }
+    });
+    while (!consumerTask.load()) {
+        std::this_thread::yield();
+    }
+    mailbox.consumerTaskHandle = consumerTask.load();
+
+    source.onActivate();
+    const int64_t startNs = benchNowNs();
+    while (result.published < frames) {
+        SourceFrame frame;
+        const FrameAcquireResult acquired = source.acquire(&frame);
+        if (acquired != FrameAcquireResult::Ok) {
+            result.noSlot += acquired == FrameAcquireResult::NoSlot;
+            std::this_thread::yield();
+            continue;
+        }
+        manager.publish(frame.handle, frame.width, frame.height, frame.format, benchNowNs() / 1000);
+        result.published++;
+        // The sensor would deliver the next frame a frame time later; give the consumer the core meanwhile.
+        std::this_thread::yield();
+    }
+    done.store(true, std::memory_order_release);
+    xTaskNotifyGive(consumerTask.load());
+    consumer.join();
+    result.consumer.elapsedNs = benchNowNs() - startNs;
+    manager.flush();
+    source.onDeactivate();
+    return result;
+}
+
+void reportPass(BenchJson& json, const char* mode, const PassResult& pass)
+{
+    json.member("mode", mode);
+    json.member("frames", pass.frames);
+    json.member("failures", pass.failures);
+    json.member("elapsed_ms", pass.elapsedNs / 1.0e6);
+    json.member("fps", pass.elapsedNs ? pass.frames * 1.0e9 / pass.elapsedNs : 0.0);
+    json.member("us_per_frame", pass.frames ? pass.elapsedNs / 1000.0 / pass.frames : 0.0);
+}
+
+} // namespace
+
+int main(int argc, char** argv)
+{
+    const uint32_t frames = benchQuick(argc, argv) ? 30 : 3000;
+
+    // Static like the firmware's injectedFrameStore: the store never frees its arena.
+    static InjectedFrameStore store(FRAME_INJECT_BUFFER_BYTES, PlacedBuffer::InjectedFrames);
+    if (!injectPictures(store)) {
+        fprintf(stderr, "cannot inject the test pictures from %s\n", HOST_TEST_PICTURES_DIR);
+        return 1;
+    }
+    ReplayFrameSource& source = *store.getSource();
+
+    const PassResult first = runSequential(source, frames);
+    const PassResult second = runSequential(source, frames);
+    const MailboxResult mailbox = runMailbox(source, frames);
+    const bool identical = first.digest == second.digest && first.frames == second.frames;
+
+    BenchJson json;
+    json.beginObject();
+    json.member("benchmark", "replay_throughput");
+    json.member("source_frames", store.getFrameCount());
+    json.member("model_input", (uint64_t)kModelSide);
+    json.member("runs_identical", identical);
+    json.key("results").beginArray();
+    json.beginObject();
+    reportPass(json, "sequential", first);
+    json.endObject();
+    json.beginObject();
+    reportPass(json, "mailbox", mailbox.consumer);
+    json.member("published", mailbox.published);
+    json.member("dropped", mailbox.published - mailbox.consumer.frames - mailbox.consumer.failures);
+    json.member("no_slot", mailbox.noSlot);
+    json.endObject();
+    json.endArray();
+    json.endObject();
+    json.finish();
+    return identical && first.failures == 0 && mailbox.consumer.failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,17 @@
+#pragma once
+
+// The parts of esp32-camera's esp_camera.h that the hardware-independent sources use; sensor.h comes from
+// the component itself.
+#include <stddef.h>
+#include <sys/time.h>
+#include "esp_err.h"
+#include "sensor.h"
+
+typedef struct {
+    uint8_t* buf;
+    size_t len;
+    size_t width;
+    size_t height;
+    pixformat_t format;
+    struct timeval timestamp;
+} camera_fb_t;
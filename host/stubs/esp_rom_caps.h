@@ -0,0 +1,3 @@
+#pragma once
+
+// Host build: no ROM, so no ESP_ROM_HAS_* capability is defined.
@@ -0,0 +1,12 @@
+#pragma once
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+// Microseconds of a monotonic clock, like the ESP-IDF timer.
+int64_t esp_timer_get_time(void);
+#ifdef __cplusplus
+}
+#endif
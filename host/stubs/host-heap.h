@@ -0,0 +1,16 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+// Counters of the heap_caps_* stand-ins: tests use them to check allocation-free paths, benchmarks to
+// report peak scratch memory.
+struct HostHeapStats {
+    uint64_t allocations = 0;
+    uint64_t frees = 0;
+    size_t liveBytes = 0;
+    size_t peakBytes = 0;       // highest liveBytes since start or the last hostHeapResetPeak()
+};
+
+HostHeapStats hostHeapStats();
+void hostHeapResetPeak();
@@ -0,0 +1,255 @@
+#include "host-heap.h"
+#include "esp_err.h"
+#include "esp_heap_caps.h"
+#include "esp_log.h"
+#include "esp_system.h"
+#include "esp_timer.h"
+#include "freertos/task.h"
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdarg>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+
+// ---- heap_caps: C heap with a size header in front of every block ----
+
+namespace {
+
+struct BlockHeader {
+    void* base;
+    size_t size;
+};
+
+std::atomic<uint64_t> heapAllocations{0};
+std::atomic<uint64_t> heapFrees{0};
+std::atomic<size_t> heapLiveBytes{0};
+std::atomic<size_t> heapPeakBytes{0};
+
+void* allocateBlock(size_t alignment, size_t size)
+{
+    if (size == 0) {
+        return nullptr;
+    }
+    if (alignment < alignof(std::max_align_t)) {
+        alignment = alignof(std::max_align_t);
+    }
+    const size_t overhead = sizeof(BlockHeader) + alignment - 1;
+    uint8_t* base = (uint8_t*)malloc(size + overhead);
+    if (!base) {
+        return nullptr;
+    }
+    uintptr_t user = ((uintptr_t)base + sizeof(BlockHeader) + alignment - 1) & ~(uintptr_t)(alignment - 1);
+    BlockHeader* header = (BlockHeader*)user - 1;
+    header->base = base;
+    header->size = size;
+
+    heapAllocations.fetch_add(1, std::memory_order_relaxed);
+    const size_t live = heapLiveBytes.fetch_add(size, std::memory_order_relaxed) + size;
+    size_t peak = heapPeakBytes.load(std::memory_order_relaxed);
+    while (live > peak && !heapPeakBytes.compare_exchange_weak(peak, live, std::memory_order_relaxed)) {
+    }
+    return (void*)user;
+}
+
+} // namespace
+
+HostHeapStats hostHeapStats()
+{
+    HostHeapStats stats;
+    stats.allocations = heapAllocations.load(std::memory_order_relaxed);
+    stats.frees = heapFrees.load(std::memory_order_relaxed);
+    stats.liveBytes = heapLiveBytes.load(std::memory_order_relaxed);
+    stats.peakBytes = heapPeakBytes.load(std::memory_order_relaxed);
+    return stats;
+}
+
+void hostHeapResetPeak()
+{
+    heapPeakBytes.store(heapLiveBytes.load(std::memory_order_relaxed), std::memory_order_relaxed);
+}
+
+extern "C" {
+
+void* heap_caps_malloc(size_t size, uint32_t)
+{
+    return allocateBlock(0, size);
+}
+
+void* heap_caps_calloc(size_t n, size_t size, uint32_t caps)
+{
+    void* p = heap_caps_malloc(n * size, caps);
+    if (p) {
+        memset(p, 0, n * size);
+    }
+    return p;
+}
+
+void* heap_caps_aligned_alloc(size_t alignment, size_t size, uint32_t)
+{
+    return allocateBlock(alignment, size);
+}
+
+void* heap_caps_aligned_calloc(size_t alignment, size_t n, size_t size, uint32_t caps)
+{
+    void* p = heap_caps_aligned_alloc(alignment, n * size, caps);
+    if (p) {
+        memset(p, 0, n * size);
+    }
+    return p;
+}
+
+void heap_caps_free(void* ptr)
+{
+    if (!ptr) {
+        return;
+    }
+    BlockHeader* header = (BlockHeader*)ptr - 1;
+    heapFrees.fetch_add(1, std::memory_order_relaxed);
+    heapLiveBytes.fetch_sub(header->size, std::memory_order_relaxed);
+    free(header->base);
+}
+
+void* heap_caps_realloc(void* ptr, size_t size, uint32_t caps)
+{
+    if (!ptr) {
+        return heap_caps_malloc(size, caps);
+    }
+    void* grown = heap_caps_malloc(size, caps);
+    if (grown) {
+        const size_t old = ((BlockHeader*)ptr - 1)->size;
+        memcpy(grown, ptr, old < size ? old : size);
+        heap_caps_free(ptr);
+    }
+    return grown;
+}
+
+size_t heap_caps_get_free_size(uint32_t)
+{
+    return 64 * 1024 * 1024;
+}
+
+size_t heap_caps_get_total_size(uint32_t)
+{
+    return 64 * 1024 * 1024;
+}
+
+size_t heap_caps_get_largest_free_block(uint32_t)
+{
+    return 64 * 1024 * 1024;
+}
+
+uint32_t esp_get_free_heap_size(void)
+{
+    return 64 * 1024 * 1024;
+}
+
+// ---- esp_timer / esp_err / esp_log ----
+
+int64_t esp_timer_get_time(void)
+{
+    using namespace std::chrono;
+    return duration_cast<microseconds>(steady_clock::now().time_since_epoch()).count();
+}
+
+const char* esp_err_to_name(esp_err_t code)
+{
+    switch (code) {
+        case ESP_OK:              return "ESP_OK";
+        case ESP_FAIL:            return "ESP_FAIL";
+        case ESP_ERR_NO_MEM:      return "ESP_ERR_NO_MEM";
+        case ESP_ERR_INVALID_ARG: return "ESP_ERR_INVALID_ARG";
+        case ESP_ERR_TIMEOUT:     return "ESP_ERR_TIMEOUT";
+        default:                  return "ESP_ERR";
+    }
+}
+
+static int hostLogLevel()
+{
+    static const int level = [] {
+        const char* env = getenv("HOST_LOG_LEVEL");
+        return env ? atoi(env) : (int)ESP_LOG_ERROR;
+    }();
+    return level;
+}
+
+void host_log(esp_log_level_t level, const char* tag, const char* format, ...)
+{
+    if ((int)level > hostLogLevel()) {
+        return;
+    }
+    static const char kLevels[] = "NEWIDV";
+    fprintf(stderr, "%c (%s) ", kLevels[level], tag);
+    va_list args;
+    va_start(args, format);
+    vfprintf(stderr, format, args);
+    va_end(args);
+    fputc('\n', stderr);
+}
+
+void esp_log_level_set(const char*, esp_log_level_t)
+{
+}
+
+} // extern "C"
+
+// ---- FreeRTOS task notifications: one counter per thread ----
+
+namespace {
+
+std::mutex notifyLock;
+std::condition_variable notifyChanged;
+std::unordered_map<TaskHandle_t, uint32_t> notifyCounts;
+thread_local char currentTaskToken;
+
+} // namespace
+
+extern "C" {
+
+TaskHandle_t xTaskGetCurrentTaskHandle(void)
+{
+    return &currentTaskToken;
+}
+
+BaseType_t xTaskNotifyGive(TaskHandle_t task)
+{
+    {
+        std::lock_guard<std::mutex> guard(notifyLock);
+        notifyCounts[task]++;
+    }
+    notifyChanged.notify_all();
+    return pdPASS;
+}
+
+uint32_t ulTaskNotifyTake(BaseType_t clearOnExit, TickType_t ticksToWait)
+{
+    TaskHandle_t self = xTaskGetCurrentTaskHandle();
+    std::unique_lock<std::mutex> guard(notifyLock);
+    auto pending = [&] { return notifyCounts[self] != 0; };
+    if (ticksToWait == portMAX_DELAY) {
+        notifyChanged.wait(guard, pending);
+    } else {
+        notifyChanged.wait_for(guard, std::chrono::milliseconds(ticksToWait * portTICK_PERIOD_MS), pending);
+    }
+    const uint32_t count = notifyCounts[self];
+    if (count != 0) {
+        notifyCounts[self] = clearOnExit ? 0 : count - 1;
+    }
+    return count;
+}
+
+void vTaskDelay(TickType_t ticks)
+{
+    std::this_thread::sleep_for(std::chrono::milliseconds(ticks * portTICK_PERIOD_MS));
+}
+
+TickType_t xTaskGetTickCount(void)
+{
+    return (TickType_t)(esp_timer_get_time() / 1000 / portTICK_PERIOD_MS);
+}
+
+} // extern "C"
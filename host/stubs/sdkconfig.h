@@ -0,0 +1,12 @@
+#pragma once
+
+// Host build: the options the shared sources test for. The ROM tjpgd does not exist here, so esp_jpeg's
+// bundled tjpgd is built with the component's Kconfig defaults instead.
+#define CONFIG_IDF_TARGET "linux"
+#define CONFIG_FREERTOS_HZ 1000
+#define CONFIG_JD_USE_ROM 0
+#define CONFIG_JD_SZBUF 512
+#define CONFIG_JD_FORMAT 0
+#define CONFIG_JD_USE_SCALE 1
+#define CONFIG_JD_TBLCLIP 1
+#define CONFIG_JD_FASTDECODE 1
@@ -0,0 +1,129 @@
+#pragma once
+
+// Small helpers for the host benchmarks: a monotonic clock, a JSON writer for the results (stdout) and
+// the --quick flag the ctest smoke runs pass.
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+
+inline int64_t benchNowNs()
+{
+    using namespace std::chrono;
+    return duration_cast<nanoseconds>(steady_clock::now().time_since_epoch()).count();
+}
+
+inline bool benchQuick(int argc, char** argv)
+{
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--quick") == 0) {
+            return true;
+        }
+    }
+    return false;
+}
+
+// Keeps a computed value alive so the optimizer cannot drop the work that produced it.
+template <typename T>
+inline void benchKeep(const T& value)
+{
+    asm volatile("" : : "g"(&value) : "memory");
+}
+
+// Runs fn once to warm caches, then repeatedly until minNs has passed; returns nanoseconds per call.
+template <typename Fn>
+inline double benchTimePerCall(Fn fn, int64_t minNs)
+{
+    fn();
+    int64_t calls = 0;
+    const int64_t startNs = benchNowNs();
+    int64_t elapsedNs = 0;
+    do {
+        fn();
+        calls++;
+        elapsedNs = benchNowNs() - startNs;
+    } while (elapsedNs < minNs);
+    return (double)elapsedNs / calls;
+}
+
+// Streams one JSON document. Objects and arrays nest; key() precedes every member of an object.
+class BenchJson
+{
+public:
+    explicit BenchJson(FILE* out = stdout) : out_(out) {}
+
+    BenchJson& beginObject() { open('{'); return *this; }
+    BenchJson& endObject() { close('}'); return *this; }
+    BenchJson& beginArray() { open('['); return *this; }
+    BenchJson& endArray() { close(']'); return *this; }
+
+    BenchJson& key(const char* name)
+    {
+        separate();
+        writeString(name);
+        fputc(':', out_);
+        afterKey_ = true;
+        return *this;
+    }
+
+    BenchJson& value(const char* text) { separate(); writeString(text); return *this; }
+    BenchJson& value(const std::string& text) { return value(text.c_str()); }
+    BenchJson& value(bool flag) { separate(); fputs(flag ? "true" : "false", out_); return *this; }
+    BenchJson& value(int64_t number) { separate(); fprintf(out_, "%lld", (long long)number); return *this; }
+    BenchJson& value(uint64_t number) { separate(); fprintf(out_, "%llu", (unsigned long long)number); return *this; }
+    BenchJson& value(int number) { return value((int64_t)number); }
+    BenchJson& value(unsigned number) { return value((uint64_t)number); }
+    BenchJson& value(double number) { separate(); fprintf(out_, "%.4g", number); return *this; }
+
+    template <typename T>
+    BenchJson& member(const char* name, const T& v) { key(name); return value(v); }
+
+    // Closes the document with a newline.
+    void finish() { fputc('\n', out_); fflush(out_); }
+
+private:
+    void open(char bracket)
+    {
+        separate();
+        fputc(bracket, out_);
+        first_.push_back(true);
+    }
+
+    void close(char bracket)
+    {
+        fputc(bracket, out_);
+        first_.pop_back();
+    }
+
+    void separate()
+    {
+        if (afterKey_) {
+            afterKey_ = false;
+            return;
+        }
+        if (!first_.empty()) {
+            if (!first_.back()) {
+                fputc(',', out_);
+            }
+            first_.back() = false;
+        }
+    }
+
+    void writeString(const char* text)
+    {
+        fputc('"', out_);
+        for (const char* c = text; *c; c++) {
+            if (*c == '"' || *c == '\\') {
+                fputc('\\', out_);
+            }
+            fputc(*c, out_);
+        }
+        fputc('"', out_);
+    }
+
+    FILE* out_;
+    std::vector<bool> first_;
+    bool afterKey_ = false;
+};
@@ -0,0 +1,108 @@
+#pragma once
+
+#include "data-types/frame-handle.h"
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+// Stand-in for the camera driver's DMA frame buffers: fbCount fixed buffers handed out like
+// esp_camera_fb_get() and lent through a FrameLender, the way CameraFrameSource does it. Every buffer
+// that comes back through the release callback (esp_camera_fb_return on the device) is counted.
+class FakeCamera
+{
+public:
+    FakeCamera(size_t fbCount, size_t frameBytes)
+        : lender_(&FakeCamera::returnFrame, this), buffers_(fbCount), returns_(fbCount)
+    {
+        for (Buffer& buffer : buffers_) {
+            buffer.data.resize(frameBytes);
+        }
+        for (std::atomic<uint32_t>& count : returns_) {
+            count.store(0);
+        }
+    }
+
+    FakeCamera(const FakeCamera&) = delete;
+    FakeCamera& operator=(const FakeCamera&) = delete;
+
+    // Next free buffer, filled with a pattern derived from seq, lent as a handle. Invalid when the driver
+    // has no free buffer or the lender no free slot (the buffer is then returned at once, as capture_task does).
+    FrameHandle capture(uint32_t seq, size_t* bufferIndex = nullptr)
+    {
+        for (size_t i = 0; i < buffers_.size(); i++) {
+            bool expected = false;
+            if (!buffers_[i].held.compare_exchange_strong(expected, true)) {
+                continue;
+            }
+            fill(buffers_[i].data.data(), buffers_[i].data.size(), seq);
+            FrameHandle handle = lender_.lend(&buffers_[i], buffers_[i].data.data(), buffers_[i].data.size());
+            if (!handle.isValid()) {
+                buffers_[i].held.store(false);
+                return handle;
+            }
+            if (bufferIndex) {
+                *bufferIndex = i;
+            }
+            return handle;
+        }
+        return FrameHandle();
+    }
+
+    static void fill(uint8_t* data, size_t len, uint32_t seq)
+    {
+        for (size_t i = 0; i < len; i++) {
+            data[i] = (uint8_t)(seq * 31 + i);
+        }
+    }
+
+    static bool matches(const uint8_t* data, size_t len, uint32_t seq)
+    {
+        for (size_t i = 0; i < len; i++) {
+            if (data[i] != (uint8_t)(seq * 31 + i)) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    const uint8_t* bufferData(size_t index) const { return buffers_[index].data.data(); }
+    uint32_t returnCount(size_t index) const { return returns_[index].load(); }
+    uint32_t totalReturns() const
+    {
+        uint32_t total = 0;
+        for (const std::atomic<uint32_t>& count : returns_) {
+            total += count.load();
+        }
+        return total;
+    }
+    size_t heldBuffers() const
+    {
+        size_t held = 0;
+        for (const Buffer& buffer : buffers_) {
+            held += buffer.held.load() ? 1 : 0;
+        }
+        return held;
+    }
+    const FrameLender& lender() const { return lender_; }
+
+private:
+    struct Buffer {
+        std::vector<uint8_t> data;
+        std::atomic<bool> held{false};
+    };
+
+    static void returnFrame(void* ctx, void* sourceFrame)
+    {
+        FakeCamera* camera = static_cast<FakeCamera*>(ctx);
+        Buffer* buffer = static_cast<Buffer*>(sourceFrame);
+        const size_t index = (size_t)(buffer - camera->buffers_.data());
+        camera->returns_[index].fetch_add(1);
+        buffer->held.store(false);
+    }
+
+    FrameLender lender_;
+    std::vector<Buffer> buffers_;
+    std::vector<std::atomic<uint32_t>> returns_;
+};
@@ -0,0 +1,179 @@
+#pragma once
+
+#include "model-store/model-storage.h"
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <fcntl.h>
+#include <map>
+#include <sys/mman.h>
+#include <unistd.h>
+#include <vector>
+
+// ModelStorage on a file, standing in for the model partition: erase() fills whole eraseSize() units with
+// 0xFF, write() can only clear bits (NOR flash ANDs new data into what is there) and map() is a shared
+// read-only mmap, so views see later writes the way the flash cache does. Reopening the same file is a
+// reboot. Every erase is logged, and writes, erases and maps can be made to fail.
+class FileModelStorage : public ModelStorage
+{
+public:
+    FileModelStorage() = default;
+    ~FileModelStorage() override { close(); }
+
+    FileModelStorage(const FileModelStorage&) = delete;
+    FileModelStorage& operator=(const FileModelStorage&) = delete;
+
+    // Opens path, keeping what it holds; a new file, or bytes beyond its end, read as erased.
+    bool open(const char* path, size_t size, size_t eraseSize)
+    {
+        close();
+        fd_ = ::open(path, O_RDWR | O_CREAT, 0644);
+        if (fd_ < 0) {
+            return false;
+        }
+        const off_t existing = lseek(fd_, 0, SEEK_END);
+        std::vector<uint8_t> erased(size > (size_t)existing ? size - (size_t)existing : 0, 0xFF);
+        if (existing < 0 || ftruncate(fd_, (off_t)size) != 0
+                || (!erased.empty() && pwrite(fd_, erased.data(), erased.size(), existing) != (ssize_t)erased.size())) {
+            close();
+            return false;
+        }
+        size_ = size;
+        eraseSize_ = eraseSize;
+        return true;
+    }
+
+    void close()
+    {
+        for (const auto& view : views_) {
+            munmap(view.second.base, view.second.len);
+        }
+        views_.clear();
+        if (fd_ >= 0) {
+            ::close(fd_);
+        }
+        fd_ = -1;
+        size_ = 0;
+    }
+
+    const char* name() const override { return "file"; }
+    size_t size() const override { return size_; }
+    size_t eraseSize() const override { return fd_ >= 0 ? eraseSize_ : 0; }
+
+    bool erase(size_t offset, size_t len) override
+    {
+        if (failErases_ || !inRange(offset, len) || offset % eraseSize_ != 0 || len % eraseSize_ != 0) {
+            return false;
+        }
+        erases_.push_back(Range{offset, len});
+        const std::vector<uint8_t> erased(len, 0xFF);
+        return pwrite(fd_, erased.data(), len, (off_t)offset) == (ssize_t)len;
+    }
+
+    bool write(size_t offset, const void* data, size_t len) override
+    {
+        if (failWrites_ || !inRange(offset, len)) {
+            return false;
+        }
+        std::vector<uint8_t> bytes(len);
+        if (pread(fd_, bytes.data(), len, (off_t)offset) != (ssize_t)len) {
+            return false;
+        }
+        const uint8_t* in = (const uint8_t*)data;
+        for (size_t i = 0; i < len; i++) {
+            bytes[i] &= in[i];
+        }
+        return pwrite(fd_, bytes.data(), len, (off_t)offset) == (ssize_t)len;
+    }
+
+    const uint8_t* map(size_t offset, size_t len, uint32_t* handle) override
+    {
+        if (failMaps_ || len == 0 || !inRange(offset, len)) {
+            return nullptr;
+        }
+        const size_t page = (size_t)sysconf(_SC_PAGESIZE);
+        const size_t start = offset / page * page;
+        const size_t mapLen = offset - start + len;
+        void* base = mmap(nullptr, mapLen, PROT_READ, MAP_SHARED, fd_, (off_t)start);
+        if (base == MAP_FAILED) {
+            return nullptr;
+        }
+        *handle = nextHandle_++;
+        views_[*handle] = View{base, mapLen, (const uint8_t*)base + (offset - start), len};
+        return views_[*handle].data;
+    }
+
+    void unmap(uint32_t handle) override
+    {
+        const auto view = views_.find(handle);
+        if (view != views_.end()) {
+            munmap(view->second.base, view->second.len);
+            views_.erase(view);
+        }
+    }
+
+    struct Range {
+        size_t offset;
+        size_t len;
+    };
+
+    // Erases since open() or the last clearEraseLog().
+    const std::vector<Range>& eraseLog() const { return erases_; }
+    void clearEraseLog() { erases_.clear(); }
+    bool erasedWithin(size_t offset, size_t len) const
+    {
+        for (const Range& range : erases_) {
+            if (range.offset < offset + len && offset < range.offset + range.len) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    size_t liveMaps() const { return views_.size(); }
+    // True when ptr lies inside a view map() handed out and nobody has unmapped yet.
+    bool isMapped(const void* ptr) const
+    {
+        for (const auto& view : views_) {
+            if ((const uint8_t*)ptr >= view.second.data && (const uint8_t*)ptr < view.second.data + view.second.dataLen) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    // Bit rot: XORs mask into one byte, bypassing the erase-before-write rule.
+    bool corrupt(size_t offset, uint8_t mask)
+    {
+        uint8_t byte = 0;
+        if (!inRange(offset, 1) || pread(fd_, &byte, 1, (off_t)offset) != 1) {
+            return false;
+        }
+        byte ^= mask;
+        return pwrite(fd_, &byte, 1, (off_t)offset) == 1;
+    }
+
+    void failErases(bool fail) { failErases_ = fail; }
+    void failWrites(bool fail) { failWrites_ = fail; }
+    void failMaps(bool fail) { failMaps_ = fail; }
+
+private:
+    struct View {
+        void* base;
+        size_t len;
+        const uint8_t* data;
+        size_t dataLen;
+    };
+
+    bool inRange(size_t offset, size_t len) const { return fd_ >= 0 && offset <= size_ && len <= size_ - offset; }
+
+    int fd_ = -1;
+    size_t size_ = 0;
+    size_t eraseSize_ = 0;
+    uint32_t nextHandle_ = 1;
+    std::map<uint32_t, View> views_;
+    std::vector<Range> erases_;
+    bool failErases_ = false;
+    bool failWrites_ = false;
+    bool failMaps_ = false;
+};
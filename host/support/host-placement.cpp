@@ -0,0 +1,30 @@
+// The firmware's bufferPlacement instance for host builds. The device table (kBufferPlacementPolicies in
+// app-globals.h) pulls in the LED and camera globals, so the host keeps its own: same alignments, and a
+// single tier because the stub heap has no separate internal and PSRAM regions.
+#include "memory/buffer-placement.h"
+#include "esp_heap_caps.h"
+
+namespace {
+
+constexpr uint32_t kHostHeap = MALLOC_CAP_8BIT;
+
+constexpr BufferPlacementPolicy kHostPlacementPolicies[] = {
+    { PlacedBuffer::InferenceGray96,       "inference gray96",        16, { kHostHeap, 0, 0 } },
+    { PlacedBuffer::InferenceWorkspace,    "inference workspace",     16, { kHostHeap, 0, 0 } },
+    { PlacedBuffer::StreamGray96,          "stream gray96",           16, { kHostHeap, 0, 0 } },
+    { PlacedBuffer::StreamWorkspace,       "stream workspace",        16, { kHostHeap, 0, 0 } },
+    { PlacedBuffer::TensorArena,           "tensor arena",            16, { kHostHeap, 0, 0 } },
+    { PlacedBuffer::TensorArenaPersistent, "tensor arena persistent", 16, { kHostHeap, 0, 0 } },
+    { PlacedBuffer::FramePoolSlabs,        "frame pool slabs",        32, { kHostHeap, 0, 0 } },
+    { PlacedBuffer::PreEventRing,          "pre-event ring",           8, { kHostHeap, 0, 0 } },
+    { PlacedBuffer::UdpPacket,             "udp packet",               4, { kHostHeap, 0, 0 } },
+    { PlacedBuffer::MotionThumbnail,       "motion thumbnail",        16, { kHostHeap, 0, 0 } },
+    { PlacedBuffer::InjectedFrames,        "injected frames",          4, { kHostHeap, 0, 0 } },
+    { PlacedBuffer::JpegDecoder,           "jpeg decoder",            16, { kHostHeap, 0, 0 } },
+    { PlacedBuffer::DetectionTiles,        "detection tiles",          4, { kHostHeap, 0, 0 } },
+};
+
+} // namespace
+
+BufferPlacement bufferPlacement(kHostPlacementPolicies,
+                                sizeof(kHostPlacementPolicies) / sizeof(kHostPlacementPolicies[0]));
@@ -0,0 +1,62 @@
+#include "host-test.h"
+#include <cstdio>
+#include <cstring>
+#include <vector>
+
+namespace {
+
+struct HostTestCase {
+    const char* name;
+    HostTestFn fn;
+};
+
+// Thrown by a failed REQUIRE to leave the current test case.
+struct HostTestAbort {};
+
+std::vector<HostTestCase>& registry()
+{
+    static std::vector<HostTestCase> tests;
+    return tests;
+}
+
+int failedChecks = 0;
+
+} // namespace
+
+bool hostRegisterTest(const char* name, HostTestFn fn)
+{
+    registry().push_back({ name, fn });
+    return true;
+}
+
+void hostCheckFailed(const char* file, int line, const char* expression, const std::string& detail, bool fatal)
+{
+    failedChecks++;
+    fprintf(stderr, "%s:%d: check failed: %s%s%s\n", file, line, expression, detail.empty() ? "" : " -- ", detail.c_str());
+    if (fatal) {
+        throw HostTestAbort();
+    }
+}
+
+int main(int argc, char** argv)
+{
+    const char* filter = argc > 1 ? argv[1] : nullptr;
+    int run = 0;
+    int failed = 0;
+    for (const HostTestCase& test : registry()) {
+        if (filter && !strstr(test.name, filter)) {
+            continue;
+        }
+        const int before = failedChecks;
+        try {
+            test.fn();
+        } catch (const HostTestAbort&) {
+        }
+        run++;
+        const bool ok = failedChecks == before;
+        failed += ok ? 0 : 1;
+        printf("[%s] %s\n", ok ? " OK " : "FAIL", test.name);
+    }
+    printf("%d/%d test cases passed\n", run - failed, run);
+    return failed == 0 && run > 0 ? 0 : 1;
+}
@@ -0,0 +1,61 @@
+#pragma once
+
+// Minimal test harness for the host build: HOST_TEST(name) { CHECK(...); } registers a test case, and
+// host-test-main.cpp runs them all (or those whose name contains argv[1]). A failed CHECK reports and the
+// test carries on; a failed REQUIRE ends the test case.
+#include <cmath>
+#include <sstream>
+#include <string>
+
+using HostTestFn = void (*)();
+
+bool hostRegisterTest(const char* name, HostTestFn fn);
+void hostCheckFailed(const char* file, int line, const char* expression, const std::string& detail, bool fatal);
+
+// Streams a CHECK_EQ operand; byte-sized integers print as numbers rather than characters.
+template <typename T>
+const T& hostPrintable(const T& value) { return value; }
+inline int hostPrintable(char value) { return value; }
+inline int hostPrintable(signed char value) { return value; }
+inline int hostPrintable(unsigned char value) { return value; }
+
+#define HOST_TEST(name)                                                   \
+    static void name();                                                   \
+    static const bool name##Registered = hostRegisterTest(#name, name);   \
+    static void name()
+
+#define HOST_CHECK_IMPL(cond, detail, fatal)                                        \
+    do {                                                                            \
+        if (!(cond)) {                                                              \
+            hostCheckFailed(__FILE__, __LINE__, #cond, detail, fatal);              \
+        }                                                                           \
+    } while (0)
+
+#define CHECK(cond) HOST_CHECK_IMPL(cond, std::string(), false)
+#define REQUIRE(cond) HOST_CHECK_IMPL(cond, std::string(), true)
+
+#define CHECK_EQ(actual, expected)                                                  \
+    do {                                                                            \
+        const auto& hostActual = (actual);                                          \
+        const auto& hostExpected = (expected);                                      \
+        if (!(hostActual == hostExpected)) {                                        \
+            std::ostringstream hostDetail;                                          \
+            hostDetail << "got " << hostPrintable(hostActual)                      \
+                       << ", expected " << hostPrintable(hostExpected);            \
+            hostCheckFailed(__FILE__, __LINE__, #actual " == " #expected,           \
+                            hostDetail.str(), false);                               \
+        }                                                                           \
+    } while (0)
+
+#define CHECK_NEAR(actual, expected, tolerance)                                     \
+    do {                                                                            \
+        const double hostActual = (double)(actual);                                 \
+        const double hostExpected = (double)(expected);                             \
+        if (!(std::fabs(hostActual - hostExpected) <= (double)(tolerance))) {       \
+            std::ostringstream hostDetail;                                          \
+            hostDetail << "got " << hostActual << ", expected " << hostExpected     \
+                       << " +/- " << (tolerance);                                   \
+            hostCheckFailed(__FILE__, __LINE__, #actual " ~ " #expected,            \
+                            hostDetail.str(), false);                               \
+        }                                                                           \
+    } while (0)
@@ -0,0 +1,26 @@
+#pragma once
+
+// The sample camera JPEGs of managed_components/espressif__esp32-camera/test/pictures:
+// test_inside.jpeg (320x240), test_outside.jpeg (480x320) and testimg.jpeg (227x149).
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+// Whole file, or an empty vector when it cannot be read.
+inline std::vector<uint8_t> loadTestPicture(const char* name)
+{
+    const std::string path = std::string(HOST_TEST_PICTURES_DIR) + "/" + name;
+    std::vector<uint8_t> data;
+    FILE* file = fopen(path.c_str(), "rb");
+    if (!file) {
+        return data;
+    }
+    uint8_t chunk[4096];
+    size_t got;
+    while ((got = fread(chunk, 1, sizeof(chunk), file)) > 0) {
+        data.insert(data.end(), chunk, chunk + got);
+    }
+    fclose(file);
+    return data;
+}
@@ -0,0 +1,225 @@
+#include "host-test.h"
+#include "http-server/bitrate-controller.h"
+#include <vector>
+
+namespace {
+
+constexpr int64_t kWindowUs = 1000000;
+constexpr int kSamplesPerWindow = 10;
+
+BitrateControllerConfig controllerConfig()
+{
+    BitrateControllerConfig config;
+    config.targetAgeUs = 300000;
+    config.ageBandPercent = 20;         // hold between 240 and 360 ms
+    config.windowUs = kWindowUs;
+    config.minSamples = 5;
+    config.recoverWindows = 3;
+    config.maxErrorRatio = 0.2f;
+    config.worstQuality = 40;
+    config.qualityDegradeStep = 5;
+    config.qualityRecoverStep = 5;
+    config.minFps = 2.0f;
+    config.unpacedFps = 25.0f;
+    config.fpsDegradeFactor = 0.5f;
+    config.fpsRecoverStep = 2.0f;
+    return config;
+}
+
+// One recorded window: every fresh sample has the same frame age; failed and stale sends come on top.
+struct TraceWindow {
+    int ageMs;
+    int fresh;
+    int failed;
+    int stale;
+};
+
+// Decision expected after the window closes.
+struct Expected {
+    int quality;
+    float fps;
+};
+
+TraceWindow late() { return { 600, kSamplesPerWindow, 0, 0 }; }
+TraceWindow good() { return { 100, kSamplesPerWindow, 0, 0 }; }
+TraceWindow inBand() { return { 300, kSamplesPerWindow, 0, 0 }; }
+
+// Feeds the window's samples spread over [startUs, startUs + windowUs) and evaluates at its end.
+BitrateDecision replayWindow(BitrateController& controller, const TraceWindow& window, int64_t* clockUs)
+{
+    const int total = window.fresh + window.failed + window.stale;
+    const int64_t stepUs = total ? kWindowUs / total : kWindowUs;
+    int64_t nowUs = *clockUs;
+    for (int i = 0; i < total; i++) {
+        BitrateSample sample;
+        sample.nowUs = nowUs;
+        sample.frameAgeUs = window.ageMs * 1000;
+        sample.sendUs = 20000;
+        sample.frameBytes = 6000;
+        sample.failed = i < window.failed;
+        sample.stale = !sample.failed && i < window.failed + window.stale;
+        controller.addSample(sample);
+        nowUs += stepUs;
+    }
+    *clockUs += kWindowUs;
+    BitrateDecision decision = controller.getDecision();
+    CHECK(controller.windowElapsed(*clockUs));
+    controller.evaluate(*clockUs, &decision);
+    return decision;
+}
+
+void replay(BitrateController& controller, const std::vector<TraceWindow>& trace,
+            const std::vector<Expected>& expected, int64_t* clockUs)
+{
+    REQUIRE(trace.size() == expected.size());
+    for (size_t i = 0; i < trace.size(); i++) {
+        const BitrateDecision decision = replayWindow(controller, trace[i], clockUs);
+        CHECK_EQ(decision.jpegQuality, expected[i].quality);
+        CHECK_NEAR(decision.targetFps, expected[i].fps, 1e-4);
+    }
+}
+
+} // namespace
+
+HOST_TEST(degradesQualityFirstThenRateDownToTheBounds)
+{
+    BitrateController controller(controllerConfig());
+    controller.setLimits(15, 10.0f);
+    int64_t clockUs = 0;
+    replay(controller,
+           { late(), late(), late(), late(), late(), late(), late(), late(), late(), late() },
+           { { 20, 10.0f }, { 25, 10.0f }, { 30, 10.0f }, { 35, 10.0f }, { 40, 10.0f },
+             { 40, 5.0f }, { 40, 2.5f }, { 40, 2.0f }, { 40, 2.0f }, { 40, 2.0f } },
+           &clockUs);
+    CHECK(controller.getStats().congested);
+    CHECK_NEAR(controller.getStats().meanAgeMs, 600.0, 1e-3);
+}
+
+HOST_TEST(recoversRateFirstThenQualityAfterRecoverWindows)
+{
+    BitrateController controller(controllerConfig());
+    controller.setLimits(15, 10.0f);
+    int64_t clockUs = 0;
+    std::vector<TraceWindow> congestion(8, late());
+    for (const TraceWindow& window : congestion) {
+        replayWindow(controller, window, &clockUs);
+    }
+    REQUIRE(controller.getDecision().jpegQuality == 40);
+
+    // Each step needs three good windows in a row; a window in the band starts the count again.
+    replay(controller,
+           { good(), good(), inBand(), good(), good(), good(), good(), good(), good() },
+           { { 40, 2.0f }, { 40, 2.0f }, { 40, 2.0f }, { 40, 2.0f }, { 40, 2.0f }, { 40, 4.0f },
+             { 40, 4.0f }, { 40, 4.0f }, { 40, 6.0f } },
+           &clockUs);
+
+    // Rate back to the 10 fps ceiling, then quality back to 15 and no further.
+    std::vector<TraceWindow> recovery(3 * 9, good());
+    std::vector<Expected> expected;
+    const Expected steps[] = { { 40, 8.0f }, { 40, 10.0f }, { 35, 10.0f }, { 30, 10.0f }, { 25, 10.0f },
+                               { 20, 10.0f }, { 15, 10.0f }, { 15, 10.0f }, { 15, 10.0f } };
+    for (const Expected& step : steps) {
+        const Expected hold = expected.empty() ? Expected{ 40, 6.0f } : expected.back();
+        expected.push_back(hold);
+        expected.push_back(hold);
+        expected.push_back(step);
+    }
+    replay(controller, recovery, expected, &clockUs);
+    CHECK(!controller.getStats().congested);
+}
+
+HOST_TEST(sendErrorsDegradeEvenWithGoodAge)
+{
+    BitrateController controller(controllerConfig());
+    controller.setLimits(15, 10.0f);
+    int64_t clockUs = 0;
+    // 2 of 10 failed is at the 0.2 limit, 3 of 10 over it.
+    replay(controller,
+           { { 100, 8, 2, 0 }, { 100, 7, 3, 0 } },
+           { { 15, 10.0f }, { 20, 10.0f } },
+           &clockUs);
+    CHECK_NEAR(controller.getStats().errorRatio, 0.3, 1e-6);
+    CHECK(controller.getStats().congested);
+}
+
+HOST_TEST(tooFewFreshSamplesHold)
+{
+    BitrateController controller(controllerConfig());
+    controller.setLimits(15, 10.0f);
+    int64_t clockUs = 0;
+    // Stale repeats say nothing about the link: 4 fresh samples are below minSamples either way.
+    replay(controller,
+           { { 900, 4, 0, 0 }, { 900, 4, 0, 20 }, { 900, 5, 0, 0 } },
+           { { 15, 10.0f }, { 15, 10.0f }, { 20, 10.0f } },
+           &clockUs);
+    CHECK_EQ(controller.getStats().samples, 5u);
+}
+
+HOST_TEST(windowsOnlyCloseAfterWindowUs)
+{
+    BitrateController controller(controllerConfig());
+    controller.setLimits(15, 10.0f);
+    BitrateDecision decision;
+    CHECK(!controller.windowElapsed(0));
+    CHECK(!controller.evaluate(0, &decision));
+    for (int i = 0; i < kSamplesPerWindow; i++) {
+        BitrateSample sample;
+        sample.nowUs = 5000000 + i * 1000;
+        sample.frameAgeUs = 800000;
+        controller.addSample(sample);
+    }
+    CHECK(!controller.evaluate(5000000 + kWindowUs - 1, &decision));
+    CHECK(controller.evaluate(5000000 + kWindowUs, &decision));
+    CHECK_EQ(decision.jpegQuality, 20);
+}
+
+HOST_TEST(unpacedCeilingReportsZeroAndCutsFromUnpacedFps)
+{
+    BitrateController controller(controllerConfig());
+    controller.setLimits(38, 0.0f);
+    int64_t clockUs = 0;
+    replay(controller,
+           { late(), late(), late(), good(), good(), good(), good(), good(), good() },
+           { { 40, 0.0f }, { 40, 12.5f }, { 40, 6.25f }, { 40, 6.25f }, { 40, 6.25f }, { 40, 8.25f },
+             { 40, 8.25f }, { 40, 8.25f }, { 40, 10.25f } },
+           &clockUs);
+}
+
+HOST_TEST(newLimitsResetTheOperatingPoint)
+{
+    BitrateController controller(controllerConfig());
+    controller.setLimits(15, 10.0f);
+    int64_t clockUs = 0;
+    replayWindow(controller, late(), &clockUs);
+    replayWindow(controller, good(), &clockUs);
+    controller.setLimits(15, 10.0f);        // unchanged limits keep the state
+    CHECK_EQ(controller.getDecision().jpegQuality, 20);
+    controller.setLimits(12, 8.0f);
+    CHECK_EQ(controller.getDecision().jpegQuality, 12);
+    CHECK_NEAR(controller.getDecision().targetFps, 8.0, 1e-6);
+    // The good-window count started before the reset does not carry over.
+    replay(controller, { good(), good() }, { { 12, 8.0f }, { 12, 8.0f } }, &clockUs);
+}
+
+HOST_TEST(sameTraceReplaysToTheSameDecisions)
+{
+    std::vector<TraceWindow> trace;
+    for (int i = 0; i < 60; i++) {
+        const int phase = (i * 7) % 11;
+        trace.push_back({ 150 + phase * 60, 3 + phase, phase % 4, phase % 3 });
+    }
+    BitrateController first(controllerConfig());
+    BitrateController second(controllerConfig());
+    first.setLimits(15, 12.0f);
+    second.setLimits(15, 12.0f);
+    int64_t firstClockUs = 0;
+    int64_t secondClockUs = 0;
+    for (const TraceWindow& window : trace) {
+        const BitrateDecision a = replayWindow(first, window, &firstClockUs);
+        const BitrateDecision b = replayWindow(second, window, &secondClockUs);
+        CHECK_EQ(a.jpegQuality, b.jpegQuality);
+        CHECK_EQ(a.targetFps, b.targetFps);
+        CHECK(a.jpegQuality >= 15 && a.jpegQuality <= 40);
+        CHECK(a.targetFps >= 2.0f && a.targetFps <= 12.0f);
+    }
+}
@@ -0,0 +1,222 @@
+#include "host-test.h"
+#include "camera-driver/capture-pacer.h"
+#include <cmath>
+
+namespace {
+
+class FakeClock : public PacerClock
+{
+public:
+    int64_t nowUs() const override { return nowUs_; }
+    void advance(int64_t us) { nowUs_ += us; }
+    void set(int64_t us) { nowUs_ = us; }
+
+private:
+    int64_t nowUs_ = 1000000;
+};
+
+constexpr int64_t kCaptureLatencyUs = 5000;
+
+CapturePacerConfig pacerConfig(float targetFps)
+{
+    CapturePacerConfig config;
+    config.targetFps = targetFps;
+    config.maxIntervalUs = 400000;
+    config.maxStreamLag = 2;
+    config.maxInferenceLag = 3;
+    config.maxHeldFrames = 4;
+    return config;
+}
+
+CaptureBacklog congested()
+{
+    CaptureBacklog backlog;
+    backlog.streamLag = 3;
+    return backlog;
+}
+
+// One capture_task iteration: report the frame, wait as told, then spend the capture latency.
+int64_t captureFrame(CapturePacer& pacer, FakeClock& clock, const CaptureBacklog& backlog)
+{
+    const int64_t waitUs = pacer.onFrameCaptured(backlog);
+    clock.advance(waitUs + kCaptureLatencyUs);
+    return waitUs;
+}
+
+} // namespace
+
+HOST_TEST(deadlinesFollowAFixedGrid)
+{
+    FakeClock clock;
+    CapturePacer pacer(&clock, pacerConfig(10.0f));
+    const int64_t startUs = clock.nowUs();
+
+    CHECK_EQ(captureFrame(pacer, clock, CaptureBacklog()), 100000);
+    // The capture latency comes out of the next wait instead of stretching the period.
+    for (int frame = 1; frame <= 20; frame++) {
+        CHECK_EQ(clock.nowUs(), startUs + frame * 100000 + kCaptureLatencyUs);
+        CHECK_EQ(captureFrame(pacer, clock, CaptureBacklog()), 100000 - kCaptureLatencyUs);
+    }
+}
+
+HOST_TEST(stallRestartsTheGridInsteadOfBursting)
+{
+    FakeClock clock;
+    CapturePacer pacer(&clock, pacerConfig(10.0f));
+    captureFrame(pacer, clock, CaptureBacklog());
+    captureFrame(pacer, clock, CaptureBacklog());
+
+    clock.advance(350000);
+    CHECK_EQ(pacer.onFrameCaptured(CaptureBacklog()), 0);
+    // Next deadline is one period after the late frame, not one of the missed grid points.
+    CHECK_EQ(pacer.onFrameCaptured(CaptureBacklog()), 100000);
+}
+
+HOST_TEST(backlogBacksOffToTheCeilingAndDecaysToTheTarget)
+{
+    FakeClock clock;
+    CapturePacer pacer(&clock, pacerConfig(10.0f));
+    CapturePacerStats stats;
+
+    const int64_t expectedBackoff[] = { 125000, 156250, 195312, 244140, 305175, 381468, 400000, 400000 };
+    for (int64_t intervalUs : expectedBackoff) {
+        captureFrame(pacer, clock, congested());
+        REQUIRE(pacer.pollStats(0, &stats));
+        CHECK_EQ(stats.currentIntervalUs, intervalUs);
+        CHECK_EQ(stats.congestedFrames, 1u);
+    }
+
+    // Each uncongested frame removes a quarter of the excess, snapping to the target within 1 ms.
+    int64_t intervalUs = 400000;
+    int frames = 0;
+    while (intervalUs > 100000) {
+        captureFrame(pacer, clock, CaptureBacklog());
+        REQUIRE(pacer.pollStats(0, &stats));
+        const int64_t expected = 100000 + ((intervalUs - 100000) * 3) / 4;
+        intervalUs = (expected - 100000 < 1000) ? 100000 : expected;
+        CHECK_EQ(stats.currentIntervalUs, intervalUs);
+        CHECK_EQ(stats.congestedFrames, 0u);
+        frames++;
+    }
+    CHECK_EQ(frames, 20);
+}
+
+HOST_TEST(freeRunningCaptureBacksOffFromTheMinimumStep)
+{
+    FakeClock clock;
+    CapturePacer pacer(&clock, pacerConfig(0.0f));
+    CHECK_EQ(pacer.onFrameCaptured(CaptureBacklog()), 0);
+    CHECK_EQ(pacer.onFrameCaptured(congested()), 12500);
+    clock.advance(20000);
+    // 15.625 ms interval on the grid started 20 ms ago.
+    CHECK_EQ(pacer.onFrameCaptured(congested()), 12500 + 15625 - 20000);
+    for (int i = 0; i < 16; i++) {
+        clock.advance(20000);
+        pacer.onFrameCaptured(CaptureBacklog());
+    }
+    CHECK_EQ(pacer.onFrameCaptured(CaptureBacklog()), 0);
+}
+
+HOST_TEST(eachLimitTriggersCongestionAndZeroDisablesIt)
+{
+    FakeClock clock;
+    CapturePacer pacer(&clock, pacerConfig(0.0f));
+    CapturePacerStats stats;
+
+    CaptureBacklog atLimits;
+    atLimits.streamLag = 2;
+    atLimits.inferenceLag = 3;
+    atLimits.heldFrames = 4;
+    CHECK_EQ(pacer.onFrameCaptured(atLimits), 0);
+
+    CaptureBacklog inference;
+    inference.inferenceLag = 4;
+    CaptureBacklog held;
+    held.heldFrames = 5;
+    CHECK(pacer.onFrameCaptured(inference) > 0);
+    CHECK(pacer.onFrameCaptured(held) > 0);
+    REQUIRE(pacer.pollStats(0, &stats));
+    CHECK_EQ(stats.congestedFrames, 2u);
+
+    pacer.setMaxHeldFrames(0);
+    CaptureBacklog manyHeld;
+    manyHeld.heldFrames = 100;
+    pacer.onFrameCaptured(manyHeld);
+    REQUIRE(pacer.pollStats(0, &stats));
+    CHECK_EQ(stats.congestedFrames, 0u);
+}
+
+// The firmware's limits with CAMERA_FB_COUNT 3 and inference not pacing capture. In steady state the HTTP
+// store and the mailboxes reference the newest frame and inference runs on an older one: two buffers held,
+// one left for the DMA. That is normal operation; only the stream sender holding the third congests.
+HOST_TEST(steadyStateReadersDoNotCongestCapture)
+{
+    constexpr uint32_t kFbCount = 3;
+    FakeClock clock;
+    CapturePacerConfig config;
+    config.targetFps = 20.0f;
+    config.maxIntervalUs = 250000;
+    config.maxStreamLag = 2;
+    config.maxHeldFrames = kFbCount - 1;
+    CapturePacer pacer(&clock, config);
+
+    CaptureBacklog steady;
+    steady.heldFrames = 2;              // HTTP frame store + inference front slot
+    for (int frame = 0; frame < 100; frame++) {
+        steady.inferenceLag = (uint32_t)(frame % 8);     // Invoke() is slower than capture
+        // The grid starts at the first frame; after that each wait is the interval minus the capture latency.
+        CHECK_EQ(captureFrame(pacer, clock, steady), frame == 0 ? 50000 : 50000 - kCaptureLatencyUs);
+    }
+    CapturePacerStats stats;
+    REQUIRE(pacer.pollStats(0, &stats));
+    CHECK_EQ(stats.congestedFrames, 0u);
+    CHECK_EQ(stats.currentIntervalUs, (int64_t)50000);
+
+    CaptureBacklog allHeld = steady;
+    allHeld.heldFrames = kFbCount;
+    CHECK(captureFrame(pacer, clock, allHeld) > 50000 - kCaptureLatencyUs);
+    REQUIRE(pacer.pollStats(0, &stats));
+    CHECK_EQ(stats.congestedFrames, 1u);
+}
+
+HOST_TEST(statsReportRateMeanAndJitterPerWindow)
+{
+    FakeClock clock;
+    CapturePacer pacer(&clock, pacerConfig(0.0f));
+    CapturePacerStats stats;
+    CHECK(!pacer.pollStats(0, &stats));     // no frame yet, no window
+
+    // 21 frames, intervals alternating 90 and 110 ms: mean 100 ms, sample deviation sqrt(20/19) * 10 ms.
+    const int64_t startUs = clock.nowUs();
+    for (int frame = 0; frame <= 20; frame++) {
+        pacer.onFrameCaptured(CaptureBacklog());
+        clock.advance((frame % 2) ? 110000 : 90000);
+    }
+    clock.set(startUs + 2000000 - 1);
+    CHECK(!pacer.pollStats(2000000, &stats));
+    clock.set(startUs + 2000000);
+    REQUIRE(pacer.pollStats(2000000, &stats));
+    CHECK_EQ(stats.frames, 21u);
+    CHECK_NEAR(stats.achievedFps, 10.5, 1e-3);
+    CHECK_NEAR(stats.meanIntervalUs, 100000.0, 1e-3);
+    CHECK_NEAR(stats.jitterUs, 10000.0 * std::sqrt(20.0 / 19.0), 0.5);
+
+    // The next window starts empty.
+    clock.advance(1000000);
+    REQUIRE(pacer.pollStats(1000000, &stats));
+    CHECK_EQ(stats.frames, 0u);
+    CHECK_NEAR(stats.jitterUs, 0.0, 1e-9);
+}
+
+HOST_TEST(retargetingRestartsTheGrid)
+{
+    FakeClock clock;
+    CapturePacer pacer(&clock, pacerConfig(10.0f));
+    captureFrame(pacer, clock, CaptureBacklog());
+    pacer.setTargetFps(20.0f);
+    CHECK_NEAR(pacer.getTargetFps(), 20.0, 1e-6);
+    CHECK_EQ(pacer.onFrameCaptured(CaptureBacklog()), 50000);
+    pacer.setTargetFps(-1.0f);
+    CHECK_NEAR(pacer.getTargetFps(), 0.0, 1e-6);
+    CHECK_EQ(pacer.onFrameCaptured(CaptureBacklog()), 0);
+}
@@ -0,0 +1,255 @@
+#include "host-test.h"
+#include "detection-scheduler/detection-scheduler.h"
+#include "define.h"
+#include <vector>
+
+namespace {
+
+constexpr int64_t kFrameUs = 100000;    // 10 fps camera
+constexpr int64_t kFirstBackoffUs = (int64_t)DETECTION_BACKOFF_FIRST_MS * 1000;
+constexpr int64_t kMaxIntervalUs = (int64_t)DETECTION_BACKOFF_MAX_MS * 1000;
+
+DetectionSchedulerConfig firmwareConfig()
+{
+    DetectionSchedulerConfig config;
+    config.emaAlpha = DETECTION_EMA_ALPHA;
+    config.enterThreshold = DETECTION_ENTER_THRESHOLD;
+    config.exitThreshold = DETECTION_EXIT_THRESHOLD;
+    config.settledMargin = DETECTION_SETTLED_MARGIN;
+    config.settleInferences = DETECTION_SETTLE_INFERENCES;
+    config.firstBackoffUs = kFirstBackoffUs;
+    config.maxIntervalUs = kMaxIntervalUs;
+    return config;
+}
+
+// Person confidences as inference_task logged them, one per frame at 10 fps.
+// Empty hallway, someone walks through the frame, empty again.
+const std::vector<float> kWalkThrough = {
+    0.06f, 0.04f, 0.09f, 0.05f, 0.07f, 0.12f, 0.31f, 0.58f, 0.71f, 0.83f,
+    0.88f, 0.64f, 0.52f, 0.79f, 0.86f, 0.91f, 0.57f, 0.49f, 0.62f, 0.44f,
+    0.22f, 0.09f, 0.05f, 0.06f, 0.04f, 0.05f,
+};
+// A coat on a chair the model scores right around DETECTION_THRESHOLD.
+const std::vector<float> kHovering = {
+    0.55f, 0.63f, 0.52f, 0.61f, 0.53f, 0.63f, 0.52f, 0.62f, 0.54f, 0.63f,
+    0.52f, 0.61f, 0.55f, 0.63f, 0.52f, 0.62f,
+};
+
+struct Replay {
+    std::vector<bool> ran;          // per frame: Invoke() would have run
+    std::vector<bool> present;      // per frame: state after the frame
+    std::vector<int64_t> intervals; // per inference: interval the update returned
+    uint32_t transitions = 0;
+    int64_t endUs = 0;
+};
+
+// Offers one frame per kFrameUs; frames that run feed the next confidence of the trace, which repeats
+// when frames outlasts it.
+Replay replay(DetectionScheduler& scheduler, const std::vector<float>& trace, size_t frames, int64_t startUs = 0,
+              const std::vector<size_t>& motionFrames = {})
+{
+    Replay result;
+    size_t next = 0;
+    for (size_t frame = 0; frame < frames; frame++) {
+        const int64_t nowUs = startUs + (int64_t)frame * kFrameUs;
+        bool motion = false;
+        for (size_t motionFrame : motionFrames) {
+            motion = motion || motionFrame == frame;
+        }
+        const bool run = scheduler.shouldRun(nowUs, motion);
+        result.ran.push_back(run);
+        if (run) {
+            const DetectionUpdate update = scheduler.update(trace[next % trace.size()], nowUs);
+            next++;
+            result.intervals.push_back(update.intervalUs);
+            result.transitions += update.changed ? 1 : 0;
+        }
+        result.present.push_back(scheduler.present());
+        result.endUs = nowUs + kFrameUs;
+    }
+    return result;
+}
+
+// LED toggles of the previous single-threshold decision (DETECTION_THRESHOLD in tf-lite.h, the same 0.6).
+uint32_t rawThresholdToggles(const std::vector<float>& trace)
+{
+    uint32_t toggles = 0;
+    bool on = false;
+    for (float confidence : trace) {
+        const bool now = confidence > DETECTION_ENTER_THRESHOLD;
+        toggles += now != on ? 1 : 0;
+        on = now;
+    }
+    return toggles;
+}
+
+} // namespace
+
+HOST_TEST(walkThroughTogglesOnceEachWay)
+{
+    DetectionSchedulerConfig config = firmwareConfig();
+    config.firstBackoffUs = 0;   // every frame, so each recorded confidence is used once
+    DetectionScheduler scheduler(config);
+    const Replay result = replay(scheduler, kWalkThrough, kWalkThrough.size());
+
+    // The raw threshold flickers through the dips at frames 11-12, 16-17 and 19; hysteresis does not.
+    CHECK(rawThresholdToggles(kWalkThrough) > 2);
+    CHECK_EQ(result.transitions, 2u);
+    // Enters once the smoothed score passes 0.6 (frame 9: 0.55 -> 0.69), leaves below 0.4 (frame 20:
+    // 0.525 -> 0.372).
+    CHECK(!result.present[8]);
+    CHECK(result.present[9]);
+    CHECK(result.present[19]);
+    CHECK(!result.present[20]);
+}
+
+HOST_TEST(hoveringAtTheThresholdNeverEntersOrBacksOff)
+{
+    // The raw score crosses 0.6 on every other frame; the smoothed one stays between 0.55 and 0.6.
+    CHECK(rawThresholdToggles(kHovering) > 10);
+    DetectionScheduler scheduler(firmwareConfig());
+    const Replay result = replay(scheduler, kHovering, kHovering.size());
+    CHECK_EQ(result.transitions, 0u);
+    for (size_t i = 0; i < result.ran.size(); i++) {
+        CHECK(result.ran[i]);   // near the threshold: every frame is inferred
+    }
+    for (int64_t interval : result.intervals) {
+        CHECK_EQ(interval, 0);
+    }
+}
+
+HOST_TEST(singleSpikeDoesNotEnter)
+{
+    DetectionScheduler scheduler(firmwareConfig());
+    for (float confidence : { 0.1f, 0.1f, 0.95f, 0.1f, 0.1f }) {
+        CHECK(!scheduler.update(confidence, 0).present);
+    }
+}
+
+HOST_TEST(backoffDoublesUpToTheCap)
+{
+    DetectionScheduler scheduler(firmwareConfig());
+    std::vector<int64_t> intervals;
+    for (int i = 0; i < 8; i++) {
+        intervals.push_back(scheduler.update(0.05f, (int64_t)i * kFrameUs).intervalUs);
+    }
+    const std::vector<int64_t> expected = {
+        0, 0, kFirstBackoffUs, 2 * kFirstBackoffUs, 4 * kFirstBackoffUs, kMaxIntervalUs, kMaxIntervalUs, kMaxIntervalUs,
+    };
+    CHECK(intervals == expected);
+}
+
+HOST_TEST(framesInsideTheIntervalAreSkipped)
+{
+    DetectionScheduler scheduler(firmwareConfig());
+    const std::vector<float> empty = { 0.05f };
+    const Replay result = replay(scheduler, empty, 60);
+    // Frames 0-2 settle, then 250 ms (run at 5), 500 ms (10), 1 s (20), 2 s (40), 2 s (no more before 60).
+    std::vector<size_t> runs;
+    for (size_t i = 0; i < result.ran.size(); i++) {
+        if (result.ran[i]) {
+            runs.push_back(i);
+        }
+    }
+    const std::vector<size_t> expected = { 0, 1, 2, 5, 10, 20, 40 };
+    CHECK(runs == expected);
+}
+
+HOST_TEST(nearThresholdResultRestoresEveryFrame)
+{
+    DetectionScheduler scheduler(firmwareConfig());
+    int64_t nowUs = 0;
+    for (int i = 0; i < 6; i++, nowUs += kFrameUs) {
+        scheduler.update(0.05f, nowUs);
+    }
+    // 0.05 -> 0.55 smoothed 0.30: 0.3 below the enter threshold, still settled.
+    CHECK(scheduler.update(0.55f, nowUs).intervalUs > 0);
+    // 0.30 -> 0.55 smoothed 0.425: inside the margin, so every frame again.
+    const DetectionUpdate update = scheduler.update(0.55f, nowUs + kFrameUs);
+    CHECK(!update.present);
+    CHECK_EQ(update.intervalUs, 0);
+    CHECK(scheduler.shouldRun(nowUs + 2 * kFrameUs, false));
+}
+
+HOST_TEST(stateChangeRestoresEveryFrame)
+{
+    DetectionScheduler scheduler(firmwareConfig());
+    int64_t nowUs = 0;
+    for (int i = 0; i < 6; i++, nowUs += kFrameUs) {
+        scheduler.update(0.95f, nowUs);
+    }
+    CHECK(scheduler.present());
+    CHECK(scheduler.update(0.95f, nowUs).intervalUs > 0);
+    scheduler.update(0.1f, nowUs += kFrameUs);      // 0.525: inside the exit margin
+    const DetectionUpdate left = scheduler.update(0.05f, nowUs += kFrameUs);
+    CHECK(left.changed);
+    CHECK(!left.present);
+    CHECK_EQ(left.intervalUs, 0);
+}
+
+HOST_TEST(motionEndsTheBackoff)
+{
+    DetectionScheduler scheduler(firmwareConfig());
+    const std::vector<float> empty = { 0.05f };
+    // Backed off to 2 s by frame 40; motion at frame 45 runs that frame, then every frame until the
+    // three confident results back it off from 250 ms again.
+    const Replay result = replay(scheduler, empty, 60, 0, { 45 });
+    CHECK(!result.ran[44]);
+    CHECK(result.ran[45]);
+    CHECK(result.ran[46]);
+    CHECK(result.ran[47]);
+    CHECK(!result.ran[48]);
+    CHECK(result.ran[50]);  // 250 ms after frame 47
+
+    DetectionSchedulerStats stats;
+    scheduler.takeStats(&stats, result.endUs);
+    CHECK_EQ(stats.motionWakeups, 1u);
+}
+
+HOST_TEST(motionOnADueFrameIsNotAWakeup)
+{
+    DetectionScheduler scheduler(firmwareConfig());
+    CHECK(scheduler.shouldRun(0, true));
+    DetectionSchedulerStats stats;
+    scheduler.takeStats(&stats, kFrameUs);
+    CHECK_EQ(stats.motionWakeups, 0u);
+    CHECK_EQ(stats.skipped, 0u);
+}
+
+HOST_TEST(savedPerMinuteScalesTheSkippedFrames)
+{
+    DetectionScheduler scheduler(firmwareConfig());
+    const std::vector<float> empty = { 0.05f };
+    // One minute of an empty room at 10 fps.
+    const Replay result = replay(scheduler, empty, 600);
+    DetectionSchedulerStats stats;
+    scheduler.takeStats(&stats, result.endUs);
+    CHECK_EQ(stats.frames, 600u);
+    CHECK_EQ(stats.inferences + stats.skipped, 600u);
+    // 0, 1, 2, 5, 10, 20, then every 20 frames from 40 to 580: 6 + 28 inferences.
+    CHECK_EQ(stats.inferences, 34u);
+    CHECK_NEAR(stats.savedPerMinute, 566.0, 0.01);
+    CHECK(!stats.present);
+    CHECK_EQ(stats.intervalUs, kMaxIntervalUs);
+
+    // The next window starts at takeStats(): half a minute with the same skip rate saves the same per minute.
+    const Replay next = replay(scheduler, empty, 300, result.endUs);
+    scheduler.takeStats(&stats, next.endUs);
+    CHECK_EQ(stats.frames, 300u);
+    CHECK_EQ(stats.inferences, 15u);
+    CHECK_NEAR(stats.savedPerMinute, 2.0 * 285.0, 0.01);
+}
+
+HOST_TEST(withoutBackoffNothingIsSaved)
+{
+    DetectionSchedulerConfig config = firmwareConfig();
+    config.firstBackoffUs = 0;
+    DetectionScheduler scheduler(config);
+    const std::vector<float> empty = { 0.05f };
+    const Replay result = replay(scheduler, empty, 100);
+    DetectionSchedulerStats stats;
+    scheduler.takeStats(&stats, result.endUs);
+    CHECK_EQ(stats.inferences, 100u);
+    CHECK_EQ(stats.skipped, 0u);
+    CHECK_EQ(stats.savedPerMinute, 0.0f);
+}
@@ -0,0 +1,178 @@
+#include "host-test.h"
+#include "fake-camera.h"
+#include "data-types/frame-handle.h"
+#include <thread>
+#include <utility>
+#include <vector>
+
+HOST_TEST(lendWrapsTheDriverBufferWithoutCopying)
+{
+    FakeCamera camera(2, 64);
+    size_t index = 99;
+    FrameHandle handle = camera.capture(1, &index);
+    REQUIRE(handle.isValid());
+    CHECK_EQ(index, 0u);
+    CHECK(handle.data() == camera.bufferData(0));
+    CHECK_EQ(handle.len(), 64u);
+    CHECK_EQ(handle.useCount(), 1u);
+    CHECK_EQ(camera.lender().getLentCount(), 1u);
+    CHECK(FakeCamera::matches(handle.data(), handle.len(), 1));
+
+    handle.reset();
+    CHECK(!handle.isValid());
+    CHECK(handle.data() == nullptr);
+    CHECK_EQ(camera.returnCount(0), 1u);
+    CHECK_EQ(camera.lender().getLentCount(), 0u);
+}
+
+HOST_TEST(lendRejectsEmptyPayloads)
+{
+    FrameLender lender(nullptr, nullptr);
+    uint8_t byte = 0;
+    CHECK(!lender.lend(&byte, nullptr, 4).isValid());
+    CHECK(!lender.lend(&byte, &byte, 0).isValid());
+    CHECK_EQ(lender.getLentCount(), 0u);
+}
+
+HOST_TEST(everyReaderRetainsTheFrameUntilTheLastDrops)
+{
+    FakeCamera camera(1, 32);
+    FrameHandle capture = camera.capture(7);
+    REQUIRE(capture.isValid());
+
+    // capture_task publishes to the stream mailbox, the inference mailbox and the clip ring.
+    FrameHandle stream = capture;
+    FrameHandle inference = capture;
+    FrameHandle clip(stream);
+    CHECK_EQ(capture.useCount(), 4u);
+    CHECK(stream.data() == capture.data() && clip.data() == capture.data());
+
+    capture.reset();
+    stream.reset();
+    inference.reset();
+    CHECK_EQ(camera.returnCount(0), 0u);
+    CHECK_EQ(clip.useCount(), 1u);
+    CHECK(FakeCamera::matches(clip.data(), clip.len(), 7));
+
+    clip.reset();
+    CHECK_EQ(camera.returnCount(0), 1u);
+    CHECK_EQ(camera.heldBuffers(), 0u);
+}
+
+HOST_TEST(framesReleasedOutOfOrderGoBackIndividually)
+{
+    FakeCamera camera(3, 16);
+    size_t a = 0, b = 0, c = 0;
+    FrameHandle frameA = camera.capture(1, &a);
+    FrameHandle frameB = camera.capture(2, &b);
+    FrameHandle frameC = camera.capture(3, &c);
+    REQUIRE(frameA.isValid() && frameB.isValid() && frameC.isValid());
+    FrameHandle slowReaderOfA = frameA;
+
+    frameB.reset();
+    CHECK_EQ(camera.returnCount(b), 1u);
+    CHECK_EQ(camera.returnCount(a), 0u);
+    CHECK_EQ(camera.returnCount(c), 0u);
+
+    // The freed buffer is reused while A and C are still out.
+    size_t d = 0;
+    FrameHandle frameD = camera.capture(4, &d);
+    REQUIRE(frameD.isValid());
+    CHECK_EQ(d, b);
+    CHECK(FakeCamera::matches(slowReaderOfA.data(), slowReaderOfA.len(), 1));
+
+    frameC.reset();
+    frameA.reset();
+    CHECK_EQ(camera.returnCount(c), 1u);
+    CHECK_EQ(camera.returnCount(a), 0u);
+    slowReaderOfA.reset();
+    frameD.reset();
+    CHECK_EQ(camera.returnCount(a), 1u);
+    CHECK_EQ(camera.returnCount(b), 2u);
+    CHECK_EQ(camera.totalReturns(), 4u);
+}
+
+HOST_TEST(releaseCallbackRunsExactlyOnce)
+{
+    FakeCamera camera(1, 8);
+    FrameHandle handle = camera.capture(1);
+    REQUIRE(handle.isValid());
+
+    FrameHandle moved(std::move(handle));
+    CHECK(!handle.isValid());
+    handle.reset();
+    CHECK_EQ(camera.returnCount(0), 0u);
+
+    FrameHandle assigned;
+    assigned = moved;
+    assigned = assigned;            // self-assignment keeps the reference
+    FrameHandle& alias = moved;
+    moved = std::move(alias);       // self-move as well
+    CHECK_EQ(assigned.useCount(), 2u);
+
+    moved.reset();
+    moved.reset();
+    CHECK_EQ(camera.returnCount(0), 0u);
+    assigned = FrameHandle();
+    CHECK_EQ(camera.returnCount(0), 1u);
+    assigned.reset();
+    CHECK_EQ(camera.returnCount(0), 1u);
+}
+
+HOST_TEST(lenderRunsOutOfSlotsAndRecovers)
+{
+    FakeCamera camera(FRAME_LENDER_SLOTS + 1, 8);
+    std::vector<FrameHandle> held;
+    for (uint32_t seq = 0; seq < FRAME_LENDER_SLOTS; seq++) {
+        held.push_back(camera.capture(seq));
+        CHECK(held.back().isValid());
+    }
+    CHECK_EQ(camera.lender().getLentCount(), (size_t)FRAME_LENDER_SLOTS);
+
+    // No slot: the buffer goes straight back to the driver and the caller gets nothing.
+    FrameHandle overflow = camera.capture(100);
+    CHECK(!overflow.isValid());
+    CHECK_EQ(camera.heldBuffers(), (size_t)FRAME_LENDER_SLOTS);
+
+    held.front().reset();
+    FrameHandle again = camera.capture(101);
+    CHECK(again.isValid());
+    CHECK(FakeCamera::matches(again.data(), again.len(), 101));
+}
+
+HOST_TEST(concurrentReadersReturnEachFrameOnce)
+{
+    constexpr int kFrames = 2000;
+    constexpr int kReaders = 3;
+    FakeCamera camera(FRAME_LENDER_SLOTS, 128);
+    bool corrupt = false;
+    int lent = 0;
+
+    for (int seq = 0; seq < kFrames; seq++) {
+        FrameHandle frame = camera.capture((uint32_t)seq);
+        if (!frame.isValid()) {
+            continue;
+        }
+        lent++;
+        std::vector<std::thread> readers;
+        uint8_t ok[kReaders] = {};
+        for (int r = 0; r < kReaders; r++) {
+            readers.emplace_back([copy = frame, seq, r, &ok]() mutable {
+                FrameHandle local = copy;
+                copy.reset();
+                ok[r] = FakeCamera::matches(local.data(), local.len(), (uint32_t)seq);
+            });
+        }
+        frame.reset();
+        for (std::thread& reader : readers) {
+            reader.join();
+        }
+        for (uint8_t readerOk : ok) {
+            corrupt = corrupt || !readerOk;
+        }
+    }
+    CHECK(!corrupt);
+    CHECK_EQ(camera.totalReturns(), (uint32_t)lent);
+    CHECK_EQ(camera.heldBuffers(), 0u);
+    CHECK_EQ(camera.lender().getLentCount(), 0u);
+}
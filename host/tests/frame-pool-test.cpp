@@ -0,0 +1,86 @@
+#include "host-test.h"
+#include "data-types/frame-pool.h"
+#include <cstring>
+#include <vector>
+
+namespace {
+
+// The same three classes in ascending order, reversed, and with the largest in the middle.
+const FramePoolClassConfig kAscending[] = { { 1024, 2 }, { 4096, 2 }, { 16384, 1 } };
+const FramePoolClassConfig kDescending[] = { { 16384, 1 }, { 4096, 2 }, { 1024, 2 } };
+const FramePoolClassConfig kShuffled[] = { { 4096, 2 }, { 16384, 1 }, { 1024, 2 } };
+
+size_t blockSizeOf(const FramePool& pool, size_t classIndex)
+{
+    FramePoolClassStats stats;
+    REQUIRE(pool.getClassStats(classIndex, &stats));
+    return stats.blockSize;
+}
+
+} // namespace
+
+HOST_TEST(classesAreOrderedBySizeWhateverTheTableOrder)
+{
+    for (const FramePoolClassConfig* classes : { kAscending, kDescending, kShuffled }) {
+        FramePool pool(classes, 3, FramePoolOversizePolicy::Reject);
+        REQUIRE(pool.init(PlacedBuffer::FramePoolSlabs));
+        CHECK_EQ(pool.getMaxBlockSize(), (size_t)16384);
+        CHECK_EQ(blockSizeOf(pool, 0), (size_t)1024);
+        CHECK_EQ(blockSizeOf(pool, 1), (size_t)4096);
+        CHECK_EQ(blockSizeOf(pool, 2), (size_t)16384);
+        FramePoolClassStats stats;
+        REQUIRE(pool.getClassStats(1, &stats));
+        CHECK_EQ(stats.blockCount, (size_t)2);
+        CHECK_EQ(pool.getReservedBytes(), (size_t)(2 * 1024 + 2 * 4096 + 16384));
+    }
+}
+
+HOST_TEST(unsortedClassesStillPickTheSmallestFittingBlock)
+{
+    FramePool pool(kShuffled, 3, FramePoolOversizePolicy::Reject);
+    REQUIRE(pool.init(PlacedBuffer::FramePoolSlabs));
+    uint8_t* writable = nullptr;
+    size_t granted = 0;
+
+    FrameHandle small = pool.allocate(500, &writable, &granted);
+    CHECK(small.isValid());
+    CHECK_EQ(granted, (size_t)500);
+    FrameHandle medium = pool.allocate(3000, &writable, &granted);
+    CHECK(medium.isValid());
+    // A frame only the largest class fits is not rejected as oversize.
+    FrameHandle large = pool.allocate(10000, &writable, &granted);
+    CHECK(large.isValid());
+    CHECK_EQ(granted, (size_t)10000);
+    CHECK_EQ(pool.getOversizeCount(), 0u);
+
+    FramePoolClassStats stats;
+    for (size_t i = 0; i < pool.getClassCount(); i++) {
+        REQUIRE(pool.getClassStats(i, &stats));
+        CHECK_EQ(stats.inUse, 1u);
+        CHECK_EQ(stats.exhausted, 0u);
+    }
+    CHECK(!pool.allocate(20000, &writable, &granted).isValid());
+    CHECK_EQ(pool.getOversizeCount(), 1u);
+}
+
+HOST_TEST(truncateCutsOnlyAboveTheLargestClass)
+{
+    FramePool pool(kDescending, 3, FramePoolOversizePolicy::Truncate);
+    REQUIRE(pool.init(PlacedBuffer::FramePoolSlabs));
+    std::vector<uint8_t> payload(20000);
+    for (size_t i = 0; i < payload.size(); i++) {
+        payload[i] = (uint8_t)(i * 13);
+    }
+
+    FrameHandle fits = pool.copyFrom(payload.data(), 12000);
+    REQUIRE(fits.isValid());
+    CHECK_EQ(fits.len(), (size_t)12000);
+    CHECK(memcmp(fits.data(), payload.data(), 12000) == 0);
+    fits = FrameHandle();
+
+    FrameHandle cut = pool.copyFrom(payload.data(), payload.size());
+    REQUIRE(cut.isValid());
+    CHECK_EQ(cut.len(), (size_t)16384);
+    CHECK(memcmp(cut.data(), payload.data(), 16384) == 0);
+    CHECK_EQ(pool.getOversizeCount(), 1u);
+}
@@ -0,0 +1,287 @@
+#include "host-test.h"
+#include "test-pictures.h"
+#include "image-editing/gray-resample.h"
+#include "image-editing/jpeg-gray-crop.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <random>
+#include <vector>
+
+namespace {
+
+struct Image {
+    std::vector<uint8_t> pixels;
+    int width = 0;
+    int height = 0;
+
+    uint8_t at(int x, int y) const { return pixels[(size_t)y * width + x]; }
+};
+
+Image randomImage(int width, int height, uint32_t seed)
+{
+    std::mt19937 rng(seed);
+    Image image;
+    image.width = width;
+    image.height = height;
+    image.pixels.resize((size_t)width * height);
+    for (uint8_t& pixel : image.pixels) {
+        pixel = (uint8_t)rng();
+    }
+    return image;
+}
+
+// Smooth content (a product of sines) where bilinear filtering has something meaningful to interpolate.
+Image smoothImage(int width, int height)
+{
+    Image image;
+    image.width = width;
+    image.height = height;
+    image.pixels.resize((size_t)width * height);
+    for (int y = 0; y < height; y++) {
+        for (int x = 0; x < width; x++) {
+            const double value = 128.0 + 120.0 * std::sin(x * 0.07) * std::cos(y * 0.05);
+            image.pixels[(size_t)y * width + x] = (uint8_t)std::lround(value);
+        }
+    }
+    return image;
+}
+
+// Double-precision bilinear with the same pixel-center alignment and edge clamping.
+double referenceBilinear(const Image& src, int dstWidth, int dstHeight, int x, int y)
+{
+    auto source = [](int i, int srcLen, int dstLen) {
+        return std::clamp((i + 0.5) * srcLen / dstLen - 0.5, 0.0, (double)(srcLen - 1));
+    };
+    const double sx = source(x, src.width, dstWidth);
+    const double sy = source(y, src.height, dstHeight);
+    const int x0 = (int)sx;
+    const int y0 = (int)sy;
+    const int x1 = std::min(x0 + 1, src.width - 1);
+    const int y1 = std::min(y0 + 1, src.height - 1);
+    const double fx = sx - x0;
+    const double fy = sy - y0;
+    const double top = src.at(x0, y0) * (1 - fx) + src.at(x1, y0) * fx;
+    const double bottom = src.at(x0, y1) * (1 - fx) + src.at(x1, y1) * fx;
+    return top * (1 - fy) + bottom * fy;
+}
+
+std::vector<uint8_t> resize(const Image& src, int dstWidth, int dstHeight)
+{
+    std::vector<uint8_t> scratch(grayResizeScratchBytes(src.width, dstWidth));
+    std::vector<uint8_t> dst((size_t)dstWidth * dstHeight);
+    resizeGrayBilinear(src.pixels.data(), src.width, src.height, dst.data(), dstWidth, dstHeight, scratch.data());
+    return dst;
+}
+
+// Feeds src to a GrayBilinearRowResizer in stripes of stripeRows rows.
+std::vector<uint8_t> resizeInStripes(const Image& src, int dstWidth, int dstHeight, int stripeRows,
+                                     const uint8_t* lut = nullptr)
+{
+    std::vector<uint8_t> scratch(GrayBilinearRowResizer::scratchBytes(src.width, dstWidth));
+    std::vector<uint8_t> dst((size_t)dstWidth * dstHeight, 0);
+    GrayBilinearRowResizer resizer;
+    REQUIRE(resizer.begin(src.width, src.height, dst.data(), dstWidth, dstHeight, scratch.data(), scratch.size(), lut));
+    for (int top = 0; top < src.height; top += stripeRows) {
+        const int rows = std::min(stripeRows, src.height - top);
+        CHECK(resizer.pushRows(src.pixels.data() + (size_t)top * src.width, top, rows));
+    }
+    CHECK(resizer.finished());
+    return dst;
+}
+
+} // namespace
+
+HOST_TEST(halveRoundsTheTwoByTwoMean)
+{
+    const Image src = randomImage(161, 121, 1);   // odd: the last row and column are dropped
+    std::vector<uint8_t> dst(80 * 60);
+    halveGray(src.pixels.data(), src.width, src.height, dst.data());
+    size_t mismatches = 0;
+    for (int y = 0; y < 60; y++) {
+        for (int x = 0; x < 80; x++) {
+            const int sum = src.at(2 * x, 2 * y) + src.at(2 * x + 1, 2 * y) + src.at(2 * x, 2 * y + 1) +
+                            src.at(2 * x + 1, 2 * y + 1);
+            mismatches += dst[(size_t)y * 80 + x] != (uint8_t)((sum + 2) / 4);
+        }
+    }
+    CHECK_EQ(mismatches, 0u);
+}
+
+HOST_TEST(halveWorksInPlace)
+{
+    const Image src = randomImage(320, 240, 2);
+    std::vector<uint8_t> separate(160 * 120);
+    halveGray(src.pixels.data(), src.width, src.height, separate.data());
+    std::vector<uint8_t> inPlace = src.pixels;
+    halveGray(inPlace.data(), src.width, src.height, inPlace.data());
+    CHECK(std::equal(separate.begin(), separate.end(), inPlace.begin()));
+}
+
+HOST_TEST(bilinearTracksTheExactFilter)
+{
+    // 8-bit weights and a rounded 16-bit intermediate keep every pixel within one level.
+    const int geometries[][4] = {
+        { 160, 120, 96, 96 }, { 200, 150, 96, 96 }, { 120, 90, 96, 96 }, { 191, 97, 96, 96 }, { 96, 96, 61, 37 },
+    };
+    for (const auto& geometry : geometries) {
+        const Image src = smoothImage(geometry[0], geometry[1]);
+        const int dstWidth = geometry[2];
+        const int dstHeight = geometry[3];
+        const std::vector<uint8_t> dst = resize(src, dstWidth, dstHeight);
+        double worst = 0.0;
+        for (int y = 0; y < dstHeight; y++) {
+            for (int x = 0; x < dstWidth; x++) {
+                const double error = std::fabs(dst[(size_t)y * dstWidth + x] - referenceBilinear(src, dstWidth, dstHeight, x, y));
+                worst = std::max(worst, error);
+            }
+        }
+        CHECK(worst <= 1.0);
+    }
+}
+
+HOST_TEST(bilinearAtTheSameSizeIsACopy)
+{
+    const Image src = randomImage(96, 96, 3);
+    CHECK(resize(src, 96, 96) == src.pixels);
+}
+
+HOST_TEST(flatImagesStayFlat)
+{
+    for (int level : { 0, 1, 127, 254, 255 }) {
+        Image src;
+        src.width = 213;
+        src.height = 160;
+        src.pixels.assign((size_t)src.width * src.height, (uint8_t)level);
+        const std::vector<uint8_t> dst = resize(src, 96, 96);
+        CHECK(std::all_of(dst.begin(), dst.end(), [&](uint8_t pixel) { return pixel == level; }));
+    }
+}
+
+HOST_TEST(fullViewKeepsTheFrameEdges)
+{
+    // Unlike a centered crop, every part of the frame reaches the output: a bright border on a dark
+    // QQVGA frame shows up on all four output edges.
+    Image src;
+    src.width = 160;
+    src.height = 120;
+    src.pixels.assign((size_t)src.width * src.height, 0);
+    for (int y = 0; y < src.height; y++) {
+        for (int x = 0; x < src.width; x++) {
+            if (x < 4 || y < 4 || x >= src.width - 4 || y >= src.height - 4) {
+                src.pixels[(size_t)y * src.width + x] = 255;
+            }
+        }
+    }
+    const std::vector<uint8_t> dst = resize(src, 96, 96);
+    CHECK_EQ(dst[0], 255);
+    CHECK_EQ(dst[95], 255);
+    CHECK_EQ(dst[95 * 96], 255);
+    CHECK_EQ(dst[95 * 96 + 95], 255);
+    CHECK_EQ(dst[48 * 96 + 48], 0);
+}
+
+HOST_TEST(downscaleHalvesThenResizes)
+{
+    // UXGA luma: three halvings to 200x150, then one bilinear pass.
+    const Image src = smoothImage(1600, 1200);
+    Image halved = src;
+    while (halved.width >= 192 && halved.height >= 192) {
+        halveGray(halved.pixels.data(), halved.width, halved.height, halved.pixels.data());
+        halved.width /= 2;
+        halved.height /= 2;
+        halved.pixels.resize((size_t)halved.width * halved.height);
+    }
+    CHECK_EQ(halved.width, 200);
+    const std::vector<uint8_t> expected = resize(halved, 96, 96);
+
+    std::vector<uint8_t> work((size_t)800 * 600 + 4096);
+    std::vector<uint8_t> dst(96 * 96);
+    REQUIRE(downscaleGray(src.pixels.data(), src.width, src.height, work.data(), work.size(), dst.data(), 96, 96));
+    CHECK(dst == expected);
+
+    // The source may be the start of the work buffer itself (decoded luma in the shared workspace).
+    std::vector<uint8_t> shared = src.pixels;
+    std::vector<uint8_t> sharedDst(96 * 96);
+    REQUIRE(downscaleGray(shared.data(), src.width, src.height, shared.data(), shared.size(), sharedDst.data(), 96, 96));
+    CHECK(sharedDst == expected);
+}
+
+HOST_TEST(downscaleRejectsShortWorkAndUpscales)
+{
+    const Image src = smoothImage(320, 240);
+    std::vector<uint8_t> dst(96 * 96);
+    std::vector<uint8_t> work(160 * 120 - 1);
+    CHECK(!downscaleGray(src.pixels.data(), 320, 240, work.data(), work.size(), dst.data(), 96, 96));
+    work.resize(160 * 120 + grayResizeScratchBytes(160, 96));
+    CHECK(downscaleGray(src.pixels.data(), 320, 240, work.data(), work.size(), dst.data(), 96, 96));
+    CHECK(!downscaleGray(src.pixels.data(), 64, 64, work.data(), work.size(), dst.data(), 96, 96));
+}
+
+HOST_TEST(rowResizerMatchesTheWholeFrameResize)
+{
+    const Image src = randomImage(160, 120, 4);
+    const std::vector<uint8_t> expected = resize(src, 96, 96);
+    for (int stripeRows : { 1, 2, 7, 8, 16, 119, 120 }) {
+        CHECK(resizeInStripes(src, 96, 96, stripeRows) == expected);
+    }
+}
+
+HOST_TEST(rowResizerAppliesTheLut)
+{
+    const Image src = randomImage(200, 150, 5);
+    uint8_t lut[256];
+    for (int i = 0; i < 256; i++) {
+        lut[i] = (uint8_t)(i ^ 0x80);   // uint8 -> int8 zero point shift
+    }
+    std::vector<uint8_t> expected = resize(src, 96, 96);
+    for (uint8_t& pixel : expected) {
+        pixel = lut[pixel];
+    }
+    CHECK(resizeInStripes(src, 96, 96, 16, lut) == expected);
+}
+
+HOST_TEST(rowResizerRejectsOutOfOrderStripes)
+{
+    const Image src = randomImage(160, 120, 6);
+    std::vector<uint8_t> scratch(GrayBilinearRowResizer::scratchBytes(160, 96));
+    std::vector<uint8_t> dst(96 * 96);
+    GrayBilinearRowResizer resizer;
+    CHECK(!resizer.begin(160, 120, dst.data(), 96, 96, scratch.data(), scratch.size() - 1));
+    REQUIRE(resizer.begin(160, 120, dst.data(), 96, 96, scratch.data(), scratch.size()));
+    CHECK(resizer.pushRows(src.pixels.data(), 0, 16));
+    CHECK(!resizer.pushRows(src.pixels.data() + 32 * 160, 32, 16));   // rows 16..31 skipped
+    CHECK(!resizer.pushRows(src.pixels.data() + 16 * 160, 16, 16));   // stays failed
+    CHECK(!resizer.finished());
+}
+
+HOST_TEST(stripedJpegDecodeFeedsTheResizer)
+{
+    // The full-view JPEG path: 1:2 stripes of a QVGA picture straight into the resizer match resizing
+    // the whole 1:2 luma image.
+    const std::vector<uint8_t> jpeg = loadTestPicture("test_inside.jpeg");
+    REQUIRE(!jpeg.empty());
+    std::vector<uint8_t> pool(kJpegGrayCropPoolBytes);
+    std::vector<uint8_t> luma(160 * 120);
+    JpegGrayCropResult whole;
+    REQUIRE(decodeJpegGrayScaled(jpeg.data(), jpeg.size(), 1, luma.data(), luma.size(), pool.data(), pool.size(), &whole));
+    REQUIRE(whole.outputWidth == 160 && whole.outputHeight == 120);
+    Image image;
+    image.width = 160;
+    image.height = 120;
+    image.pixels = luma;
+    const std::vector<uint8_t> expected = resize(image, 96, 96);
+
+    std::vector<uint8_t> scratch(GrayBilinearRowResizer::scratchBytes(160, 96));
+    std::vector<uint8_t> dst(96 * 96);
+    GrayBilinearRowResizer resizer;
+    REQUIRE(resizer.begin(160, 120, dst.data(), 96, 96, scratch.data(), scratch.size()));
+    std::vector<uint8_t> stripe(jpegGrayStripeBytes(320, 1));
+    JpegGrayCropResult streamed;
+    CHECK(decodeJpegGrayStripes(
+        jpeg.data(), jpeg.size(), 1, stripe.data(), stripe.size(),
+        [](const JpegGrayStripe& s, void* user) { return ((GrayBilinearRowResizer*)user)->pushRows(s.luma, s.top, s.rows); },
+        &resizer, pool.data(), pool.size(), &streamed));
+    CHECK(resizer.finished());
+    CHECK(dst == expected);
+}
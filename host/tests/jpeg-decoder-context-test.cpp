@@ -0,0 +1,160 @@
+#include "host-test.h"
+#include "host-heap.h"
+#include "test-pictures.h"
+#include "image-editing/jpeg-decoder-context.h"
+#include "esp_heap_caps.h"
+#include <cstring>
+#include <vector>
+
+namespace {
+
+const char* const kPictures[] = { "test_inside.jpeg", "test_outside.jpeg", "testimg.jpeg" };
+
+std::vector<std::vector<uint8_t>> loadPictures()
+{
+    std::vector<std::vector<uint8_t>> pictures;
+    for (const char* name : kPictures) {
+        pictures.push_back(loadTestPicture(name));
+        REQUIRE(!pictures.back().empty());
+    }
+    return pictures;
+}
+
+// esp_jpeg_decode with its own work area and a heap output buffer, as allocatingDecodeCameraJpeg did.
+std::vector<uint8_t> decodeStandalone(const std::vector<uint8_t>& jpeg, esp_jpeg_image_scale_t scale)
+{
+    esp_jpeg_image_cfg_t cfg = {};
+    cfg.indata = (uint8_t*)jpeg.data();
+    cfg.indata_size = jpeg.size();
+    cfg.out_format = JPEG_IMAGE_FORMAT_RGB565;
+    cfg.out_scale = scale;
+    esp_jpeg_image_output_t info = {};
+    REQUIRE(esp_jpeg_get_image_info(&cfg, &info) == ESP_OK);
+    std::vector<uint8_t> out(info.output_len);
+    std::vector<uint8_t> work(kJpegGrayCropPoolBytes);
+    cfg.outbuf = out.data();
+    cfg.outbuf_size = out.size();
+    cfg.advanced.working_buffer = work.data();
+    cfg.advanced.working_buffer_size = work.size();
+    esp_jpeg_image_output_t decoded = {};
+    REQUIRE(esp_jpeg_decode(&cfg, &decoded) == ESP_OK);
+    return out;
+}
+
+bool countStripeRows(const JpegGrayStripe& stripe, void* user)
+{
+    *(uint32_t*)user += stripe.rows;
+    return true;
+}
+
+} // namespace
+
+HOST_TEST(steadyStateDecodingAllocatesNothing)
+{
+    const auto pictures = loadPictures();
+    JpegDecoderContext decoder(PlacedBuffer::JpegDecoder);
+    JpegDecodedImage image;
+    // Warm-up: the largest picture sizes the buffer once.
+    REQUIRE(decoder.decode(pictures[1].data(), pictures[1].size(), JPEG_IMAGE_FORMAT_RGB565, JPEG_IMAGE_SCALE_0, &image) == ESP_OK);
+
+    const HostHeapStats before = hostHeapStats();
+    for (int round = 0; round < 20; round++) {
+        for (const auto& jpeg : pictures) {
+            CHECK(decoder.decode(jpeg.data(), jpeg.size(), JPEG_IMAGE_FORMAT_RGB565, JPEG_IMAGE_SCALE_0, &image) == ESP_OK);
+            CHECK(decoder.decode(jpeg.data(), jpeg.size(), JPEG_IMAGE_FORMAT_RGB888, JPEG_IMAGE_SCALE_1_2, &image) == ESP_OK);
+            uint32_t rows = 0;
+            CHECK(decoder.decodeGrayStripes(jpeg.data(), jpeg.size(), JPEG_IMAGE_SCALE_1_8, countStripeRows, &rows, nullptr));
+            CHECK(rows > 0);
+        }
+    }
+    const HostHeapStats after = hostHeapStats();
+    CHECK_EQ(after.allocations, before.allocations);
+    CHECK_EQ(after.frees, before.frees);
+
+    JpegDecoderStats stats;
+    decoder.takeStats(&stats);
+    CHECK_EQ(stats.decodes, 1u + 20u * 3u * 3u);
+    CHECK_EQ(stats.failures, 0u);
+    CHECK_EQ(stats.growths, 1u);
+    CHECK_EQ(stats.capacityBytes, (size_t)480 * 320 * 2);
+}
+
+HOST_TEST(reserveAvoidsEvenTheFirstAllocation)
+{
+    const auto pictures = loadPictures();
+    JpegDecoderContext decoder(PlacedBuffer::JpegDecoder);
+    REQUIRE(decoder.reserve((size_t)480 * 320 * 2));
+    const HostHeapStats before = hostHeapStats();
+    JpegDecodedImage image;
+    for (const auto& jpeg : pictures) {
+        CHECK(decoder.decode(jpeg.data(), jpeg.size(), JPEG_IMAGE_FORMAT_RGB565, JPEG_IMAGE_SCALE_0, &image) == ESP_OK);
+    }
+    CHECK_EQ(hostHeapStats().allocations, before.allocations);
+}
+
+HOST_TEST(bufferGrowsOnlyWithTheFrame)
+{
+    const auto pictures = loadPictures();
+    JpegDecoderContext decoder(PlacedBuffer::JpegDecoder);
+    JpegDecodedImage image;
+    JpegDecoderStats stats;
+    // 227x149, then 320x240 (grows), 227x149 again (fits), then 480x320 (grows).
+    for (int index : { 2, 0, 2, 1, 0, 2 }) {
+        CHECK(decoder.decode(pictures[index].data(), pictures[index].size(), JPEG_IMAGE_FORMAT_RGB565,
+                             JPEG_IMAGE_SCALE_0, &image) == ESP_OK);
+    }
+    decoder.takeStats(&stats);
+    CHECK_EQ(stats.growths, 3u);
+    decoder.takeStats(&stats);
+    CHECK_EQ(stats.decodes, 0u);   // takeStats() starts a new window
+    CHECK_EQ(stats.growths, 0u);
+}
+
+HOST_TEST(outputMatchesAStandaloneDecode)
+{
+    const auto pictures = loadPictures();
+    JpegDecoderContext decoder(PlacedBuffer::JpegDecoder);
+    for (const auto& jpeg : pictures) {
+        for (esp_jpeg_image_scale_t scale : { JPEG_IMAGE_SCALE_0, JPEG_IMAGE_SCALE_1_4 }) {
+            const std::vector<uint8_t> expected = decodeStandalone(jpeg, scale);
+            JpegDecodedImage image;
+            REQUIRE(decoder.decode(jpeg.data(), jpeg.size(), JPEG_IMAGE_FORMAT_RGB565, scale, &image) == ESP_OK);
+            CHECK_EQ(image.len, expected.size());
+            CHECK(image.len == expected.size() && memcmp(image.data, expected.data(), image.len) == 0);
+        }
+    }
+}
+
+HOST_TEST(corruptFramesCountAsFailuresWithoutAllocating)
+{
+    const auto pictures = loadPictures();
+    JpegDecoderContext decoder(PlacedBuffer::JpegDecoder);
+    JpegDecodedImage image;
+    REQUIRE(decoder.decode(pictures[0].data(), pictures[0].size(), JPEG_IMAGE_FORMAT_RGB565, JPEG_IMAGE_SCALE_0, &image) == ESP_OK);
+
+    std::vector<uint8_t> noSoi = pictures[0];
+    noSoi[1] = 0x00;
+    const std::vector<uint8_t> headerOnly(pictures[0].begin(), pictures[0].begin() + 8);
+    const HostHeapStats before = hostHeapStats();
+    CHECK(decoder.decode(noSoi.data(), noSoi.size(), JPEG_IMAGE_FORMAT_RGB565, JPEG_IMAGE_SCALE_0, &image) != ESP_OK);
+    CHECK(decoder.decode(headerOnly.data(), headerOnly.size(), JPEG_IMAGE_FORMAT_RGB565, JPEG_IMAGE_SCALE_0, &image) != ESP_OK);
+    CHECK_EQ(hostHeapStats().allocations, before.allocations);
+
+    JpegDecoderStats stats;
+    decoder.takeStats(&stats);
+    CHECK_EQ(stats.decodes, 3u);
+    CHECK_EQ(stats.failures, 2u);
+}
+
+HOST_TEST(destructorReleasesTheBuffer)
+{
+    const auto pictures = loadPictures();
+    const size_t liveBefore = hostHeapStats().liveBytes;
+    {
+        JpegDecoderContext decoder(PlacedBuffer::JpegDecoder);
+        JpegDecodedImage image;
+        REQUIRE(decoder.decode(pictures[1].data(), pictures[1].size(), JPEG_IMAGE_FORMAT_RGB565, JPEG_IMAGE_SCALE_0, &image) == ESP_OK);
+        CHECK(hostHeapStats().liveBytes > liveBefore);
+    }
+    CHECK_EQ(hostHeapStats().liveBytes, liveBefore);
+}
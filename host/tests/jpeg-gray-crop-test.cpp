@@ -0,0 +1,222 @@
+#include "host-test.h"
+#include "test-pictures.h"
+#include "image-editing/editing.h"
+#include "image-editing/jpeg-gray-crop.h"
+#include "image-editing/pixel-kernels.h"
+#include "jpeg_decoder.h"
+#include <algorithm>
+#include <cstring>
+#include <vector>
+
+namespace {
+
+const char* const kPictures[] = { "test_inside.jpeg", "test_outside.jpeg", "testimg.jpeg" };
+
+struct Luma {
+    std::vector<uint8_t> pixels;
+    int width = 0;
+    int height = 0;
+};
+
+// The pre-streaming path: esp_jpeg to RGB565 at the given scale, then the reference gray conversion.
+Luma decodeViaRgb565(const std::vector<uint8_t>& jpeg, uint8_t scale)
+{
+    esp_jpeg_image_cfg_t cfg = {};
+    cfg.indata = (uint8_t*)jpeg.data();
+    cfg.indata_size = jpeg.size();
+    cfg.out_format = JPEG_IMAGE_FORMAT_RGB565;
+    cfg.out_scale = (esp_jpeg_image_scale_t)scale;
+    esp_jpeg_image_output_t info = {};
+    REQUIRE(esp_jpeg_get_image_info(&cfg, &info) == ESP_OK);
+    std::vector<uint16_t> rgb565(info.output_len / 2);
+    std::vector<uint8_t> work(kJpegGrayCropPoolBytes);
+    cfg.outbuf = (uint8_t*)rgb565.data();
+    cfg.outbuf_size = info.output_len;
+    cfg.advanced.working_buffer = work.data();
+    cfg.advanced.working_buffer_size = work.size();
+    esp_jpeg_image_output_t out = {};
+    REQUIRE(esp_jpeg_decode(&cfg, &out) == ESP_OK);
+    Luma luma;
+    luma.width = out.width;
+    luma.height = out.height;
+    luma.pixels.resize((size_t)out.width * out.height);
+    referenceRgb565ToGray(rgb565.data(), luma.pixels.data(), luma.pixels.size());
+    return luma;
+}
+
+Luma decodeScaled(const std::vector<uint8_t>& jpeg, uint8_t scale)
+{
+    std::vector<uint8_t> pool(kJpegGrayCropPoolBytes);
+    Luma luma;
+    luma.pixels.resize(480 * 320);
+    JpegGrayCropResult result;
+    REQUIRE(decodeJpegGrayScaled(jpeg.data(), jpeg.size(), scale, luma.pixels.data(), luma.pixels.size(), pool.data(),
+                                 pool.size(), &result));
+    luma.width = result.outputWidth;
+    luma.height = result.outputHeight;
+    luma.pixels.resize((size_t)luma.width * luma.height);
+    return luma;
+}
+
+// Reassembles the streamed stripes and checks they arrive in order, within the stripe buffer.
+struct StripeCollector {
+    Luma image;
+    int stripes = 0;
+    int maxStripeBytes = 0;
+    int stopAfter = -1;
+    bool inOrder = true;
+};
+
+bool collectStripe(const JpegGrayStripe& stripe, void* user)
+{
+    StripeCollector& collector = *(StripeCollector*)user;
+    if (collector.image.width == 0) {
+        collector.image.width = stripe.width;
+    }
+    collector.inOrder = collector.inOrder && stripe.width == collector.image.width &&
+                        stripe.top == collector.image.height && stripe.rows > 0;
+    collector.image.pixels.insert(collector.image.pixels.end(), stripe.luma, stripe.luma + (size_t)stripe.width * stripe.rows);
+    collector.image.height += stripe.rows;
+    collector.maxStripeBytes = std::max(collector.maxStripeBytes, (int)stripe.width * stripe.rows);
+    collector.stripes++;
+    return collector.stripes != collector.stopAfter;
+}
+
+} // namespace
+
+HOST_TEST(scaledLumaMatchesTheRgb565Path)
+{
+    for (const char* name : kPictures) {
+        const std::vector<uint8_t> jpeg = loadTestPicture(name);
+        REQUIRE(!jpeg.empty());
+        for (uint8_t scale = 0; scale <= 3; scale++) {
+            const Luma expected = decodeViaRgb565(jpeg, scale);
+            const Luma luma = decodeScaled(jpeg, scale);
+            CHECK_EQ(luma.width, expected.width);
+            CHECK_EQ(luma.height, expected.height);
+            CHECK(luma.pixels == expected.pixels);
+        }
+    }
+}
+
+HOST_TEST(stripesReassembleTheWholeFrame)
+{
+    for (const char* name : kPictures) {
+        const std::vector<uint8_t> jpeg = loadTestPicture(name);
+        REQUIRE(!jpeg.empty());
+        uint16_t width = 0;
+        uint16_t height = 0;
+        REQUIRE(readJpegDimensions(jpeg.data(), jpeg.size(), &width, &height));
+        for (uint8_t scale = 0; scale <= 3; scale++) {
+            const Luma expected = decodeScaled(jpeg, scale);
+            const size_t stripeBytes = jpegGrayStripeBytes(width, scale);
+            std::vector<uint8_t> stripe(stripeBytes);
+            std::vector<uint8_t> pool(kJpegGrayCropPoolBytes);
+            StripeCollector collector;
+            JpegGrayCropResult result;
+            CHECK(decodeJpegGrayStripes(jpeg.data(), jpeg.size(), scale, stripe.data(), stripe.size(), collectStripe,
+                                        &collector, pool.data(), pool.size(), &result));
+            CHECK(collector.inOrder);
+            CHECK(!result.stoppedEarly);
+            CHECK_EQ(result.outputHeight, expected.height);
+            CHECK_EQ(collector.image.width, expected.width);
+            CHECK_EQ(collector.image.height, expected.height);
+            CHECK(collector.image.pixels == expected.pixels);
+            CHECK((size_t)collector.maxStripeBytes <= stripeBytes);
+            // Scaled, tjpgd skips edge MCUs whose clipped part rounds to no pixels (testimg's last
+            // column is 3 pixels wide); at 1:1 every MCU reaches the sink.
+            if (scale == 0) {
+                CHECK_EQ(result.mcusDelivered, result.mcusTotal);
+            } else {
+                CHECK(result.mcusDelivered <= result.mcusTotal);
+            }
+        }
+    }
+}
+
+HOST_TEST(stripeScratchIsOneMcuRow)
+{
+    // QVGA at 1:1 with 2x1 or 2x2 MCUs: at most 16 rows of 320 pixels, against a 76.8 KB luma frame.
+    CHECK(jpegGrayStripeBytes(320, 0) <= 320u * 16u);
+    CHECK(jpegGrayStripeBytes(320, 3) <= 40u * 2u);
+    CHECK(jpegGrayStripeBytes(1600, 0) <= 1600u * 16u);
+}
+
+HOST_TEST(sinkCanStopTheDecode)
+{
+    const std::vector<uint8_t> jpeg = loadTestPicture("test_outside.jpeg");
+    REQUIRE(!jpeg.empty());
+    std::vector<uint8_t> stripe(jpegGrayStripeBytes(480, 0));
+    std::vector<uint8_t> pool(kJpegGrayCropPoolBytes);
+    StripeCollector collector;
+    collector.stopAfter = 3;
+    JpegGrayCropResult result;
+    CHECK(decodeJpegGrayStripes(jpeg.data(), jpeg.size(), 0, stripe.data(), stripe.size(), collectStripe, &collector,
+                                pool.data(), pool.size(), &result));
+    CHECK(result.stoppedEarly);
+    CHECK_EQ(collector.stripes, 3);
+    CHECK(result.mcusDelivered < result.mcusTotal);
+    CHECK_EQ((int)result.outputHeight, collector.image.height);
+}
+
+HOST_TEST(shortBuffersAreRejected)
+{
+    const std::vector<uint8_t> jpeg = loadTestPicture("test_inside.jpeg");
+    REQUIRE(!jpeg.empty());
+    std::vector<uint8_t> stripe(jpegGrayStripeBytes(320, 0));
+    std::vector<uint8_t> pool(kJpegGrayCropPoolBytes);
+    StripeCollector collector;
+    JpegGrayCropResult result;
+    CHECK(!decodeJpegGrayStripes(jpeg.data(), jpeg.size(), 0, stripe.data(), 320 * 4, collectStripe, &collector,
+                                 pool.data(), pool.size(), &result));
+    CHECK_EQ(collector.stripes, 0);
+    CHECK(!decodeJpegGrayStripes(jpeg.data(), jpeg.size(), 0, stripe.data(), stripe.size(), collectStripe, &collector,
+                                 pool.data(), 512, &result));
+    std::vector<uint8_t> luma(160 * 120 - 1);
+    CHECK(!decodeJpegGrayScaled(jpeg.data(), jpeg.size(), 1, luma.data(), luma.size(), pool.data(), pool.size(), &result));
+}
+
+HOST_TEST(centerCropMatchesTheFullFrameCrop)
+{
+    uint8_t lut[256];
+    for (int i = 0; i < 256; i++) {
+        lut[i] = (uint8_t)(255 - i);
+    }
+    for (const char* name : kPictures) {
+        const std::vector<uint8_t> jpeg = loadTestPicture(name);
+        REQUIRE(!jpeg.empty());
+        const Luma frame = decodeViaRgb565(jpeg, 0);
+        std::vector<uint8_t> expected(96 * 96);
+        REQUIRE(cropCenter(frame.pixels.data(), frame.width, frame.height, expected.data(), 96, 96, 1));
+
+        std::vector<uint8_t> pool(kJpegGrayCropPoolBytes);
+        std::vector<uint8_t> crop(96 * 96);
+        JpegGrayCropResult result;
+        REQUIRE(decodeJpegGrayCenterCrop(jpeg.data(), jpeg.size(), crop.data(), 96, 96, pool.data(), pool.size(), &result));
+        CHECK(crop == expected);
+        CHECK(result.stoppedEarly);   // rows below the window are never decoded
+
+        REQUIRE(decodeJpegGrayCenterCrop(jpeg.data(), jpeg.size(), crop.data(), 96, 96, pool.data(), pool.size(), &result, lut));
+        for (uint8_t& pixel : expected) {
+            pixel = lut[pixel];
+        }
+        CHECK(crop == expected);
+    }
+}
+
+HOST_TEST(thumbnailIsTheOneEighthDecode)
+{
+    JpegDecoderContext decoder(PlacedBuffer::JpegDecoder);
+    for (const char* name : kPictures) {
+        const std::vector<uint8_t> jpeg = loadTestPicture(name);
+        REQUIRE(!jpeg.empty());
+        const Luma expected = decodeScaled(jpeg, 3);
+        std::vector<uint8_t> thumbnail(expected.pixels.size());
+        uint16_t width = 0;
+        uint16_t height = 0;
+        REQUIRE(decodeJpegLumaThumbnail(decoder, jpeg.data(), jpeg.size(), thumbnail.data(), thumbnail.size(), &width, &height));
+        CHECK_EQ((int)width, expected.width);
+        CHECK_EQ((int)height, expected.height);
+        CHECK(thumbnail == expected.pixels);
+    }
+}
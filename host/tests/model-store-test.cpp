@@ -0,0 +1,544 @@
+#include "host-test.h"
+#include "file-model-storage.h"
+#include "model-store/model-store.h"
+#include "tflite-person-detect/person_detect_model_data.h"
+#include "tensorflow/lite/micro/micro_interpreter.h"
+#include "tensorflow/lite/schema/schema_generated.h"
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <unistd.h>
+#include <vector>
+
+const char* hostPrintable(ModelImageStatus status) { return modelImageStatusName(status); }
+
+namespace {
+
+constexpr size_t kEraseBytes = 4096;
+
+const uint8_t* personModel() { return g_person_detect_model_data; }
+size_t personModelBytes() { return (size_t)g_person_detect_model_data_len; }
+
+// Two slots just large enough for the person detection model.
+size_t slotBytesFor(size_t modelBytes)
+{
+    return (kModelImageDataOffset + modelBytes + kEraseBytes - 1) / kEraseBytes * kEraseBytes;
+}
+
+// Storage file that is removed again when the test case ends; reopening it is a reboot.
+class TempStorageFile
+{
+public:
+    TempStorageFile()
+    {
+        char path[] = "/tmp/model-store-test-XXXXXX";
+        const int fd = mkstemp(path);
+        REQUIRE(fd >= 0);
+        ::close(fd);
+        path_ = path;
+    }
+    ~TempStorageFile() { unlink(path_.c_str()); }
+
+    const char* path() const { return path_.c_str(); }
+
+private:
+    std::string path_;
+};
+
+// Slot image (header + model) in a buffer whose model bytes start shift bytes past a 16-byte boundary.
+class SlotImage
+{
+public:
+    SlotImage(const uint8_t* model, size_t modelBytes, uint32_t sequence, size_t shift = 0)
+        : buffer_(kModelImageDataOffset + modelBytes + kModelImageAlignment + shift, 0xFF)
+    {
+        const uintptr_t base = (uintptr_t)buffer_.data();
+        offset_ = (size_t)((kModelImageAlignment - base % kModelImageAlignment) % kModelImageAlignment) + shift;
+        bytes_ = kModelImageDataOffset + modelBytes;
+
+        ModelImageHeader header;
+        memset(&header, 0, sizeof(header));
+        header.magic = kModelImageMagic;
+        header.formatVersion = kModelImageFormatVersion;
+        header.headerBytes = sizeof(ModelImageHeader);
+        header.modelBytes = (uint32_t)modelBytes;
+        header.crc32 = modelImageCrc32(0, model, modelBytes);
+        header.sequence = sequence;
+        memcpy(data(), &header, sizeof(header));
+        memcpy(data() + kModelImageDataOffset, model, modelBytes);
+    }
+
+    uint8_t* data() { return buffer_.data() + offset_; }
+    size_t size() const { return bytes_; }
+    uint8_t* model() { return data() + kModelImageDataOffset; }
+
+    ModelImageHeader& header() { return *(ModelImageHeader*)data(); }
+    // After editing the model bytes, so only the edit itself is what validation sees.
+    void resealCrc() { header().crc32 = modelImageCrc32(0, model(), header().modelBytes); }
+
+private:
+    std::vector<uint8_t> buffer_;
+    size_t offset_ = 0;
+    size_t bytes_ = 0;
+};
+
+ModelImageStatus validate(SlotImage& image, size_t slotBytes = 0)
+{
+    ModelImageHeader header;
+    return validateModelImage(image.data(), slotBytes ? slotBytes : image.size(), &header);
+}
+
+// Offset of the root table's schema version field inside a .tflite flatbuffer.
+size_t schemaVersionOffset(const uint8_t* model)
+{
+    uint32_t table = 0;
+    int32_t vtableDistance = 0;
+    uint16_t fieldOffset = 0;
+    memcpy(&table, model, sizeof(table));
+    memcpy(&vtableDistance, model + table, sizeof(vtableDistance));
+    memcpy(&fieldOffset, model + table - vtableDistance + tflite::Model::VT_VERSION, sizeof(fieldOffset));
+    REQUIRE(fieldOffset != 0);
+    return table + fieldOffset;
+}
+
+struct StorageFixture {
+    explicit StorageFixture(size_t slotBytes = slotBytesFor(personModelBytes()))
+        : slotBytes(slotBytes)
+    {
+        REQUIRE(storage.open(file.path(), 2 * slotBytes, kEraseBytes));
+    }
+
+    void writeSlot(size_t slot, SlotImage& image)
+    {
+        REQUIRE(storage.erase(slot * slotBytes, slotBytes));
+        REQUIRE(storage.write(slot * slotBytes, image.data(), image.size()));
+    }
+
+    // Power cycle: the store is rebuilt on a freshly opened storage file.
+    void reboot()
+    {
+        storage.close();
+        REQUIRE(storage.open(file.path(), 2 * slotBytes, kEraseBytes));
+    }
+
+    ModelImageStatus upload(ModelStore& store, const uint8_t* model, size_t modelBytes, const uint8_t** mapped)
+    {
+        ModelImageStatus status = store.beginUpload(modelBytes);
+        // HTTP-sized chunks, the last one short.
+        for (size_t done = 0; status == ModelImageStatus::Ok && done < modelBytes; done += 1460) {
+            const size_t chunk = modelBytes - done < 1460 ? modelBytes - done : 1460;
+            status = store.appendUpload(model + done, chunk);
+        }
+        return status == ModelImageStatus::Ok ? store.commitUpload(mapped) : status;
+    }
+
+    TempStorageFile file;
+    FileModelStorage storage;
+    size_t slotBytes;
+};
+
+// A model that differs from the person detection one but still validates: same flatbuffer, one weight
+// byte near the end changed.
+std::vector<uint8_t> otherModel(uint8_t tag)
+{
+    std::vector<uint8_t> model(personModel(), personModel() + personModelBytes());
+    model[model.size() - 4096] ^= tag;
+    return model;
+}
+
+} // namespace
+
+HOST_TEST(crc32MatchesTheIeeeCheckValueAndStreams)
+{
+    const char* check = "123456789";
+    CHECK_EQ(modelImageCrc32(0, check, 9), 0xCBF43926u);
+    CHECK_EQ(modelImageCrc32(modelImageCrc32(0, check, 4), check + 4, 5), 0xCBF43926u);
+    CHECK_EQ(modelImageCrc32(0, check, 0), 0u);
+
+    const uint32_t whole = modelImageCrc32(0, personModel(), personModelBytes());
+    uint32_t streamed = 0;
+    for (size_t done = 0; done < personModelBytes(); done += 1000) {
+        const size_t chunk = personModelBytes() - done < 1000 ? personModelBytes() - done : 1000;
+        streamed = modelImageCrc32(streamed, personModel() + done, chunk);
+    }
+    CHECK_EQ(streamed, whole);
+}
+
+HOST_TEST(validationAcceptsThePersonDetectionModel)
+{
+    SlotImage image(personModel(), personModelBytes(), 1);
+    ModelImageHeader header;
+    CHECK_EQ(validateModelImage(image.data(), image.size(), &header), ModelImageStatus::Ok);
+    CHECK_EQ(header.modelBytes, (uint32_t)personModelBytes());
+    CHECK_EQ(header.sequence, 1u);
+    // Room to spare in the slot is fine.
+    CHECK_EQ(validate(image, slotBytesFor(personModelBytes())), ModelImageStatus::Ok);
+}
+
+HOST_TEST(validationRejectsHeaderFaults)
+{
+    {
+        std::vector<uint8_t> erased(kModelImageDataOffset + 64, 0xFF);
+        ModelImageHeader header;
+        CHECK_EQ(validateModelImage(erased.data(), erased.size(), &header), ModelImageStatus::Empty);
+        CHECK_EQ(validateModelImage(erased.data(), kModelImageDataOffset - 1, &header), ModelImageStatus::TooLarge);
+        CHECK_EQ(header.magic, 0u);
+    }
+    {
+        SlotImage image(personModel(), personModelBytes(), 1);
+        image.header().formatVersion = kModelImageFormatVersion + 1;
+        CHECK_EQ(validate(image), ModelImageStatus::BadHeader);
+    }
+    {
+        SlotImage image(personModel(), personModelBytes(), 1);
+        image.header().headerBytes = sizeof(ModelImageHeader) - 4;
+        CHECK_EQ(validate(image), ModelImageStatus::BadHeader);
+    }
+    {
+        SlotImage image(personModel(), personModelBytes(), 1);
+        CHECK_EQ(validate(image, image.size() - 1), ModelImageStatus::TooLarge);
+        image.header().modelBytes = 0;
+        CHECK_EQ(validate(image), ModelImageStatus::TooLarge);
+    }
+}
+
+HOST_TEST(validationRejectsMisalignedModels)
+{
+    for (size_t shift : { (size_t)1, (size_t)4, (size_t)8 }) {
+        SlotImage image(personModel(), personModelBytes(), 1, shift);
+        CHECK_EQ(validate(image), ModelImageStatus::Misaligned);
+    }
+}
+
+HOST_TEST(validationRejectsCorruptedModelBytes)
+{
+    {
+        // A flipped bit anywhere, checksum left as written.
+        for (size_t offset : { (size_t)0, personModelBytes() / 2, personModelBytes() - 1 }) {
+            SlotImage image(personModel(), personModelBytes(), 1);
+            image.model()[offset] ^= 0x10;
+            CHECK_EQ(validate(image), ModelImageStatus::ChecksumMismatch);
+        }
+    }
+    {
+        // The checks behind the checksum, each with a matching CRC so that it is the one that trips.
+        SlotImage image(personModel(), personModelBytes(), 1);
+        CHECK(tflite::ModelBufferHasIdentifier(image.model()));
+        memcpy(image.model() + 4, "TFL2", 4);
+        image.resealCrc();
+        CHECK_EQ(validate(image), ModelImageStatus::NotTflite);
+    }
+    {
+        SlotImage image(personModel(), personModelBytes(), 1);
+        const uint32_t rootBeyondEnd = (uint32_t)personModelBytes() + 64;
+        memcpy(image.model(), &rootBeyondEnd, sizeof(rootBeyondEnd));
+        image.resealCrc();
+        CHECK_EQ(validate(image), ModelImageStatus::Malformed);
+    }
+    {
+        SlotImage image(personModel(), personModelBytes(), 1);
+        const size_t versionOffset = schemaVersionOffset(image.model());
+        uint32_t version = 0;
+        memcpy(&version, image.model() + versionOffset, sizeof(version));
+        CHECK_EQ(version, (uint32_t)TFLITE_SCHEMA_VERSION);
+        version = TFLITE_SCHEMA_VERSION + 1;
+        memcpy(image.model() + versionOffset, &version, sizeof(version));
+        image.resealCrc();
+        CHECK_EQ(validate(image), ModelImageStatus::SchemaVersion);
+    }
+}
+
+HOST_TEST(erasedStorageMountsWithoutAModel)
+{
+    StorageFixture fixture;
+    ModelStore store(fixture.storage);
+    CHECK(!store.mount());
+    CHECK_EQ(store.activeSlot(), -1);
+    CHECK(store.activeModel() == nullptr);
+    CHECK_EQ(store.maxModelBytes(), fixture.slotBytes - kModelImageDataOffset);
+    for (size_t slot = 0; slot < ModelStore::kSlotCount; slot++) {
+        CHECK_EQ(store.slotInfo(slot).status, ModelImageStatus::Empty);
+    }
+    CHECK_EQ(fixture.storage.liveMaps(), (size_t)0);
+}
+
+HOST_TEST(mountPicksTheValidSlotWithTheHighestSequence)
+{
+    StorageFixture fixture;
+    const std::vector<uint8_t> newer = otherModel(0x5A);
+    SlotImage slot0(personModel(), personModelBytes(), 7);
+    SlotImage slot1(newer.data(), newer.size(), 5);
+    fixture.writeSlot(0, slot0);
+    fixture.writeSlot(1, slot1);
+    {
+        ModelStore store(fixture.storage);
+        CHECK(store.mount());
+        CHECK_EQ(store.activeSlot(), 0);
+        CHECK_EQ(store.slotInfo(0).sequence, 7u);
+        CHECK_EQ(store.slotInfo(1).status, ModelImageStatus::Ok);
+        CHECK_EQ(store.slotInfo(1).sequence, 5u);
+        // Mapped in place, and only the active slot stays mapped.
+        CHECK(fixture.storage.isMapped(store.activeModel()));
+        CHECK_EQ(fixture.storage.liveMaps(), (size_t)1);
+        CHECK(memcmp(store.activeModel(), personModel(), personModelBytes()) == 0);
+    }
+    CHECK_EQ(fixture.storage.liveMaps(), (size_t)0);
+
+    SlotImage slot1Newer(newer.data(), newer.size(), 9);
+    fixture.writeSlot(1, slot1Newer);
+    {
+        ModelStore store(fixture.storage);
+        CHECK(store.mount());
+        CHECK_EQ(store.activeSlot(), 1);
+        CHECK(memcmp(store.activeModel(), newer.data(), newer.size()) == 0);
+    }
+
+    // Bit rot in the newer slot: the older one is what boots.
+    REQUIRE(fixture.storage.corrupt(fixture.slotBytes + kModelImageDataOffset + 1000, 0x01));
+    {
+        ModelStore store(fixture.storage);
+        CHECK(store.mount());
+        CHECK_EQ(store.activeSlot(), 0);
+        CHECK_EQ(store.slotInfo(1).status, ModelImageStatus::ChecksumMismatch);
+        CHECK_EQ(fixture.storage.liveMaps(), (size_t)1);
+    }
+
+    // A header that announces more than a slot holds is rejected before anything larger is mapped.
+    SlotImage oversized(personModel(), personModelBytes(), 11);
+    oversized.header().modelBytes = (uint32_t)fixture.slotBytes;
+    fixture.writeSlot(1, oversized);
+    {
+        ModelStore store(fixture.storage);
+        CHECK(store.mount());
+        CHECK_EQ(store.activeSlot(), 0);
+        CHECK_EQ(store.slotInfo(1).status, ModelImageStatus::TooLarge);
+    }
+}
+
+HOST_TEST(uploadsAlternateSlotsAndSurviveAReboot)
+{
+    StorageFixture fixture;
+    const std::vector<uint8_t> models[] = {
+        std::vector<uint8_t>(personModel(), personModel() + personModelBytes()), otherModel(0x01), otherModel(0x02),
+    };
+    int expectedSlot = 0;
+    for (uint32_t round = 0; round < 3; round++) {
+        const std::vector<uint8_t>& model = models[round];
+        {
+            ModelStore store(fixture.storage);
+            CHECK_EQ(store.mount(), round > 0);
+            const uint8_t* mapped = nullptr;
+            REQUIRE(fixture.upload(store, model.data(), model.size(), &mapped) == ModelImageStatus::Ok);
+            CHECK_EQ(store.uploadSlot(), expectedSlot);
+            CHECK(fixture.storage.isMapped(mapped));
+            CHECK(memcmp(mapped, model.data(), model.size()) == 0);
+            CHECK_EQ(store.slotInfo((size_t)expectedSlot).sequence, round + 1);
+            // Until activation the running model stays where it was.
+            CHECK_EQ(store.activeSlot(), round > 0 ? 1 - expectedSlot : -1);
+
+            store.activateUpload();
+            CHECK_EQ(store.activeSlot(), expectedSlot);
+            CHECK(store.activeModel() == mapped);
+            CHECK_EQ(fixture.storage.liveMaps(), (size_t)1);
+        }
+
+        fixture.reboot();
+        ModelStore store(fixture.storage);
+        CHECK(store.mount());
+        CHECK_EQ(store.activeSlot(), expectedSlot);
+        CHECK_EQ(store.slotInfo((size_t)expectedSlot).sequence, round + 1);
+        CHECK(memcmp(store.activeModel(), model.data(), model.size()) == 0);
+        expectedSlot = 1 - expectedSlot;
+    }
+}
+
+HOST_TEST(beginUploadNeverErasesTheActiveSlot)
+{
+    StorageFixture fixture;
+    for (size_t activeSlot = 0; activeSlot < ModelStore::kSlotCount; activeSlot++) {
+        SlotImage image(personModel(), personModelBytes(), 3);
+        REQUIRE(fixture.storage.erase(0, 2 * fixture.slotBytes));
+        fixture.writeSlot(activeSlot, image);
+        fixture.storage.clearEraseLog();
+
+        ModelStore store(fixture.storage);
+        REQUIRE(store.mount());
+        REQUIRE(store.activeSlot() == (int)activeSlot);
+        // Largest and smallest uploads, and a restart of an upload already under way.
+        CHECK_EQ(store.beginUpload(store.maxModelBytes()), ModelImageStatus::Ok);
+        CHECK_EQ(store.beginUpload(1), ModelImageStatus::Ok);
+        CHECK_EQ(store.appendUpload(personModel(), 1), ModelImageStatus::Ok);
+        CHECK_EQ(store.beginUpload(personModelBytes()), ModelImageStatus::Ok);
+        CHECK_EQ(store.uploadSlot(), 1 - (int)activeSlot);
+
+        CHECK_EQ(fixture.storage.eraseLog().size(), (size_t)3);
+        CHECK(!fixture.storage.erasedWithin(activeSlot * fixture.slotBytes, fixture.slotBytes));
+        for (const FileModelStorage::Range& range : fixture.storage.eraseLog()) {
+            CHECK_EQ(range.offset, (1 - activeSlot) * fixture.slotBytes);
+            CHECK(range.len <= fixture.slotBytes);
+        }
+        CHECK(memcmp(store.activeModel(), personModel(), personModelBytes()) == 0);
+        store.discardUpload();
+        CHECK(!fixture.storage.erasedWithin(activeSlot * fixture.slotBytes, fixture.slotBytes));
+    }
+}
+
+HOST_TEST(discardAfterInterpreterRefusalKeepsTheRunningModel)
+{
+    StorageFixture fixture;
+    SlotImage image(personModel(), personModelBytes(), 4);
+    fixture.writeSlot(0, image);
+    fixture.storage.clearEraseLog();
+    {
+        ModelStore store(fixture.storage);
+        REQUIRE(store.mount());
+        const uint8_t* running = store.activeModel();
+        const std::vector<uint8_t> refused = otherModel(0x33);
+        const uint8_t* mapped = nullptr;
+        REQUIRE(fixture.upload(store, refused.data(), refused.size(), &mapped) == ModelImageStatus::Ok);
+        CHECK_EQ(fixture.storage.liveMaps(), (size_t)2);
+        // The committed upload holds the store until the interpreter has had its say.
+        CHECK_EQ(store.beginUpload(refused.size()), ModelImageStatus::Busy);
+
+        // AllocateTensors() failed on it.
+        store.discardUpload();
+        CHECK_EQ(store.activeSlot(), 0);
+        CHECK(store.activeModel() == running);
+        CHECK(memcmp(running, personModel(), personModelBytes()) == 0);
+        CHECK_EQ(store.slotInfo(1).status, ModelImageStatus::Empty);
+        CHECK_EQ(fixture.storage.liveMaps(), (size_t)1);
+        CHECK(!fixture.storage.erasedWithin(0, fixture.slotBytes));
+        // Discarding twice is harmless, and the next upload may start.
+        store.discardUpload();
+        CHECK_EQ(store.beginUpload(refused.size()), ModelImageStatus::Ok);
+    }
+
+    // The refused model had the higher sequence; with its header gone it cannot win the next boot.
+    fixture.reboot();
+    ModelStore store(fixture.storage);
+    CHECK(store.mount());
+    CHECK_EQ(store.activeSlot(), 0);
+    CHECK_EQ(store.slotInfo(0).sequence, 4u);
+    CHECK_EQ(store.slotInfo(1).status, ModelImageStatus::Empty);
+}
+
+HOST_TEST(interruptedUploadLeavesTheRunningModel)
+{
+    StorageFixture fixture;
+    SlotImage image(personModel(), personModelBytes(), 1);
+    fixture.writeSlot(0, image);
+    {
+        ModelStore store(fixture.storage);
+        REQUIRE(store.mount());
+        const std::vector<uint8_t> next = otherModel(0x44);
+        REQUIRE(store.beginUpload(next.size()) == ModelImageStatus::Ok);
+        REQUIRE(store.appendUpload(next.data(), next.size() / 2) == ModelImageStatus::Ok);
+        // Power lost before commitUpload(): no header was written.
+    }
+    fixture.reboot();
+    ModelStore store(fixture.storage);
+    CHECK(store.mount());
+    CHECK_EQ(store.activeSlot(), 0);
+    CHECK_EQ(store.slotInfo(1).status, ModelImageStatus::Empty);
+    CHECK(memcmp(store.activeModel(), personModel(), personModelBytes()) == 0);
+}
+
+HOST_TEST(commitValidatesTheSlotAsWritten)
+{
+    StorageFixture fixture;
+    ModelStore store(fixture.storage);
+    CHECK(!store.mount());
+
+    // Not a model at all.
+    std::vector<uint8_t> junk(8192);
+    for (size_t i = 0; i < junk.size(); i++) {
+        junk[i] = (uint8_t)(i * 7 + 3);
+    }
+    const uint8_t* mapped = nullptr;
+    CHECK_EQ(fixture.upload(store, junk.data(), junk.size(), &mapped), ModelImageStatus::NotTflite);
+    CHECK(mapped == nullptr);
+    CHECK_EQ(fixture.storage.liveMaps(), (size_t)0);
+    store.discardUpload();
+    CHECK_EQ(store.slotInfo(0).status, ModelImageStatus::Empty);
+
+    // A byte that did not make it to flash as sent.
+    REQUIRE(store.beginUpload(personModelBytes()) == ModelImageStatus::Ok);
+    REQUIRE(store.appendUpload(personModel(), personModelBytes()) == ModelImageStatus::Ok);
+    REQUIRE(fixture.storage.corrupt(kModelImageDataOffset + 5000, 0x80));
+    CHECK_EQ(store.commitUpload(&mapped), ModelImageStatus::ChecksumMismatch);
+    CHECK_EQ(store.slotInfo(0).status, ModelImageStatus::ChecksumMismatch);
+    store.discardUpload();
+    CHECK_EQ(store.activeSlot(), -1);
+    CHECK(!store.mount());
+}
+
+HOST_TEST(uploadCallsOutOfOrderAreRefused)
+{
+    StorageFixture fixture;
+    ModelStore store(fixture.storage);
+    const uint8_t* mapped = nullptr;
+    // Before mount() the store has no slots.
+    CHECK_EQ(store.beginUpload(personModelBytes()), ModelImageStatus::StorageError);
+    CHECK(!store.mount());
+
+    CHECK_EQ(store.appendUpload(personModel(), 16), ModelImageStatus::Busy);
+    CHECK_EQ(store.commitUpload(&mapped), ModelImageStatus::Busy);
+    CHECK_EQ(store.beginUpload(0), ModelImageStatus::TooLarge);
+    CHECK_EQ(store.beginUpload(store.maxModelBytes() + 1), ModelImageStatus::TooLarge);
+
+    REQUIRE(store.beginUpload(personModelBytes()) == ModelImageStatus::Ok);
+    CHECK_EQ(store.appendUpload(personModel(), personModelBytes() - 16), ModelImageStatus::Ok);
+    CHECK_EQ(store.commitUpload(&mapped), ModelImageStatus::Incomplete);
+    CHECK_EQ(store.appendUpload(personModel(), 17), ModelImageStatus::TooLarge);
+    CHECK_EQ(store.appendUpload(personModel() + personModelBytes() - 16, 16), ModelImageStatus::Ok);
+    REQUIRE(store.commitUpload(&mapped) == ModelImageStatus::Ok);
+
+    CHECK_EQ(store.appendUpload(personModel(), 1), ModelImageStatus::Busy);
+    CHECK_EQ(store.commitUpload(&mapped), ModelImageStatus::Busy);
+    CHECK_EQ(store.beginUpload(personModelBytes()), ModelImageStatus::Busy);
+    store.activateUpload();
+    CHECK_EQ(store.activeSlot(), 0);
+    // Activating again without a commit changes nothing.
+    store.activateUpload();
+    CHECK_EQ(store.activeSlot(), 0);
+    CHECK_EQ(store.beginUpload(personModelBytes()), ModelImageStatus::Ok);
+    CHECK_EQ(store.uploadSlot(), 1);
+}
+
+HOST_TEST(storageFailuresSurfaceAsStorageErrors)
+{
+    StorageFixture fixture;
+    SlotImage image(personModel(), personModelBytes(), 2);
+    fixture.writeSlot(0, image);
+
+    ModelStore store(fixture.storage);
+    fixture.storage.failMaps(true);
+    CHECK(!store.mount());
+    CHECK_EQ(store.slotInfo(0).status, ModelImageStatus::StorageError);
+    fixture.storage.failMaps(false);
+    REQUIRE(store.mount());
+
+    fixture.storage.failErases(true);
+    CHECK_EQ(store.beginUpload(personModelBytes()), ModelImageStatus::StorageError);
+    CHECK_EQ(store.slotInfo(1).status, ModelImageStatus::StorageError);
+    CHECK_EQ(store.appendUpload(personModel(), 16), ModelImageStatus::Busy);
+    fixture.storage.failErases(false);
+
+    REQUIRE(store.beginUpload(personModelBytes()) == ModelImageStatus::Ok);
+    fixture.storage.failWrites(true);
+    CHECK_EQ(store.appendUpload(personModel(), 16), ModelImageStatus::StorageError);
+    fixture.storage.failWrites(false);
+    REQUIRE(store.appendUpload(personModel(), personModelBytes()) == ModelImageStatus::Ok);
+
+    const uint8_t* mapped = nullptr;
+    fixture.storage.failWrites(true);
+    CHECK_EQ(store.commitUpload(&mapped), ModelImageStatus::StorageError);
+    fixture.storage.failWrites(false);
+    fixture.storage.failMaps(true);
+    CHECK_EQ(store.commitUpload(&mapped), ModelImageStatus::StorageError);
+    fixture.storage.failMaps(false);
+    CHECK_EQ(store.commitUpload(&mapped), ModelImageStatus::Ok);
+    store.discardUpload();
+    CHECK_EQ(store.activeSlot(), 0);
+    CHECK(memcmp(store.activeModel(), personModel(), personModelBytes()) == 0);
+}
@@ -0,0 +1,199 @@
+#include "host-test.h"
+#include "test-pictures.h"
+#include "motion-gate/motion-gate.h"
+#include "image-editing/editing.h"
+#include "image-editing/jpeg-decoder-context.h"
+#include "define.h"
+#include <algorithm>
+
+namespace {
+
+constexpr int64_t kFrameUs = 100000;
+constexpr int64_t kMaxIntervalUs = (int64_t)MOTION_GATE_MAX_INTERVAL_MS * 1000;
+
+struct Thumbnail {
+    std::vector<uint8_t> luma;
+    uint16_t width = 0;
+    uint16_t height = 0;
+};
+
+// The firmware's gate input: a 1:8 luma decode of the camera JPEG.
+Thumbnail decodeThumbnail(const char* picture)
+{
+    static JpegDecoderContext decoder(PlacedBuffer::JpegDecoder);
+    const std::vector<uint8_t> jpeg = loadTestPicture(picture);
+    Thumbnail thumbnail;
+    REQUIRE(!jpeg.empty());
+    thumbnail.luma.resize(jpeg.size());
+    REQUIRE(decodeJpegLumaThumbnail(decoder, jpeg.data(), jpeg.size(), thumbnail.luma.data(), thumbnail.luma.size(),
+                                    &thumbnail.width, &thumbnail.height));
+    thumbnail.luma.resize((size_t)thumbnail.width * thumbnail.height);
+    return thumbnail;
+}
+
+// Auto exposure: every pixel moves by the same amount, clipping at the rails.
+Thumbnail shifted(const Thumbnail& source, int delta)
+{
+    Thumbnail out = source;
+    for (uint8_t& pixel : out.luma) {
+        pixel = (uint8_t)std::clamp((int)pixel + delta, 0, 255);
+    }
+    return out;
+}
+
+// Someone walks in: another picture's thumbnail pasted over part of the scene.
+Thumbnail withObject(const Thumbnail& scene, const Thumbnail& object, int left, int top)
+{
+    Thumbnail out = scene;
+    for (int y = 0; y < object.height && top + y < scene.height; y++) {
+        for (int x = 0; x < object.width && left + x < scene.width; x++) {
+            out.luma[(size_t)(top + y) * scene.width + left + x] = object.luma[(size_t)y * object.width + x];
+        }
+    }
+    return out;
+}
+
+MotionGateConfig gateConfig()
+{
+    MotionGateConfig config;
+    config.pixelThreshold = MOTION_GATE_PIXEL_THRESHOLD;
+    config.changedPermille = MOTION_GATE_CHANGED_PERMILLE;
+    config.backgroundShift = MOTION_GATE_BACKGROUND_SHIFT;
+    config.maxIntervalUs = kMaxIntervalUs;
+    return config;
+}
+
+struct GateFixture {
+    MotionGate gate{gateConfig()};
+    std::vector<uint16_t> background = std::vector<uint16_t>(64 * 64);
+    int64_t nowUs = 0;
+
+    GateFixture() { gate.bindBackground(background.data(), background.size()); }
+
+    MotionGateDecision next(const Thumbnail& frame)
+    {
+        const MotionGateDecision decision = gate.evaluate(frame.luma.data(), frame.width, frame.height, nowUs);
+        nowUs += kFrameUs;
+        return decision;
+    }
+};
+
+} // namespace
+
+HOST_TEST(thumbnailsAreOneEighthOfTheFrame)
+{
+    const Thumbnail inside = decodeThumbnail("test_inside.jpeg");
+    CHECK_EQ(inside.width, 40);
+    CHECK_EQ(inside.height, 30);
+    const Thumbnail outside = decodeThumbnail("test_outside.jpeg");
+    CHECK_EQ(outside.width, 60);
+    CHECK_EQ(outside.height, 40);
+    // Not a flat image: the gate needs unclipped pixels to work with.
+    const auto range = std::minmax_element(inside.luma.begin(), inside.luma.end());
+    CHECK(*range.second - *range.first > 64);
+}
+
+HOST_TEST(warmupOnFirstFrameNewGeometryAndUnjudgeableFrames)
+{
+    GateFixture fixture;
+    const Thumbnail inside = decodeThumbnail("test_inside.jpeg");
+    const Thumbnail outside = decodeThumbnail("test_outside.jpeg");
+
+    MotionGateDecision decision = fixture.next(inside);
+    CHECK(decision.runInference);
+    CHECK(decision.trigger == MotionTrigger::Warmup);
+
+    decision = fixture.next(inside);
+    CHECK(!decision.runInference);
+    CHECK(decision.trigger == MotionTrigger::None);
+    CHECK_EQ(decision.changedPermille, 0);
+
+    // A new frame size restarts the background rather than comparing mismatched pixels.
+    decision = fixture.next(outside);
+    CHECK(decision.trigger == MotionTrigger::Warmup);
+    CHECK(fixture.next(outside).trigger == MotionTrigger::None);
+
+    // No luma or no room for it: fail open.
+    CHECK(fixture.gate.evaluate(nullptr, 40, 30, fixture.nowUs).trigger == MotionTrigger::Warmup);
+    fixture.gate.bindBackground(fixture.background.data(), 100);
+    CHECK(fixture.next(inside).trigger == MotionTrigger::Warmup);
+
+    MotionGateStats stats;
+    fixture.gate.takeStats(&stats);
+    CHECK_EQ(stats.frames, 6u);
+    CHECK_EQ(stats.warmupTriggers, 4u);
+    CHECK_EQ(stats.skipped, 2u);
+}
+
+HOST_TEST(exposureShiftIsCompensated)
+{
+    const Thumbnail inside = decodeThumbnail("test_inside.jpeg");
+    for (int delta : { 20, 40, -20, -40 }) {
+        GateFixture fixture;
+        fixture.next(inside);
+        // Every unclipped pixel moved by more than pixelThreshold, yet nothing counts as changed.
+        CHECK(std::abs(delta) > MOTION_GATE_PIXEL_THRESHOLD);
+        const MotionGateDecision decision = fixture.next(shifted(inside, delta));
+        CHECK(!decision.runInference);
+        CHECK(decision.changedPermille < MOTION_GATE_CHANGED_PERMILLE);
+    }
+}
+
+HOST_TEST(objectEnteringTheSceneTriggersMotion)
+{
+    const Thumbnail inside = decodeThumbnail("test_inside.jpeg");
+    const Thumbnail person = decodeThumbnail("testimg.jpeg");
+    const Thumbnail entered = withObject(inside, person, 8, 6);
+
+    GateFixture fixture;
+    fixture.next(inside);
+    fixture.next(inside);
+    MotionGateDecision decision = fixture.next(entered);
+    CHECK(decision.runInference);
+    CHECK(decision.trigger == MotionTrigger::Motion);
+    CHECK(decision.changedPermille >= MOTION_GATE_CHANGED_PERMILLE);
+
+    // Same change while the exposure moves: the offset is taken out, the object still counts.
+    GateFixture exposed;
+    exposed.next(inside);
+    decision = exposed.next(shifted(entered, 25));
+    CHECK(decision.trigger == MotionTrigger::Motion);
+
+    // An object that stays becomes background (EMA weight 1/8 per frame) and stops triggering.
+    int framesUntilQuiet = 0;
+    while (fixture.next(entered).trigger == MotionTrigger::Motion && framesUntilQuiet < 50) {
+        framesUntilQuiet++;
+    }
+    CHECK(framesUntilQuiet > 2);
+    CHECK(framesUntilQuiet < 50);
+}
+
+HOST_TEST(staticSceneTimesOutAfterMaxInterval)
+{
+    const Thumbnail outside = decodeThumbnail("test_outside.jpeg");
+    GateFixture fixture;
+    CHECK(fixture.next(outside).trigger == MotionTrigger::Warmup);      // t = 0
+
+    const int framesPerInterval = (int)(kMaxIntervalUs / kFrameUs);
+    for (int round = 0; round < 3; round++) {
+        for (int frame = 1; frame < framesPerInterval; frame++) {
+            CHECK(fixture.next(outside).trigger == MotionTrigger::None);
+        }
+        const MotionGateDecision decision = fixture.next(outside);
+        CHECK(decision.runInference);
+        CHECK(decision.trigger == MotionTrigger::Timeout);
+    }
+
+    // Motion restarts the interval too.
+    const Thumbnail person = decodeThumbnail("testimg.jpeg");
+    CHECK(fixture.next(withObject(outside, person, 20, 10)).trigger == MotionTrigger::Motion);
+    MotionGateStats stats;
+    fixture.gate.recordGateCost(500);
+    fixture.gate.recordInferenceCost(200000);
+    fixture.gate.takeStats(&stats);
+    CHECK_EQ(stats.timeoutTriggers, 3u);
+    CHECK_EQ(stats.motionTriggers, 1u);
+    CHECK_EQ(stats.skipped, (uint32_t)(3 * (framesPerInterval - 1)));
+    CHECK_NEAR(stats.meanGateUs, 500.0, 1e-3);
+    CHECK_NEAR(stats.savedUs, stats.skipped * 200000.0 - 500.0, 1.0);
+}
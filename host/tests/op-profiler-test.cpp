@@ -0,0 +1,184 @@
+#include "host-test.h"
+#include "tf-lite/op-profiler.h"
+#include "tensorflow/lite/micro/micro_profiler.h"
+#include <string>
+
+namespace {
+
+int64_t g_nowUs = 0;
+
+int64_t fakeClock()
+{
+    return g_nowUs;
+}
+
+struct Op {
+    const char* tag;
+    int32_t us;
+};
+
+// One Invoke() as MicroInterpreterGraph::InvokeSubgraph runs it: a ScopedMicroProfiler around each node.
+void invoke(OpProfiler& profiler, const Op* ops, size_t count, int32_t slowdownUs = 0)
+{
+    profiler.beginInvoke();
+    for (size_t i = 0; i < count; i++) {
+        tflite::ScopedMicroProfiler scoped(ops[i].tag, &profiler);
+        g_nowUs += ops[i].us + slowdownUs;
+    }
+    profiler.endInvoke();
+}
+
+// A person-detect style graph: convolutions dominate, two nodes share each tag.
+const Op kGraph[] = {
+    { "CONV_2D", 900 },
+    { "DEPTHWISE_CONV_2D", 300 },
+    { "CONV_2D", 1500 },
+    { "DEPTHWISE_CONV_2D", 250 },
+    { "AVERAGE_POOL_2D", 40 },
+    { "FULLY_CONNECTED", 20 },
+    { "SOFTMAX", 5 },
+};
+constexpr size_t kGraphNodes = sizeof(kGraph) / sizeof(kGraph[0]);
+
+} // namespace
+
+HOST_TEST(aggregatesEachNodeAcrossInvocations)
+{
+    OpProfiler profiler(fakeClock);
+    invoke(profiler, kGraph, kGraphNodes);
+    invoke(profiler, kGraph, kGraphNodes, 10);
+    invoke(profiler, kGraph, kGraphNodes, 4);
+
+    OpProfile profile;
+    profiler.snapshot(&profile);
+    CHECK_EQ(profile.invocations, 3u);
+    CHECK_EQ(profile.nodeCount, kGraphNodes);
+    CHECK_EQ(profile.droppedEvents, 0u);
+    for (size_t i = 0; i < kGraphNodes; i++) {
+        const OpProfileNode& node = profile.nodes[i];
+        CHECK_EQ(std::string(node.tag), std::string(kGraph[i].tag));
+        CHECK_EQ(node.count, 3u);
+        CHECK_EQ(node.totalUs, (int64_t)kGraph[i].us * 3 + 14);
+        CHECK_EQ(node.maxUs, kGraph[i].us + 10);
+    }
+}
+
+HOST_TEST(summaryMergesTagsHeaviestFirst)
+{
+    OpProfiler profiler(fakeClock);
+    invoke(profiler, kGraph, kGraphNodes);
+    invoke(profiler, kGraph, kGraphNodes);
+    OpProfile profile;
+    profiler.snapshot(&profile);
+
+    OpProfileTag tags[8];
+    const size_t count = OpProfiler::summarizeByTag(profile, tags, 8);
+    REQUIRE(count == 5);
+    CHECK_EQ(std::string(tags[0].tag), "CONV_2D");
+    CHECK_EQ(tags[0].count, 4u);
+    CHECK_EQ(tags[0].totalUs, (int64_t)2 * (900 + 1500));
+    CHECK_EQ(tags[0].maxUs, 1500);
+    CHECK_EQ(std::string(tags[1].tag), "DEPTHWISE_CONV_2D");
+    CHECK_EQ(tags[1].totalUs, (int64_t)2 * (300 + 250));
+    CHECK_EQ(std::string(tags[2].tag), "AVERAGE_POOL_2D");
+    CHECK_EQ(std::string(tags[3].tag), "FULLY_CONNECTED");
+    CHECK_EQ(std::string(tags[4].tag), "SOFTMAX");
+    for (size_t i = 1; i < count; i++) {
+        CHECK(tags[i - 1].totalUs >= tags[i].totalUs);
+    }
+}
+
+HOST_TEST(summaryComparesTagText)
+{
+    // Tags from different string tables (e.g. a custom op registered twice) still merge.
+    char first[] = "CONV_2D";
+    char second[] = "CONV_2D";
+    const Op graph[] = { { first, 100 }, { second, 200 } };
+    OpProfiler profiler(fakeClock);
+    invoke(profiler, graph, 2);
+    OpProfile profile;
+    profiler.snapshot(&profile);
+    OpProfileTag tags[4];
+    REQUIRE(OpProfiler::summarizeByTag(profile, tags, 4) == 1);
+    CHECK_EQ(tags[0].count, 2u);
+    CHECK_EQ(tags[0].totalUs, 300);
+}
+
+HOST_TEST(summaryStopsAtMaxTags)
+{
+    OpProfiler profiler(fakeClock);
+    invoke(profiler, kGraph, kGraphNodes);
+    OpProfile profile;
+    profiler.snapshot(&profile);
+    OpProfileTag tags[2];
+    REQUIRE(OpProfiler::summarizeByTag(profile, tags, 2) == 2);
+    // The first two tags seen keep merging; later tags are left out.
+    CHECK_EQ(std::string(tags[0].tag), "CONV_2D");
+    CHECK_EQ(tags[0].count, 2u);
+    CHECK_EQ(std::string(tags[1].tag), "DEPTHWISE_CONV_2D");
+}
+
+HOST_TEST(nodeWithoutEndEventIsNotCounted)
+{
+    OpProfiler profiler(fakeClock);
+    invoke(profiler, kGraph, kGraphNodes);
+    // A kernel fails: the interpreter returns from Invoke() between BeginEvent and EndEvent of node 2.
+    profiler.beginInvoke();
+    for (size_t i = 0; i < 3; i++) {
+        const uint32_t handle = profiler.BeginEvent(kGraph[i].tag);
+        g_nowUs += kGraph[i].us;
+        if (i < 2) {
+            profiler.EndEvent(handle);
+        }
+    }
+    profiler.endInvoke();
+
+    OpProfile profile;
+    profiler.snapshot(&profile);
+    CHECK_EQ(profile.invocations, 2u);
+    CHECK_EQ(profile.nodes[1].count, 2u);
+    CHECK_EQ(profile.nodes[2].count, 1u);
+    CHECK_EQ(profile.nodes[2].totalUs, 1500);
+}
+
+HOST_TEST(nodesPastTheLimitAreDropped)
+{
+    OpProfiler profiler(fakeClock);
+    Op graph[kOpProfilerMaxNodes + 3];
+    for (Op& op : graph) {
+        op = { "ADD", 1 };
+    }
+    invoke(profiler, graph, kOpProfilerMaxNodes + 3);
+    invoke(profiler, graph, kOpProfilerMaxNodes + 3);
+    OpProfile profile;
+    profiler.snapshot(&profile);
+    CHECK_EQ(profile.nodeCount, kOpProfilerMaxNodes);
+    CHECK_EQ(profile.droppedEvents, 6u);
+    CHECK_EQ(profile.nodes[kOpProfilerMaxNodes - 1].count, 2u);
+}
+
+HOST_TEST(resetKeepsMacsClearDropsThem)
+{
+    OpProfiler profiler(fakeClock);
+    profiler.setNodeMacs(0, 1234567);
+    profiler.setNodeMacs(kOpProfilerMaxNodes, 1);   // ignored
+    invoke(profiler, kGraph, kGraphNodes);
+
+    profiler.reset();
+    OpProfile profile;
+    profiler.snapshot(&profile);
+    CHECK_EQ(profile.invocations, 0u);
+    CHECK_EQ(profile.nodes[0].count, 0u);
+    CHECK_EQ(profile.nodes[0].totalUs, 0);
+    CHECK_EQ(profile.nodes[0].macs, 1234567u);
+
+    invoke(profiler, kGraph, kGraphNodes);
+    profiler.snapshot(&profile);
+    CHECK_EQ(profile.nodes[0].count, 1u);
+    CHECK_EQ(profile.nodes[0].maxUs, 900);
+
+    profiler.clear();
+    profiler.snapshot(&profile);
+    CHECK_EQ(profile.nodeCount, 0u);
+    CHECK_EQ(profile.nodes[0].macs, 0u);
+}
@@ -0,0 +1,100 @@
+#include "host-test.h"
+#include "inference-pipeline/pipeline-meter.h"
+
+namespace {
+
+// A frame captured at captureUs whose stages took the given times, back to back apart from queueUs.
+PipelineSample sampleAt(int64_t captureUs, int64_t waitUs, int64_t preprocessUs, int64_t queueUs, int64_t invokeUs)
+{
+    PipelineSample sample;
+    sample.captureUs = captureUs;
+    sample.preprocessStartUs = captureUs + waitUs;
+    sample.queuedUs = sample.preprocessStartUs + preprocessUs;
+    sample.invokeStartUs = sample.queuedUs + queueUs;
+    sample.doneUs = sample.invokeStartUs + invokeUs;
+    return sample;
+}
+
+} // namespace
+
+HOST_TEST(emptyWindowReportsNothing)
+{
+    PipelineMeter meter;
+    PipelineStats stats;
+    stats.frames = 99;
+    meter.takeStats(&stats, 1000000);
+    CHECK_EQ(stats.frames, 0u);
+    CHECK_EQ(stats.framesPerSecond, 0.0f);
+    CHECK_EQ(stats.meanInvokeUs, 0.0f);
+    CHECK_EQ(stats.sequentialLimitFps, 0.0f);
+    CHECK_EQ(stats.busyCores, 0.0f);
+
+    // The next window starts at that call even without samples.
+    meter.takeStats(&stats, 3000000);
+    CHECK_EQ(stats.frames, 0u);
+    CHECK_EQ(stats.framesPerSecond, 0.0f);
+}
+
+HOST_TEST(stageMeansAndLatency)
+{
+    PipelineMeter meter;
+    // Preprocessing 20/30 ms, queue 5/15 ms, invoke 60/80 ms; the second frame waited 10 ms for the stage.
+    meter.record(sampleAt(0, 0, 20000, 5000, 60000));
+    meter.record(sampleAt(100000, 10000, 30000, 15000, 80000));
+    PipelineStats stats;
+    meter.takeStats(&stats, 200000);
+    CHECK_EQ(stats.frames, 2u);
+    CHECK_NEAR(stats.meanPreprocessUs, 25000.0, 0.5);
+    CHECK_NEAR(stats.meanQueueUs, 10000.0, 0.5);
+    CHECK_NEAR(stats.meanInvokeUs, 70000.0, 0.5);
+    CHECK_NEAR(stats.meanLatencyUs, (85000.0 + 135000.0) / 2, 0.5);
+    CHECK_EQ(stats.maxLatencyUs, (int64_t)135000);
+
+    // Sequential: 25 + 70 ms per frame; pipelined: bounded by the 70 ms invoke stage.
+    CHECK_NEAR(stats.sequentialLimitFps, 1.0e6 / 95000.0, 1e-3);
+    CHECK_NEAR(stats.pipelinedLimitFps, 1.0e6 / 70000.0, 1e-3);
+    // Window from the first preprocessing start (0) to 200 ms.
+    CHECK_NEAR(stats.framesPerSecond, 10.0, 1e-3);
+    CHECK_NEAR(stats.busyCores, (50000.0 + 140000.0) / 200000.0, 1e-4);
+}
+
+HOST_TEST(overlappedStagesShowAsMoreThanOneBusyCore)
+{
+    PipelineMeter meter;
+    // Steady state at 20 fps: 40 ms preprocessing for frame n runs while frame n-1 is invoked for 45 ms.
+    for (int64_t frame = 0; frame < 20; frame++) {
+        meter.record(sampleAt(frame * 50000, 0, 40000, 5000, 45000));
+    }
+    PipelineStats stats;
+    meter.takeStats(&stats, 1000000);
+    CHECK_EQ(stats.frames, 20u);
+    CHECK_NEAR(stats.framesPerSecond, 20.0, 1e-3);
+    CHECK_NEAR(stats.busyCores, 20 * 85000.0 / 1000000.0, 1e-4);
+    CHECK(stats.busyCores > 1.0f);
+    CHECK(stats.framesPerSecond > stats.sequentialLimitFps);
+    CHECK(stats.framesPerSecond <= stats.pipelinedLimitFps);
+}
+
+HOST_TEST(takeStatsStartsAFreshWindow)
+{
+    PipelineMeter meter;
+    meter.record(sampleAt(0, 0, 10000, 0, 500000));
+    PipelineStats stats;
+    meter.takeStats(&stats, 1000000);
+    CHECK_EQ(stats.maxLatencyUs, (int64_t)510000);
+
+    // Nothing of the first window leaks into the second, which runs from the previous call.
+    meter.record(sampleAt(1000000, 0, 10000, 0, 20000));
+    meter.record(sampleAt(1500000, 0, 10000, 0, 20000));
+    meter.takeStats(&stats, 2000000);
+    CHECK_EQ(stats.frames, 2u);
+    CHECK_EQ(stats.maxLatencyUs, (int64_t)30000);
+    CHECK_NEAR(stats.meanInvokeUs, 20000.0, 0.5);
+    CHECK_NEAR(stats.framesPerSecond, 2.0, 1e-4);
+
+    // A null stats pointer only resets the window.
+    meter.record(sampleAt(2000000, 0, 10000, 0, 20000));
+    meter.takeStats(nullptr, 3000000);
+    meter.takeStats(&stats, 4000000);
+    CHECK_EQ(stats.frames, 0u);
+}
@@ -0,0 +1,117 @@
+#include "host-test.h"
+#include "image-editing/pixel-kernels.h"
+#include <cstring>
+#include <random>
+#include <vector>
+
+// The fixed-point kernels must produce exactly the reference bytes; the per-pixel conversions are small
+// enough to check for every possible input.
+
+HOST_TEST(rgb565ToGrayMatchesForEveryPixelValue)
+{
+    std::vector<uint16_t> rgb565(65536);
+    for (size_t i = 0; i < rgb565.size(); i++) {
+        rgb565[i] = (uint16_t)i;
+    }
+    std::vector<uint8_t> reference(rgb565.size());
+    std::vector<uint8_t> fixed(rgb565.size());
+    referenceRgb565ToGray(rgb565.data(), reference.data(), rgb565.size());
+    fixedRgb565ToGray(rgb565.data(), fixed.data(), rgb565.size());
+    size_t mismatches = 0;
+    for (size_t i = 0; i < rgb565.size(); i++) {
+        mismatches += reference[i] != fixed[i];
+        mismatches += fixedRgb565Luma(rgb565[i]) != reference[i];
+    }
+    CHECK_EQ(mismatches, 0u);
+}
+
+HOST_TEST(rgb888ConversionsMatchForEveryColour)
+{
+    // One row per red value: all 65536 green/blue combinations.
+    std::vector<uint8_t> rgb(65536 * 3);
+    std::vector<uint8_t> reference(65536);
+    std::vector<uint8_t> fixed(65536);
+    std::vector<uint8_t> reference565(65536);
+    std::vector<uint8_t> fixed565(65536);
+    size_t mismatches = 0;
+    size_t mismatches565 = 0;
+    for (int r = 0; r < 256; r++) {
+        for (int gb = 0; gb < 65536; gb++) {
+            rgb[gb * 3] = (uint8_t)r;
+            rgb[gb * 3 + 1] = (uint8_t)(gb >> 8);
+            rgb[gb * 3 + 2] = (uint8_t)gb;
+        }
+        referenceRgb888ToGray(rgb.data(), reference.data(), 65536);
+        fixedRgb888ToGray(rgb.data(), fixed.data(), 65536);
+        referenceRgb888Via565ToGray(rgb.data(), reference565.data(), 65536);
+        fixedRgb888Via565ToGray(rgb.data(), fixed565.data(), 65536);
+        mismatches += memcmp(reference.data(), fixed.data(), 65536) != 0;
+        mismatches565 += memcmp(reference565.data(), fixed565.data(), 65536) != 0;
+    }
+    CHECK_EQ(mismatches, 0u);
+    CHECK_EQ(mismatches565, 0u);
+}
+
+HOST_TEST(grayToRgb888Matches)
+{
+    uint8_t gray[256];
+    for (int i = 0; i < 256; i++) {
+        gray[i] = (uint8_t)i;
+    }
+    uint8_t reference[256 * 3];
+    uint8_t fixed[256 * 3];
+    referenceGrayToRgb888(gray, reference, 256);
+    fixedGrayToRgb888(gray, fixed, 256);
+    CHECK(memcmp(reference, fixed, sizeof(reference)) == 0);
+}
+
+HOST_TEST(nearestResizeMatchesForUpAndDownscales)
+{
+    std::mt19937 rng(1234);
+    const int sizes[][4] = {
+        { 160, 120, 96, 96 }, { 320, 240, 96, 96 }, { 96, 96, 160, 120 }, { 1600, 1200, 96, 96 },
+        { 227, 149, 61, 37 }, { 7, 5, 96, 96 }, { 96, 96, 96, 96 }, { 1, 1, 3, 2 }, { 640, 480, 639, 1 },
+    };
+    for (const auto& size : sizes) {
+        const int inWidth = size[0];
+        const int inHeight = size[1];
+        const int outWidth = size[2];
+        const int outHeight = size[3];
+        std::vector<uint8_t> src((size_t)inWidth * inHeight * 3);
+        for (uint8_t& byte : src) {
+            byte = (uint8_t)rng();
+        }
+        std::vector<uint8_t> reference((size_t)outWidth * outHeight * 3);
+        std::vector<uint8_t> fixed(reference.size());
+        referenceResizeRgb888Nearest(src.data(), inWidth, inHeight, reference.data(), outWidth, outHeight);
+        fixedResizeRgb888Nearest(src.data(), inWidth, inHeight, fixed.data(), outWidth, outHeight);
+        CHECK(reference == fixed);
+    }
+}
+
+HOST_TEST(lutMapsEveryValue)
+{
+    uint8_t lut[256];
+    uint8_t pixels[256];
+    for (int i = 0; i < 256; i++) {
+        lut[i] = (uint8_t)(255 - i);
+        pixels[i] = (uint8_t)i;
+    }
+    mapGrayLut(pixels, 256, lut);
+    for (int i = 0; i < 256; i++) {
+        CHECK_EQ(pixels[i], (uint8_t)(255 - i));
+    }
+}
+
+HOST_TEST(multiplyShiftFormsMatchTheDivisions)
+{
+    for (uint32_t v5 = 0; v5 <= 31; v5++) {
+        CHECK_EQ((v5 * kExpand5Mul) >> kExpand5Shift, v5 * 255 / 31);
+    }
+    for (uint32_t v6 = 0; v6 <= 63; v6++) {
+        CHECK_EQ((v6 * kExpand6Mul) >> kExpand6Shift, v6 * 255 / 63);
+    }
+    for (uint32_t s = 0; s <= 25550; s++) {
+        CHECK_EQ((s * kDiv100Mul) >> kDiv100Shift, s / 100);
+    }
+}
@@ -0,0 +1,261 @@
+#include "host-test.h"
+#include "clip-recorder/pre-event-ring.h"
+#include <cstring>
+#include <string>
+#include <vector>
+
+namespace {
+
+constexpr int64_t kFrameUs = 100000;
+constexpr int64_t kHoldUs = 2000000;
+
+std::vector<uint8_t> makeJpeg(uint32_t seq, size_t len)
+{
+    std::vector<uint8_t> jpeg(len);
+    for (size_t i = 0; i < len; i++) {
+        jpeg[i] = (uint8_t)(seq * 7 + i);
+    }
+    return jpeg;
+}
+
+bool appendFrame(PreEventRing& ring, uint32_t seq, size_t len, int64_t captureUs)
+{
+    const std::vector<uint8_t> jpeg = makeJpeg(seq, len);
+    return ring.append(jpeg.data(), jpeg.size(), 160, 120, seq, captureUs);
+}
+
+bool collect(void* ctx, const uint8_t* data, size_t len)
+{
+    std::vector<uint8_t>* out = static_cast<std::vector<uint8_t>*>(ctx);
+    out->insert(out->end(), data, data + len);
+    return true;
+}
+
+bool abortAfterHeader(void* ctx, const uint8_t* data, size_t len)
+{
+    int* calls = static_cast<int*>(ctx);
+    return (*calls)++ == 0;
+}
+
+uint32_t u32At(const std::vector<uint8_t>& avi, size_t offset)
+{
+    return (uint32_t)avi[offset] | ((uint32_t)avi[offset + 1] << 8) |
+           ((uint32_t)avi[offset + 2] << 16) | ((uint32_t)avi[offset + 3] << 24);
+}
+
+std::string fourccAt(const std::vector<uint8_t>& avi, size_t offset)
+{
+    return std::string(reinterpret_cast<const char*>(avi.data() + offset), 4);
+}
+
+// Offsets of the fixed-size AVI header (avi-mjpeg.cpp): RIFF(12) + LIST hdrl(12) + avih(8 + 56) +
+// LIST strl(12) + strh(8 + 56) + strf(8 + 40), then the movi LIST header.
+constexpr size_t kAvihData = 12 + 12 + 8;
+constexpr size_t kMoviList = 12 + 8 + 4 + (8 + 56) + (8 + 4 + (8 + 56) + (8 + 40));
+constexpr size_t kMoviFourcc = kMoviList + 8;
+
+struct ParsedFrame {
+    size_t chunkOffset;     // of the '00dc' fourcc
+    uint32_t len;
+};
+
+} // namespace
+
+HOST_TEST(recordsArePaddedToHeaderAlignment)
+{
+    CHECK_EQ(sizeof(PreEventRecordHeader), 24u);
+    CHECK_EQ(PreEventRing::recordBytes(1), 32u);
+    CHECK_EQ(PreEventRing::recordBytes(8), 32u);
+    CHECK_EQ(PreEventRing::recordBytes(9), 40u);
+}
+
+HOST_TEST(windowEvictsFramesOlderThanTheSpan)
+{
+    PreEventRing ring;
+    REQUIRE(ring.init(64 * 1024, PlacedBuffer::PreEventRing, 3 * kFrameUs, kHoldUs));
+    for (uint32_t seq = 0; seq < 10; seq++) {
+        CHECK(appendFrame(ring, seq, 500, seq * kFrameUs));
+    }
+    PreEventRingStats stats;
+    ring.getStats(&stats);
+    // Frames at 600..900 ms are within 300 ms of the newest.
+    CHECK_EQ(stats.recordCount, 4u);
+    CHECK_EQ(stats.oldestUs, 6 * kFrameUs);
+    CHECK_EQ(stats.newestUs, 9 * kFrameUs);
+    CHECK_EQ(stats.appended, 10u);
+    CHECK_EQ(stats.evicted, 6u);
+    CHECK_EQ(stats.usedBytes, 4 * PreEventRing::recordBytes(500));
+}
+
+HOST_TEST(wrapEvictsOldestRecordsInTheWay)
+{
+    PreEventRing ring;
+    const size_t record = PreEventRing::recordBytes(200);
+    REQUIRE(ring.init(4 * record + 16, PlacedBuffer::PreEventRing, 1000 * kFrameUs, kHoldUs));
+
+    for (uint32_t seq = 1; seq <= 4; seq++) {
+        CHECK(appendFrame(ring, seq, 200, seq * kFrameUs));
+    }
+    PreEventRingStats stats;
+    ring.getStats(&stats);
+    CHECK_EQ(stats.recordCount, 4u);
+    CHECK_EQ(stats.evicted, 0u);
+
+    // No room at the tail end: the writer wraps to offset 0 and evicts frame 1 to make room there.
+    CHECK(appendFrame(ring, 5, 200, 5 * kFrameUs));
+    ring.getStats(&stats);
+    CHECK_EQ(stats.recordCount, 4u);
+    CHECK_EQ(stats.evicted, 1u);
+    CHECK_EQ(stats.oldestUs, 2 * kFrameUs);
+
+    // A larger frame evicts two records in front of the write position.
+    CHECK(appendFrame(ring, 6, 400, 6 * kFrameUs));
+    ring.getStats(&stats);
+    CHECK_EQ(stats.oldestUs, 4 * kFrameUs);
+    CHECK_EQ(stats.recordCount, 3u);
+    CHECK_EQ(stats.usedBytes, 2 * record + PreEventRing::recordBytes(400));
+
+    // Frames 4, 5, 6 come out of the export in capture order across the wrap.
+    REQUIRE(ring.requestFreeze());
+    CHECK(!appendFrame(ring, 7, 200, 7 * kFrameUs));
+    std::vector<uint8_t> avi;
+    REQUIRE(ring.exportAvi(collect, &avi, true));
+    size_t offset = kMoviFourcc + 4;
+    const uint32_t expectedSeq[] = { 4, 5, 6 };
+    const uint32_t expectedLen[] = { 200, 200, 400 };
+    for (int i = 0; i < 3; i++) {
+        CHECK_EQ(fourccAt(avi, offset), std::string("00dc"));
+        CHECK_EQ(u32At(avi, offset + 4), expectedLen[i]);
+        const std::vector<uint8_t> jpeg = makeJpeg(expectedSeq[i], expectedLen[i]);
+        CHECK(memcmp(avi.data() + offset + 8, jpeg.data(), jpeg.size()) == 0);
+        offset += 8 + expectedLen[i];
+    }
+}
+
+HOST_TEST(frameLargerThanTheRingIsRejected)
+{
+    PreEventRing ring;
+    REQUIRE(ring.init(1024, PlacedBuffer::PreEventRing, 10 * kFrameUs, kHoldUs));
+    CHECK(appendFrame(ring, 1, 100, 0));
+    CHECK(!appendFrame(ring, 2, 1024, kFrameUs));
+    PreEventRingStats stats;
+    ring.getStats(&stats);
+    CHECK_EQ(stats.rejected, 1u);
+    CHECK_EQ(stats.recordCount, 1u);
+}
+
+HOST_TEST(freezeHoldsTheClipUntilExportOrExpiry)
+{
+    PreEventRing ring;
+    REQUIRE(ring.init(64 * 1024, PlacedBuffer::PreEventRing, 10 * kFrameUs, kHoldUs));
+
+    // Freezing an empty ring has nothing to keep: the next frame is recorded normally.
+    REQUIRE(ring.requestFreeze());
+    CHECK(appendFrame(ring, 1, 300, kFrameUs));
+    CHECK(ring.getState() == PreEventRingState::Recording);
+
+    CHECK(appendFrame(ring, 2, 300, 2 * kFrameUs));
+    REQUIRE(ring.requestFreeze());
+    CHECK(!ring.requestFreeze());
+    CHECK(ring.getState() == PreEventRingState::FreezeRequested);
+    CHECK(!appendFrame(ring, 3, 300, 3 * kFrameUs));
+    CHECK(ring.hasClip());
+
+    // Frozen: appends are dropped and clear() leaves the clip alone.
+    CHECK(!appendFrame(ring, 4, 300, 4 * kFrameUs));
+    ring.clear();
+    PreEventRingStats stats;
+    ring.getStats(&stats);
+    CHECK_EQ(stats.recordCount, 2u);
+    CHECK_EQ(stats.clips, 1u);
+    CHECK_EQ(stats.dropped, 2u);
+
+    // An export without releaseAfter keeps the clip; so does an aborted one.
+    std::vector<uint8_t> avi;
+    CHECK(ring.exportAvi(collect, &avi, false));
+    CHECK(ring.hasClip());
+    int calls = 0;
+    CHECK(!ring.exportAvi(abortAfterHeader, &calls, true));
+    CHECK(ring.hasClip());
+
+    // Nobody claimed it within holdUs: recording resumes on the frame that expires it.
+    CHECK(!appendFrame(ring, 5, 300, 3 * kFrameUs + kHoldUs - 1));
+    CHECK(appendFrame(ring, 6, 300, 3 * kFrameUs + kHoldUs));
+    CHECK(ring.getState() == PreEventRingState::Recording);
+    CHECK(!ring.exportAvi(collect, &avi, true));
+
+    REQUIRE(ring.requestFreeze());
+    CHECK(!appendFrame(ring, 7, 300, 4 * kFrameUs + kHoldUs));
+    CHECK(ring.releaseClip());
+    CHECK(ring.getState() == PreEventRingState::Recording);
+    CHECK(!ring.releaseClip());
+}
+
+HOST_TEST(aviHeaderAndIndexMatchTheFrames)
+{
+    PreEventRing ring;
+    REQUIRE(ring.init(64 * 1024, PlacedBuffer::PreEventRing, 100 * kFrameUs, kHoldUs));
+    // Odd lengths get a pad byte in movi that the index sizes must leave out.
+    const uint32_t lengths[] = { 1001, 1200, 777, 1500 };
+    const uint32_t frameCount = 4;
+    uint32_t payloadBytes = 0;
+    uint32_t paddingBytes = 0;
+    for (uint32_t i = 0; i < frameCount; i++) {
+        CHECK(appendFrame(ring, i, lengths[i], i * kFrameUs));
+        payloadBytes += lengths[i];
+        paddingBytes += lengths[i] & 1;
+    }
+    REQUIRE(ring.requestFreeze());
+    CHECK(!appendFrame(ring, 99, 100, frameCount * kFrameUs));
+
+    std::vector<uint8_t> avi;
+    REQUIRE(ring.exportAvi(collect, &avi, true));
+    CHECK(ring.getState() == PreEventRingState::Recording);
+
+    AviClipInfo info;
+    info.frameCount = frameCount;
+    info.payloadBytes = payloadBytes;
+    info.paddingBytes = paddingBytes;
+    CHECK_EQ(avi.size(), aviFileSize(info));
+
+    CHECK_EQ(fourccAt(avi, 0), std::string("RIFF"));
+    CHECK_EQ((size_t)u32At(avi, 4), avi.size() - 8);
+    CHECK_EQ(fourccAt(avi, 8), std::string("AVI "));
+    CHECK_EQ(fourccAt(avi, kAvihData - 8), std::string("avih"));
+    CHECK_EQ(u32At(avi, kAvihData), (uint32_t)kFrameUs);        // dwMicroSecPerFrame
+    CHECK_EQ(u32At(avi, kAvihData + 16), frameCount);           // dwTotalFrames
+    CHECK_EQ(u32At(avi, kAvihData + 28), 1500u);                // dwSuggestedBufferSize
+    CHECK_EQ(u32At(avi, kAvihData + 32), 160u);
+    CHECK_EQ(u32At(avi, kAvihData + 36), 120u);
+
+    CHECK_EQ(fourccAt(avi, kMoviList), std::string("LIST"));
+    CHECK_EQ(fourccAt(avi, kMoviFourcc), std::string("movi"));
+    const uint32_t moviBytes = u32At(avi, kMoviList + 4);
+    CHECK_EQ(moviBytes, 4 + frameCount * 8 + payloadBytes + paddingBytes);
+
+    std::vector<ParsedFrame> frames;
+    size_t offset = kMoviFourcc + 4;
+    for (uint32_t i = 0; i < frameCount; i++) {
+        CHECK_EQ(fourccAt(avi, offset), std::string("00dc"));
+        const uint32_t len = u32At(avi, offset + 4);
+        CHECK_EQ(len, lengths[i]);
+        const std::vector<uint8_t> jpeg = makeJpeg(i, lengths[i]);
+        CHECK(memcmp(avi.data() + offset + 8, jpeg.data(), jpeg.size()) == 0);
+        frames.push_back({ offset, len });
+        offset += 8 + len + (len & 1);
+    }
+    CHECK_EQ(offset, kMoviList + 8 + moviBytes);
+
+    CHECK_EQ(fourccAt(avi, offset), std::string("idx1"));
+    CHECK_EQ(u32At(avi, offset + 4), frameCount * 16);
+    offset += 8;
+    for (uint32_t i = 0; i < frameCount; i++) {
+        CHECK_EQ(fourccAt(avi, offset), std::string("00dc"));
+        CHECK_EQ(u32At(avi, offset + 4), 0x10u);                // AVIIF_KEYFRAME
+        // idx1 offsets count from the 'movi' fourcc to the chunk header.
+        CHECK_EQ((size_t)u32At(avi, offset + 8), frames[i].chunkOffset - kMoviFourcc);
+        CHECK_EQ(u32At(avi, offset + 12), frames[i].len);
+        offset += 16;
+    }
+    CHECK_EQ(offset, avi.size());
+}
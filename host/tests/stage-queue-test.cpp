@@ -0,0 +1,242 @@
+#include "host-test.h"
+#include "data-types/stage-queue.h"
+#include <atomic>
+#include <thread>
+
+namespace {
+
+constexpr size_t kPayloadWords = 256;
+
+// inUse is set by the consumer between acquire() and release(); a producer that gets such a slot from
+// beginWrite() would overwrite an input the invoke stage is still reading.
+struct Payload {
+    std::atomic<bool> inUse{false};
+    uint32_t seq = 0;
+    uint32_t words[kPayloadWords] = {};
+};
+
+void fillPayload(Payload& payload, uint32_t seq)
+{
+    payload.seq = seq;
+    for (size_t i = 0; i < kPayloadWords; i++) {
+        payload.words[i] = seq ^ (uint32_t)(i * 2654435761u);
+    }
+}
+
+bool payloadIntact(const Payload& payload, uint32_t seq)
+{
+    if (payload.seq != seq) {
+        return false;
+    }
+    for (size_t i = 0; i < kPayloadWords; i++) {
+        if (payload.words[i] != (seq ^ (uint32_t)(i * 2654435761u))) {
+            return false;
+        }
+    }
+    return true;
+}
+
+struct RaceResult {
+    uint32_t consumed = 0;
+    uint32_t outOfOrder = 0;
+    uint32_t torn = 0;
+    uint32_t reusedWhileAcquired = 0;
+    uint32_t producerFull = 0;     // beginWrite() found every slot queued or held
+    uint32_t consumerEmpty = 0;    // acquire() found nothing queued
+};
+
+// The preprocessing stage (producer) and the invoke stage (consumer) on two threads. Every published
+// slot must arrive once, in order and intact, and beginWrite() must never hand out the acquired slot.
+// The consumer holds each slot and re-reads it; every holdMask + 1 slots it also stalls, so both the
+// full and the empty edge are crossed many times.
+template <size_t Depth>
+RaceResult race(uint32_t frames, uint32_t holdMask)
+{
+    StageQueue<Payload, Depth> queue;
+    RaceResult result;
+    std::atomic<uint32_t> reused{0};
+    std::atomic<uint32_t> full{0};
+
+    std::thread producer([&] {
+        uint32_t seq = 0;
+        while (seq < frames) {
+            Payload* slot = queue.beginWrite();
+            if (!slot) {
+                full.fetch_add(1, std::memory_order_relaxed);
+                std::this_thread::yield();
+                continue;
+            }
+            if (slot->inUse.load(std::memory_order_acquire)) {
+                reused.fetch_add(1, std::memory_order_relaxed);
+            }
+            fillPayload(*slot, ++seq);
+            queue.publish();
+        }
+    });
+
+    uint32_t expected = 1;
+    while (expected <= frames) {
+        Payload* slot = queue.acquire();
+        if (!slot) {
+            result.consumerEmpty++;
+            std::this_thread::yield();
+            continue;
+        }
+        slot->inUse.store(true, std::memory_order_release);
+        if (slot->seq != expected) {
+            result.outOfOrder++;
+        }
+        const uint32_t seq = slot->seq;
+        for (int pass = 0; pass < 4; pass++) {
+            if (!payloadIntact(*slot, seq)) {
+                result.torn++;
+                break;
+            }
+        }
+        if ((expected & holdMask) == 0) {
+            std::this_thread::yield();
+        }
+        slot->inUse.store(false, std::memory_order_release);
+        queue.release();
+        result.consumed++;
+        expected = seq + 1;
+    }
+    producer.join();
+
+    result.reusedWhileAcquired = reused.load();
+    result.producerFull = full.load();
+    return result;
+}
+
+} // namespace
+
+HOST_TEST(emptyQueueHasNothingToAcquire)
+{
+    StageQueue<int, 2> queue;
+    CHECK_EQ(queue.depth(), (size_t)2);
+    CHECK(queue.acquire() == nullptr);
+    CHECK_EQ(queue.occupied(), (size_t)0);
+
+    // A slot taken with beginWrite() but not published is not visible to the consumer, and the
+    // producer gets the same slot back.
+    int* slot = queue.beginWrite();
+    REQUIRE(slot != nullptr);
+    *slot = 7;
+    CHECK(queue.beginWrite() == slot);
+    CHECK(queue.acquire() == nullptr);
+    CHECK_EQ(queue.occupied(), (size_t)0);
+}
+
+HOST_TEST(slotsComeOutInPublishOrder)
+{
+    StageQueue<int, 3> queue;
+    for (int round = 0; round < 5; round++) {
+        for (int i = 0; i < 3; i++) {
+            int* slot = queue.beginWrite();
+            REQUIRE(slot != nullptr);
+            *slot = round * 10 + i;
+            queue.publish();
+        }
+        for (int i = 0; i < 3; i++) {
+            int* slot = queue.acquire();
+            REQUIRE(slot != nullptr);
+            CHECK_EQ(*slot, round * 10 + i);
+            queue.release();
+        }
+        CHECK(queue.acquire() == nullptr);
+    }
+}
+
+HOST_TEST(fullQueueRefusesTheProducerUntilRelease)
+{
+    StageQueue<int, 3> queue;
+    for (int i = 0; i < 3; i++) {
+        int* slot = queue.beginWrite();
+        REQUIRE(slot != nullptr);
+        *slot = i;
+        queue.publish();
+    }
+    CHECK(queue.beginWrite() == nullptr);
+    CHECK_EQ(queue.occupied(), (size_t)3);
+
+    // An acquired slot still counts as occupied: the producer stays refused until release().
+    int* held = queue.acquire();
+    REQUIRE(held != nullptr);
+    CHECK_EQ(*held, 0);
+    CHECK(queue.beginWrite() == nullptr);
+    CHECK_EQ(queue.occupied(), (size_t)3);
+    // Acquiring again without a release gives the same slot, not the next one.
+    CHECK(queue.acquire() == held);
+
+    queue.release();
+    CHECK_EQ(queue.occupied(), (size_t)2);
+    int* next = queue.beginWrite();
+    CHECK(next == held);                // the slot just released, and only that one
+    CHECK_EQ(*queue.acquire(), 1);
+}
+
+HOST_TEST(producerNeverGetsTheAcquiredSlot)
+{
+    StageQueue<int, 3> queue;
+    int* first = queue.beginWrite();
+    REQUIRE(first != nullptr);
+    *first = 0;
+    queue.publish();
+    int* held = queue.acquire();
+    REQUIRE(held == first);
+
+    // The producer cycles through the other slots while the consumer keeps the first one.
+    for (int seq = 1; seq < 50; seq++) {
+        int* slot = queue.beginWrite();
+        if (!slot) {
+            int* queued = queue.acquire();
+            CHECK(queued == held);
+            break;
+        }
+        CHECK(slot != held);
+        *slot = seq;
+        queue.publish();
+    }
+    CHECK_EQ(*held, 0);
+    CHECK_EQ(queue.occupied(), (size_t)3);
+}
+
+HOST_TEST(singleSlotQueueAlternates)
+{
+    StageQueue<int, 1> queue;
+    int* slot = queue.beginWrite();
+    REQUIRE(slot != nullptr);
+    for (int seq = 0; seq < 10; seq++) {
+        REQUIRE(queue.beginWrite() == slot);
+        *slot = seq;
+        queue.publish();
+        CHECK(queue.beginWrite() == nullptr);
+        REQUIRE(queue.acquire() == slot);
+        CHECK(queue.beginWrite() == nullptr);
+        CHECK_EQ(*slot, seq);
+        queue.release();
+        CHECK(queue.acquire() == nullptr);
+    }
+}
+
+HOST_TEST(twoStagesKeepOrderAndNeverShareASlot)
+{
+    const RaceResult result = race<3>(100000, 7);
+    CHECK_EQ(result.consumed, 100000u);
+    CHECK_EQ(result.outOfOrder, 0u);
+    CHECK_EQ(result.torn, 0u);
+    CHECK_EQ(result.reusedWhileAcquired, 0u);
+    // Both edges were really exercised.
+    CHECK(result.producerFull > 0);
+    CHECK(result.consumerEmpty > 0);
+}
+
+HOST_TEST(twoStagesThroughASingleSlot)
+{
+    const RaceResult result = race<1>(20000, 3);
+    CHECK_EQ(result.consumed, 20000u);
+    CHECK_EQ(result.outOfOrder, 0u);
+    CHECK_EQ(result.torn, 0u);
+    CHECK_EQ(result.reusedWhileAcquired, 0u);
+    CHECK(result.producerFull > 0);
+}
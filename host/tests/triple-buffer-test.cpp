@@ -0,0 +1,247 @@
+#include "host-test.h"
+#include "fake-camera.h"
+#include "data-types/frame-mailbox.h"
+#include "data-types/triple-buffer.h"
+#include <atomic>
+#include <thread>
+
+namespace {
+
+constexpr size_t kPayloadWords = 1024;
+
+struct Payload {
+    uint32_t seq = 0;
+    uint32_t words[kPayloadWords] = {};
+};
+
+void fillPayload(Payload& payload, uint32_t seq)
+{
+    payload.seq = seq;
+    for (size_t i = 0; i < kPayloadWords; i++) {
+        payload.words[i] = seq ^ (uint32_t)(i * 2654435761u);
+    }
+}
+
+bool payloadIntact(const Payload& payload)
+{
+    for (size_t i = 0; i < kPayloadWords; i++) {
+        if (payload.words[i] != (payload.seq ^ (uint32_t)(i * 2654435761u))) {
+            return false;
+        }
+    }
+    return true;
+}
+
+} // namespace
+
+HOST_TEST(acquireReturnsOnlyFreshSlots)
+{
+    TripleBuffer<int> buffer;
+    buffer.reset();
+    CHECK(buffer.acquire() == nullptr);
+    CHECK(!buffer.hasFresh());
+
+    buffer.beginWrite() = 1;
+    buffer.publish();
+    buffer.beginWrite() = 2;
+    buffer.publish();
+    CHECK(buffer.hasFresh());
+    int* newest = buffer.acquire();
+    REQUIRE(newest != nullptr);
+    CHECK_EQ(*newest, 2);              // 1 was overwritten unread
+    CHECK(buffer.acquire() == nullptr);
+    buffer.release();
+    CHECK_EQ(*newest, 0);              // release() clears the slot
+}
+
+HOST_TEST(heldSlotIsNeverWrittenByThePublisher)
+{
+    TripleBuffer<int> buffer;
+    buffer.reset();
+    buffer.beginWrite() = 10;
+    buffer.publish();
+    int* held = buffer.acquire();
+    REQUIRE(held != nullptr);
+    for (int seq = 11; seq < 100; seq++) {
+        int& back = buffer.beginWrite();
+        CHECK(&back != held);
+        back = seq;
+        buffer.publish();
+    }
+    CHECK_EQ(*held, 10);
+    buffer.release();
+    int* next = buffer.acquire();
+    REQUIRE(next != nullptr);
+    CHECK_EQ(*next, 99);
+}
+
+// The writer publishes as fast as it can while the reader holds each acquired slot and re-reads it many
+// times: any write into a held slot shows up as a changed or torn payload.
+HOST_TEST(readerHoldsWhileWriterSpins)
+{
+    TripleBuffer<Payload> buffer;
+    buffer.reset();
+    std::atomic<bool> stop{false};
+    std::atomic<uint32_t> published{0};
+
+    std::thread writer([&] {
+        uint32_t seq = 0;
+        while (!stop.load(std::memory_order_relaxed)) {
+            fillPayload(buffer.beginWrite(), ++seq);
+            buffer.publish();
+            published.store(seq, std::memory_order_relaxed);
+            if (seq % 64 == 0) {
+                std::this_thread::yield();      // lets the reader run on a single-core host
+            }
+        }
+    });
+
+    uint32_t acquired = 0;
+    uint32_t torn = 0;
+    uint32_t reordered = 0;
+    uint32_t lastSeq = 0;
+    while (acquired < 2000) {
+        Payload* payload = buffer.acquire();
+        if (!payload) {
+            std::this_thread::yield();
+            continue;
+        }
+        acquired++;
+        const uint32_t seq = payload->seq;
+        if (seq <= lastSeq) {
+            reordered++;
+        }
+        lastSeq = seq;
+        for (int pass = 0; pass < 8; pass++) {
+            if (payload->seq != seq || !payloadIntact(*payload)) {
+                torn++;
+                break;
+            }
+        }
+        buffer.release();
+    }
+    stop.store(true);
+    writer.join();
+
+    CHECK_EQ(torn, 0u);
+    CHECK_EQ(reordered, 0u);
+    CHECK(published.load() > acquired);     // the writer really did run over the held slots
+}
+
+// The same race through FrameMailboxManager with lent camera buffers: every buffer goes back to the
+// driver exactly when the last slot referencing it is overwritten or released.
+HOST_TEST(mailboxReturnsEveryFrameUnderLoad)
+{
+    FrameMailbox mailbox;
+    FrameMailboxManager manager(&mailbox);
+    REQUIRE(manager.initFrameMailbox("test"));
+    FakeCamera camera(FRAME_LENDER_SLOTS, 4096);
+    std::atomic<bool> stop{false};
+    std::atomic<uint32_t> captured{0};
+
+    std::thread writer([&] {
+        uint32_t seq = 0;
+        while (!stop.load(std::memory_order_relaxed)) {
+            FrameHandle frame = camera.capture(seq + 1);
+            if (!frame.isValid()) {
+                std::this_thread::yield();
+                continue;
+            }
+            seq++;
+            manager.publish(frame, 64, 64, PIXFORMAT_JPEG, (int64_t)seq);
+            captured.store(seq, std::memory_order_relaxed);
+            if (seq % 64 == 0) {
+                std::this_thread::yield();
+            }
+        }
+    });
+
+    uint32_t acquired = 0;
+    uint32_t corrupt = 0;
+    uint32_t lastSeq = 0;
+    while (acquired < 2000) {
+        const FrameSnapshot* snapshot = manager.acquire();
+        if (!snapshot) {
+            std::this_thread::yield();
+            continue;
+        }
+        acquired++;
+        // The mailbox numbers frames itself; the payload carries the capture order in captureUs.
+        if (snapshot->seq <= lastSeq || !FakeCamera::matches(snapshot->data, snapshot->len, (uint32_t)snapshot->captureUs)) {
+            corrupt++;
+        }
+        lastSeq = snapshot->seq;
+        manager.release();
+    }
+    stop.store(true);
+    writer.join();
+    CHECK_EQ(corrupt, 0u);
+
+    // Whatever is still parked in the mailbox goes back on flush and the final acquire/release.
+    manager.flush();
+    CHECK(manager.acquire() == nullptr);
+    manager.release();
+    CHECK_EQ(camera.heldBuffers(), 0u);
+    CHECK_EQ(camera.totalReturns(), captured.load());
+}
+
+HOST_TEST(consumerLagCountsUnreadPublishes)
+{
+    FrameMailbox mailbox;
+    FrameMailboxManager manager(&mailbox);
+    REQUIRE(manager.initFrameMailbox("lag"));
+    FakeCamera camera(FRAME_LENDER_SLOTS, 16);
+
+    for (uint32_t seq = 1; seq <= 3; seq++) {
+        manager.publish(camera.capture(seq), 4, 4, PIXFORMAT_GRAYSCALE, seq);
+    }
+    CHECK_EQ(manager.getPublishedSeq(), 3u);
+    CHECK_EQ(manager.getConsumerLag(), 3u);
+    const FrameSnapshot* snapshot = manager.acquire();
+    REQUIRE(snapshot != nullptr);
+    CHECK_EQ(snapshot->seq, 3u);
+    CHECK_EQ(manager.getConsumerLag(), 0u);
+    manager.release();
+    // Frames 1 and 2 were dropped as soon as a newer one was published, and 3 is released.
+    CHECK_EQ(camera.heldBuffers(), 0u);
+    manager.flush();
+    CHECK_EQ(camera.heldBuffers(), 0u);
+    CHECK(manager.acquire() == nullptr);
+}
+
+// Nobody reads the mailbox: each publish drops the frame it replaces at once, so the mailbox pins exactly
+// one camera buffer and the driver always has the others to capture into.
+HOST_TEST(unreadMailboxPinsOneBuffer)
+{
+    FrameMailbox mailboxes[2];
+    FrameMailboxManager first(&mailboxes[0]);
+    FrameMailboxManager second(&mailboxes[1]);
+    REQUIRE(first.initFrameMailbox("unread-a"));
+    REQUIRE(second.initFrameMailbox("unread-b"));
+    FakeCamera camera(3, 16);
+
+    for (uint32_t seq = 1; seq <= 20; seq++) {
+        FrameHandle frame = camera.capture(seq);
+        REQUIRE(frame.isValid());
+        first.publish(frame, 4, 4, PIXFORMAT_GRAYSCALE, seq);
+        second.publish(frame, 4, 4, PIXFORMAT_GRAYSCALE, seq);
+        frame = FrameHandle();
+        // Both mailboxes share the newest frame; every older one is back with the driver.
+        CHECK_EQ(camera.lender().getLentCount(), (size_t)1);
+        CHECK_EQ(camera.heldBuffers(), (size_t)1);
+    }
+    CHECK_EQ(camera.totalReturns(), 19u);
+
+    // With a slow reader holding its frame, one more buffer is pinned and no more.
+    const FrameSnapshot* held = first.acquire();
+    REQUIRE(held != nullptr);
+    for (uint32_t seq = 21; seq <= 30; seq++) {
+        first.publish(camera.capture(seq), 4, 4, PIXFORMAT_GRAYSCALE, seq);
+        CHECK_EQ(camera.lender().getLentCount(), (size_t)2);     // the held frame (also in second) and the newest
+        CHECK_EQ(first.getPublishedSeq(), seq);
+    }
+    first.release();
+    first.flush();
+    second.flush();
+    CHECK_EQ(camera.lender().getLentCount(), (size_t)0);
+}
@@ -8,6 +8,9 @@
 #include "led/red-led.h"
 
 #include "checkpoint-timer/checkpoint-timer.h" //A
+#include "data-types/frame-pool.h"
+#include "memory/buffer-placement.h"
+#include "esp_heap_caps.h"
 
 
 extern RgbLedController rgb;
@@ -35,9 +38,47 @@ extern CheckpointTimer tensorFlowTimer;
 extern CheckpointTimer httpTimer;
 
 // Large enough for QQVGA grayscale and worst-case QQVGA JPEG payload bursts.
+// This is the biggest frame pool block; larger payloads follow kFramePoolOversizePolicy.
 constexpr size_t kPublishedFrameMaxBytes = (65 * 1024); // 65 KB
 
+// Frame payload size classes shared by every copying frame store; FramePool orders them by block size.
+// A QQVGA JPEG is typically 3-8 KB, a 96x96 grayscale frame 9 KB, a QQVGA grayscale frame 19 KB.
+constexpr FramePoolClassConfig kFramePoolClasses[] = {
+    { 4 * 1024, 4 },
+    { 8 * 1024, 4 },
+    { 16 * 1024, 3 },
+    { 32 * 1024, 2 },
+    { kPublishedFrameMaxBytes, 1 },
+};
+constexpr FramePoolOversizePolicy kFramePoolOversizePolicy = FramePoolOversizePolicy::Reject;
+
 // The current inference camera mode is QQVGA, so a full grayscale scratch frame fits here.
 constexpr size_t kAcquiredFrameMaxPixels = 160 * 120;
 
+// Motion gate thumbnail (1:8 decode) per pixel: Q8.8 background and luma. The RGB565 decode output
+// lives in the inference task's JpegDecoderContext.
+constexpr size_t kMotionThumbnailBytesPerPixel = 2 + 1;
+
+// Where each long-lived pipeline buffer is allocated, one entry per PlacedBuffer (looked up by id, so in any
+// order). Tiers are tried left to right.
+// Small buffers touched per pixel every frame go to internal SRAM first (the octal PSRAM runs at 40 MHz);
+// bulk frame storage stays in PSRAM. 16-byte alignment matches the esp-nn/PIE vector loads.
+constexpr uint32_t kPlaceInternal = MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT;
+constexpr uint32_t kPlacePsram = MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT;
+constexpr BufferPlacementPolicy kBufferPlacementPolicies[] = {
+    { PlacedBuffer::InferenceGray96,    "inference gray96",    16, { kPlaceInternal, kPlacePsram, 0 } },
+    { PlacedBuffer::InferenceWorkspace, "inference workspace", 16, { kPlaceInternal, kPlacePsram, 0 } },
+    { PlacedBuffer::StreamGray96,       "stream gray96",       16, { kPlaceInternal, kPlacePsram, 0 } },
+    { PlacedBuffer::StreamWorkspace,    "stream workspace",    16, { kPlaceInternal, kPlacePsram, 0 } },
+    { PlacedBuffer::TensorArena,        "tensor arena",        16, { kPlaceInternal, kPlacePsram, 0 } },
+    { PlacedBuffer::TensorArenaPersistent, "tensor arena persistent", 16, { kPlacePsram, kPlaceInternal, 0 } },
+    { PlacedBuffer::FramePoolSlabs,     "frame pool slabs",    32, { kPlacePsram, 0, 0 } },
+    { PlacedBuffer::PreEventRing,       "pre-event ring",       8, { kPlacePsram, 0, 0 } },
+    { PlacedBuffer::UdpPacket,          "udp packet",           4, { kPlaceInternal | MALLOC_CAP_DMA, kPlaceInternal, 0 } },
+    { PlacedBuffer::MotionThumbnail,    "motion thumbnail",    16, { kPlaceInternal, kPlacePsram, 0 } },
+    { PlacedBuffer::InjectedFrames,     "injected frames",      4, { kPlacePsram, 0, 0 } },
+    { PlacedBuffer::JpegDecoder,        "jpeg decoder",        16, { kPlaceInternal, kPlacePsram, 0 } },
+    { PlacedBuffer::DetectionTiles,     "detection tiles",      4, { kPlaceInternal, kPlacePsram, 0 } },
+};
+
 
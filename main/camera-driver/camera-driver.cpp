@@ -5,6 +5,9 @@
 #include "debug.h"
 #include "app-globals.h"
 #include "data-types/frame-mailbox.h"
+#include "clip-recorder/pre-event-ring.h"
+#include "http-server/http-frame-buffer.h"
+#include "image-editing/editing.h"
 #include <driver/gpio.h>
 #include <esp_timer.h>
 
@@ -27,7 +30,14 @@
 
 // Sync signals
 
-CameraDriver::CameraDriver() {
+int64_t EspTimerPacerClock::nowUs() const
+{
+    return esp_timer_get_time();
+}
+
+CameraDriver::CameraDriver()
+    : capturePacer(&pacerClock, makePacerConfig())
+{
     configureCamera();
 }
 
@@ -54,12 +64,19 @@ void CameraDriver::configureCamera() {
     config.pin_sccb_scl = SIOC_GPIO_NUM;
     config.pin_pwdn = PWDN_GPIO_NUM;
     config.pin_reset = RESET_GPIO_NUM;
-    config.xclk_freq_hz = 10000000; //was 20000000
-    config.pixel_format = PIXFORMAT_JPEG; //PIXFORMAT_JPEG; //PIXFORMAT_GRAYSCALE; 
+    settings.xclkFreqHz = 10000000; //was 20000000
+    settings.pixelFormat = PIXFORMAT_JPEG; //PIXFORMAT_JPEG; //PIXFORMAT_GRAYSCALE; 
     //IMAGE_FRAME_SIZE_FOR_INFERENCE; // FRAMESIZE_QQVGA; //used with inference
-    config.frame_size = FRAMESIZE_QQVGA;
-    config.jpeg_quality = 15; //0-63 lower number means higher quality
-    config.fb_count = 2;
+    settings.frameSize = FRAMESIZE_QQVGA;
+    settings.jpegQuality = 15; //0-63 lower number means higher quality
+    settings.fbCount = CAMERA_FB_COUNT; // frames are lent to consumers, keep one spare for DMA
+    settings.targetFps = CAPTURE_TARGET_FPS;
+    config.xclk_freq_hz = settings.xclkFreqHz;
+    config.pixel_format = settings.pixelFormat;
+    config.frame_size = settings.frameSize;
+    config.jpeg_quality = settings.jpegQuality;
+    streamBudgetQuality = settings.jpegQuality;
+    config.fb_count = settings.fbCount;
     config.fb_location = CAMERA_FB_IN_PSRAM; //Store in internal RAM
     config.grab_mode = CAMERA_GRAB_LATEST;
 }
@@ -69,6 +86,14 @@ esp_err_t CameraDriver::init(FrameMailboxManager* streamMailboxManagerPtr, Frame
     streamMailboxManagerPtr_ = streamMailboxManagerPtr;
     inferenceMailboxManagerPtr_ = inferenceMailboxManagerPtr;
 
+    reconfigureMutex = xSemaphoreCreateMutex();
+    captureParkedSem = xSemaphoreCreateBinary();
+    captureResumeSem = xSemaphoreCreateBinary();
+    if (!reconfigureMutex || !captureParkedSem || !captureResumeSem) {
+        ESP_LOGE(CAMERA_TAG, "Failed to create reconfiguration semaphores");
+        return ESP_ERR_NO_MEM;
+    }
+
     esp_err_t err = esp_camera_init(&config);
     if (err != ESP_OK) {
         ESP_LOGE(CAMERA_TAG, "Camera initialization failed: 0x%x", err);
@@ -76,6 +101,13 @@ esp_err_t CameraDriver::init(FrameMailboxManager* streamMailboxManagerPtr, Frame
         ESP_LOGI(CAMERA_TAG, "Camera successfully initialized");
     }
 
+    applyOrientation();
+
+    return err;
+}
+
+void CameraDriver::applyOrientation()
+{
     // Flip image 180°
     sensor_t *s = esp_camera_sensor_get();
     if (s) {
@@ -85,8 +117,277 @@ esp_err_t CameraDriver::init(FrameMailboxManager* streamMailboxManagerPtr, Frame
     } else {
         ESP_LOGW(OV2640_TAG, "Failed to get camera sensor handle for flipping");
     }
+}
 
-    return err;
+CameraSettings CameraDriver::getSettings()
+{
+    CameraSettings current;
+    if (xSemaphoreTake(reconfigureMutex, portMAX_DELAY) == pdTRUE) {
+        current = settings;
+        xSemaphoreGive(reconfigureMutex);
+    }
+    return current;
+}
+
+const char* CameraDriver::validateSettings(const CameraSettings& requested)
+{
+    if (requested.frameSize < 0 || requested.frameSize > CAMERA_RECONFIG_MAX_FRAMESIZE) {
+        return "frame size out of range";
+    }
+    if (requested.pixelFormat != PIXFORMAT_JPEG &&
+        requested.pixelFormat != PIXFORMAT_GRAYSCALE &&
+        requested.pixelFormat != PIXFORMAT_RGB565) {
+        return "pixel format must be jpeg, grayscale or rgb565";
+    }
+    if (requested.pixelFormat != PIXFORMAT_JPEG && requested.frameSize > CAMERA_RECONFIG_MAX_RAW_FRAMESIZE) {
+        return "frame size too large for a raw pixel format";
+    }
+    if (requested.jpegQuality < 4 || requested.jpegQuality > 63) {
+        return "jpeg quality must be 4-63";
+    }
+    if (requested.xclkFreqHz < 5000000 || requested.xclkFreqHz > 20000000) {
+        return "xclk must be 5-20 MHz";
+    }
+    // Lending needs one buffer for the DMA plus at least one for readers.
+    if (requested.fbCount < 2 || requested.fbCount > FRAME_LENDER_SLOTS) {
+        return "fb count out of range";
+    }
+    if (requested.targetFps < 0.0f || requested.targetFps > 60.0f) {
+        return "target fps must be 0-60";
+    }
+    return nullptr;
+}
+
+bool CameraDriver::needsReinit(const CameraSettings& requested) const
+{
+    if (requested.pixelFormat != settings.pixelFormat ||
+        requested.xclkFreqHz != settings.xclkFreqHz ||
+        requested.fbCount != settings.fbCount) {
+        return true;
+    }
+    // JPEG buffers have a fixed size (CONFIG_CAMERA_JPEG_MODE_FRAME_SIZE); raw buffers were sized for the
+    // frame size used at init and cannot grow in place.
+    const uint32_t requestedPixels = (uint32_t)resolution[requested.frameSize].width * resolution[requested.frameSize].height;
+    const uint32_t allocatedPixels = (uint32_t)resolution[config.frame_size].width * resolution[config.frame_size].height;
+    return requested.pixelFormat != PIXFORMAT_JPEG && requestedPixels > allocatedPixels;
+}
+
+bool CameraDriver::quiesceCapture()
+{
+    if (!captureTaskRunning.load(std::memory_order_acquire)) {
+        return true;
+    }
+    xSemaphoreTake(captureParkedSem, 0);
+    captureParkState.store(CaptureParkState::ParkRequested, std::memory_order_release);
+    // capture_task parks at the top of its loop; esp_camera_fb_get() waits at most one frame time.
+    if (xSemaphoreTake(captureParkedSem, pdMS_TO_TICKS(CAMERA_RECONFIG_TIMEOUT_MS)) == pdTRUE) {
+        return true;
+    }
+    // Withdraw the request unless capture_task took it in the meantime. If it did, it is parked (or about
+    // to give the semaphore) and waits for resumeCapture(), so the quiesce succeeded after all.
+    CaptureParkState expected = CaptureParkState::ParkRequested;
+    if (captureParkState.compare_exchange_strong(expected, CaptureParkState::Running, std::memory_order_acq_rel)) {
+        return false;
+    }
+    xSemaphoreTake(captureParkedSem, portMAX_DELAY);
+    return true;
+}
+
+void CameraDriver::resumeCapture()
+{
+    CaptureParkState expected = CaptureParkState::Parked;
+    if (captureParkState.compare_exchange_strong(expected, CaptureParkState::Running, std::memory_order_acq_rel)) {
+        xSemaphoreGive(captureResumeSem);
+    }
+}
+
+bool CameraDriver::drainLentFrames(int64_t timeoutUs)
+{
+    // capture_task is parked, so this task acts as the mailbox producer while it flushes.
+    #if ENABLE_RGB_STREAM_TASK
+        streamMailboxManagerPtr_->flush();
+    #endif
+    #if ENABLE_INFERENCE
+        inferenceMailboxManagerPtr_->flush();
+    #endif
+    httpFrameBuffer.clearActiveHttpFrame();
+
+    // Consumers still working on a frame return it when they release it or finish sending.
+    const int64_t deadlineUs = esp_timer_get_time() + timeoutUs;
+    while (activeSource->getLentCount() > 0) {
+        if (esp_timer_get_time() >= deadlineUs) {
+            return false;
+        }
+        vTaskDelay(pdMS_TO_TICKS(10));
+    }
+    return true;
+}
+
+bool CameraDriver::frameMatchesSettings(const camera_fb_t* fb) const
+{
+    const uint16_t expectedWidth = resolution[settings.frameSize].width;
+    const uint16_t expectedHeight = resolution[settings.frameSize].height;
+    if (!fb || fb->format != settings.pixelFormat) {
+        return false;
+    }
+    // fb->width/height are stamped from the sensor state at fb_get time, so they cannot prove which
+    // geometry the pixels were captured with; the payload itself is checked instead.
+    if (fb->format == PIXFORMAT_JPEG) {
+        uint16_t jpegWidth = 0;
+        uint16_t jpegHeight = 0;
+        return readJpegDimensions(fb->buf, fb->len, &jpegWidth, &jpegHeight) &&
+               jpegWidth == expectedWidth &&
+               jpegHeight == expectedHeight;
+    }
+    const size_t bytesPerPixel = (fb->format == PIXFORMAT_GRAYSCALE) ? 1 : 2;
+    return fb->len == (size_t)expectedWidth * expectedHeight * bytesPerPixel;
+}
+
+esp_err_t CameraDriver::reconfigure(const CameraSettings& requested, CameraReconfigureResult* result)
+{
+    CameraReconfigureResult localResult;
+    CameraReconfigureResult& out = result ? *result : localResult;
+    out = CameraReconfigureResult();
+    const int64_t startUs = esp_timer_get_time();
+
+    const char* invalid = validateSettings(requested);
+    if (invalid) {
+        out.err = ESP_ERR_INVALID_ARG;
+        out.message = invalid;
+        return out.err;
+    }
+    if (xSemaphoreTake(reconfigureMutex, pdMS_TO_TICKS(CAMERA_RECONFIG_TIMEOUT_MS)) != pdTRUE) {
+        out.err = ESP_ERR_TIMEOUT;
+        out.message = "another reconfiguration is running";
+        return out.err;
+    }
+
+    const bool geometryChanges = requested.frameSize != settings.frameSize ||
+                                 requested.pixelFormat != settings.pixelFormat;
+    // Compared with what the sensor runs at: applyStreamBudget() may have moved it off settings.jpegQuality.
+    const bool qualityChanges = requested.jpegQuality != streamBudgetQuality;
+    const bool sensorChanges = geometryChanges || qualityChanges;
+    const bool reinit = needsReinit(requested);
+    out.path = reinit ? CameraSwitchPath::Reinit : (sensorChanges ? CameraSwitchPath::Sensor : CameraSwitchPath::None);
+
+    int64_t phaseUs = esp_timer_get_time();
+    if (!quiesceCapture()) {
+        out.err = ESP_ERR_TIMEOUT;
+        out.message = "capture task did not park";
+        xSemaphoreGive(reconfigureMutex);
+        return out.err;
+    }
+    out.quiesceUs = esp_timer_get_time() - phaseUs;
+
+    phaseUs = esp_timer_get_time();
+    if (geometryChanges || reinit) {
+        // esp_camera_deinit frees the buffers, so every lent frame must be back first.
+        const bool drained = drainLentFrames((int64_t)CAMERA_RECONFIG_TIMEOUT_MS * 1000);
+        if (!drained && reinit) {
+            out.err = ESP_ERR_TIMEOUT;
+            out.message = "frames still held by consumers";
+        }
+    }
+    out.drainUs = esp_timer_get_time() - phaseUs;
+
+    phaseUs = esp_timer_get_time();
+    if (out.err == ESP_OK && reinit) {
+        const camera_config_t previousConfig = config;
+        esp_camera_deinit();
+        config.pixel_format = requested.pixelFormat;
+        config.frame_size = requested.frameSize;
+        config.jpeg_quality = requested.jpegQuality;
+        config.xclk_freq_hz = requested.xclkFreqHz;
+        config.fb_count = requested.fbCount;
+        out.err = esp_camera_init(&config);
+        if (out.err != ESP_OK) {
+            ESP_LOGE(CAMERA_TAG, "Camera re-init failed: 0x%x, restoring previous configuration", out.err);
+            out.message = "camera re-init failed, previous configuration restored";
+            config = previousConfig;
+            if (esp_camera_init(&config) != ESP_OK) {
+                ESP_LOGE(CAMERA_TAG, "Camera restore failed");
+                out.message = "camera re-init and restore failed";
+            }
+            streamBudgetQuality = config.jpeg_quality;
+        }
+        applyOrientation();
+    } else if (out.err == ESP_OK && sensorChanges) {
+        sensor_t* s = esp_camera_sensor_get();
+        if (!s) {
+            out.err = ESP_FAIL;
+            out.message = "no sensor handle";
+        } else {
+            if (requested.frameSize != settings.frameSize && s->set_framesize(s, requested.frameSize) != 0) {
+                out.err = ESP_FAIL;
+                out.message = "sensor rejected frame size";
+            }
+            if (out.err == ESP_OK && qualityChanges && s->set_quality(s, requested.jpegQuality) != 0) {
+                out.err = ESP_FAIL;
+                out.message = "sensor rejected jpeg quality";
+            }
+            if (out.err == ESP_OK) {
+                config.frame_size = requested.frameSize;
+                config.jpeg_quality = requested.jpegQuality;
+            }
+        }
+    }
+    out.applyUs = esp_timer_get_time() - phaseUs;
+
+    if (out.err == ESP_OK) {
+        settings = requested;
+        capturePacer.setTargetFps(requested.targetFps);
+        capturePacer.setMaxHeldFrames((uint32_t)requested.fbCount - 1);
+        // A stream budget computed against the old settings must not override the new ones.
+        streamBudgetQuality = requested.jpegQuality;
+        pendingTargetFps.store(-1.0f, std::memory_order_release);
+    }
+
+    // Frames queued before a geometry change come back stamped with the new size: throw them away
+    // until the driver delivers one whose payload matches the new settings.
+    phaseUs = esp_timer_get_time();
+    if (out.err == ESP_OK && geometryChanges) {
+        bool settled = false;
+        for (int attempt = 0; attempt < settings.fbCount + CAMERA_RECONFIG_SETTLE_FRAMES && !settled; attempt++) {
+            camera_fb_t* fb = esp_camera_fb_get();
+            if (!fb) {
+                continue;
+            }
+            settled = frameMatchesSettings(fb);
+            esp_camera_fb_return(fb);
+            out.discardedFrames++;
+        }
+        if (!settled) {
+            ESP_LOGW(CAMERA_TAG, "No frame with the new geometry after %lu discards", (unsigned long)out.discardedFrames);
+        }
+        #if ENABLE_PRE_EVENT_CLIP
+            // A clip is played back at one geometry; capture is parked, so this task owns the ring writer side.
+            preEventRing.clear();
+        #endif
+    }
+    out.settleUs = esp_timer_get_time() - phaseUs;
+
+    resumeCapture();
+    out.totalUs = esp_timer_get_time() - startUs;
+    xSemaphoreGive(reconfigureMutex);
+
+    ESP_LOGW(CAMERA_TAG,
+             "Reconfigure %s: path=%d total=%lld ms (quiesce=%lld drain=%lld apply=%lld settle=%lld ms, discarded=%lu) -> %ux%u fmt=%d q=%d xclk=%d fb=%d fps=%.1f",
+             out.err == ESP_OK ? "done" : out.message,
+             (int)out.path,
+             (long long)(out.totalUs / 1000),
+             (long long)(out.quiesceUs / 1000),
+             (long long)(out.drainUs / 1000),
+             (long long)(out.applyUs / 1000),
+             (long long)(out.settleUs / 1000),
+             (unsigned long)out.discardedFrames,
+             (unsigned int)resolution[settings.frameSize].width,
+             (unsigned int)resolution[settings.frameSize].height,
+             (int)settings.pixelFormat,
+             settings.jpegQuality,
+             settings.xclkFreqHz,
+             settings.fbCount,
+             settings.targetFps);
+    return out.err;
 }
 
 camera_fb_t* CameraDriver::captureFrame() 
@@ -108,6 +409,37 @@ void CameraDriver::releaseFrame(camera_fb_t* fb)
     }
 }
 
+CapturePacerConfig CameraDriver::makePacerConfig()
+{
+    CapturePacerConfig pacerConfig;
+    pacerConfig.targetFps = CAPTURE_TARGET_FPS;
+    pacerConfig.maxIntervalUs = (int64_t)CAPTURE_MAX_INTERVAL_MS * 1000;
+    pacerConfig.maxStreamLag = ENABLE_RGB_STREAM_TASK ? CAPTURE_MAX_STREAM_LAG : 0;
+    pacerConfig.maxInferenceLag = (ENABLE_INFERENCE && CAPTURE_PACE_ON_INFERENCE) ? 1 : 0;
+    // Readers may hold all but one buffer: in steady state the newest frame (HTTP store and mailboxes) and
+    // the one inference is running on. Only when they hold every buffer is the DMA left nothing to fill.
+    pacerConfig.maxHeldFrames = CAMERA_FB_COUNT - 1;
+    return pacerConfig;
+}
+
+CaptureBacklog CameraDriver::sampleBacklog() const
+{
+    CaptureBacklog backlog;
+    #if ENABLE_RGB_STREAM_TASK
+        backlog.streamLag = streamMailboxManagerPtr_->getConsumerLag();
+    #endif
+    #if ENABLE_INFERENCE
+        backlog.inferenceLag = inferenceMailboxManagerPtr_->getConsumerLag();
+    #endif
+    backlog.heldFrames = (uint32_t)activeSource->getLentCount();
+    return backlog;
+}
+
+CapturePacer* CameraDriver::getMutableCapturePacerPtr()
+{
+    return &capturePacer;
+}
+
 FrameMailboxManager* CameraDriver::getMutableStreamMailboxManagerPtr() 
 { 
     return streamMailboxManagerPtr_; 
@@ -118,15 +450,92 @@ FrameMailboxManager* CameraDriver::getMutableInferenceMailboxManagerPtr()
     return inferenceMailboxManagerPtr_; 
 }
 
+bool CameraDriver::applyStreamBudget(int jpegQuality, float targetFps)
+{
+    // Called from the network send path: never wait behind a reconfiguration.
+    if (xSemaphoreTake(reconfigureMutex, 0) != pdTRUE) {
+        return false;
+    }
+    bool applied = true;
+    if (settings.pixelFormat == PIXFORMAT_JPEG && jpegQuality != streamBudgetQuality) {
+        // Quality only changes the quantisation tables, not the geometry, so capture keeps running.
+        sensor_t* s = esp_camera_sensor_get();
+        if (s && s->set_quality(s, jpegQuality) == 0) {
+            streamBudgetQuality = jpegQuality;
+        } else {
+            applied = false;
+        }
+    }
+    pendingTargetFps.store(targetFps, std::memory_order_release);
+    xSemaphoreGive(reconfigureMutex);
+    return applied;
+}
+
+esp_err_t CameraDriver::setFrameSource(FrameSource* source)
+{
+    FrameSource* next = source ? source : &cameraSource;
+    if (xSemaphoreTake(reconfigureMutex, pdMS_TO_TICKS(CAMERA_RECONFIG_TIMEOUT_MS)) != pdTRUE) {
+        return ESP_ERR_TIMEOUT;
+    }
+    if (next == activeSource) {
+        xSemaphoreGive(reconfigureMutex);
+        return ESP_OK;
+    }
+
+    const int64_t startUs = esp_timer_get_time();
+    esp_err_t err = ESP_OK;
+    if (!quiesceCapture()) {
+        err = ESP_ERR_TIMEOUT;
+    } else if (!drainLentFrames((int64_t)CAMERA_RECONFIG_TIMEOUT_MS * 1000)) {
+        // Readers still hold frames of the old source: keep it rather than pull payloads from under them.
+        err = ESP_ERR_TIMEOUT;
+    } else {
+        FrameSource* previous = activeSource;
+        previous->onDeactivate();
+        next->onActivate();
+        activeSource = next;
+        #if ENABLE_PRE_EVENT_CLIP
+            preEventRing.clear();
+        #endif
+    }
+    resumeCapture();
+    xSemaphoreGive(reconfigureMutex);
+
+    if (err == ESP_OK) {
+        ESP_LOGW(CAMERA_TAG, "Frame source: %s (switched in %lld ms)",
+                 activeSource->name(),
+                 (long long)((esp_timer_get_time() - startUs) / 1000));
+    } else {
+        ESP_LOGE(CAMERA_TAG, "Frame source switch to %s failed: frames still held", next->name());
+    }
+    return err;
+}
+
 // Background task: capture frames and hand them to downstream consumers.
 void CameraDriver::capture_task(CameraDriver* cameraPtr)
 {
     ESP_LOGI(CAPTURE_TAG, "Camera capture task started");
+    cameraPtr->captureTaskRunning.store(true, std::memory_order_release);
     // CameraDriver* cameraPtr = static_cast<CameraDriver*>(arg);
-    uint32_t capturedFrames = 0;
-    int64_t captureWindowStartUs = esp_timer_get_time();
+    uint32_t captureSeq = 0;
 
     while (true) {
+        CaptureParkState parkRequested = CaptureParkState::ParkRequested;
+        if (cameraPtr->captureParkState.compare_exchange_strong(parkRequested, CaptureParkState::Parked,
+                                                                std::memory_order_acq_rel)) {
+            // Parked for reconfigure(): no frame is held here, the reconfiguring task owns the driver.
+            // Once Parked, the requester no longer withdraws, so resumeCapture() always follows.
+            xSemaphoreGive(cameraPtr->captureParkedSem);
+            xSemaphoreTake(cameraPtr->captureResumeSem, portMAX_DELAY);
+            continue;
+        }
+
+        // The pacer is only touched from this task; budget changes are handed over through an atomic.
+        const float budgetFps = cameraPtr->pendingTargetFps.exchange(-1.0f, std::memory_order_acq_rel);
+        if (budgetFps >= 0.0f && budgetFps != cameraPtr->capturePacer.getTargetFps()) {
+            cameraPtr->capturePacer.setTargetFps(budgetFps);
+        }
+
         if (pauseCameraAcquisition) {
             // Freeze mode keeps serving the last published frame to isolate HTTP/network speed.
             vTaskDelay(pdMS_TO_TICKS(10));
@@ -136,58 +545,89 @@ void CameraDriver::capture_task(CameraDriver* cameraPtr)
         // --- Handle JPEG decoding or raw frame ---
         ESP_LOGD(CAPTURE_TAG, "Handle JPEG decoding or raw frame, mark checkpoint"); 
         cameraAcquisitionTimer.checkpoint();
-        camera_fb_t *frameBuffer = esp_camera_fb_get();
-
-        vTaskDelay(pdMS_TO_TICKS(50));
-
-        if (!frameBuffer) {
-            ESP_LOGW(CAPTURE_TAG, "Failed to get frame buffer");
+        SourceFrame sourced;
+        const FrameAcquireResult acquired = cameraPtr->activeSource->acquire(&sourced);
+        if (acquired == FrameAcquireResult::NoFrame) {
+            ESP_LOGW(CAPTURE_TAG, "Failed to get frame buffer from %s", cameraPtr->activeSource->name());
             vTaskDelay(pdMS_TO_TICKS(100));
             continue;
         }
-        ESP_LOGD(CAPTURE_TAG, "Frame: %dx%d, len=%d, format=%d", frameBuffer->width, frameBuffer->height, frameBuffer->len, frameBuffer->format);
+        if (acquired == FrameAcquireResult::NoSlot) {
+            ESP_LOGW(CAPTURE_TAG, "No free lending slot, dropping frame");
+            vTaskDelay(pdMS_TO_TICKS(10));
+            continue;
+        }
+        // Every consumer shares the source's buffer; it goes back when the last one drops its handle.
+        FrameHandle& frame = sourced.handle;
+        ESP_LOGD(CAPTURE_TAG, "Frame: %dx%d, len=%d, format=%d", sourced.width, sourced.height, frame.len(), sourced.format);
         cameraAcquisitionTimer.logCheckpoint(CAPTURE_TAG, "frame captured");
 
         const int64_t captureUs = esp_timer_get_time();
 
+        captureSeq++;
+
+        #if ENABLE_PRE_EVENT_CLIP
+            // The only copy the clip recorder makes; the lent buffer itself is not held.
+            if (sourced.format == PIXFORMAT_JPEG) {
+                preEventRing.append(frame.data(),
+                                    frame.len(),
+                                    sourced.width,
+                                    sourced.height,
+                                    captureSeq,
+                                    captureUs);
+            }
+        #endif
+
         #if ENABLE_RGB_STREAM_TASK
             cameraPtr->getMutableStreamMailboxManagerPtr()->publish(
-                                                                    frameBuffer->buf,
-                                                                    frameBuffer->len,
-                                                                    frameBuffer->width,
-                                                                    frameBuffer->height,
-                                                                    frameBuffer->format,
+                                                                    frame,
+                                                                    sourced.width,
+                                                                    sourced.height,
+                                                                    sourced.format,
                                                                     captureUs);
         #endif
         #if ENABLE_INFERENCE
             cameraPtr->getMutableInferenceMailboxManagerPtr()->publish(
-                                                                    frameBuffer->buf,
-                                                                    frameBuffer->len,
-                                                                    frameBuffer->width,
-                                                                    frameBuffer->height,
-                                                                    frameBuffer->format,
+                                                                    frame,
+                                                                    sourced.width,
+                                                                    sourced.height,
+                                                                    sourced.format,
                                                                     captureUs);
         #endif
 
-        capturedFrames++;
-        const int64_t elapsedUs = captureUs - captureWindowStartUs;
-        if (elapsedUs >= 2000000) {
-            const float captureFps = (capturedFrames * 1000000.0f) / (float)elapsedUs;
+        CapturePacerStats pacerStats;
+        if (cameraPtr->capturePacer.pollStats(2000000, &pacerStats)) {
             ESP_LOGI(CAPTURE_TAG,
-                     "Capture FPS: %.2f | latest frame=%dx%d fmt=%d len=%d",
-                     captureFps,
-                     frameBuffer->width,
-                     frameBuffer->height,
-                     frameBuffer->format,
-                     frameBuffer->len);
-            capturedFrames = 0;
-            captureWindowStartUs = captureUs;
+                     "Capture FPS: %.2f (target %.1f) | interval=%.1f ms jitter=%.1f ms pacing=%lld ms congested=%lu/%lu | latest frame=%dx%d fmt=%d len=%d",
+                     pacerStats.achievedFps,
+                     pacerStats.targetFps,
+                     pacerStats.meanIntervalUs / 1000.0f,
+                     pacerStats.jitterUs / 1000.0f,
+                     (long long)(pacerStats.currentIntervalUs / 1000),
+                     (unsigned long)pacerStats.congestedFrames,
+                     (unsigned long)pacerStats.frames,
+                     sourced.width,
+                     sourced.height,
+                     sourced.format,
+                     (int)frame.len());
+            #if ENABLE_PRE_EVENT_CLIP
+                preEventRing.logStatus(CAPTURE_TAG);
+            #endif
         }
 
-        esp_camera_fb_return(frameBuffer);
+        // Drop the capture task's reference; the payload must not be touched after this.
+        frame.reset();
 
-        // Yield to networking/HTTP tasks to avoid burst-and-freeze behavior.
-        vTaskDelay(pdMS_TO_TICKS(10));
+        // Backlog is sampled after our own reference is gone, so heldFrames counts readers only.
+        // esp_camera_fb_get() blocks until the sensor delivers, so a zero wait still yields; replay sources
+        // return at once and get a one-tick floor instead.
+        const int64_t waitUs = cameraPtr->capturePacer.onFrameCaptured(cameraPtr->sampleBacklog());
+        const TickType_t waitTicks = pdMS_TO_TICKS(waitUs / 1000);
+        if (waitTicks > 0) {
+            vTaskDelay(waitTicks);
+        } else if (!cameraPtr->activeSource->blocksUntilFrame()) {
+            vTaskDelay(1);
+        }
     }
 }
 
@@ -5,8 +5,51 @@ extern "C" {
 }
 #include "esp_err.h"
 #include "data-types/frame-mailbox.h"
+#include "data-types/frame-handle.h"
+#include "camera-driver/capture-pacer.h"
+#include "camera-driver/camera-frame-source.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+#include <atomic>
 #include <cstdint>
 
+// esp_timer backed clock for the capture pacer.
+class EspTimerPacerClock : public PacerClock
+{
+public:
+    int64_t nowUs() const override;
+};
+
+// Runtime-tunable camera parameters.
+struct CameraSettings {
+    framesize_t frameSize = FRAMESIZE_QQVGA;
+    pixformat_t pixelFormat = PIXFORMAT_JPEG;
+    int jpegQuality = 15;       // 0-63, lower is better
+    int xclkFreqHz = 10000000;
+    int fbCount = 3;
+    float targetFps = 0.0f;     // capture pacer target, 0 = sensor rate
+};
+
+// How a reconfiguration was applied.
+enum class CameraSwitchPath {
+    None,       // nothing changed
+    Sensor,     // sensor registers only (frame size / quality / pacing)
+    Reinit,     // esp_camera_deinit + esp_camera_init
+};
+
+// Outcome and timing of reconfigure(), split by phase.
+struct CameraReconfigureResult {
+    esp_err_t err = ESP_OK;
+    const char* message = "ok";
+    CameraSwitchPath path = CameraSwitchPath::None;
+    int64_t quiesceUs = 0;      // until capture_task parked
+    int64_t drainUs = 0;        // until every lent frame of the old configuration came back
+    int64_t applyUs = 0;        // sensor writes or driver re-init
+    int64_t settleUs = 0;       // until the driver delivered a frame with the new geometry
+    int64_t totalUs = 0;
+    uint32_t discardedFrames = 0;
+};
+
 class CameraDriver {
 public:
     CameraDriver();
@@ -27,10 +70,56 @@ public:
     FrameMailboxManager* getMutableStreamMailboxManagerPtr();
     FrameMailboxManager* getMutableInferenceMailboxManagerPtr();
 
+    CapturePacer* getMutableCapturePacerPtr();
+
+    CameraSettings getSettings();
+
+    // Thread-safe live reconfiguration: parks capture_task, drains frames of the old configuration,
+    // applies the change through sensor_t or a driver re-init and resumes capture once the driver
+    // delivers frames of the new geometry. Frames carry their own metadata, and every frame that
+    // could be stamped with the new settings but hold old pixels is discarded before capture resumes.
+    esp_err_t reconfigure(const CameraSettings& requested, CameraReconfigureResult* result);
+
+    // Stream bitrate controller output, applied on top of the configured settings without parking
+    // capture: JPEG quality goes to the sensor, the FPS target to the pacer on capture_task's next
+    // frame. Returns false (nothing applied) while reconfigure() runs.
+    bool applyStreamBudget(int jpegQuality, float targetFps);
+
+    // Switches where capture_task takes frames from (nullptr = the camera). Parks capture and waits for
+    // every frame of the old source to come back, so consumers never mix the two; the pre-event ring is
+    // cleared. Pacing, mailboxes and consumers are unchanged.
+    esp_err_t setFrameSource(FrameSource* source);
+    const char* getFrameSourceName() const { return activeSource->name(); }
+
 private:
     camera_config_t config;
+    CameraFrameSource cameraSource;
+    FrameSource* activeSource = &cameraSource;     // changed only while capture_task is parked
+    EspTimerPacerClock pacerClock;
+    CapturePacer capturePacer;
     FrameMailboxManager* streamMailboxManagerPtr_ = nullptr;
     FrameMailboxManager* inferenceMailboxManagerPtr_ = nullptr;
 
+    CameraSettings settings;
+    SemaphoreHandle_t reconfigureMutex = nullptr;
+    SemaphoreHandle_t captureParkedSem = nullptr;
+    SemaphoreHandle_t captureResumeSem = nullptr;
+    // reconfigure() <-> capture_task parking handshake. Only quiesceCapture() moves Running -> ParkRequested
+    // and back, only capture_task moves ParkRequested -> Parked, only resumeCapture() moves Parked -> Running.
+    enum class CaptureParkState : uint8_t { Running, ParkRequested, Parked };
+    std::atomic<CaptureParkState> captureParkState{CaptureParkState::Running};
+    std::atomic<bool> captureTaskRunning{false};
+    int streamBudgetQuality = 0;                    // quality last written to the sensor
+    std::atomic<float> pendingTargetFps{-1.0f};     // handed to the pacer by capture_task, -1 = none
+
     void configureCamera();
+    void applyOrientation();
+    static const char* validateSettings(const CameraSettings& requested);
+    bool needsReinit(const CameraSettings& requested) const;
+    bool quiesceCapture();
+    void resumeCapture();
+    bool drainLentFrames(int64_t timeoutUs);
+    bool frameMatchesSettings(const camera_fb_t* fb) const;
+    CaptureBacklog sampleBacklog() const;
+    static CapturePacerConfig makePacerConfig();
 };
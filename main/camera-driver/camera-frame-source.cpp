@@ -0,0 +1,37 @@
+#include "camera-driver/camera-frame-source.h"
+#include <utility>
+
+CameraFrameSource::CameraFrameSource()
+    : frameLender(&CameraFrameSource::returnLentFrame, nullptr) {}
+
+FrameAcquireResult CameraFrameSource::acquire(SourceFrame* frame)
+{
+    camera_fb_t* fb = esp_camera_fb_get();
+    if (!fb) {
+        return FrameAcquireResult::NoFrame;
+    }
+
+    // Every consumer shares the DMA buffer; it goes back to the driver when the last one drops it.
+    FrameHandle handle = frameLender.lend(fb, fb->buf, fb->len);
+    if (!handle.isValid()) {
+        esp_camera_fb_return(fb);
+        return FrameAcquireResult::NoSlot;
+    }
+
+    frame->handle = std::move(handle);
+    frame->width = fb->width;
+    frame->height = fb->height;
+    frame->format = fb->format;
+    return FrameAcquireResult::Ok;
+}
+
+size_t CameraFrameSource::getLentCount() const
+{
+    return frameLender.getLentCount();
+}
+
+void CameraFrameSource::returnLentFrame(void* releaseCtx, void* sourceFrame)
+{
+    (void)releaseCtx;
+    esp_camera_fb_return(static_cast<camera_fb_t*>(sourceFrame));
+}
@@ -0,0 +1,24 @@
+#pragma once
+
+extern "C" {
+    #include "esp_camera.h"
+}
+#include "frame-source/frame-source.h"
+
+// The sensor as a FrameSource: esp_camera_fb_get() frames lent to readers, returned through
+// esp_camera_fb_return when the last one drops its handle.
+class CameraFrameSource : public FrameSource
+{
+public:
+    CameraFrameSource();
+
+    const char* name() const override { return "camera"; }
+    FrameAcquireResult acquire(SourceFrame* frame) override;
+    size_t getLentCount() const override;
+    bool blocksUntilFrame() const override { return true; }
+
+private:
+    static void returnLentFrame(void* releaseCtx, void* sourceFrame);
+
+    FrameLender frameLender;
+};
@@ -0,0 +1,114 @@
+#include "camera-driver/capture-pacer.h"
+#include <cmath>
+
+namespace {
+
+// First backoff step when the target interval is 0 (free-running capture).
+constexpr int64_t kMinBackoffUs = 10000;
+// Below this distance from the target interval the decay snaps to the target.
+constexpr int64_t kSnapUs = 1000;
+
+} // namespace
+
+CapturePacer::CapturePacer(const PacerClock* clock, const CapturePacerConfig& config)
+    : clock_(clock), config_(config)
+{
+    intervalUs_ = targetIntervalUs();
+}
+
+void CapturePacer::setTargetFps(float targetFps)
+{
+    config_.targetFps = (targetFps > 0.0f) ? targetFps : 0.0f;
+    intervalUs_ = targetIntervalUs();
+    deadlineUs_ = -1;
+}
+
+int64_t CapturePacer::targetIntervalUs() const
+{
+    return (config_.targetFps > 0.0f) ? (int64_t)(1000000.0f / config_.targetFps) : 0;
+}
+
+bool CapturePacer::isCongested(const CaptureBacklog& backlog) const
+{
+    return (config_.maxStreamLag && backlog.streamLag > config_.maxStreamLag) ||
+           (config_.maxInferenceLag && backlog.inferenceLag > config_.maxInferenceLag) ||
+           (config_.maxHeldFrames && backlog.heldFrames > config_.maxHeldFrames);
+}
+
+int64_t CapturePacer::onFrameCaptured(const CaptureBacklog& backlog)
+{
+    const int64_t nowUs = clock_->nowUs();
+
+    if (windowStartUs_ < 0) {
+        windowStartUs_ = nowUs;
+    }
+    if (lastFrameUs_ >= 0) {
+        const double intervalUs = (double)(nowUs - lastFrameUs_);
+        windowIntervals_++;
+        const double delta = intervalUs - intervalMean_;
+        intervalMean_ += delta / windowIntervals_;
+        intervalM2_ += delta * (intervalUs - intervalMean_);
+    }
+    lastFrameUs_ = nowUs;
+    windowFrames_++;
+
+    const int64_t baseUs = targetIntervalUs();
+    if (isCongested(backlog)) {
+        windowCongested_++;
+        int64_t stepUs = (intervalUs_ > baseUs) ? intervalUs_ : baseUs;
+        if (stepUs < kMinBackoffUs) {
+            stepUs = kMinBackoffUs;
+        }
+        intervalUs_ = stepUs + stepUs / 4;
+        if (config_.maxIntervalUs > 0 && intervalUs_ > config_.maxIntervalUs) {
+            intervalUs_ = (config_.maxIntervalUs > baseUs) ? config_.maxIntervalUs : baseUs;
+        }
+    } else if (intervalUs_ > baseUs) {
+        intervalUs_ = baseUs + ((intervalUs_ - baseUs) * 3) / 4;
+        if (intervalUs_ - baseUs < kSnapUs) {
+            intervalUs_ = baseUs;
+        }
+    } else {
+        intervalUs_ = baseUs;
+    }
+
+    if (intervalUs_ == 0) {
+        deadlineUs_ = nowUs;
+        return 0;
+    }
+
+    // Deadlines advance on a fixed grid so waits do not accumulate the capture latency; after a
+    // stall the grid restarts from now instead of bursting to catch up.
+    deadlineUs_ = (deadlineUs_ < 0) ? nowUs + intervalUs_ : deadlineUs_ + intervalUs_;
+    if (deadlineUs_ < nowUs) {
+        deadlineUs_ = nowUs;
+    }
+    return deadlineUs_ - nowUs;
+}
+
+bool CapturePacer::pollStats(int64_t windowUs, CapturePacerStats* stats)
+{
+    const int64_t nowUs = clock_->nowUs();
+    if (windowStartUs_ < 0 || nowUs - windowStartUs_ < windowUs) {
+        return false;
+    }
+
+    if (stats) {
+        const int64_t elapsedUs = nowUs - windowStartUs_;
+        stats->targetFps = config_.targetFps;
+        stats->achievedFps = (elapsedUs > 0) ? (windowFrames_ * 1000000.0f) / (float)elapsedUs : 0.0f;
+        stats->meanIntervalUs = (float)intervalMean_;
+        stats->jitterUs = (windowIntervals_ > 1) ? (float)std::sqrt(intervalM2_ / (windowIntervals_ - 1)) : 0.0f;
+        stats->currentIntervalUs = intervalUs_;
+        stats->frames = windowFrames_;
+        stats->congestedFrames = windowCongested_;
+    }
+
+    windowStartUs_ = nowUs;
+    windowFrames_ = 0;
+    windowIntervals_ = 0;
+    windowCongested_ = 0;
+    intervalMean_ = 0.0;
+    intervalM2_ = 0.0;
+    return true;
+}
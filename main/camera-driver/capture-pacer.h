@@ -0,0 +1,76 @@
+#pragma once
+
+#include <cstdint>
+
+// Time source for the pacer. The firmware uses esp_timer; a host simulation can step its own clock.
+class PacerClock
+{
+public:
+    virtual ~PacerClock() = default;
+    virtual int64_t nowUs() const = 0;
+};
+
+// How far the consumers are behind, sampled by capture_task after publishing a frame.
+struct CaptureBacklog {
+    uint32_t streamLag = 0;         // stream mailbox: frames published since the last acquire
+    uint32_t inferenceLag = 0;      // inference mailbox: same, grows while Invoke() runs
+    uint32_t heldFrames = 0;        // camera buffers still referenced by readers (in-flight sends included)
+};
+
+struct CapturePacerConfig {
+    float targetFps = 0.0f;         // 0 paces only on backlog, otherwise as fast as the sensor delivers
+    int64_t maxIntervalUs = 0;      // backoff ceiling
+    uint32_t maxStreamLag = 0;      // 0 disables the check
+    uint32_t maxInferenceLag = 0;   // 0 disables the check
+    uint32_t maxHeldFrames = 0;     // 0 disables the check; like the lags, congested only above it
+};
+
+// Achieved rate over the last stats window.
+struct CapturePacerStats {
+    float targetFps = 0.0f;
+    float achievedFps = 0.0f;
+    float meanIntervalUs = 0.0f;
+    float jitterUs = 0.0f;          // standard deviation of the frame interval
+    int64_t currentIntervalUs = 0;  // interval the controller is steering to
+    uint32_t frames = 0;
+    uint32_t congestedFrames = 0;   // frames after which a consumer was over its limit
+};
+
+// Target-FPS capture pacing. Each captured frame reports the consumer backlog; the controller keeps
+// a deadline grid at the target interval, backs off multiplicatively while any consumer is over its
+// limit and decays back to the target once they catch up. No FreeRTOS calls: the caller turns the
+// returned wait into a delay.
+class CapturePacer
+{
+public:
+    CapturePacer(const PacerClock* clock, const CapturePacerConfig& config);
+
+    void setTargetFps(float targetFps);
+    float getTargetFps() const { return config_.targetFps; }
+    void setMaxHeldFrames(uint32_t maxHeldFrames) { config_.maxHeldFrames = maxHeldFrames; }
+
+    // Call once per captured frame. Returns how long to wait (us) before fetching the next frame.
+    int64_t onFrameCaptured(const CaptureBacklog& backlog);
+
+    // Fills stats and starts a new window once windowUs has elapsed since the previous one.
+    bool pollStats(int64_t windowUs, CapturePacerStats* stats);
+
+private:
+    int64_t targetIntervalUs() const;
+    bool isCongested(const CaptureBacklog& backlog) const;
+
+    const PacerClock* clock_;
+    CapturePacerConfig config_;
+
+    int64_t intervalUs_ = 0;
+    int64_t deadlineUs_ = -1;
+    int64_t lastFrameUs_ = -1;
+
+    // Stats window (Welford running mean/variance of the frame interval).
+    int64_t windowStartUs_ = -1;
+    uint32_t windowFrames_ = 0;
+    uint32_t windowIntervals_ = 0;
+    uint32_t windowCongested_ = 0;
+    double intervalMean_ = 0.0;
+    double intervalM2_ = 0.0;
+};
@@ -0,0 +1,174 @@
+#include "clip-recorder/avi-mjpeg.h"
+
+namespace {
+
+constexpr uint32_t kAvihBytes = 56;
+constexpr uint32_t kStrhBytes = 56;
+constexpr uint32_t kStrfBytes = 40;
+constexpr uint32_t kStrlListBytes = 4 + (8 + kStrhBytes) + (8 + kStrfBytes);
+constexpr uint32_t kHdrlListBytes = 4 + (8 + kAvihBytes) + (8 + kStrlListBytes);
+// RIFF header + hdrl LIST + movi LIST header.
+constexpr uint32_t kHeaderBytes = 12 + (8 + kHdrlListBytes) + 12;
+constexpr uint32_t kChunkHeaderBytes = 8;
+constexpr uint32_t kIndexEntryBytes = 16;
+
+constexpr uint32_t kAvifHasIndex = 0x10;
+constexpr uint32_t kAviifKeyframe = 0x10;
+
+// Little-endian writer over a caller-owned buffer.
+struct ByteWriter {
+    uint8_t* out;
+    size_t pos = 0;
+
+    void u16(uint16_t v)
+    {
+        out[pos++] = (uint8_t)(v & 0xFF);
+        out[pos++] = (uint8_t)(v >> 8);
+    }
+    void u32(uint32_t v)
+    {
+        for (int i = 0; i < 4; i++) {
+            out[pos++] = (uint8_t)(v >> (8 * i));
+        }
+    }
+    void fourcc(const char* cc)
+    {
+        for (int i = 0; i < 4; i++) {
+            out[pos++] = (uint8_t)cc[i];
+        }
+    }
+};
+
+uint32_t moviListBytes(const AviClipInfo& info)
+{
+    return 4 + info.frameCount * kChunkHeaderBytes + info.payloadBytes + info.paddingBytes;
+}
+
+uint32_t indexBytes(const AviClipInfo& info)
+{
+    return info.frameCount * kIndexEntryBytes;
+}
+
+} // namespace
+
+size_t aviFileSize(const AviClipInfo& info)
+{
+    return kHeaderBytes - 4 + moviListBytes(info) + 8 + indexBytes(info);
+}
+
+bool aviWriteHeader(const AviClipInfo& info, ClipSinkFn sink, void* sinkCtx)
+{
+    uint8_t header[kHeaderBytes];
+    ByteWriter w{header};
+
+    const uint32_t usPerFrame = info.usPerFrame ? info.usPerFrame : 1;
+    const uint32_t fps = 1000000u / usPerFrame;
+
+    w.fourcc("RIFF");
+    w.u32((uint32_t)aviFileSize(info) - 8);
+    w.fourcc("AVI ");
+
+    w.fourcc("LIST");
+    w.u32(kHdrlListBytes);
+    w.fourcc("hdrl");
+
+    // MainAVIHeader
+    w.fourcc("avih");
+    w.u32(kAvihBytes);
+    w.u32(usPerFrame);
+    w.u32(info.maxFrameBytes * (fps ? fps : 1));   // dwMaxBytesPerSec
+    w.u32(0);                                       // dwPaddingGranularity
+    w.u32(kAvifHasIndex);
+    w.u32(info.frameCount);
+    w.u32(0);                                       // dwInitialFrames
+    w.u32(1);                                       // dwStreams
+    w.u32(info.maxFrameBytes);
+    w.u32(info.width);
+    w.u32(info.height);
+    for (int i = 0; i < 4; i++) {
+        w.u32(0);
+    }
+
+    w.fourcc("LIST");
+    w.u32(kStrlListBytes);
+    w.fourcc("strl");
+
+    // AVISTREAMHEADER: rate/scale expressed in microseconds so irregular capture keeps its mean rate.
+    w.fourcc("strh");
+    w.u32(kStrhBytes);
+    w.fourcc("vids");
+    w.fourcc("MJPG");
+    w.u32(0);                                       // dwFlags
+    w.u16(0);                                       // wPriority
+    w.u16(0);                                       // wLanguage
+    w.u32(0);                                       // dwInitialFrames
+    w.u32(usPerFrame);                              // dwScale
+    w.u32(1000000);                                 // dwRate
+    w.u32(0);                                       // dwStart
+    w.u32(info.frameCount);                         // dwLength
+    w.u32(info.maxFrameBytes);
+    w.u32(0xFFFFFFFF);                              // dwQuality
+    w.u32(0);                                       // dwSampleSize
+    w.u16(0);
+    w.u16(0);
+    w.u16(info.width);
+    w.u16(info.height);
+
+    // BITMAPINFOHEADER
+    w.fourcc("strf");
+    w.u32(kStrfBytes);
+    w.u32(kStrfBytes);
+    w.u32(info.width);
+    w.u32(info.height);
+    w.u16(1);                                       // biPlanes
+    w.u16(24);                                      // biBitCount
+    w.fourcc("MJPG");
+    w.u32((uint32_t)info.width * info.height * 3);
+    for (int i = 0; i < 4; i++) {
+        w.u32(0);
+    }
+
+    w.fourcc("LIST");
+    w.u32(moviListBytes(info));
+    w.fourcc("movi");
+
+    return sink(sinkCtx, header, w.pos);
+}
+
+bool aviWriteFrame(const uint8_t* jpeg, uint32_t len, ClipSinkFn sink, void* sinkCtx)
+{
+    uint8_t chunk[kChunkHeaderBytes];
+    ByteWriter w{chunk};
+    w.fourcc("00dc");
+    w.u32(len);
+    if (!sink(sinkCtx, chunk, w.pos) || !sink(sinkCtx, jpeg, len)) {
+        return false;
+    }
+    // RIFF chunks are word aligned.
+    if (len & 1) {
+        const uint8_t pad = 0;
+        return sink(sinkCtx, &pad, 1);
+    }
+    return true;
+}
+
+bool aviWriteIndexHeader(const AviClipInfo& info, ClipSinkFn sink, void* sinkCtx)
+{
+    uint8_t chunk[kChunkHeaderBytes];
+    ByteWriter w{chunk};
+    w.fourcc("idx1");
+    w.u32(indexBytes(info));
+    return sink(sinkCtx, chunk, w.pos);
+}
+
+bool aviWriteIndexEntry(uint32_t len, uint32_t* moviOffset, ClipSinkFn sink, void* sinkCtx)
+{
+    uint8_t entry[kIndexEntryBytes];
+    ByteWriter w{entry};
+    w.fourcc("00dc");
+    w.u32(kAviifKeyframe);
+    w.u32(*moviOffset);
+    w.u32(len);
+    *moviOffset += kChunkHeaderBytes + len + (len & 1);
+    return sink(sinkCtx, entry, w.pos);
+}
@@ -0,0 +1,37 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+// Receives the exported byte stream (HTTP chunk sender, file writer, test buffer).
+// Returns false to abort the export.
+using ClipSinkFn = bool (*)(void* sinkCtx, const uint8_t* data, size_t len);
+
+// Everything the AVI headers need, known before the first frame is written.
+struct AviClipInfo {
+    uint32_t frameCount = 0;
+    uint16_t width = 0;
+    uint16_t height = 0;
+    uint32_t usPerFrame = 0;
+    uint32_t maxFrameBytes = 0;
+    // Sum of the JPEG payload lengths (without chunk headers or padding).
+    uint32_t payloadBytes = 0;
+    // Sum of the odd-length padding bytes of all frames.
+    uint32_t paddingBytes = 0;
+};
+
+// Minimal MJPEG-in-AVI (RIFF) writer: one video stream, every frame a keyframe, idx1 index.
+// Layout: RIFF/AVI { LIST hdrl { avih, LIST strl { strh, strf } }, LIST movi { 00dc... }, idx1 }.
+// Write order: aviWriteHeader, aviWriteFrame per frame, aviWriteIndexEntry per frame (same order).
+
+// Total file size in bytes for the given clip.
+size_t aviFileSize(const AviClipInfo& info);
+
+bool aviWriteHeader(const AviClipInfo& info, ClipSinkFn sink, void* sinkCtx);
+
+bool aviWriteFrame(const uint8_t* jpeg, uint32_t len, ClipSinkFn sink, void* sinkCtx);
+
+// moviOffset: offset of this frame's chunk header from the 'movi' fourcc; advanced past the chunk.
+bool aviWriteIndexEntry(uint32_t len, uint32_t* moviOffset, ClipSinkFn sink, void* sinkCtx);
+
+bool aviWriteIndexHeader(const AviClipInfo& info, ClipSinkFn sink, void* sinkCtx);
@@ -0,0 +1,280 @@
+#include "clip-recorder/pre-event-ring.h"
+#include "esp_log.h"
+#include "debug.h"
+#include <cstring>
+
+namespace {
+
+constexpr size_t kRecordAlign = alignof(PreEventRecordHeader);
+// Frame spacing used for the AVI header when the clip holds a single frame.
+constexpr uint32_t kDefaultUsPerFrame = 100000;
+
+} // namespace
+
+PreEventRing::~PreEventRing()
+{
+    bufferPlacement.release(placement_, storage_, capacity_);
+    storage_ = nullptr;
+}
+
+bool PreEventRing::init(size_t capacityBytes, PlacedBuffer placement, int64_t windowUs, int64_t holdUs)
+{
+    if (storage_) {
+        return true;
+    }
+    placement_ = placement;
+    capacity_ = capacityBytes & ~(kRecordAlign - 1);
+    storage_ = (uint8_t*)bufferPlacement.allocate(placement_, capacity_);
+    if (!storage_) {
+        ESP_LOGE(MAIN_TAG, "Failed to allocate pre-event ring of %u bytes", (unsigned int)capacity_);
+        capacity_ = 0;
+        return false;
+    }
+    windowUs_ = windowUs;
+    holdUs_ = holdUs;
+    ESP_LOGI(MAIN_TAG, "Pre-event ring ready: %u bytes, %lld ms window",
+             (unsigned int)capacity_,
+             (long long)(windowUs_ / 1000));
+    return true;
+}
+
+size_t PreEventRing::recordBytes(size_t payloadLen)
+{
+    return (sizeof(PreEventRecordHeader) + payloadLen + kRecordAlign - 1) & ~(kRecordAlign - 1);
+}
+
+const PreEventRecordHeader* PreEventRing::headerAt(size_t offset) const
+{
+    return reinterpret_cast<const PreEventRecordHeader*>(storage_ + offset);
+}
+
+size_t PreEventRing::nextOffset(size_t offset) const
+{
+    const size_t next = offset + recordBytes(headerAt(offset)->len);
+    return (wrapped_ && next == wrapEnd_) ? 0 : next;
+}
+
+void PreEventRing::evictOldest()
+{
+    const size_t size = recordBytes(headerAt(head_)->len);
+    head_ += size;
+    used_ -= size;
+    count_--;
+    evicted_.fetch_add(1, std::memory_order_relaxed);
+    if (wrapped_ && head_ == wrapEnd_) {
+        head_ = 0;
+        wrapped_ = false;
+    }
+    if (count_ == 0) {
+        head_ = 0;
+        tail_ = 0;
+        wrapped_ = false;
+    }
+}
+
+bool PreEventRing::ensureSpace(size_t needed)
+{
+    while (true) {
+        if (!wrapped_) {
+            // Records occupy [head_, tail_): free space is the tail end, then the front after a wrap.
+            if (capacity_ - tail_ >= needed) {
+                return true;
+            }
+            if (count_ == 0) {
+                return false;
+            }
+            wrapEnd_ = tail_;
+            tail_ = 0;
+            wrapped_ = true;
+            continue;
+        }
+        if (head_ - tail_ >= needed) {
+            return true;
+        }
+        evictOldest();
+    }
+}
+
+bool PreEventRing::append(const uint8_t* jpeg, size_t len, uint16_t width, uint16_t height, uint32_t seq, int64_t captureUs)
+{
+    if (!storage_ || !jpeg || len == 0) {
+        return false;
+    }
+
+    PreEventRingState state = state_.load(std::memory_order_acquire);
+    if (state == PreEventRingState::FreezeRequested) {
+        if (count_ > 0) {
+            // Everything written so far becomes visible to the exporter with this release store.
+            frozenAtUs_ = captureUs;
+            clips_.fetch_add(1, std::memory_order_relaxed);
+            state_.store(PreEventRingState::Frozen, std::memory_order_release);
+            dropped_.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        }
+        // Nothing recorded yet, so there is no clip to keep.
+        state_.store(PreEventRingState::Recording, std::memory_order_release);
+        state = PreEventRingState::Recording;
+    }
+    if (state == PreEventRingState::Frozen) {
+        // An unclaimed clip is given up after holdUs_; an exporter that got in first keeps it.
+        PreEventRingState expected = PreEventRingState::Frozen;
+        if (captureUs - frozenAtUs_ < holdUs_ ||
+            !state_.compare_exchange_strong(expected, PreEventRingState::Recording, std::memory_order_acquire)) {
+            dropped_.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        }
+        state = PreEventRingState::Recording;
+    }
+    if (state != PreEventRingState::Recording) {
+        dropped_.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+
+    const size_t needed = recordBytes(len);
+    if (needed > capacity_) {
+        rejected_.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+
+    while (count_ > 0 && headerAt(head_)->captureUs < captureUs - windowUs_) {
+        evictOldest();
+    }
+    if (!ensureSpace(needed)) {
+        rejected_.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+
+    PreEventRecordHeader header = {};
+    header.len = (uint32_t)len;
+    header.seq = seq;
+    header.captureUs = captureUs;
+    header.width = width;
+    header.height = height;
+    memcpy(storage_ + tail_, &header, sizeof(header));
+    memcpy(storage_ + tail_ + sizeof(header), jpeg, len);
+
+    tail_ += needed;
+    used_ += needed;
+    count_++;
+    newestUs_ = captureUs;
+    appended_.fetch_add(1, std::memory_order_relaxed);
+    return true;
+}
+
+void PreEventRing::clear()
+{
+    if (getState() != PreEventRingState::Recording) {
+        return;
+    }
+    evicted_.fetch_add(count_, std::memory_order_relaxed);
+    head_ = 0;
+    tail_ = 0;
+    wrapped_ = false;
+    count_ = 0;
+    used_ = 0;
+}
+
+bool PreEventRing::requestFreeze()
+{
+    PreEventRingState expected = PreEventRingState::Recording;
+    return state_.compare_exchange_strong(expected, PreEventRingState::FreezeRequested, std::memory_order_acq_rel);
+}
+
+bool PreEventRing::releaseClip()
+{
+    PreEventRingState expected = PreEventRingState::Frozen;
+    return state_.compare_exchange_strong(expected, PreEventRingState::Recording, std::memory_order_release);
+}
+
+bool PreEventRing::buildClipInfo(AviClipInfo* info) const
+{
+    if (count_ == 0) {
+        return false;
+    }
+
+    size_t offset = head_;
+    const int64_t firstUs = headerAt(head_)->captureUs;
+    int64_t lastUs = firstUs;
+    for (uint32_t i = 0; i < count_; i++) {
+        const PreEventRecordHeader* header = headerAt(offset);
+        info->payloadBytes += header->len;
+        info->paddingBytes += header->len & 1;
+        if (header->len > info->maxFrameBytes) {
+            info->maxFrameBytes = header->len;
+        }
+        info->width = header->width;
+        info->height = header->height;
+        lastUs = header->captureUs;
+        offset = nextOffset(offset);
+    }
+    info->frameCount = count_;
+    info->usPerFrame = (count_ > 1) ? (uint32_t)((lastUs - firstUs) / (count_ - 1)) : kDefaultUsPerFrame;
+    return true;
+}
+
+bool PreEventRing::exportAvi(ClipSinkFn sink, void* sinkCtx, bool releaseAfter)
+{
+    if (!sink) {
+        return false;
+    }
+    // Pins the clip: the writer can no longer expire it and leaves the layout alone.
+    PreEventRingState expected = PreEventRingState::Frozen;
+    if (!state_.compare_exchange_strong(expected, PreEventRingState::Exporting, std::memory_order_acquire)) {
+        return false;
+    }
+
+    AviClipInfo info;
+    bool ok = buildClipInfo(&info) && aviWriteHeader(info, sink, sinkCtx);
+
+    size_t offset = head_;
+    for (uint32_t i = 0; ok && i < count_; i++) {
+        const PreEventRecordHeader* header = headerAt(offset);
+        ok = aviWriteFrame(storage_ + offset + sizeof(PreEventRecordHeader), header->len, sink, sinkCtx);
+        offset = nextOffset(offset);
+    }
+
+    ok = ok && aviWriteIndexHeader(info, sink, sinkCtx);
+    uint32_t moviOffset = 4;
+    offset = head_;
+    for (uint32_t i = 0; ok && i < count_; i++) {
+        ok = aviWriteIndexEntry(headerAt(offset)->len, &moviOffset, sink, sinkCtx);
+        offset = nextOffset(offset);
+    }
+
+    state_.store((ok && releaseAfter) ? PreEventRingState::Recording : PreEventRingState::Frozen,
+                 std::memory_order_release);
+    return ok;
+}
+
+void PreEventRing::getStats(PreEventRingStats* stats) const
+{
+    if (!stats) {
+        return;
+    }
+    stats->recordCount = count_;
+    stats->usedBytes = used_;
+    stats->capacityBytes = capacity_;
+    stats->oldestUs = (count_ > 0) ? headerAt(head_)->captureUs : 0;
+    stats->newestUs = (count_ > 0) ? newestUs_ : 0;
+    stats->appended = appended_.load(std::memory_order_relaxed);
+    stats->evicted = evicted_.load(std::memory_order_relaxed);
+    stats->rejected = rejected_.load(std::memory_order_relaxed);
+    stats->dropped = dropped_.load(std::memory_order_relaxed);
+    stats->clips = clips_.load(std::memory_order_relaxed);
+}
+
+void PreEventRing::logStatus(const char* tag) const
+{
+    PreEventRingStats stats;
+    getStats(&stats);
+    ESP_LOGI(tag, "Pre-event ring: state=%u records=%lu span=%lld ms used=%u/%u B evicted=%lu dropped=%lu rejected=%lu clips=%lu",
+             (unsigned int)getState(),
+             (unsigned long)stats.recordCount,
+             (long long)((stats.newestUs - stats.oldestUs) / 1000),
+             (unsigned int)stats.usedBytes,
+             (unsigned int)stats.capacityBytes,
+             (unsigned long)stats.evicted,
+             (unsigned long)stats.dropped,
+             (unsigned long)stats.rejected,
+             (unsigned long)stats.clips);
+}
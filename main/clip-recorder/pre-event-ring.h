@@ -0,0 +1,116 @@
+#pragma once
+
+#include "clip-recorder/avi-mjpeg.h"
+#include "memory/buffer-placement.h"
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+// Header stored in front of every JPEG payload in the ring. Payloads are padded to the header alignment so the
+// next header stays aligned.
+struct PreEventRecordHeader {
+    uint32_t len;
+    uint32_t seq;
+    int64_t captureUs;
+    uint16_t width;
+    uint16_t height;
+    uint32_t reserved;
+};
+
+// What the ring is currently doing with appends and exports.
+enum class PreEventRingState : uint32_t {
+    Recording,          // appends evict the oldest records
+    FreezeRequested,    // the next append freezes the ring instead of writing
+    Frozen,             // contents are the clip; appends are dropped until released or the hold expires
+    Exporting,          // an exporter is reading the clip
+};
+
+struct PreEventRingStats {
+    uint32_t recordCount = 0;
+    size_t usedBytes = 0;
+    size_t capacityBytes = 0;
+    int64_t oldestUs = 0;
+    int64_t newestUs = 0;
+    uint32_t appended = 0;
+    uint32_t evicted = 0;
+    uint32_t rejected = 0;      // frames larger than the ring
+    uint32_t dropped = 0;       // frames skipped while frozen
+    uint32_t clips = 0;
+};
+
+// Pre-event buffer: the last windowUs worth of JPEG frames packed back to back in one contiguous
+// region as variable-length records. capture_task is the only writer (one memcpy per frame);
+// requestFreeze() may be called from any task and export runs from the HTTP task while frozen.
+// No FreeRTOS primitives: the writer/exporter hand-off is a CAS on the state word, so the class
+// builds unchanged on a host.
+class PreEventRing
+{
+public:
+    PreEventRing() = default;
+    ~PreEventRing();
+
+    PreEventRing(const PreEventRing&) = delete;
+    PreEventRing& operator=(const PreEventRing&) = delete;
+
+    // Allocates capacityBytes through bufferPlacement under the given placement entry.
+    // windowUs bounds the pre-event span, holdUs how long an unexported clip blocks recording.
+    bool init(size_t capacityBytes, PlacedBuffer placement, int64_t windowUs, int64_t holdUs);
+
+    // Writer: copies one JPEG frame in, evicting records that are too old or in the way.
+    // Returns false when the frame was not stored (frozen, exporting or too large).
+    bool append(const uint8_t* jpeg, size_t len, uint16_t width, uint16_t height, uint32_t seq, int64_t captureUs);
+
+    // Writer: drops every record (e.g. after a geometry change). A frozen clip is kept.
+    void clear();
+
+    // Any task: freeze the ring at the next append. Ignored unless the ring is recording.
+    bool requestFreeze();
+
+    // Exporter: streams the frozen clip as an MJPEG AVI. Returns false when no clip is ready, another
+    // export is running or the sink aborted. releaseAfter resumes recording once the clip is sent.
+    bool exportAvi(ClipSinkFn sink, void* sinkCtx, bool releaseAfter);
+
+    // Exporter: drops a frozen clip without sending it.
+    bool releaseClip();
+
+    PreEventRingState getState() const { return state_.load(std::memory_order_acquire); }
+    bool hasClip() const { return getState() == PreEventRingState::Frozen; }
+
+    // Writer task only (or while frozen): reads the writer-owned layout.
+    void getStats(PreEventRingStats* stats) const;
+    void logStatus(const char* tag) const;
+
+    static size_t recordBytes(size_t payloadLen);
+
+private:
+    const PreEventRecordHeader* headerAt(size_t offset) const;
+    size_t nextOffset(size_t offset) const;
+    void evictOldest();
+    bool ensureSpace(size_t needed);
+    bool buildClipInfo(AviClipInfo* info) const;
+
+    uint8_t* storage_ = nullptr;
+    size_t capacity_ = 0;
+    PlacedBuffer placement_ = PlacedBuffer::PreEventRing;
+    int64_t windowUs_ = 0;
+    int64_t holdUs_ = 0;
+
+    // Writer-owned layout. When wrapped_, records live in [head_, wrapEnd_) then [0, tail_).
+    size_t head_ = 0;
+    size_t tail_ = 0;
+    size_t wrapEnd_ = 0;
+    bool wrapped_ = false;
+    uint32_t count_ = 0;
+    size_t used_ = 0;
+    int64_t newestUs_ = 0;
+    int64_t frozenAtUs_ = 0;
+
+    std::atomic<PreEventRingState> state_{PreEventRingState::Recording};
+    std::atomic<uint32_t> appended_{0};
+    std::atomic<uint32_t> evicted_{0};
+    std::atomic<uint32_t> rejected_{0};
+    std::atomic<uint32_t> dropped_{0};
+    std::atomic<uint32_t> clips_{0};
+};
+
+extern PreEventRing preEventRing;
@@ -0,0 +1,108 @@
+#include "data-types/frame-handle.h"
+
+#include <utility>
+
+FrameHandle::FrameHandle(LentFrame* frame) : frame_(frame) {}
+
+FrameHandle::FrameHandle(const FrameHandle& other) : frame_(other.frame_)
+{
+    if (frame_) {
+        frame_->refCount.fetch_add(1, std::memory_order_relaxed);
+    }
+}
+
+FrameHandle::FrameHandle(FrameHandle&& other) noexcept : frame_(other.frame_)
+{
+    other.frame_ = nullptr;
+}
+
+FrameHandle& FrameHandle::operator=(const FrameHandle& other)
+{
+    if (this != &other) {
+        FrameHandle copy(other);
+        std::swap(frame_, copy.frame_);
+    }
+    return *this;
+}
+
+FrameHandle& FrameHandle::operator=(FrameHandle&& other) noexcept
+{
+    if (this != &other) {
+        reset();
+        frame_ = other.frame_;
+        other.frame_ = nullptr;
+    }
+    return *this;
+}
+
+FrameHandle::~FrameHandle()
+{
+    reset();
+}
+
+void FrameHandle::reset()
+{
+    LentFrame* frame = frame_;
+    frame_ = nullptr;
+    if (!frame) {
+        return;
+    }
+
+    // acq_rel: the last reader must observe every other reader's accesses before the payload is recycled.
+    if (frame->refCount.fetch_sub(1, std::memory_order_acq_rel) != 1) {
+        return;
+    }
+
+    FrameReleaseFn release = frame->release;
+    void* releaseCtx = frame->releaseCtx;
+    void* sourceFrame = frame->sourceFrame;
+    frame->data = nullptr;
+    frame->len = 0;
+    frame->sourceFrame = nullptr;
+    if (release) {
+        release(releaseCtx, sourceFrame);
+    }
+    // Slot becomes reusable only after the owner got its buffer back.
+    frame->inUse.store(false, std::memory_order_release);
+}
+
+uint32_t FrameHandle::useCount() const
+{
+    return frame_ ? frame_->refCount.load(std::memory_order_relaxed) : 0;
+}
+
+FrameLender::FrameLender(FrameReleaseFn release, void* releaseCtx)
+    : release_(release), releaseCtx_(releaseCtx) {}
+
+FrameHandle FrameLender::lend(void* sourceFrame, const uint8_t* data, size_t len)
+{
+    if (!data || len == 0) {
+        return FrameHandle();
+    }
+
+    for (LentFrame& slot : slots) {
+        bool expected = false;
+        if (!slot.inUse.compare_exchange_strong(expected, true, std::memory_order_acquire)) {
+            continue;
+        }
+        slot.data = data;
+        slot.len = len;
+        slot.sourceFrame = sourceFrame;
+        slot.release = release_;
+        slot.releaseCtx = releaseCtx_;
+        slot.refCount.store(1, std::memory_order_release);
+        return FrameHandle(&slot);
+    }
+    return FrameHandle();
+}
+
+size_t FrameLender::getLentCount() const
+{
+    size_t count = 0;
+    for (const LentFrame& slot : slots) {
+        if (slot.inUse.load(std::memory_order_relaxed)) {
+            count++;
+        }
+    }
+    return count;
+}
@@ -0,0 +1,72 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+// Invoked exactly once, when the last FrameHandle referencing a lent frame is dropped.
+// sourceFrame is the opaque object the payload belongs to (e.g. a camera_fb_t*).
+using FrameReleaseFn = void (*)(void* releaseCtx, void* sourceFrame);
+
+// Refcount control block for a frame payload owned by someone else (camera driver, pool).
+struct LentFrame {
+    std::atomic<uint32_t> refCount{0};
+    std::atomic<bool> inUse{false};
+    const uint8_t* data = nullptr;
+    size_t len = 0;
+    void* sourceFrame = nullptr;
+    FrameReleaseFn release = nullptr;
+    void* releaseCtx = nullptr;
+};
+
+// Shared, read-only reference to a lent frame payload.
+// Copying a handle adds a reader; the payload goes back to its owner when the last copy is dropped.
+// Handles carry no FreeRTOS or camera types so the refcount logic can be exercised on a host build.
+class FrameHandle
+{
+public:
+    FrameHandle() = default;
+    // Adopts one reference already accounted for in frame->refCount.
+    explicit FrameHandle(LentFrame* frame);
+    FrameHandle(const FrameHandle& other);
+    FrameHandle(FrameHandle&& other) noexcept;
+    FrameHandle& operator=(const FrameHandle& other);
+    FrameHandle& operator=(FrameHandle&& other) noexcept;
+    ~FrameHandle();
+
+    // Drops this reference (returns the payload to its owner if it was the last one).
+    void reset();
+
+    bool isValid() const { return frame_ != nullptr; }
+    const uint8_t* data() const { return frame_ ? frame_->data : nullptr; }
+    size_t len() const { return frame_ ? frame_->len : 0; }
+    uint32_t useCount() const;
+
+private:
+    LentFrame* frame_ = nullptr;
+};
+
+// Number of frames that can be lent at the same time. Must be >= camera fb_count.
+#define FRAME_LENDER_SLOTS 4
+
+// Wraps externally owned frame buffers into FrameHandles without copying the payload.
+class FrameLender
+{
+public:
+    FrameLender(FrameReleaseFn release, void* releaseCtx);
+    ~FrameLender() = default;
+
+    FrameLender(const FrameLender&) = delete;
+    FrameLender& operator=(const FrameLender&) = delete;
+
+    // Returns an invalid handle when every slot is still referenced; the caller keeps ownership then.
+    FrameHandle lend(void* sourceFrame, const uint8_t* data, size_t len);
+
+    // Number of slots currently referenced by at least one reader.
+    size_t getLentCount() const;
+
+private:
+    LentFrame slots[FRAME_LENDER_SLOTS];
+    FrameReleaseFn release_ = nullptr;
+    void* releaseCtx_ = nullptr;
+};
@@ -1,104 +1,82 @@
-
 #include "data-types/frame-mailbox.h"
 #include "esp_log.h"
 #include "define.h"
 #include "debug.h"
-#include <esp_heap_caps.h>
-#include <cstring>
 
-FrameMailboxManager::FrameMailboxManager(FrameMailbox* mailbox, size_t publishedFrameMaxBytes)
-    : mailbox(mailbox), publishedFrameMaxBytes_(publishedFrameMaxBytes) {}
+FrameMailboxManager::FrameMailboxManager(FrameMailbox* mailbox)
+    : mailbox(mailbox) {}
 
-bool FrameMailboxManager::initFrameMailbox(const char* tag, uint32_t caps) //caps MALLOC_CAP_SPIRAM
+bool FrameMailboxManager::initFrameMailbox(const char* tag)
 {
     if (!mailbox) {
         return false;
     }
     mailbox->tag = tag;
-    if (mailbox->buffers[0]){
-        delete[] mailbox->buffers[0];
-        mailbox->buffers[0] = nullptr;
-    }
-    if (mailbox->buffers[1]){
-        delete[] mailbox->buffers[1];
-        mailbox->buffers[1] = nullptr;
-    }
-    mailbox->buffers[0] = (uint8_t*)heap_caps_malloc(publishedFrameMaxBytes_, caps);
-    mailbox->buffers[1] = (uint8_t*)heap_caps_malloc(publishedFrameMaxBytes_, caps);
-    if (!mailbox->buffers[0] || !mailbox->buffers[1]) {
-        ESP_LOGE(MAIN_TAG, "Failed to allocate mailbox buffers for %s", tag ? tag : "unknown");
-        return false;
-    }
-    mailbox->activeIndex = 0;
-    mailbox->frameLen = 0;
-    mailbox->frameWidth = 0;
-    mailbox->frameHeight = 0;
-    mailbox->frameFormat = PIXFORMAT_GRAYSCALE;
-    mailbox->frameSeq = 0;
-    mailbox->frameCaptureUs = 0;
+    mailbox->frames.reset();
+    mailbox->publishedSeq.store(0, std::memory_order_relaxed);
+    mailbox->consumedSeq.store(0, std::memory_order_relaxed);
     mailbox->consumerTaskHandle = nullptr;
     return true;
 }
 
-void FrameMailboxManager::publish(const uint8_t* cameraFrameSrc,
-                                    size_t srcLen,
+void FrameMailboxManager::publish(const FrameHandle& frame,
                                     uint16_t width,
                                     uint16_t height,
                                     pixformat_t format,
                                     int64_t captureUs)
 {
-    if (!cameraFrameSrc || !mailbox || srcLen == 0) {
+    if (!frame.isValid() || !mailbox) {
         return;
     }
 
-    size_t frameLen = srcLen;
-    if (frameLen > publishedFrameMaxBytes_) {
-        ESP_LOGW(MAIN_TAG,
-                 "Mailbox %s frame too large (%u > %u), truncating",
-                 mailbox->tag ? mailbox->tag : "unknown",
-                 (unsigned int)frameLen,
-                 (unsigned int)publishedFrameMaxBytes_);
-        frameLen = publishedFrameMaxBytes_;
-    }
-
-    uint8_t publishIndex = mailbox->activeIndex ^ 1;
-    if (!mailbox->buffers[publishIndex]) {
-        return;
-    }
-
-    memcpy(mailbox->buffers[publishIndex], cameraFrameSrc, frameLen);
-    taskENTER_CRITICAL(&mailbox->lock);
-    mailbox->frameLen = frameLen;
-    mailbox->frameWidth = width;
-    mailbox->frameHeight = height;
-    mailbox->frameFormat = format;
-    mailbox->activeIndex = publishIndex;
-    mailbox->frameSeq++;
-    mailbox->frameCaptureUs = captureUs;
-    taskEXIT_CRITICAL(&mailbox->lock);
+    const uint32_t seq = mailbox->publishedSeq.load(std::memory_order_relaxed) + 1;
+    FrameSnapshot& slot = mailbox->frames.beginWrite();
+    slot.handle = frame;
+    slot.data = frame.data();
+    slot.len = frame.len();
+    slot.width = width;
+    slot.height = height;
+    slot.format = format;
+    slot.seq = seq;
+    slot.captureUs = captureUs;
+    // After publish() the slot belongs to the consumer, which may already have acquired and cleared it.
+    mailbox->frames.publish();
+    // The back slot now holds the frame the consumer skipped, if any. Clearing it at once drops that
+    // frame and hands its buffer back to the camera driver (no lock is held); otherwise it would stay
+    // pinned until the next capture, so a slow consumer plus its mailbox would hold three buffers.
+    mailbox->frames.beginWrite() = FrameSnapshot();
+    mailbox->publishedSeq.store(seq, std::memory_order_relaxed);
 
     if (mailbox->consumerTaskHandle) {
         xTaskNotifyGive(mailbox->consumerTaskHandle);
     }
 }
 
-bool FrameMailboxManager::snapshot(FrameSnapshot* snapshot)
+void FrameMailboxManager::flush()
 {
-    if (!mailbox || !snapshot) {
-        return false;
+    if (!mailbox) {
+        return;
     }
+    // Publishing an empty slot swaps the pending frame into the back slot, which is then cleared too.
+    // acquire() skips empty snapshots, so the consumer never sees the placeholder.
+    mailbox->frames.beginWrite() = FrameSnapshot();
+    mailbox->frames.publish();
+    mailbox->frames.beginWrite() = FrameSnapshot();
+}
 
-    ESP_LOGD(MAIN_TAG, "Snapshotting mailbox %s", mailbox->tag ? mailbox->tag : "unknown");
-    taskENTER_CRITICAL(&mailbox->lock);
-    const uint8_t activeIndex = mailbox->activeIndex;
-    snapshot->len = mailbox->frameLen;
-    snapshot->width = mailbox->frameWidth;
-    snapshot->height = mailbox->frameHeight;
-    snapshot->format = mailbox->frameFormat;
-    snapshot->seq = mailbox->frameSeq;
-    snapshot->captureUs = mailbox->frameCaptureUs;
-    taskEXIT_CRITICAL(&mailbox->lock);
-    ESP_LOGD(MAIN_TAG, "Snapshot: seq=%lu, len=%u, %dx%d, format=%d, captureUs=%lld",
+const FrameSnapshot* FrameMailboxManager::acquire()
+{
+    if (!mailbox) {
+        return nullptr;
+    }
+
+    const FrameSnapshot* snapshot = mailbox->frames.acquire();
+    if (!snapshot) {
+        return nullptr;
+    }
+    mailbox->consumedSeq.store(snapshot->seq, std::memory_order_relaxed);
+    ESP_LOGD(MAIN_TAG, "Acquired mailbox %s: seq=%lu, len=%u, %dx%d, format=%d, captureUs=%lld",
+             mailbox->tag ? mailbox->tag : "unknown",
              (unsigned long)snapshot->seq,
              (unsigned int)snapshot->len,
              (unsigned int)snapshot->width,
@@ -106,6 +84,29 @@ bool FrameMailboxManager::snapshot(FrameSnapshot* snapshot)
              (int)snapshot->format,
              (long long)snapshot->captureUs);
 
-    snapshot->data = mailbox->buffers[activeIndex];
-    return snapshot->data != nullptr && snapshot->len > 0;
-}
\ No newline at end of file
+    if (!snapshot->data || snapshot->len == 0) {
+        mailbox->frames.release();
+        return nullptr;
+    }
+    return snapshot;
+}
+
+void FrameMailboxManager::release()
+{
+    if (mailbox) {
+        mailbox->frames.release();
+    }
+}
+
+uint32_t FrameMailboxManager::getPublishedSeq() const
+{
+    return mailbox ? mailbox->publishedSeq.load(std::memory_order_relaxed) : 0;
+}
+
+uint32_t FrameMailboxManager::getConsumerLag() const
+{
+    if (!mailbox) {
+        return 0;
+    }
+    return mailbox->publishedSeq.load(std::memory_order_relaxed) - mailbox->consumedSeq.load(std::memory_order_relaxed);
+}
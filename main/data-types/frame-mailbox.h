@@ -3,21 +3,20 @@
 #include "esp_camera.h"
 #include "esp_err.h"
 #include "frame-snapshot.h"
+#include "frame-handle.h"
+#include "triple-buffer.h"
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
-#include "freertos/portmacro.h"
+#include <atomic>
 #include <cstdint>
 
+// Latest published frame for exactly one producer (capture_task) and one consumer task.
+// The payload is lent (refcounted), never copied into the mailbox.
 struct FrameMailbox {
-    uint8_t* buffers[2] = {nullptr, nullptr};
-    volatile uint8_t activeIndex = 0;
-    volatile size_t frameLen = 0;
-    volatile uint16_t frameWidth = 0;
-    volatile uint16_t frameHeight = 0;
-    volatile pixformat_t frameFormat = PIXFORMAT_GRAYSCALE;
-    volatile uint32_t frameSeq = 0;
-    volatile int64_t frameCaptureUs = 0;
-    portMUX_TYPE lock = portMUX_INITIALIZER_UNLOCKED;
+    TripleBuffer<FrameSnapshot> frames;
+    std::atomic<uint32_t> publishedSeq{0};
+    // Seq of the newest frame the consumer acquired.
+    std::atomic<uint32_t> consumedSeq{0};
     TaskHandle_t consumerTaskHandle = nullptr;
     const char* tag = nullptr;
 };
@@ -25,24 +24,31 @@ struct FrameMailbox {
 class FrameMailboxManager 
 {
 public:
-    FrameMailboxManager(FrameMailbox* mailbox, size_t publishedFrameMaxBytes);
+    explicit FrameMailboxManager(FrameMailbox* mailbox);
     ~FrameMailboxManager() = default;
-    bool initFrameMailbox(const char* tag, uint32_t caps);
-    void publish( const uint8_t* cameraFrameSrc,
-                    size_t srcLen,
+    bool initFrameMailbox(const char* tag);
+    // Producer: shares the frame with the consumer. A frame the consumer never acquired is dropped.
+    void publish( const FrameHandle& frame,
                     uint16_t width,
                     uint16_t height,
                     pixformat_t format,
                     int64_t captureUs);
-    bool snapshot(FrameSnapshot* snapshot);
+    // Producer: drops every frame still waiting in the mailbox. The consumer's acquired frame goes at its release().
+    void flush();
+    // Consumer: newest unread frame, or nullptr. The frame stays untouched by the producer until release().
+    const FrameSnapshot* acquire();
+    // Consumer: drops the acquired frame (its camera buffer may go back to the driver here).
+    void release();
+    // Sequence number of the newest published frame.
+    uint32_t getPublishedSeq() const;
+    // Frames published since the consumer last acquired one (1 right after a publish it has not picked up yet).
+    uint32_t getConsumerLag() const;
 
 private:
     FrameMailbox* mailbox;
-    size_t publishedFrameMaxBytes_ = 0;
 };
 
 extern FrameMailbox inferenceMailbox;
 extern FrameMailbox streamMailbox;
 extern FrameMailboxManager inferenceMailboxManager;
 extern FrameMailboxManager streamMailboxManager;
-
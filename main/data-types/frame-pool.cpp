@@ -0,0 +1,193 @@
+#include "data-types/frame-pool.h"
+#include "esp_log.h"
+#include "debug.h"
+#include <cstring>
+#include <new>
+
+FramePool::FramePool(const FramePoolClassConfig* classes, size_t classCount, FramePoolOversizePolicy oversizePolicy)
+    : oversizePolicy_(oversizePolicy)
+{
+    classCount_ = (classCount > FRAME_POOL_MAX_CLASSES) ? FRAME_POOL_MAX_CLASSES : classCount;
+    // Kept in ascending block size whatever the table order: allocate() takes the first class that fits
+    // and getMaxBlockSize() the last one. At most FRAME_POOL_MAX_CLASSES entries, so an insertion sort.
+    for (size_t i = 0; i < classCount_; i++) {
+        size_t j = i;
+        for (; j > 0 && classes_[j - 1].blockSize > classes[i].blockSize; j--) {
+            classes_[j].blockSize = classes_[j - 1].blockSize;
+            classes_[j].blockCount = classes_[j - 1].blockCount;
+        }
+        classes_[j].blockSize = classes[i].blockSize;
+        classes_[j].blockCount = classes[i].blockCount;
+    }
+}
+
+FramePool::~FramePool()
+{
+    for (size_t i = 0; i < classCount_; i++) {
+        bufferPlacement.release(placement_, classes_[i].storage, classes_[i].blockSize * classes_[i].blockCount);
+        delete[] classes_[i].blocks;
+        classes_[i].storage = nullptr;
+        classes_[i].blocks = nullptr;
+    }
+}
+
+bool FramePool::init(PlacedBuffer placement)
+{
+    placement_ = placement;
+    for (size_t i = 0; i < classCount_; i++) {
+        SlabClass& slab = classes_[i];
+        if (slab.storage) {
+            continue;
+        }
+        slab.storage = (uint8_t*)bufferPlacement.allocate(placement_, slab.blockSize * slab.blockCount);
+        slab.blocks = new (std::nothrow) LentFrame[slab.blockCount];
+        if (!slab.storage || !slab.blocks) {
+            ESP_LOGE(MAIN_TAG, "Failed to allocate frame pool class %u x %u",
+                     (unsigned int)slab.blockSize,
+                     (unsigned int)slab.blockCount);
+            return false;
+        }
+    }
+    ESP_LOGI(MAIN_TAG, "Frame pool ready: %u bytes in %u size classes",
+             (unsigned int)getReservedBytes(),
+             (unsigned int)classCount_);
+    return true;
+}
+
+FrameHandle FramePool::allocate(size_t len, uint8_t** writable, size_t* grantedLen)
+{
+    if (len == 0 || !writable) {
+        return FrameHandle();
+    }
+
+    size_t granted = len;
+    if (len > getMaxBlockSize()) {
+        oversize_.fetch_add(1, std::memory_order_relaxed);
+        if (oversizePolicy_ == FramePoolOversizePolicy::Reject) {
+            ESP_LOGW(MAIN_TAG, "Frame of %u bytes exceeds pool max block %u, dropped",
+                     (unsigned int)len,
+                     (unsigned int)getMaxBlockSize());
+            return FrameHandle();
+        }
+        ESP_LOGW(MAIN_TAG, "Frame of %u bytes exceeds pool max block %u, truncating",
+                 (unsigned int)len,
+                 (unsigned int)getMaxBlockSize());
+        granted = getMaxBlockSize();
+    }
+
+    // Smallest fitting class first, spilling into bigger classes when it is exhausted.
+    for (size_t i = 0; i < classCount_; i++) {
+        SlabClass& slab = classes_[i];
+        if (slab.blockSize < granted || !slab.storage) {
+            continue;
+        }
+        FrameHandle handle = takeBlock(slab, granted, writable);
+        if (handle.isValid()) {
+            if (grantedLen) {
+                *grantedLen = granted;
+            }
+            return handle;
+        }
+        slab.exhausted.fetch_add(1, std::memory_order_relaxed);
+    }
+    return FrameHandle();
+}
+
+FrameHandle FramePool::copyFrom(const uint8_t* src, size_t len)
+{
+    if (!src) {
+        return FrameHandle();
+    }
+    uint8_t* dst = nullptr;
+    size_t granted = 0;
+    FrameHandle handle = allocate(len, &dst, &granted);
+    if (handle.isValid()) {
+        memcpy(dst, src, granted);
+    }
+    return handle;
+}
+
+FrameHandle FramePool::takeBlock(SlabClass& slab, size_t len, uint8_t** writable)
+{
+    for (size_t i = 0; i < slab.blockCount; i++) {
+        LentFrame& block = slab.blocks[i];
+        bool expected = false;
+        if (!block.inUse.compare_exchange_strong(expected, true, std::memory_order_acquire)) {
+            continue;
+        }
+        uint8_t* payload = slab.storage + i * slab.blockSize;
+        block.data = payload;
+        block.len = len;
+        block.sourceFrame = payload;
+        block.release = &FramePool::releaseBlock;
+        block.releaseCtx = &slab;
+        block.refCount.store(1, std::memory_order_release);
+
+        slab.allocations.fetch_add(1, std::memory_order_relaxed);
+        const uint32_t inUse = slab.inUse.fetch_add(1, std::memory_order_relaxed) + 1;
+        uint32_t highWater = slab.highWater.load(std::memory_order_relaxed);
+        while (inUse > highWater &&
+               !slab.highWater.compare_exchange_weak(highWater, inUse, std::memory_order_relaxed)) {
+        }
+
+        *writable = payload;
+        return FrameHandle(&block);
+    }
+    return FrameHandle();
+}
+
+void FramePool::releaseBlock(void* releaseCtx, void* sourceFrame)
+{
+    (void)sourceFrame;
+    SlabClass* slab = static_cast<SlabClass*>(releaseCtx);
+    if (slab) {
+        slab->inUse.fetch_sub(1, std::memory_order_relaxed);
+    }
+}
+
+size_t FramePool::getMaxBlockSize() const
+{
+    return (classCount_ > 0) ? classes_[classCount_ - 1].blockSize : 0;
+}
+
+bool FramePool::getClassStats(size_t classIndex, FramePoolClassStats* stats) const
+{
+    if (classIndex >= classCount_ || !stats) {
+        return false;
+    }
+    const SlabClass& slab = classes_[classIndex];
+    stats->blockSize = slab.blockSize;
+    stats->blockCount = slab.blockCount;
+    stats->inUse = slab.inUse.load(std::memory_order_relaxed);
+    stats->highWater = slab.highWater.load(std::memory_order_relaxed);
+    stats->allocations = slab.allocations.load(std::memory_order_relaxed);
+    stats->exhausted = slab.exhausted.load(std::memory_order_relaxed);
+    return true;
+}
+
+size_t FramePool::getReservedBytes() const
+{
+    size_t total = 0;
+    for (size_t i = 0; i < classCount_; i++) {
+        total += classes_[i].blockSize * classes_[i].blockCount;
+    }
+    return total;
+}
+
+void FramePool::logStatus(const char* tag) const
+{
+    for (size_t i = 0; i < classCount_; i++) {
+        FramePoolClassStats stats;
+        getClassStats(i, &stats);
+        ESP_LOGI(tag, "Frame pool %6u B: in_use=%lu/%u high_water=%lu allocs=%lu exhausted=%lu",
+                 (unsigned int)stats.blockSize,
+                 (unsigned long)stats.inUse,
+                 (unsigned int)stats.blockCount,
+                 (unsigned long)stats.highWater,
+                 (unsigned long)stats.allocations,
+                 (unsigned long)stats.exhausted);
+    }
+    ESP_LOGI(tag, "Frame pool oversize=%lu (max block %u B)",
+             (unsigned long)getOversizeCount(),
+             (unsigned int)getMaxBlockSize());
+}
@@ -0,0 +1,86 @@
+#pragma once
+
+#include "data-types/frame-handle.h"
+#include "memory/buffer-placement.h"
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+// One slab: blockCount payload blocks of blockSize bytes each.
+struct FramePoolClassConfig {
+    size_t blockSize;
+    size_t blockCount;
+};
+
+// What allocate() does with a payload larger than the biggest size class.
+enum class FramePoolOversizePolicy {
+    Reject,     // drop the frame and count it
+    Truncate,   // hand out the biggest block and cut the payload (legacy behaviour)
+};
+
+// Per size class counters, safe to read from any task.
+struct FramePoolClassStats {
+    size_t blockSize = 0;
+    size_t blockCount = 0;
+    uint32_t inUse = 0;
+    uint32_t highWater = 0;
+    uint32_t allocations = 0;
+    uint32_t exhausted = 0;     // requests that had to spill to a bigger class or failed
+};
+
+#define FRAME_POOL_MAX_CLASSES 6
+
+// Size-class slab pool for frame payloads. Blocks are picked by actual payload length and
+// handed out as FrameHandles, so a store drops its block simply by dropping the handle.
+class FramePool
+{
+public:
+    FramePool(const FramePoolClassConfig* classes, size_t classCount, FramePoolOversizePolicy oversizePolicy);
+    ~FramePool();
+
+    FramePool(const FramePool&) = delete;
+    FramePool& operator=(const FramePool&) = delete;
+
+    // Allocates every slab through bufferPlacement under the given placement entry.
+    bool init(PlacedBuffer placement);
+
+    // Reserves a block for len bytes. *writable receives the payload pointer and *grantedLen the
+    // number of bytes the caller may write (less than len only under the Truncate policy).
+    // Returns an invalid handle when no block is available or the payload is rejected.
+    FrameHandle allocate(size_t len, uint8_t** writable, size_t* grantedLen);
+
+    // Allocates and fills a block with a copy of src.
+    FrameHandle copyFrom(const uint8_t* src, size_t len);
+
+    size_t getMaxBlockSize() const;
+    size_t getClassCount() const { return classCount_; }
+    bool getClassStats(size_t classIndex, FramePoolClassStats* stats) const;
+    size_t getReservedBytes() const;
+    uint32_t getOversizeCount() const { return oversize_.load(std::memory_order_relaxed); }
+
+    // Logs occupancy and high-water mark of every size class.
+    void logStatus(const char* tag) const;
+
+private:
+    struct SlabClass {
+        size_t blockSize = 0;
+        size_t blockCount = 0;
+        uint8_t* storage = nullptr;
+        LentFrame* blocks = nullptr;
+        std::atomic<uint32_t> inUse{0};
+        std::atomic<uint32_t> highWater{0};
+        std::atomic<uint32_t> allocations{0};
+        std::atomic<uint32_t> exhausted{0};
+    };
+
+    static void releaseBlock(void* releaseCtx, void* sourceFrame);
+    FrameHandle takeBlock(SlabClass& slab, size_t len, uint8_t** writable);
+
+    SlabClass classes_[FRAME_POOL_MAX_CLASSES];
+    size_t classCount_ = 0;
+    PlacedBuffer placement_ = PlacedBuffer::FramePoolSlabs;
+    FramePoolOversizePolicy oversizePolicy_;
+    std::atomic<uint32_t> oversize_{0};
+};
+
+extern FramePool framePool;
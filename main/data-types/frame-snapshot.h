@@ -2,6 +2,7 @@
 
 #include <cstdint>
 #include "esp_camera.h"
+#include "data-types/frame-handle.h"
 
 struct FrameSnapshot {
     const uint8_t* data = nullptr;
@@ -11,4 +12,6 @@ struct FrameSnapshot {
     pixformat_t format = PIXFORMAT_GRAYSCALE;
     uint32_t seq = 0;
     int64_t captureUs = 0;
-};
\ No newline at end of file
+    // Keeps data alive while the snapshot is held. Invalid when data points into a caller-owned buffer.
+    FrameHandle handle;
+};
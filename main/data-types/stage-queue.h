@@ -0,0 +1,68 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+// Lock-free single-producer / single-consumer queue of Depth slots between two pipeline stages.
+// The producer fills the slot from beginWrite() and publish()es it; the consumer takes slots in
+// order with acquire() and hands each back with release(). A slot is owned by exactly one side at a
+// time (an acquired slot still counts as occupied), so slot contents are never copied or locked.
+// When every slot is queued or held, beginWrite() returns nullptr and the producer decides what to
+// drop. No FreeRTOS primitives: wake-ups are left to the caller, so the class runs unchanged under
+// host pthreads.
+template <typename T, size_t Depth>
+class StageQueue
+{
+    static_assert(Depth > 0, "StageQueue needs at least one slot");
+
+public:
+    StageQueue() = default;
+
+    StageQueue(const StageQueue&) = delete;
+    StageQueue& operator=(const StageQueue&) = delete;
+
+    static constexpr size_t depth() { return Depth; }
+
+    // Not thread-safe: slot setup (e.g. buffers) before either stage starts.
+    T& slot(size_t index) { return slots[index]; }
+
+    // Producer: free slot to fill, or nullptr when all Depth slots are queued or held by the consumer.
+    T* beginWrite()
+    {
+        const uint32_t head = head_.load(std::memory_order_relaxed);
+        if (head - tail_.load(std::memory_order_acquire) >= Depth) {
+            return nullptr;
+        }
+        return &slots[head % Depth];
+    }
+
+    // Producer: queues the slot from beginWrite().
+    void publish() { head_.store(head_.load(std::memory_order_relaxed) + 1, std::memory_order_release); }
+
+    // Consumer: oldest queued slot, or nullptr when the queue is empty. Stays valid until release().
+    T* acquire()
+    {
+        const uint32_t tail = tail_.load(std::memory_order_relaxed);
+        if (tail == head_.load(std::memory_order_acquire)) {
+            return nullptr;
+        }
+        return &slots[tail % Depth];
+    }
+
+    // Consumer: hands the acquired slot back to the producer.
+    void release() { tail_.store(tail_.load(std::memory_order_relaxed) + 1, std::memory_order_release); }
+
+    // Slots queued or held by the consumer; exact only on the calling side.
+    size_t occupied() const
+    {
+        return head_.load(std::memory_order_acquire) - tail_.load(std::memory_order_acquire);
+    }
+
+private:
+    T slots[Depth];
+    // Written by the producer only.
+    std::atomic<uint32_t> head_{0};
+    // Written by the consumer only.
+    std::atomic<uint32_t> tail_{0};
+};
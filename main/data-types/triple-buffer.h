@@ -0,0 +1,71 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+
+// Lock-free single-producer / single-consumer triple buffer.
+// The writer fills the back slot and swaps it with the shared middle slot; the reader swaps the
+// middle slot with its front slot only when a newer one is available. The slot returned by
+// acquire() is owned by the reader and is never written by the producer until release() and a
+// later acquire() hand it back, so a slow consumer can never observe a torn frame.
+// No FreeRTOS primitives: publish/acquire are a single atomic exchange each, so neither side spins
+// across cores and the class builds unchanged on a host.
+template <typename T>
+class TripleBuffer
+{
+public:
+    TripleBuffer() = default;
+
+    TripleBuffer(const TripleBuffer&) = delete;
+    TripleBuffer& operator=(const TripleBuffer&) = delete;
+
+    // Not thread-safe: call before producer and consumer start.
+    void reset()
+    {
+        for (T& slot : slots) {
+            slot = T();
+        }
+        backIndex = 0;
+        frontIndex = 2;
+        state.store(1, std::memory_order_relaxed);
+    }
+
+    // Producer: slot to fill before publish(). May still hold a frame the reader skipped.
+    T& beginWrite() { return slots[backIndex]; }
+
+    // Producer: makes the back slot the newest frame.
+    void publish()
+    {
+        const uint32_t previous = state.exchange(backIndex | kFreshBit, std::memory_order_acq_rel);
+        backIndex = previous & kIndexMask;
+    }
+
+    // Consumer: newest unread slot, or nullptr when nothing was published since the last acquire.
+    T* acquire()
+    {
+        if ((state.load(std::memory_order_relaxed) & kFreshBit) == 0) {
+            return nullptr;
+        }
+        const uint32_t previous = state.exchange(frontIndex, std::memory_order_acq_rel);
+        frontIndex = previous & kIndexMask;
+        return &slots[frontIndex];
+    }
+
+    // Consumer: done with the acquired slot; its contents are cleared so held resources are freed now.
+    void release() { slots[frontIndex] = T(); }
+
+    // True when a frame has been published and not yet acquired.
+    bool hasFresh() const { return (state.load(std::memory_order_relaxed) & kFreshBit) != 0; }
+
+private:
+    static constexpr uint32_t kIndexMask = 0x3;
+    static constexpr uint32_t kFreshBit = 0x4;
+
+    T slots[3];
+    // Middle slot index plus fresh flag, shared by both sides.
+    std::atomic<uint32_t> state{1};
+    // Producer-owned.
+    uint32_t backIndex = 0;
+    // Consumer-owned.
+    uint32_t frontIndex = 2;
+};
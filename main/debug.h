@@ -13,6 +13,7 @@
 #define MAIN_TAG    "_______Main"
 #define JPEG_TAG    "_______Jpeg"
 #define HTTP_TAG    "_______http"
+#define MODEL_TAG   "______Model"
 
 void log_RAM_status(const std::string& header);
 
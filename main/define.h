@@ -13,11 +13,153 @@
 
 #define STREAM_ORIGINALLY_ACQUIRED_IMAGE 1// basically skips the cropping to 96x96 grayscale
 
+// Camera driver frame buffers. Captured frames are lent (not copied) to the mailboxes and HTTP store,
+// so readers may hold up to two buffers while the DMA fills the third.
+#define CAMERA_FB_COUNT 3
+
+// Pre-event clip recorder: keeps the last PRE_EVENT_CLIP_SECONDS of JPEG frames in a PSRAM ring and
+// freezes them into a clip (/clip.avi) when inference reports a person.
+#define ENABLE_PRE_EVENT_CLIP 1
+#define PRE_EVENT_CLIP_SECONDS 5
+#define PRE_EVENT_RING_BYTES (512 * 1024)
+// An undownloaded clip is dropped and recording resumes after this many seconds.
+#define PRE_EVENT_CLIP_HOLD_SECONDS 60
+
+// Capture pacing. CAPTURE_TARGET_FPS 0 captures as fast as the sensor delivers.
+// The pacer backs off (up to CAPTURE_MAX_INTERVAL_MS per frame) while the stream consumer skips more than
+// CAPTURE_MAX_STREAM_LAG frames or readers hold every camera buffer. Inference drops stale frames
+// for free, so its lag only throttles capture when CAPTURE_PACE_ON_INFERENCE is 1.
+#define CAPTURE_TARGET_FPS 20
+#define CAPTURE_MAX_INTERVAL_MS 250
+#define CAPTURE_MAX_STREAM_LAG 2
+#define CAPTURE_PACE_ON_INFERENCE 0
+
+// Runtime camera reconfiguration (/camera/config). Raw formats are limited further because their
+// frames are copied into the frame pool and grayscale workspaces.
+#define CAMERA_RECONFIG_MAX_FRAMESIZE FRAMESIZE_VGA
+#define CAMERA_RECONFIG_MAX_RAW_FRAMESIZE FRAMESIZE_QVGA
+// Upper bound for parking capture_task and for consumers to hand back lent frames.
+#define CAMERA_RECONFIG_TIMEOUT_MS 2000
+// Extra frames fetched after a geometry change, on top of the driver's queued buffers.
+#define CAMERA_RECONFIG_SETTLE_FRAMES 3
+
+// Stream bitrate control: holds the end-to-end frame age of the stream near STREAM_TARGET_FRAME_AGE_MS
+// (+/- STREAM_FRAME_AGE_BAND_PERCENT) by lowering JPEG quality down to STREAM_WORST_JPEG_QUALITY, then the
+// capture rate down to STREAM_MIN_FPS, and restoring both once the link recovers. The configured camera
+// quality and CAPTURE_TARGET_FPS are the ceiling. Keep STREAM_MIN_FPS above 1000 / (2 * target age):
+// below that the capture interval alone pushes the mean age over the target.
+#define ENABLE_STREAM_BITRATE_CONTROL 1
+#define STREAM_TARGET_FRAME_AGE_MS 150
+#define STREAM_FRAME_AGE_BAND_PERCENT 25
+#define STREAM_WORST_JPEG_QUALITY 40
+#define STREAM_MIN_FPS 5
+
+// Motion gate in front of inference: JPEG frames are decoded at 1:8 into a luma thumbnail and compared with
+// a running background. Invoke() only runs when more than MOTION_GATE_CHANGED_PERMILLE of the thumbnail
+// pixels moved by over MOTION_GATE_PIXEL_THRESHOLD, or MOTION_GATE_MAX_INTERVAL_MS passed since the last one.
+#define ENABLE_MOTION_GATE 1
+#define MOTION_GATE_PIXEL_THRESHOLD 12
+#define MOTION_GATE_CHANGED_PERMILLE 30
+#define MOTION_GATE_BACKGROUND_SHIFT 3
+#define MOTION_GATE_MAX_INTERVAL_MS 2000
+
+// Adaptive inference scheduling (detection-scheduler/detection-scheduler.h): the person confidence is
+// smoothed with an EMA (DETECTION_EMA_ALPHA = weight of the newest result), and detection turns on
+// above DETECTION_ENTER_THRESHOLD and off below DETECTION_EXIT_THRESHOLD. After
+// DETECTION_SETTLE_INFERENCES results at least DETECTION_SETTLED_MARGIN away from the threshold that
+// would flip the state, the time between inferences doubles from DETECTION_BACKOFF_FIRST_MS up to
+// DETECTION_BACKOFF_MAX_MS. Motion (with ENABLE_MOTION_GATE) or a result near the threshold restores
+// one inference per frame. 0 runs every admitted frame against DETECTION_THRESHOLD alone.
+#define ENABLE_ADAPTIVE_SCHEDULING 1
+#define DETECTION_EMA_ALPHA 0.5f
+#define DETECTION_ENTER_THRESHOLD 0.6f
+#define DETECTION_EXIT_THRESHOLD 0.4f
+#define DETECTION_SETTLED_MARGIN 0.2f
+#define DETECTION_SETTLE_INFERENCES 3
+#define DETECTION_BACKOFF_FIRST_MS 250
+#define DETECTION_BACKOFF_MAX_MS 2000
+
+// Model input: INFERENCE_INPUT_CENTER_CROP takes the centered 96x96 window of the frame as is;
+// INFERENCE_INPUT_FULL_VIEW decodes JPEG at the largest 1:2/1:4/1:8 scale that still covers 96x96 and
+// resamples the whole frame down (2x2 averaging, then bilinear), so larger capture sizes cost about
+// the same per inference while the model sees the full field of view.
+// INFERENCE_INPUT_TILED decodes a luma frame whose long side is at most TILED_INFERENCE_MAX_SIDE and
+// slides overlapping 96x96 windows over it (image-editing/detection-tiles.h): windows with the most
+// change since the previous frame run first, and the frame stops at the first person or when the next
+// Invoke() would overrun TILED_INFERENCE_BUDGET_MS. The HTTP gray preview stays a center crop.
+#define INFERENCE_INPUT_CENTER_CROP 0
+#define INFERENCE_INPUT_FULL_VIEW 1
+#define INFERENCE_INPUT_TILED 2
+#define INFERENCE_INPUT_MODE INFERENCE_INPUT_CENTER_CROP
+
+// Tiled inference: minimum overlap between neighbouring windows (a person cut by one window edge is
+// whole in the next), window cap per frame, and the per-frame Invoke() budget. At least one window
+// always runs.
+#define TILED_INFERENCE_MAX_SIDE 320
+#define TILED_INFERENCE_OVERLAP_PERCENT 25
+#define TILED_INFERENCE_MAX_TILES 16
+#define TILED_INFERENCE_BUDGET_MS 1500
+
+// Two-stage inference (inference-pipeline/pipeline-meter.h, data-types/stage-queue.h): a preprocessing
+// task on INFERENCE_PREPROCESS_CORE runs the motion gate, the scheduler and the 96x96 decode/crop, and
+// hands ready inputs through an INFERENCE_PIPELINE_DEPTH-slot queue to inference_task on
+// INFERENCE_INVOKE_CORE, so frame N+1 is prepared while frame N is in Invoke(). With the queue full the
+// camera frame stays in the mailbox and the newest one is taken once a slot frees up. A slot frees as
+// soon as its input is copied into the tensor, so one slot already overlaps the stages fully; more only
+// absorb preprocessing jitter, each adding up to one Invoke() of capture-to-result latency. Throughput,
+// stage times and latency are logged every 2 s. INFERENCE_INPUT_TILED always runs in one task: its
+// windows are cut between Invoke() calls of the same frame.
+#define ENABLE_INFERENCE_PIPELINE 1
+#define INFERENCE_PIPELINE_DEPTH 1
+#define INFERENCE_PREPROCESS_CORE 1
+#define INFERENCE_INVOKE_CORE 0
+#define INFERENCE_PIPELINED (ENABLE_INFERENCE && ENABLE_INFERENCE_PIPELINE && INFERENCE_INPUT_MODE != INFERENCE_INPUT_TILED)
+
+// Pixel conversion kernels (image-editing/pixel-kernels.h): 0 = division-free fixed-point kernels,
+// 1 = the original scalar loops. Both produce identical output; 1 is kept for A/B timing on the device.
+#define PIXEL_KERNELS_REFERENCE 0
+
+// Frame injection for reproducible benchmarks: POST /frames/inject stores up to FRAME_INJECT_MAX_FRAMES
+// frames (FRAME_INJECT_BUFFER_BYTES in PSRAM, allocated on the first upload) and /frames/source?use=injected
+// feeds them to capture_task in a loop instead of the camera.
+#define FRAME_INJECT_MAX_FRAMES 16
+#define FRAME_INJECT_BUFFER_BYTES (256 * 1024)
+
+// Per-operator inference profiling (tf-lite/op-profiler.h): the interpreter reports every node's Invoke
+// to a profiler that keeps count, total and max time per graph node, served as JSON by
+// GET /inference/profile (?reset=1 clears the totals after reading).
+#define ENABLE_OP_PROFILER 1
+
 // Size of temporary JPEG-related working buffer (bytes).
 #define JPEG_BUFFER_SIZE (20 * 1024)
 
-// TensorFlow Lite arena size reserved for model execution (bytes).
+// TensorFlow Lite arena size reserved for model execution (bytes). With ENABLE_ARENA_MEASUREMENT this is
+// only the scratch arena of a boot-time recording pass (RecordingMicroAllocator): the real arena is then
+// allocated at the measured head + tail usage plus ARENA_MARGIN_BYTES, internal SRAM first.
 #define ARENA_SIZE (128 * 1024)
+#define ENABLE_ARENA_MEASUREMENT 1
+#define ARENA_MARGIN_BYTES 1024
+
+// Tensor arena layout. TENSOR_ARENA_SINGLE hands tflite-micro one arena (TensorArena placement).
+// TENSOR_ARENA_SPLIT hands it two: the non-persistent arena (activations and kernel scratch, read and
+// written by every Invoke()) from TensorArena, internal SRAM first, and the persistent arena (tensor
+// structs, quantization params, op data, written once by AllocateTensors()) from TensorArenaPersistent,
+// PSRAM first. ARENA_PERSISTENT_SIZE / ARENA_NON_PERSISTENT_SIZE size the two; with
+// ENABLE_ARENA_MEASUREMENT each is replaced by its measured part plus ARENA_MARGIN_BYTES.
+#define TENSOR_ARENA_SINGLE 0
+#define TENSOR_ARENA_SPLIT 1
+#define TENSOR_ARENA_LAYOUT TENSOR_ARENA_SPLIT
+#define ARENA_PERSISTENT_SIZE (48 * 1024)
+#define ARENA_NON_PERSISTENT_SIZE (80 * 1024)
+
+// Model partition (partitions.csv, label MODEL_PARTITION_LABEL): two slots holding a validated .tflite
+// image each. At boot the newest valid slot is memory-mapped and the interpreter runs on it in place;
+// without one the compiled-in model is used. POST /inference/model writes an upload into the other slot
+// and swaps the interpreter over to it without a reboot, waiting up to MODEL_SWAP_TIMEOUT_MS for the
+// inference task to take it between frames.
+#define ENABLE_MODEL_PARTITION 1
+#define MODEL_PARTITION_LABEL "model"
+#define MODEL_SWAP_TIMEOUT_MS 5000
 
 // Keep /stream.rgb connection open indefinitely when set to 1.
 // Set to 0 to stream a limited burst and reconnect.
@@ -27,6 +169,11 @@
 // Set to 0 to suspend inference for streaming performance tests.
 #define ENABLE_INFERENCE 0
 #define TF_IMAGE_INPUT_SIZE 96
+// Real value range the model expects for luma 0..255 (the bundled person detector was trained on
+// [-1, 1]). Quantized inputs store round(real / scale) + zero_point with the input tensor's own
+// parameters; float inputs get the real value itself.
+#define TF_INPUT_REAL_MIN -1.0f
+#define TF_INPUT_REAL_MAX 1.0f
 
 // Enable browser fallback from /stream.rgb to /capture.rgb polling when set to 1.
 #define ENABLE_POLLING_FALLBACK 0
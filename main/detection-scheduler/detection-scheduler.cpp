@@ -0,0 +1,95 @@
+#include "detection-scheduler/detection-scheduler.h"
+
+DetectionScheduler::DetectionScheduler(const DetectionSchedulerConfig& config)
+    : config_(config) {}
+
+void DetectionScheduler::reset()
+{
+    hasSmoothed_ = false;
+    smoothed_ = 0.0f;
+    present_ = false;
+    settledCount_ = 0;
+    intervalUs_ = 0;
+}
+
+bool DetectionScheduler::shouldRun(int64_t nowUs, bool motion)
+{
+    if (windowStartUs_ < 0) {
+        windowStartUs_ = nowUs;
+    }
+    window_.frames++;
+
+    const bool due = intervalUs_ == 0 || nowUs - lastInferenceUs_ >= intervalUs_;
+    if (!due && motion) {
+        // Something moved: the settled result may be stale, so sample at full rate again.
+        intervalUs_ = 0;
+        settledCount_ = 0;
+        window_.motionWakeups++;
+        return true;
+    }
+    if (!due) {
+        window_.skipped++;
+    }
+    return due;
+}
+
+DetectionUpdate DetectionScheduler::update(float confidence, int64_t nowUs)
+{
+    DetectionUpdate result;
+    window_.inferences++;
+    lastInferenceUs_ = nowUs;
+
+    if (!hasSmoothed_) {
+        smoothed_ = confidence;
+        hasSmoothed_ = true;
+    } else {
+        smoothed_ += config_.emaAlpha * (confidence - smoothed_);
+    }
+
+    const bool wasPresent = present_;
+    if (!present_ && smoothed_ > config_.enterThreshold) {
+        present_ = true;
+    } else if (present_ && smoothed_ < config_.exitThreshold) {
+        present_ = false;
+    }
+    result.changed = present_ != wasPresent;
+    if (result.changed) {
+        window_.transitions++;
+    }
+
+    // Margin to the threshold that would flip the current state.
+    const float margin = present_ ? smoothed_ - config_.exitThreshold : config_.enterThreshold - smoothed_;
+    if (result.changed || margin < config_.settledMargin) {
+        settledCount_ = 0;
+        intervalUs_ = 0;
+    } else {
+        if (settledCount_ < config_.settleInferences) {
+            settledCount_++;
+        }
+        if (settledCount_ >= config_.settleInferences && config_.firstBackoffUs > 0) {
+            intervalUs_ = intervalUs_ == 0 ? config_.firstBackoffUs : intervalUs_ * 2;
+            if (intervalUs_ > config_.maxIntervalUs) {
+                intervalUs_ = config_.maxIntervalUs;
+            }
+        }
+    }
+
+    result.present = present_;
+    result.smoothed = smoothed_;
+    result.intervalUs = intervalUs_;
+    return result;
+}
+
+void DetectionScheduler::takeStats(DetectionSchedulerStats* stats, int64_t nowUs)
+{
+    const int64_t elapsedUs = windowStartUs_ >= 0 ? nowUs - windowStartUs_ : 0;
+    window_.savedPerMinute = elapsedUs > 0 ? window_.skipped * (60.0e6f / (float)elapsedUs) : 0.0f;
+    window_.smoothed = smoothed_;
+    window_.intervalUs = intervalUs_;
+    window_.present = present_;
+    if (stats) {
+        *stats = window_;
+    }
+    window_ = DetectionSchedulerStats();
+    windowStartUs_ = nowUs;
+}
@@ -0,0 +1,71 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+struct DetectionSchedulerConfig {
+    float emaAlpha = 0.5f;              // weight of the newest confidence in the smoothed value
+    float enterThreshold = 0.6f;        // smoothed confidence above this turns detection on
+    float exitThreshold = 0.4f;         // ... and below this turns it off again
+    float settledMargin = 0.2f;         // distance from the active threshold that counts as a confident result
+    uint8_t settleInferences = 3;       // consecutive confident results before the interval backs off
+    int64_t firstBackoffUs = 0;         // first non-zero interval; doubles per further confident result
+    int64_t maxIntervalUs = 0;          // longest interval while settled
+};
+
+struct DetectionUpdate {
+    bool present = false;
+    bool changed = false;               // present flipped with this result
+    float smoothed = 0.0f;
+    int64_t intervalUs = 0;             // time until the next frame is worth an inference
+};
+
+struct DetectionSchedulerStats {
+    uint32_t frames = 0;                // frames offered to shouldRun()
+    uint32_t skipped = 0;
+    uint32_t inferences = 0;
+    uint32_t motionWakeups = 0;         // skipped-interval frames run early because of motion
+    uint32_t transitions = 0;
+    float savedPerMinute = 0.0f;        // skipped inferences, scaled to one minute of the stats window
+    float smoothed = 0.0f;
+    int64_t intervalUs = 0;
+    bool present = false;
+};
+
+// Person detection state machine on top of the raw model confidence. Confidence is smoothed with an
+// EMA and present switches with separate enter/exit thresholds, so a score hovering at the threshold
+// does not flicker the LEDs or re-trigger clips. The same margin drives the inference rate: after
+// settleInferences results far from the active threshold the interval between inferences doubles from
+// firstBackoffUs up to maxIntervalUs, and a result near the threshold, a state change or motion brings
+// it back to every frame. No ESP-IDF calls; recorded confidence sequences replay on a host.
+class DetectionScheduler
+{
+public:
+    explicit DetectionScheduler(const DetectionSchedulerConfig& config);
+
+    void reset();
+
+    // Whether the frame at nowUs should run Invoke(). motion (e.g. a MotionGate Motion trigger) ends a
+    // back-off at once.
+    bool shouldRun(int64_t nowUs, bool motion);
+
+    // Feeds the person confidence of an inference that ran at nowUs.
+    DetectionUpdate update(float confidence, int64_t nowUs);
+
+    bool present() const { return present_; }
+
+    // Fills stats and starts a new window.
+    void takeStats(DetectionSchedulerStats* stats, int64_t nowUs);
+
+private:
+    DetectionSchedulerConfig config_;
+    bool hasSmoothed_ = false;
+    float smoothed_ = 0.0f;
+    bool present_ = false;
+    uint8_t settledCount_ = 0;
+    int64_t intervalUs_ = 0;
+    int64_t lastInferenceUs_ = 0;
+
+    DetectionSchedulerStats window_;
+    int64_t windowStartUs_ = -1;
+};
@@ -0,0 +1,44 @@
+#pragma once
+
+#include "sensor.h"
+#include "data-types/frame-handle.h"
+#include <cstddef>
+#include <cstdint>
+
+// One frame handed out by a FrameSource: the payload is lent through handle, never copied.
+struct SourceFrame {
+    FrameHandle handle;
+    uint16_t width = 0;
+    uint16_t height = 0;
+    pixformat_t format = PIXFORMAT_JPEG;
+};
+
+enum class FrameAcquireResult : uint8_t {
+    Ok,
+    NoFrame,    // nothing delivered (sensor timeout, empty replay list)
+    NoSlot,     // readers still hold every lending slot; the frame was given back
+};
+
+// Where capture_task gets its frames from. The camera is the normal source; replay sources hand out a
+// fixed frame list in order, so the mailboxes, inference and streaming see identical input run to run.
+// No FreeRTOS or driver types, so replay sources and the code behind them build on a host.
+class FrameSource
+{
+public:
+    virtual ~FrameSource() = default;
+
+    virtual const char* name() const = 0;
+
+    // Next frame. Blocks at most about one frame time.
+    virtual FrameAcquireResult acquire(SourceFrame* frame) = 0;
+
+    // Frames still referenced by readers.
+    virtual size_t getLentCount() const = 0;
+
+    // True when acquire() waits for the next frame (the sensor); replay sources return at once.
+    virtual bool blocksUntilFrame() const { return false; }
+
+    // Called with capture parked: before the first acquire() and after the last lent frame came back.
+    virtual void onActivate() {}
+    virtual void onDeactivate() {}
+};
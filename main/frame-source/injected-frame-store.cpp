@@ -0,0 +1,68 @@
+#include "frame-source/injected-frame-store.h"
+#include "esp_log.h"
+#include "debug.h"
+
+InjectedFrameStore::InjectedFrameStore(size_t capacityBytes, PlacedBuffer placement)
+    : capacity_(capacityBytes), placement_(placement) {}
+
+uint8_t* InjectedFrameStore::reserve(size_t len)
+{
+    if (source_.isActive() || len == 0 || count_ >= FRAME_INJECT_MAX_FRAMES) {
+        return nullptr;
+    }
+    if (!storage_) {
+        storage_ = (uint8_t*)bufferPlacement.allocate(placement_, capacity_);
+        if (!storage_) {
+            return nullptr;
+        }
+    }
+    // 4-byte aligned starts keep RGB565 payloads readable as uint16_t.
+    const size_t offset = (used_ + 3) & ~(size_t)3;
+    if (offset + len > capacity_) {
+        return nullptr;
+    }
+    pending_ = storage_ + offset;
+    pendingLen_ = len;
+    return pending_;
+}
+
+bool InjectedFrameStore::commit(uint16_t width, uint16_t height, pixformat_t format)
+{
+    if (!pending_ || source_.isActive()) {
+        return false;
+    }
+    ReplayFrame& frame = frames_[count_];
+    frame.data = pending_;
+    frame.len = pendingLen_;
+    frame.width = width;
+    frame.height = height;
+    frame.format = format;
+    used_ = (size_t)(pending_ - storage_) + pendingLen_;
+    count_++;
+    pending_ = nullptr;
+    pendingLen_ = 0;
+    source_.setFrames(frames_, count_);
+    ESP_LOGI(MAIN_TAG, "Injected frame %u: %ux%u fmt=%d len=%u (%u/%u bytes used)",
+             (unsigned int)count_,
+             (unsigned int)width,
+             (unsigned int)height,
+             (int)format,
+             (unsigned int)frame.len,
+             (unsigned int)used_,
+             (unsigned int)capacity_);
+    return true;
+}
+
+bool InjectedFrameStore::clear()
+{
+    if (source_.isActive()) {
+        return false;
+    }
+    count_ = 0;
+    used_ = 0;
+    pending_ = nullptr;
+    pendingLen_ = 0;
+    source_.setFrames(nullptr, 0);
+    // Keep the arena: uploads usually come in batches.
+    return true;
+}
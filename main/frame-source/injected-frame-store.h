@@ -0,0 +1,40 @@
+#pragma once
+
+#include "define.h"
+#include "frame-source/replay-frame-source.h"
+#include "memory/buffer-placement.h"
+
+// Frames uploaded over HTTP (POST /frames/inject), replayed through the ReplayFrameSource it owns.
+// The PSRAM arena is allocated on the first upload. Uploads and clear() come from the HTTP server task
+// and are refused while the frames are being replayed.
+class InjectedFrameStore
+{
+public:
+    InjectedFrameStore(size_t capacityBytes, PlacedBuffer placement);
+
+    // Reserves len bytes for the next frame; fill them, then commit(). nullptr when full or replaying.
+    uint8_t* reserve(size_t len);
+    // Publishes the reserved frame to the replay list.
+    bool commit(uint16_t width, uint16_t height, pixformat_t format);
+    // Drops every frame. Refused (false) while replaying.
+    bool clear();
+
+    ReplayFrameSource* getSource() { return &source_; }
+    size_t getFrameCount() const { return count_; }
+    size_t getUsedBytes() const { return used_; }
+    size_t getCapacityBytes() const { return capacity_; }
+
+private:
+    ReplayFrameSource source_;
+    ReplayFrame frames_[FRAME_INJECT_MAX_FRAMES];
+    size_t count_ = 0;
+
+    uint8_t* storage_ = nullptr;
+    size_t capacity_ = 0;
+    size_t used_ = 0;
+    PlacedBuffer placement_;
+    uint8_t* pending_ = nullptr;
+    size_t pendingLen_ = 0;
+};
+
+extern InjectedFrameStore injectedFrameStore;
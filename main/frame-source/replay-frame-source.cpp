@@ -0,0 +1,59 @@
+#include "frame-source/replay-frame-source.h"
+#include <utility>
+
+ReplayFrameSource::ReplayFrameSource()
+    : lender_(nullptr, nullptr) {}
+
+bool ReplayFrameSource::setFrames(const ReplayFrame* frames, size_t count)
+{
+    if (isActive()) {
+        return false;
+    }
+    frames_ = frames;
+    count_ = frames ? count : 0;
+    next_ = 0;
+    return true;
+}
+
+FrameAcquireResult ReplayFrameSource::acquire(SourceFrame* frame)
+{
+    if (count_ == 0) {
+        return FrameAcquireResult::NoFrame;
+    }
+    const ReplayFrame& stored = frames_[next_];
+    FrameHandle handle = lender_.lend(const_cast<ReplayFrame*>(&stored), stored.data, stored.len);
+    if (!handle.isValid()) {
+        return FrameAcquireResult::NoSlot;
+    }
+
+    frame->handle = std::move(handle);
+    frame->width = stored.width;
+    frame->height = stored.height;
+    frame->format = stored.format;
+
+    delivered_++;
+    if (++next_ == count_) {
+        next_ = 0;
+        loops_++;
+    }
+    return FrameAcquireResult::Ok;
+}
+
+size_t ReplayFrameSource::getLentCount() const
+{
+    return lender_.getLentCount();
+}
+
+void ReplayFrameSource::onActivate()
+{
+    // Every activation replays the same sequence from the first frame.
+    next_ = 0;
+    delivered_ = 0;
+    loops_ = 0;
+    active_.store(true, std::memory_order_release);
+}
+
+void ReplayFrameSource::onDeactivate()
+{
+    active_.store(false, std::memory_order_release);
+}
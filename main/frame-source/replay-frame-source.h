@@ -0,0 +1,45 @@
+#pragma once
+
+#include "frame-source/frame-source.h"
+#include <atomic>
+
+// One stored frame. The payload must stay valid and unchanged while the source is active.
+struct ReplayFrame {
+    const uint8_t* data = nullptr;
+    size_t len = 0;
+    uint16_t width = 0;
+    uint16_t height = 0;
+    pixformat_t format = PIXFORMAT_JPEG;
+};
+
+// Hands out a caller-owned frame list in order, wrapping around at the end. Payloads are lent, not
+// copied; nothing is returned to anyone when the last reader drops a frame.
+class ReplayFrameSource : public FrameSource
+{
+public:
+    ReplayFrameSource();
+
+    // Replaces the frame list. Refused (false) while the source is active.
+    bool setFrames(const ReplayFrame* frames, size_t count);
+
+    const char* name() const override { return "replay"; }
+    FrameAcquireResult acquire(SourceFrame* frame) override;
+    size_t getLentCount() const override;
+    void onActivate() override;
+    void onDeactivate() override;
+
+    bool isActive() const { return active_.load(std::memory_order_acquire); }
+    size_t getFrameCount() const { return count_; }
+    // Frames handed out and completed passes over the list since activation.
+    uint32_t getDelivered() const { return delivered_; }
+    uint32_t getLoops() const { return loops_; }
+
+private:
+    FrameLender lender_;
+    const ReplayFrame* frames_ = nullptr;
+    size_t count_ = 0;
+    size_t next_ = 0;
+    uint32_t delivered_ = 0;
+    uint32_t loops_ = 0;
+    std::atomic<bool> active_{false};
+};
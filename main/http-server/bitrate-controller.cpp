@@ -0,0 +1,161 @@
+#include "http-server/bitrate-controller.h"
+
+BitrateController::BitrateController(const BitrateControllerConfig& config)
+    : config_(config) {}
+
+void BitrateController::setLimits(int bestQuality, float maxFps)
+{
+    if (maxFps < 0.0f) {
+        maxFps = 0.0f;
+    }
+    if (hasLimits_ && bestQuality == bestQuality_ && maxFps == maxFps_) {
+        return;
+    }
+    bestQuality_ = bestQuality;
+    maxFps_ = maxFps;
+    hasLimits_ = true;
+    quality_ = bestQuality_;
+    fps_ = ceilingFps();
+    goodWindows_ = 0;
+}
+
+float BitrateController::ceilingFps() const
+{
+    return (maxFps_ > 0.0f) ? maxFps_ : config_.unpacedFps;
+}
+
+void BitrateController::addSample(const BitrateSample& sample)
+{
+    if (windowStartUs_ < 0) {
+        windowStartUs_ = sample.nowUs;
+    }
+    windowSkipped_ += sample.skippedFrames;
+    if (sample.failed) {
+        windowFailed_++;
+        return;
+    }
+    if (sample.stale) {
+        windowStale_++;
+        return;
+    }
+    windowSamples_++;
+    windowAgeSumUs_ += sample.frameAgeUs;
+    windowSendSumUs_ += sample.sendUs;
+    if (sample.sendUs > windowSendMaxUs_) {
+        windowSendMaxUs_ = sample.sendUs;
+    }
+    windowBytes_ += sample.frameBytes;
+}
+
+bool BitrateController::windowElapsed(int64_t nowUs) const
+{
+    return windowStartUs_ >= 0 && nowUs - windowStartUs_ >= config_.windowUs;
+}
+
+void BitrateController::resetWindow(int64_t nowUs)
+{
+    windowStartUs_ = nowUs;
+    windowSamples_ = 0;
+    windowStale_ = 0;
+    windowFailed_ = 0;
+    windowSkipped_ = 0;
+    windowAgeSumUs_ = 0;
+    windowSendSumUs_ = 0;
+    windowSendMaxUs_ = 0;
+    windowBytes_ = 0;
+}
+
+void BitrateController::degrade()
+{
+    // Quality first: it cuts bytes per frame without adding the capture interval to the frame age.
+    if (quality_ < config_.worstQuality) {
+        quality_ += config_.qualityDegradeStep;
+        if (quality_ > config_.worstQuality) {
+            quality_ = config_.worstQuality;
+        }
+        return;
+    }
+    if (fps_ > config_.minFps) {
+        fps_ *= config_.fpsDegradeFactor;
+        if (fps_ < config_.minFps) {
+            fps_ = config_.minFps;
+        }
+    }
+}
+
+void BitrateController::recover()
+{
+    // Reverse order of degrade(): rate back to the ceiling, then quality.
+    const float ceiling = ceilingFps();
+    if (fps_ < ceiling) {
+        fps_ += config_.fpsRecoverStep;
+        if (fps_ > ceiling) {
+            fps_ = ceiling;
+        }
+        return;
+    }
+    if (quality_ > bestQuality_) {
+        quality_ -= config_.qualityRecoverStep;
+        if (quality_ < bestQuality_) {
+            quality_ = bestQuality_;
+        }
+    }
+}
+
+bool BitrateController::evaluate(int64_t nowUs, BitrateDecision* decision)
+{
+    if (!hasLimits_ || !windowElapsed(nowUs)) {
+        return false;
+    }
+
+    const uint32_t sent = windowSamples_ + windowStale_ + windowFailed_;
+    const uint32_t delivered = windowSamples_ + windowStale_;
+    stats_.samples = windowSamples_;
+    stats_.staleSamples = windowStale_;
+    stats_.meanAgeMs = windowSamples_ ? (float)windowAgeSumUs_ / (1000.0f * windowSamples_) : 0.0f;
+    stats_.meanSendMs = windowSamples_ ? (float)windowSendSumUs_ / (1000.0f * windowSamples_) : 0.0f;
+    stats_.maxSendMs = (float)windowSendMaxUs_ / 1000.0f;
+    stats_.meanFrameBytes = windowSamples_ ? (float)windowBytes_ / (float)windowSamples_ : 0.0f;
+    stats_.errorRatio = sent ? (float)windowFailed_ / (float)sent : 0.0f;
+    stats_.skipRatio = (windowSkipped_ + delivered) ? (float)windowSkipped_ / (float)(windowSkipped_ + delivered) : 0.0f;
+
+    const BitrateDecision previous = getDecision();
+    const bool enoughSamples = windowSamples_ >= config_.minSamples;
+    const int64_t bandUs = (config_.targetAgeUs * config_.ageBandPercent) / 100;
+    const int64_t meanAgeUs = windowSamples_ ? windowAgeSumUs_ / windowSamples_ : 0;
+    const bool erroring = sent > 0 && stats_.errorRatio > config_.maxErrorRatio;
+    const bool late = enoughSamples && meanAgeUs > config_.targetAgeUs + bandUs;
+    const bool early = enoughSamples && windowFailed_ == 0 && meanAgeUs < config_.targetAgeUs - bandUs;
+
+    stats_.congested = erroring || late;
+    if (stats_.congested) {
+        goodWindows_ = 0;
+        degrade();
+    } else if (early) {
+        if (++goodWindows_ >= config_.recoverWindows) {
+            goodWindows_ = 0;
+            recover();
+        }
+    } else {
+        // Inside the band, or too few samples to judge: hold.
+        goodWindows_ = 0;
+    }
+    resetWindow(nowUs);
+
+    const BitrateDecision current = getDecision();
+    stats_.jpegQuality = current.jpegQuality;
+    stats_.targetFps = current.targetFps;
+    if (decision) {
+        *decision = current;
+    }
+    return current.jpegQuality != previous.jpegQuality || current.targetFps != previous.targetFps;
+}
+
+BitrateDecision BitrateController::getDecision() const
+{
+    BitrateDecision decision;
+    decision.jpegQuality = quality_;
+    // At the ceiling of an unpaced configuration hand back 0 so capture stays unpaced.
+    decision.targetFps = (maxFps_ <= 0.0f && fps_ >= config_.unpacedFps) ? 0.0f : fps_;
+    return decision;
+}
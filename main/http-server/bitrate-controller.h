@@ -0,0 +1,103 @@
+#pragma once
+
+#include <cstdint>
+
+// One delivered (or failed) frame, reported by the transport after the send returns.
+struct BitrateSample {
+    int64_t nowUs = 0;          // send completion time
+    int64_t frameAgeUs = 0;     // capture -> send completion
+    int64_t sendUs = 0;         // time spent in the send call(s)
+    uint32_t frameBytes = 0;
+    uint32_t skippedFrames = 0; // sequence numbers the client never received before this one
+    bool stale = false;         // same frame as the previous send; its age says nothing about the link
+    bool failed = false;        // send error
+};
+
+struct BitrateControllerConfig {
+    int64_t targetAgeUs = 0;        // end-to-end frame age to hold
+    uint32_t ageBandPercent = 0;    // dead band around the target, in percent of it
+    int64_t windowUs = 0;           // decision interval
+    uint32_t minSamples = 0;        // windows with fewer fresh samples make no decision
+    uint32_t recoverWindows = 0;    // consecutive good windows before stepping back up
+    float maxErrorRatio = 0.0f;     // failed / sent above this counts as congestion
+    int worstQuality = 0;           // JPEG quality floor (esp32-camera: higher value = smaller frame)
+    int qualityDegradeStep = 0;
+    int qualityRecoverStep = 0;
+    float minFps = 0.0f;
+    float unpacedFps = 0.0f;        // starting point for rate cuts when the capture target is 0 (sensor rate)
+    float fpsDegradeFactor = 0.0f;  // multiplicative cut, applied once quality is at its floor
+    float fpsRecoverStep = 0.0f;    // additive recovery
+};
+
+// What the controller wants applied. targetFps 0 means unpaced (the configured ceiling).
+struct BitrateDecision {
+    int jpegQuality = 0;
+    float targetFps = 0.0f;
+};
+
+// Measurements of the window that produced the latest decision.
+struct BitrateControllerStats {
+    float meanAgeMs = 0.0f;
+    float meanSendMs = 0.0f;
+    float maxSendMs = 0.0f;
+    float meanFrameBytes = 0.0f;
+    float errorRatio = 0.0f;
+    float skipRatio = 0.0f;     // skipped / (skipped + delivered)
+    uint32_t samples = 0;
+    uint32_t staleSamples = 0;
+    int jpegQuality = 0;
+    float targetFps = 0.0f;
+    bool congested = false;
+};
+
+// Closed-loop stream bitrate control. Transports report every send; once per window the mean
+// end-to-end frame age (and the send error ratio) is compared with the target band. Above it the
+// controller first lowers JPEG quality, then the capture rate; below it for recoverWindows windows
+// in a row it restores the rate first, then quality. Inside the band nothing changes. Pure
+// arithmetic on caller-supplied timestamps, so a recorded trace replays to the same decisions.
+class BitrateController
+{
+public:
+    explicit BitrateController(const BitrateControllerConfig& config);
+
+    // Best allowed operating point, normally the configured camera settings. A change resets the
+    // controller to it. targetFps 0 = sensor rate.
+    void setLimits(int bestQuality, float maxFps);
+
+    void addSample(const BitrateSample& sample);
+
+    // True once windowUs has passed since the window opened; evaluate() only decides then.
+    bool windowElapsed(int64_t nowUs) const;
+
+    // Closes the window if it elapsed. Returns true when the decision differs from the previous one.
+    bool evaluate(int64_t nowUs, BitrateDecision* decision);
+
+    BitrateDecision getDecision() const;
+    BitrateControllerStats getStats() const { return stats_; }
+
+private:
+    void degrade();
+    void recover();
+    float ceilingFps() const;
+    void resetWindow(int64_t nowUs);
+
+    BitrateControllerConfig config_;
+    int bestQuality_ = 0;
+    float maxFps_ = 0.0f;
+    bool hasLimits_ = false;
+
+    int quality_ = 0;
+    float fps_ = 0.0f;
+    uint32_t goodWindows_ = 0;
+    BitrateControllerStats stats_;
+
+    int64_t windowStartUs_ = -1;
+    uint32_t windowSamples_ = 0;    // fresh, successful sends
+    uint32_t windowStale_ = 0;
+    uint32_t windowFailed_ = 0;
+    uint32_t windowSkipped_ = 0;
+    int64_t windowAgeSumUs_ = 0;
+    int64_t windowSendSumUs_ = 0;
+    int64_t windowSendMaxUs_ = 0;
+    uint64_t windowBytes_ = 0;
+};
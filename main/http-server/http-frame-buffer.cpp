@@ -1,33 +1,24 @@
-
 #include "http-server/http-frame-buffer.h"
 #include "app-globals.h"
 #include "define.h"
 #include "debug.h"
 #include <stdint.h>
 #include <cstring>
+#include <utility>
 
-HttpFrameBuffer::HttpFrameBuffer(size_t publishedFrameMaxBytes) : 
-    publishedFrameMaxBytes_(publishedFrameMaxBytes) 
+HttpFrameBuffer::HttpFrameBuffer(FramePool* framePool) : 
+    framePool_(framePool) 
 {
 }
 
-bool HttpFrameBuffer::initPublishedHttpFrameStore(size_t publishedFrameMaxBytes, uint32_t mallocCapSpiram)
+bool HttpFrameBuffer::initPublishedHttpFrameStore()
 {
-    if (buffers[0]){
-        delete[] buffers[0];
-        buffers[0] = nullptr;
-    }
-    if (buffers[1]){
-        delete[] buffers[1];
-        buffers[1] = nullptr;
-    }
-    buffers[0] = (uint8_t*)heap_caps_malloc(publishedFrameMaxBytes, mallocCapSpiram);
-    buffers[1] = (uint8_t*)heap_caps_malloc(publishedFrameMaxBytes, mallocCapSpiram);
-    if (!buffers[0] || !buffers[1]) {
-        ESP_LOGE(MAIN_TAG, "Failed to allocate published HTTP frame buffers");
+    if (!framePool_) {
+        ESP_LOGE(MAIN_TAG, "Published HTTP frame store has no frame pool");
         return false;
     }
 
+    activeHttpFrameHandle.reset();
     activeHttpFrameLength = 0;
     activeHttpFrameWidth = TF_IMAGE_INPUT_SIZE; // TODO inizializzare anche questi?
     activeHttpFrameHeight = TF_IMAGE_INPUT_SIZE;
@@ -44,36 +35,52 @@ void HttpFrameBuffer::publishHttpFrame(const uint8_t* src,
                                         pixformat_t format,
                                         int64_t publishUs)
 {
-    if (!src || srcLen == 0) {
+    if (!src || srcLen == 0 || !framePool_) {
         return;
     }
 
-    size_t frameLen = srcLen;
-    if (frameLen > publishedFrameMaxBytes_) {
-        ESP_LOGW(HTTP_TAG,
-                 "Published frame too large (%u > %u), truncating",
-                 (unsigned int)frameLen,
-                 (unsigned int)publishedFrameMaxBytes_);
-        frameLen = publishedFrameMaxBytes_;
+    // Oversized payloads are rejected or truncated by the pool policy.
+    FrameHandle frame = framePool_->copyFrom(src, srcLen);
+    if (!frame.isValid()) {
+        ESP_LOGW(HTTP_TAG, "No frame pool block for %u bytes, HTTP frame not published", (unsigned int)srcLen);
+        return;
     }
+    ESP_LOGD(HTTP_TAG, "Publish HTTP frame");
+    storeActiveHttpFrame(frame, width, height, format, publishUs);
+}
 
-    uint8_t publishIndex = activeHttpFrameIndex ^ 1;
-    if (!buffers[publishIndex]) {
+void HttpFrameBuffer::publishHttpFrame(const FrameSnapshot& frame, int64_t publishUs)
+{
+    if (!frame.handle.isValid() || frame.len == 0) {
+        return;
+    }
+    if (frame.len == frame.handle.len()) {
+        storeActiveHttpFrame(frame.handle, frame.width, frame.height, frame.format, publishUs);
         return;
     }
+    // Caller narrowed the payload (e.g. raw grayscale without padding): publish only that prefix.
+    publishHttpFrame(frame.data, frame.len, frame.width, frame.height, frame.format, publishUs);
+}
 
-    memcpy(buffers[publishIndex], src, frameLen);
-    ESP_LOGD(HTTP_TAG, "Publish HTTP frame");
-    
+void HttpFrameBuffer::storeActiveHttpFrame(const FrameHandle& frame,
+                                            uint16_t width,
+                                            uint16_t height,
+                                            pixformat_t format,
+                                            int64_t publishUs)
+{
+    // The displaced reference may hand a buffer back to its owner: drop it outside the lock.
+    FrameHandle displaced;
     taskENTER_CRITICAL(&httpFrameMetaLock);
-    activeHttpFrameLength = frameLen;
+    displaced = std::move(activeHttpFrameHandle);
+    activeHttpFrameHandle = frame;
+    activeHttpFrameLength = frame.len();
     activeHttpFrameWidth = width;
     activeHttpFrameHeight = height;
     activeHttpFrameFormat = format;
-    activeHttpFrameIndex = publishIndex;
     activeHttpFrameSeq++;
     activeHttpFramePublishUs = publishUs;
     taskEXIT_CRITICAL(&httpFrameMetaLock);
+    displaced.reset();
 
     ESP_LOGD(HTTP_TAG, "Published HTTP frame metadata updated: seq=%lu, len=%u, %dx%d, format=%d, publishUs=%lld",
              (unsigned long)activeHttpFrameSeq,
@@ -91,24 +98,35 @@ void HttpFrameBuffer::publishHttpFrame(const uint8_t* src,
     #endif
 }
 
-bool HttpFrameBuffer::isBuffersInitialized(uint8_t index) const
+void HttpFrameBuffer::clearActiveHttpFrame()
 {
-    return index < FRAME_BUFFERS && buffers[index] != nullptr;
+    FrameHandle displaced;
+    taskENTER_CRITICAL(&httpFrameMetaLock);
+    displaced = std::move(activeHttpFrameHandle);
+    activeHttpFrameLength = 0;
+    taskEXIT_CRITICAL(&httpFrameMetaLock);
+    displaced.reset();
 }
 
-uint8_t* HttpFrameBuffer::getMutableBuffer(uint8_t index)
+bool HttpFrameBuffer::acquireActiveHttpFrame(FrameSnapshot* frame)
 {
-    return (index < FRAME_BUFFERS) ? buffers[index] : nullptr;
-}
+    if (!frame) {
+        return false;
+    }
 
-const uint8_t* HttpFrameBuffer::getBuffer(uint8_t index) const
-{
-    return (index < FRAME_BUFFERS) ? buffers[index] : nullptr;
-}
+    frame->handle.reset();
+    taskENTER_CRITICAL(&httpFrameMetaLock);
+    frame->handle = activeHttpFrameHandle;
+    frame->len = activeHttpFrameLength;
+    frame->width = activeHttpFrameWidth;
+    frame->height = activeHttpFrameHeight;
+    frame->format = activeHttpFrameFormat;
+    frame->seq = activeHttpFrameSeq;
+    frame->captureUs = activeHttpFramePublishUs;
+    taskEXIT_CRITICAL(&httpFrameMetaLock);
 
-uint8_t HttpFrameBuffer::getActiveHttpFrameIndex() const 
-{ 
-    return activeHttpFrameIndex; 
+    frame->data = frame->handle.data();
+    return frame->data != nullptr && frame->len > 0;
 }
 
 size_t HttpFrameBuffer::getActiveHttpFrameLength() const 
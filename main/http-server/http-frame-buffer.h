@@ -1,19 +1,23 @@
 #pragma once
 
 #include "define.h"
+#include "data-types/frame-snapshot.h"
+#include "data-types/frame-handle.h"
+#include "data-types/frame-pool.h"
 #include <stdint.h>
 #include <sensor.h>
 #include <cstddef>
 
-#define FRAME_BUFFERS 2
-
+// Frame currently served over HTTP/UDP. Every payload is held through a FrameHandle (a lent camera
+// buffer or a frame pool block), so a reader can never see it overwritten by the next publish.
 class HttpFrameBuffer 
 {
 public:
-    HttpFrameBuffer(size_t publishedFrameMaxBytes);
+    explicit HttpFrameBuffer(FramePool* framePool);
 
-    bool initPublishedHttpFrameStore(size_t publishedFrameMaxBytes, uint32_t mallocCapSpiram); //MALLOC_CAP_SPIRAM
+    bool initPublishedHttpFrameStore();
 
+    // Copies src into a frame pool block sized to srcLen.
     void publishHttpFrame(const uint8_t* src,
                             size_t srcLen,
                             uint16_t width,
@@ -21,10 +25,16 @@ public:
                             pixformat_t format,
                             int64_t publishUs);
 
-    bool isBuffersInitialized(uint8_t index) const;
-    uint8_t* getMutableBuffer(uint8_t index);
-    const uint8_t* getBuffer(uint8_t index) const;
-    uint8_t getActiveHttpFrameIndex() const;
+    // Zero-copy publish: keeps a reference to the lent frame instead of copying its payload.
+    void publishHttpFrame(const FrameSnapshot& frame, int64_t publishUs);
+
+    // Fills frame with the active HTTP frame (captureUs carries the publish time).
+    // frame->handle pins the payload until the caller resets it.
+    bool acquireActiveHttpFrame(FrameSnapshot* frame);
+
+    // Drops the active frame (e.g. before a camera reconfiguration); readers see no frame until the next publish.
+    void clearActiveHttpFrame();
+
     size_t getActiveHttpFrameLength() const;
     uint16_t getActiveHttpFrameWidth() const;
     uint16_t getActiveHttpFrameHeight() const;
@@ -33,17 +43,20 @@ public:
     int64_t getActiveHttpFramePublishUs() const;
 
 private:
-    uint8_t* buffers[FRAME_BUFFERS] = {nullptr, nullptr};
-    volatile uint8_t activeHttpFrameIndex = 0;
+    void storeActiveHttpFrame(const FrameHandle& frame,
+                                uint16_t width,
+                                uint16_t height,
+                                pixformat_t format,
+                                int64_t publishUs);
+
+    FramePool* framePool_ = nullptr;
+    FrameHandle activeHttpFrameHandle;
     volatile size_t activeHttpFrameLength = 0;
     volatile uint16_t activeHttpFrameWidth = 0; //TF_IMAGE_INPUT_SIZE;
     volatile uint16_t activeHttpFrameHeight = 0; //TF_IMAGE_INPUT_SIZE;
     volatile pixformat_t activeHttpFrameFormat = PIXFORMAT_GRAYSCALE; //?
     volatile uint32_t activeHttpFrameSeq = 0;
     volatile int64_t activeHttpFramePublishUs = 0;
-    size_t publishedFrameMaxBytes_ = 0;
-
 };
 
 extern HttpFrameBuffer httpFrameBuffer;        
-
@@ -9,6 +9,12 @@
 #include <arpa/inet.h>   // For inet_ntoa, inet_aton
 #include "image-editing/editing.h"
 #include "http-server/udp-fram-header.h"
+#include "clip-recorder/pre-event-ring.h"
+#include "camera-driver/camera-driver.h"
+#include "http-server/bitrate-controller.h"
+#include "frame-source/injected-frame-store.h"
+#include "tf-lite/tf-lite.h"
+#include "model-store/model-store.h"
 #include <sys/socket.h>
 
 ////https://github.com/espressif/arduino-esp32/blob/master/libraries/ESP32/examples/Camera/CameraWebServer/app_httpd.cpp
@@ -137,10 +143,72 @@ Bypassing the intermediate mailbox and snapshot layers eliminates the CPU memory
 
 CameraHttpServer::CaptureCallback CameraHttpServer::s_captureCallback = nullptr;
 CameraHttpServer::StreamCallback CameraHttpServer::s_streamCallback = nullptr;
+CameraDriver* CameraHttpServer::s_cameraDriver = nullptr;
+TfLiteWrapper* CameraHttpServer::s_inference = nullptr;
+ModelStore* CameraHttpServer::s_modelStore = nullptr;
 
 CameraHttpServer::CameraHttpServer() = default;
 CameraHttpServer::~CameraHttpServer() { stop(); }
 
+#pragma region STREAM_BITRATE_CONTROL
+#if ENABLE_STREAM_BITRATE_CONTROL
+static BitrateControllerConfig makeBitrateConfig()
+{
+    BitrateControllerConfig bitrateConfig;
+    bitrateConfig.targetAgeUs = (int64_t)STREAM_TARGET_FRAME_AGE_MS * 1000;
+    bitrateConfig.ageBandPercent = STREAM_FRAME_AGE_BAND_PERCENT;
+    bitrateConfig.windowUs = 1000000;
+    bitrateConfig.minSamples = 3;
+    bitrateConfig.recoverWindows = 2;
+    bitrateConfig.maxErrorRatio = 0.1f;
+    bitrateConfig.worstQuality = STREAM_WORST_JPEG_QUALITY;
+    bitrateConfig.qualityDegradeStep = 5;
+    bitrateConfig.qualityRecoverStep = 2;
+    bitrateConfig.minFps = STREAM_MIN_FPS;
+    bitrateConfig.unpacedFps = 25.0f;
+    bitrateConfig.fpsDegradeFactor = 0.75f;
+    bitrateConfig.fpsRecoverStep = 2.0f;
+    return bitrateConfig;
+}
+
+// Only one transport streams at a time (USE_TCP / USE_UDP), so a single controller serves both.
+static BitrateController streamBitrateController(makeBitrateConfig());
+
+// Feeds one send into the bitrate controller; once per window re-reads the configured ceiling and
+// applies the controller's quality/FPS to the camera.
+static void reportStreamSend(const BitrateSample& sample, CameraDriver* camera)
+{
+    streamBitrateController.addSample(sample);
+    if (!camera || !streamBitrateController.windowElapsed(sample.nowUs)) {
+        return;
+    }
+    const CameraSettings settings = camera->getSettings();
+    streamBitrateController.setLimits(settings.jpegQuality, settings.targetFps);
+
+    BitrateDecision decision;
+    const bool changed = streamBitrateController.evaluate(sample.nowUs, &decision);
+    // Applied every window so a budget skipped during a reconfiguration is not lost.
+    camera->applyStreamBudget(decision.jpegQuality, decision.targetFps);
+    if (changed) {
+        const BitrateControllerStats stats = streamBitrateController.getStats();
+        ESP_LOGW("STREAM_RATE",
+                 "%s: quality=%d fps=%.1f | age=%.1f ms (target %d) send avg=%.1f max=%.1f ms | len=%.0f | err=%.2f skip=%.2f | n=%lu stale=%lu",
+                 stats.congested ? "congested" : "recovering",
+                 decision.jpegQuality,
+                 decision.targetFps,
+                 stats.meanAgeMs,
+                 STREAM_TARGET_FRAME_AGE_MS,
+                 stats.meanSendMs,
+                 stats.maxSendMs,
+                 stats.meanFrameBytes,
+                 stats.errorRatio,
+                 stats.skipRatio,
+                 (unsigned long)stats.samples,
+                 (unsigned long)stats.staleSamples);
+    }
+}
+#endif
+
 
 #pragma region HTTP_CAPTURE_CALLBACK
 // HTTP handler, returns the latest captured frame payload, uses httpd_resp_send (HTTP over TCP)
@@ -177,24 +245,16 @@ esp_err_t CameraHttpServer::captureRgbTcpCallback(httpd_req_t *req, HttpFrameBuf
 
     httpd_resp_set_type(req, "application/octet-stream");
 
-    size_t frameLength = 0;
-    uint8_t frameIndex = 0;
-    uint16_t frameWidth = 0; //TF_IMAGE_INPUT_SIZE;
-    uint16_t frameHeight = 0; // TF_IMAGE_INPUT_SIZE
-    pixformat_t frameFormat; // = PIXFORMAT_GRAYSCALE; 
-    uint32_t frameSeq = 0;
-    int64_t framePublishUs = 0;
-
     ESP_LOGD(HTTP_TAG, "Capture request received, seq=%lu", (unsigned long)httpReqWindowLastSeq + 1);
-    taskENTER_CRITICAL(frameMetaLock);
-    frameLength = frameBuffer->getActiveHttpFrameLength();
-    frameIndex = frameBuffer->getActiveHttpFrameIndex();
-    frameWidth = frameBuffer->getActiveHttpFrameWidth();
-    frameHeight = frameBuffer->getActiveHttpFrameHeight();
-    frameFormat = frameBuffer->getActiveHttpFrameFormat();
-    frameSeq = frameBuffer->getActiveHttpFrameSeq();
-    framePublishUs = frameBuffer->getActiveHttpFramePublishUs();
-    taskEXIT_CRITICAL(frameMetaLock);
+    // The acquired frame holds a reference on lent payloads until this handler returns.
+    FrameSnapshot frame = {};
+    const bool hasFrame = frameBuffer->acquireActiveHttpFrame(&frame);
+    const size_t frameLength = frame.len;
+    const uint16_t frameWidth = frame.width;
+    const uint16_t frameHeight = frame.height;
+    const pixformat_t frameFormat = frame.format;
+    const uint32_t frameSeq = frame.seq;
+    const int64_t framePublishUs = frame.captureUs;
     ESP_LOGD(HTTP_TAG, "Capture request metadata: seq=%lu, len=%u, %dx%d, format=%d, publishUs=%lld",
              (unsigned long)frameSeq,
              (unsigned int)frameLength,
@@ -239,7 +299,9 @@ esp_err_t CameraHttpServer::captureRgbTcpCallback(httpd_req_t *req, HttpFrameBuf
     }
 
     httpReqWindowCount++;
-    if (frameSeq == httpReqWindowLastSeq && frameSeq != 0) {
+    const bool staleFrame = (frameSeq == httpReqWindowLastSeq && frameSeq != 0);
+    uint32_t skippedFrames = 0;
+    if (staleFrame) {
         httpReqWindowStale++;
     } else if (httpReqWindowLastSeq != 0 && frameSeq > httpReqWindowLastSeq) {
         const uint32_t advancedBy = frameSeq - httpReqWindowLastSeq;
@@ -247,6 +309,7 @@ esp_err_t CameraHttpServer::captureRgbTcpCallback(httpd_req_t *req, HttpFrameBuf
         httpReqWindowAdvancedFrames += advancedBy;
         if (advancedBy > 1) {
             const uint32_t dropped = advancedBy - 1;
+            skippedFrames = dropped;
             httpReqWindowDroppedEstimate += dropped;
             if (dropped > httpReqWindowMaxDroppedBurst) {
                 httpReqWindowMaxDroppedBurst = dropped;
@@ -260,13 +323,13 @@ esp_err_t CameraHttpServer::captureRgbTcpCallback(httpd_req_t *req, HttpFrameBuf
 
     const uint8_t *sendPtr = nullptr;
     size_t sendLength = frameLength;
-    if (frameLength > 0 && frameBuffer->isBuffersInitialized(frameIndex)) {
-        sendPtr = frameBuffer->getBuffer(frameIndex);
+    if (hasFrame) {
+        sendPtr = frame.data;
     } else {
-        // Send a blank frame until the first capture is published.
-        static uint8_t blank[kPublishedFrameMaxBytes] = {0};
+        // Send an empty body until the first capture is published; the viewer discards short frames.
+        static const uint8_t blank[1] = {0};
         sendPtr = blank;
-        sendLength = sizeof(blank);
+        sendLength = 0;
     }
 
     const int64_t sendStartUs = esp_timer_get_time();
@@ -275,6 +338,20 @@ esp_err_t CameraHttpServer::captureRgbTcpCallback(httpd_req_t *req, HttpFrameBuf
     const int64_t sendUs = (sendEndUs > sendStartUs) ? (sendEndUs - sendStartUs) : 0;
     const int64_t reqTotalUs = (sendEndUs > reqStartUs) ? (sendEndUs - reqStartUs) : 0;
 
+    #if ENABLE_STREAM_BITRATE_CONTROL
+        if (hasFrame) {
+            BitrateSample sample;
+            sample.nowUs = sendEndUs;
+            sample.frameAgeUs = (framePublishUs > 0 && sendEndUs > framePublishUs) ? (sendEndUs - framePublishUs) : 0;
+            sample.sendUs = sendUs;
+            sample.frameBytes = (uint32_t)sendLength;
+            sample.skippedFrames = skippedFrames;
+            sample.stale = staleFrame;
+            sample.failed = (sendErr != ESP_OK);
+            reportStreamSend(sample, s_cameraDriver);
+        }
+    #endif
+
     static uint32_t txWindowCount = 0;
     static uint32_t txWindowErrCount = 0;
     static int64_t txWindowStartUs = 0;
@@ -433,9 +510,6 @@ esp_err_t CameraHttpServer::streamRgbTcpCallback(httpd_req_t *req, HttpFrameBuff
 
     // 2. Stream loop
     while (true) {
-        size_t frameLength = 0;
-        uint8_t frameIndex = 0;
-        pixformat_t frameFormat; 
         uint32_t frameSeq = 0;
 
         // Check if a new frame is ready
@@ -448,19 +522,15 @@ esp_err_t CameraHttpServer::streamRgbTcpCallback(httpd_req_t *req, HttpFrameBuff
             continue;
         }
 
-        // Extract metadata safely from the active double buffer
-        taskENTER_CRITICAL(frameMetaLock);
-        frameLength = frameBuffer->getActiveHttpFrameLength();
-        frameIndex = frameBuffer->getActiveHttpFrameIndex();
-        frameFormat = frameBuffer->getActiveHttpFrameFormat();
-        taskEXIT_CRITICAL(frameMetaLock);
-
-        // Read directly from the active buffer
-        const uint8_t *sendPtr = frameBuffer->getBuffer(frameIndex);
-        if (!sendPtr || frameLength == 0) {
+        // Acquire the active frame; a lent payload stays pinned until the part has been sent
+        FrameSnapshot frame = {};
+        if (!frameBuffer->acquireActiveHttpFrame(&frame)) {
             vTaskDelay(1);
             continue;
         }
+        frameSeq = frame.seq;
+        const size_t frameLength = frame.len;
+        const uint8_t *sendPtr = frame.data;
 
         // STEP A: Send the frame separator and boundary string together as a single atomic chunk
         res = httpd_resp_send_chunk(req, "\r\n--" STREAM_BOUNDARY "\r\n", 34);
@@ -632,6 +702,566 @@ esp_err_t CameraHttpServer::streamRgbTcpCallback(httpd_req_t *req, HttpFrameBuff
     return res;
 }*/
 
+#pragma region CLIP_AVI_CALLBACK
+// Sink for PreEventRing::exportAvi, forwards the AVI byte stream as HTTP chunks.
+static bool sendClipChunk(void* sinkCtx, const uint8_t* data, size_t len)
+{
+    httpd_req_t* req = static_cast<httpd_req_t*>(sinkCtx);
+    return httpd_resp_send_chunk(req, (const char*)data, len) == ESP_OK;
+}
+
+// HTTP handler, downloads the frozen pre-event clip as an MJPEG AVI.
+// /clip.avi?release=1 resumes recording after the download, ?drop=1 discards the clip,
+// ?trigger=1 freezes the ring by hand (useful with ENABLE_INFERENCE=0).
+esp_err_t CameraHttpServer::clipAviCallback(httpd_req_t *req)
+{
+    bool releaseAfter = false;
+    char query[64] = {0};
+    const size_t queryLen = httpd_req_get_url_query_len(req);
+    if (queryLen > 0 && queryLen < sizeof(query) &&
+        httpd_req_get_url_query_str(req, query, sizeof(query)) == ESP_OK) {
+        char value[8] = {0};
+        if (httpd_query_key_value(query, "trigger", value, sizeof(value)) == ESP_OK && strcmp(value, "1") == 0) {
+            const bool requested = preEventRing.requestFreeze();
+            httpd_resp_set_status(req, requested ? "202 Accepted" : "409 Conflict");
+            return httpd_resp_send(req, requested ? "Freeze requested" : "Clip already held", HTTPD_RESP_USE_STRLEN);
+        }
+        if (httpd_query_key_value(query, "drop", value, sizeof(value)) == ESP_OK && strcmp(value, "1") == 0) {
+            const bool dropped = preEventRing.releaseClip();
+            return httpd_resp_send(req, dropped ? "Clip dropped" : "No clip", HTTPD_RESP_USE_STRLEN);
+        }
+        releaseAfter = (httpd_query_key_value(query, "release", value, sizeof(value)) == ESP_OK && strcmp(value, "1") == 0);
+    }
+
+    if (!preEventRing.hasClip()) {
+        httpd_resp_send_err(req, HTTPD_404_NOT_FOUND, "No clip recorded");
+        return ESP_OK;
+    }
+
+    httpd_resp_set_type(req, "video/x-msvideo");
+    httpd_resp_set_hdr(req, "Content-Disposition", "attachment; filename=\"clip.avi\"");
+    httpd_resp_set_hdr(req, "Cache-Control", "no-store");
+
+    const int64_t exportStartUs = esp_timer_get_time();
+    if (!preEventRing.exportAvi(sendClipChunk, req, releaseAfter)) {
+        // Either the clip vanished between the check and the export or the client went away.
+        ESP_LOGW(HTTP_TAG, "Clip export aborted");
+        httpd_resp_send_chunk(req, nullptr, 0);
+        return ESP_FAIL;
+    }
+    ESP_LOGI(HTTP_TAG, "Clip exported in %lld ms", (long long)((esp_timer_get_time() - exportStartUs) / 1000));
+    return httpd_resp_send_chunk(req, nullptr, 0);
+}
+
+#pragma region CAMERA_CONFIG_CALLBACK
+struct FrameSizeName {
+    const char* name;
+    framesize_t frameSize;
+};
+
+// Frame sizes accepted by /camera/config, up to CAMERA_RECONFIG_MAX_FRAMESIZE.
+static constexpr FrameSizeName kFrameSizeNames[] = {
+    {"96x96", FRAMESIZE_96X96},
+    {"qqvga", FRAMESIZE_QQVGA},
+    {"128x128", FRAMESIZE_128X128},
+    {"qcif", FRAMESIZE_QCIF},
+    {"hqvga", FRAMESIZE_HQVGA},
+    {"240x240", FRAMESIZE_240X240},
+    {"qvga", FRAMESIZE_QVGA},
+    {"320x320", FRAMESIZE_320X320},
+    {"cif", FRAMESIZE_CIF},
+    {"hvga", FRAMESIZE_HVGA},
+    {"vga", FRAMESIZE_VGA},
+};
+
+static bool parseFrameSize(const char* value, framesize_t* frameSize)
+{
+    for (const FrameSizeName& entry : kFrameSizeNames) {
+        if (strcasecmp(value, entry.name) == 0) {
+            *frameSize = entry.frameSize;
+            return true;
+        }
+    }
+    char* end = nullptr;
+    const long number = strtol(value, &end, 10);
+    if (end == value || *end != '\0' || number < 0 || number >= FRAMESIZE_INVALID) {
+        return false;
+    }
+    *frameSize = (framesize_t)number;
+    return true;
+}
+
+static const char* frameSizeName(framesize_t frameSize)
+{
+    for (const FrameSizeName& entry : kFrameSizeNames) {
+        if (entry.frameSize == frameSize) {
+            return entry.name;
+        }
+    }
+    return "other";
+}
+
+static bool parsePixelFormat(const char* value, pixformat_t* pixelFormat)
+{
+    if (strcasecmp(value, "jpeg") == 0) {
+        *pixelFormat = PIXFORMAT_JPEG;
+    } else if (strcasecmp(value, "gray") == 0 || strcasecmp(value, "grayscale") == 0) {
+        *pixelFormat = PIXFORMAT_GRAYSCALE;
+    } else if (strcasecmp(value, "rgb565") == 0) {
+        *pixelFormat = PIXFORMAT_RGB565;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+static const char* pixelFormatName(pixformat_t pixelFormat)
+{
+    switch (pixelFormat) {
+        case PIXFORMAT_JPEG: return "jpeg";
+        case PIXFORMAT_GRAYSCALE: return "gray";
+        case PIXFORMAT_RGB565: return "rgb565";
+        default: return "other";
+    }
+}
+
+static const char* switchPathName(CameraSwitchPath path)
+{
+    switch (path) {
+        case CameraSwitchPath::Sensor: return "sensor";
+        case CameraSwitchPath::Reinit: return "reinit";
+        default: return "none";
+    }
+}
+
+static int formatCameraSettings(char* out, size_t outLen, const CameraSettings& settings)
+{
+    return snprintf(out, outLen,
+                    "\"framesize\":\"%s\",\"width\":%u,\"height\":%u,\"format\":\"%s\","
+                    "\"quality\":%d,\"xclk\":%d,\"fb\":%d,\"fps\":%.1f",
+                    frameSizeName(settings.frameSize),
+                    (unsigned int)resolution[settings.frameSize].width,
+                    (unsigned int)resolution[settings.frameSize].height,
+                    pixelFormatName(settings.pixelFormat),
+                    settings.jpegQuality,
+                    settings.xclkFreqHz,
+                    settings.fbCount,
+                    settings.targetFps);
+}
+
+// HTTP handler, reads or changes the camera configuration at runtime.
+// /camera/config returns the current settings; any of framesize=(qvga|vga|96x96|...|<index>),
+// format=(jpeg|gray|rgb565), quality=4-63, xclk=<Hz>, fb=<count>, fps=<target> applies a change and
+// returns the switch path and per-phase timings. Fields that are not given keep their current value.
+esp_err_t CameraHttpServer::cameraConfigCallback(httpd_req_t *req)
+{
+    if (!s_cameraDriver) {
+        httpd_resp_set_status(req, "503 Service Unavailable");
+        return httpd_resp_send(req, "Camera not available", HTTPD_RESP_USE_STRLEN);
+    }
+
+    CameraSettings requested = s_cameraDriver->getSettings();
+    bool changeRequested = false;
+    char query[128] = {0};
+    const size_t queryLen = httpd_req_get_url_query_len(req);
+    if (queryLen >= sizeof(query)) {
+        httpd_resp_send_err(req, HTTPD_400_BAD_REQUEST, "Query too long");
+        return ESP_OK;
+    }
+    if (queryLen > 0 && httpd_req_get_url_query_str(req, query, sizeof(query)) == ESP_OK) {
+        char value[16] = {0};
+        if (httpd_query_key_value(query, "framesize", value, sizeof(value)) == ESP_OK) {
+            if (!parseFrameSize(value, &requested.frameSize)) {
+                httpd_resp_send_err(req, HTTPD_400_BAD_REQUEST, "Unknown framesize");
+                return ESP_OK;
+            }
+            changeRequested = true;
+        }
+        if (httpd_query_key_value(query, "format", value, sizeof(value)) == ESP_OK) {
+            if (!parsePixelFormat(value, &requested.pixelFormat)) {
+                httpd_resp_send_err(req, HTTPD_400_BAD_REQUEST, "Unknown format");
+                return ESP_OK;
+            }
+            changeRequested = true;
+        }
+        if (httpd_query_key_value(query, "quality", value, sizeof(value)) == ESP_OK) {
+            requested.jpegQuality = atoi(value);
+            changeRequested = true;
+        }
+        if (httpd_query_key_value(query, "xclk", value, sizeof(value)) == ESP_OK) {
+            requested.xclkFreqHz = atoi(value);
+            changeRequested = true;
+        }
+        if (httpd_query_key_value(query, "fb", value, sizeof(value)) == ESP_OK) {
+            requested.fbCount = atoi(value);
+            changeRequested = true;
+        }
+        if (httpd_query_key_value(query, "fps", value, sizeof(value)) == ESP_OK) {
+            requested.targetFps = strtof(value, nullptr);
+            changeRequested = true;
+        }
+    }
+
+    char settingsJson[192];
+    char body[384];
+    httpd_resp_set_type(req, "application/json");
+    httpd_resp_set_hdr(req, "Cache-Control", "no-store");
+
+    if (!changeRequested) {
+        formatCameraSettings(settingsJson, sizeof(settingsJson), requested);
+        snprintf(body, sizeof(body), "{%s}", settingsJson);
+        return httpd_resp_send(req, body, HTTPD_RESP_USE_STRLEN);
+    }
+
+    CameraReconfigureResult result;
+    s_cameraDriver->reconfigure(requested, &result);
+    formatCameraSettings(settingsJson, sizeof(settingsJson), s_cameraDriver->getSettings());
+    snprintf(body, sizeof(body),
+             "{\"ok\":%s,\"message\":\"%s\",\"path\":\"%s\",%s,"
+             "\"quiesce_ms\":%.1f,\"drain_ms\":%.1f,\"apply_ms\":%.1f,\"settle_ms\":%.1f,"
+             "\"total_ms\":%.1f,\"discarded\":%lu}",
+             result.err == ESP_OK ? "true" : "false",
+             result.message,
+             switchPathName(result.path),
+             settingsJson,
+             result.quiesceUs / 1000.0,
+             result.drainUs / 1000.0,
+             result.applyUs / 1000.0,
+             result.settleUs / 1000.0,
+             result.totalUs / 1000.0,
+             (unsigned long)result.discardedFrames);
+    if (result.err == ESP_ERR_INVALID_ARG) {
+        httpd_resp_set_status(req, "400 Bad Request");
+    } else if (result.err != ESP_OK) {
+        httpd_resp_set_status(req, "500 Internal Server Error");
+    }
+    return httpd_resp_send(req, body, HTTPD_RESP_USE_STRLEN);
+}
+
+#pragma region FRAME_INJECTION_CALLBACKS
+// HTTP handler, stores the request body as one injected frame for replay.
+// POST /frames/inject?format=jpeg|gray|rgb565&width=..&height=.. (JPEG frames read their size from the
+// SOF header), ?clear=1 drops the stored frames first. Refused while the injected frames are replaying.
+esp_err_t CameraHttpServer::frameInjectCallback(httpd_req_t *req)
+{
+    pixformat_t format = PIXFORMAT_JPEG;
+    uint16_t width = 0;
+    uint16_t height = 0;
+    char query[96] = {0};
+    const size_t queryLen = httpd_req_get_url_query_len(req);
+    if (queryLen > 0 && queryLen < sizeof(query) &&
+        httpd_req_get_url_query_str(req, query, sizeof(query)) == ESP_OK) {
+        char value[16] = {0};
+        if (httpd_query_key_value(query, "format", value, sizeof(value)) == ESP_OK &&
+            !parsePixelFormat(value, &format)) {
+            httpd_resp_send_err(req, HTTPD_400_BAD_REQUEST, "Unknown format");
+            return ESP_OK;
+        }
+        if (httpd_query_key_value(query, "width", value, sizeof(value)) == ESP_OK) {
+            width = (uint16_t)atoi(value);
+        }
+        if (httpd_query_key_value(query, "height", value, sizeof(value)) == ESP_OK) {
+            height = (uint16_t)atoi(value);
+        }
+        if (httpd_query_key_value(query, "clear", value, sizeof(value)) == ESP_OK && strcmp(value, "1") == 0 &&
+            !injectedFrameStore.clear()) {
+            httpd_resp_set_status(req, "409 Conflict");
+            return httpd_resp_send(req, "Injected frames are replaying", HTTPD_RESP_USE_STRLEN);
+        }
+    }
+
+    const size_t frameLen = req->content_len;
+    if (frameLen == 0) {
+        httpd_resp_send_err(req, HTTPD_400_BAD_REQUEST, "Empty frame");
+        return ESP_OK;
+    }
+    uint8_t* dst = injectedFrameStore.reserve(frameLen);
+    if (!dst) {
+        httpd_resp_set_status(req, "409 Conflict");
+        return httpd_resp_send(req, "Store full or replaying", HTTPD_RESP_USE_STRLEN);
+    }
+
+    size_t received = 0;
+    while (received < frameLen) {
+        const int got = httpd_req_recv(req, (char*)dst + received, frameLen - received);
+        if (got == HTTPD_SOCK_ERR_TIMEOUT) {
+            continue;
+        }
+        if (got <= 0) {
+            // Nothing was committed; the reservation is reused by the next upload.
+            return ESP_FAIL;
+        }
+        received += (size_t)got;
+    }
+
+    if (format == PIXFORMAT_JPEG) {
+        if (!readJpegDimensions(dst, frameLen, &width, &height)) {
+            httpd_resp_send_err(req, HTTPD_400_BAD_REQUEST, "No JPEG SOF header");
+            return ESP_OK;
+        }
+    } else {
+        const size_t bytesPerPixel = (format == PIXFORMAT_GRAYSCALE) ? 1 : 2;
+        if (width == 0 || height == 0 || (size_t)width * height * bytesPerPixel != frameLen) {
+            httpd_resp_send_err(req, HTTPD_400_BAD_REQUEST, "Raw frame needs width/height matching its length");
+            return ESP_OK;
+        }
+    }
+    injectedFrameStore.commit(width, height, format);
+
+    char body[128];
+    snprintf(body, sizeof(body), "{\"frames\":%u,\"width\":%u,\"height\":%u,\"used\":%u,\"capacity\":%u}",
+             (unsigned int)injectedFrameStore.getFrameCount(),
+             (unsigned int)width,
+             (unsigned int)height,
+             (unsigned int)injectedFrameStore.getUsedBytes(),
+             (unsigned int)injectedFrameStore.getCapacityBytes());
+    httpd_resp_set_type(req, "application/json");
+    return httpd_resp_send(req, body, HTTPD_RESP_USE_STRLEN);
+}
+
+// HTTP handler, reads or switches the capture frame source.
+// /frames/source?use=camera|injected; without a query it reports the active source and replay progress.
+esp_err_t CameraHttpServer::frameSourceCallback(httpd_req_t *req)
+{
+    if (!s_cameraDriver) {
+        httpd_resp_set_status(req, "503 Service Unavailable");
+        return httpd_resp_send(req, "Camera not available", HTTPD_RESP_USE_STRLEN);
+    }
+
+    esp_err_t err = ESP_OK;
+    char query[32] = {0};
+    const size_t queryLen = httpd_req_get_url_query_len(req);
+    if (queryLen > 0 && queryLen < sizeof(query) &&
+        httpd_req_get_url_query_str(req, query, sizeof(query)) == ESP_OK) {
+        char value[16] = {0};
+        if (httpd_query_key_value(query, "use", value, sizeof(value)) == ESP_OK) {
+            if (strcmp(value, "camera") == 0) {
+                err = s_cameraDriver->setFrameSource(nullptr);
+            } else if (strcmp(value, "injected") == 0) {
+                if (injectedFrameStore.getFrameCount() == 0) {
+                    httpd_resp_send_err(req, HTTPD_400_BAD_REQUEST, "No injected frames");
+                    return ESP_OK;
+                }
+                err = s_cameraDriver->setFrameSource(injectedFrameStore.getSource());
+            } else {
+                httpd_resp_send_err(req, HTTPD_400_BAD_REQUEST, "Unknown source");
+                return ESP_OK;
+            }
+        }
+    }
+
+    const ReplayFrameSource* replay = injectedFrameStore.getSource();
+    char body[160];
+    snprintf(body, sizeof(body),
+             "{\"ok\":%s,\"source\":\"%s\",\"injected_frames\":%u,\"delivered\":%lu,\"loops\":%lu}",
+             err == ESP_OK ? "true" : "false",
+             s_cameraDriver->getFrameSourceName(),
+             (unsigned int)injectedFrameStore.getFrameCount(),
+             (unsigned long)replay->getDelivered(),
+             (unsigned long)replay->getLoops());
+    if (err != ESP_OK) {
+        httpd_resp_set_status(req, "409 Conflict");
+    }
+    httpd_resp_set_type(req, "application/json");
+    httpd_resp_set_hdr(req, "Cache-Control", "no-store");
+    return httpd_resp_send(req, body, HTTPD_RESP_USE_STRLEN);
+}
+
+// HTTP handler, per-operator inference timings as JSON: totals per op type (heaviest first) and per
+// graph node with its MACs per microsecond, which shows whether the esp-nn kernels carry the convolutions.
+// /inference/profile?reset=1 clears the totals after reading.
+esp_err_t CameraHttpServer::inferenceProfileCallback(httpd_req_t *req)
+{
+    if (!s_inference) {
+        httpd_resp_set_status(req, "503 Service Unavailable");
+        return httpd_resp_send(req, "Inference not available", HTTPD_RESP_USE_STRLEN);
+    }
+
+    bool reset = false;
+    char query[32] = {0};
+    const size_t queryLen = httpd_req_get_url_query_len(req);
+    if (queryLen > 0 && queryLen < sizeof(query) &&
+        httpd_req_get_url_query_str(req, query, sizeof(query)) == ESP_OK) {
+        char value[8] = {0};
+        reset = httpd_query_key_value(query, "reset", value, sizeof(value)) == ESP_OK && strcmp(value, "1") == 0;
+    }
+
+    // Handlers run one at a time on the httpd task; static keeps the snapshot off its stack.
+    static OpProfile profile;
+    static OpProfileTag tags[kOpProfilerMaxNodes];
+    s_inference->getOpProfile(&profile, reset);
+    const size_t tagCount = OpProfiler::summarizeByTag(profile, tags, kOpProfilerMaxNodes);
+    int64_t totalUs = 0;
+    for (size_t i = 0; i < tagCount; i++) {
+        totalUs += tags[i].totalUs;
+    }
+
+    httpd_resp_set_type(req, "application/json");
+    httpd_resp_set_hdr(req, "Cache-Control", "no-store");
+    char line[224];
+    snprintf(line, sizeof(line),
+             "{\"arena\":\"%s\",\"invocations\":%lu,\"dropped_events\":%lu,\"mean_invoke_us\":%lld,\"by_tag\":[",
+             s_inference->arenaPlacement(),
+             (unsigned long)profile.invocations,
+             (unsigned long)profile.droppedEvents,
+             profile.invocations ? (long long)(totalUs / profile.invocations) : 0LL);
+    esp_err_t res = httpd_resp_send_chunk(req, line, HTTPD_RESP_USE_STRLEN);
+
+    for (size_t i = 0; i < tagCount && res == ESP_OK; i++) {
+        const OpProfileTag& tag = tags[i];
+        snprintf(line, sizeof(line),
+                 "%s{\"tag\":\"%s\",\"count\":%lu,\"total_us\":%lld,\"max_us\":%ld,\"share\":%.3f}",
+                 i ? "," : "",
+                 tag.tag,
+                 (unsigned long)tag.count,
+                 (long long)tag.totalUs,
+                 (long)tag.maxUs,
+                 totalUs ? (double)tag.totalUs / (double)totalUs : 0.0);
+        res = httpd_resp_send_chunk(req, line, HTTPD_RESP_USE_STRLEN);
+    }
+    if (res == ESP_OK) {
+        res = httpd_resp_send_chunk(req, "],\"ops\":[", HTTPD_RESP_USE_STRLEN);
+    }
+
+    for (size_t i = 0; i < profile.nodeCount && res == ESP_OK; i++) {
+        const OpProfileNode& node = profile.nodes[i];
+        const int64_t meanUs = node.count ? node.totalUs / node.count : 0;
+        snprintf(line, sizeof(line),
+                 "%s{\"index\":%u,\"tag\":\"%s\",\"count\":%lu,\"mean_us\":%lld,\"max_us\":%ld,\"total_us\":%lld,\"macs\":%lu,\"macs_per_us\":%.1f}",
+                 i ? "," : "",
+                 (unsigned int)i,
+                 node.tag ? node.tag : "",
+                 (unsigned long)node.count,
+                 (long long)meanUs,
+                 (long)node.maxUs,
+                 (long long)node.totalUs,
+                 (unsigned long)node.macs,
+                 meanUs > 0 ? (double)node.macs / (double)meanUs : 0.0);
+        res = httpd_resp_send_chunk(req, line, HTTPD_RESP_USE_STRLEN);
+    }
+    if (res == ESP_OK) {
+        res = httpd_resp_send_chunk(req, "]}", HTTPD_RESP_USE_STRLEN);
+    }
+    if (res == ESP_OK) {
+        res = httpd_resp_send_chunk(req, nullptr, 0);
+    }
+    return res;
+}
+
+// HTTP handler, writes the request body (a .tflite flatbuffer) into the inactive model partition slot,
+// validates it as read back from flash and swaps the interpreter over to it in place.
+// POST /inference/model. A model the interpreter refuses is erased again and the running one kept.
+esp_err_t CameraHttpServer::modelUploadCallback(httpd_req_t *req)
+{
+    if (!s_modelStore || !s_inference) {
+        httpd_resp_set_status(req, "503 Service Unavailable");
+        return httpd_resp_send(req, "Model partition not available", HTTPD_RESP_USE_STRLEN);
+    }
+
+    const size_t modelLen = req->content_len;
+    const int64_t startUs = esp_timer_get_time();
+    ModelImageStatus status = s_modelStore->beginUpload(modelLen);
+    if (status != ModelImageStatus::Ok) {
+        httpd_resp_set_status(req, status == ModelImageStatus::TooLarge ? "413 Payload Too Large" : "409 Conflict");
+        return httpd_resp_send(req, modelImageStatusName(status), HTTPD_RESP_USE_STRLEN);
+    }
+
+    // Handlers run one at a time on the httpd task; static keeps the chunk off its stack.
+    static uint8_t chunk[2048];
+    size_t received = 0;
+    while (received < modelLen && status == ModelImageStatus::Ok) {
+        const size_t want = modelLen - received < sizeof(chunk) ? modelLen - received : sizeof(chunk);
+        const int got = httpd_req_recv(req, (char*)chunk, want);
+        if (got == HTTPD_SOCK_ERR_TIMEOUT) {
+            continue;
+        }
+        if (got <= 0) {
+            // The slot has no header yet, so it stays invalid; the running model is untouched.
+            s_modelStore->discardUpload();
+            return ESP_FAIL;
+        }
+        status = s_modelStore->appendUpload(chunk, (size_t)got);
+        received += (size_t)got;
+    }
+    const int64_t writtenUs = esp_timer_get_time();
+
+    const uint8_t* model = nullptr;
+    if (status == ModelImageStatus::Ok) {
+        status = s_modelStore->commitUpload(&model);
+    }
+    const int slot = s_modelStore->uploadSlot();
+    bool swapped = false;
+    if (status == ModelImageStatus::Ok) {
+        swapped = s_inference->swapModel(model);
+    }
+    if (swapped) {
+        s_modelStore->activateUpload();
+    } else {
+        s_modelStore->discardUpload();
+    }
+    const int64_t doneUs = esp_timer_get_time();
+
+    const ModelSlotInfo& info = s_modelStore->slotInfo((size_t)slot);
+    ESP_LOGW(MODEL_TAG, "Model upload: %u bytes into slot %d, %s%s | write=%lld ms validate+swap=%lld ms",
+             (unsigned int)modelLen,
+             slot,
+             modelImageStatusName(status),
+             status == ModelImageStatus::Ok ? (swapped ? ", swapped" : ", refused by the interpreter") : "",
+             (long long)((writtenUs - startUs) / 1000),
+             (long long)((doneUs - writtenUs) / 1000));
+
+    char body[192];
+    snprintf(body, sizeof(body),
+             "{\"ok\":%s,\"status\":\"%s\",\"slot\":%d,\"bytes\":%u,\"sequence\":%lu,\"crc32\":\"%08lx\",\"write_ms\":%lld,\"swap_ms\":%lld}",
+             swapped ? "true" : "false",
+             status == ModelImageStatus::Ok && !swapped ? "refused by the interpreter" : modelImageStatusName(status),
+             slot,
+             (unsigned int)modelLen,
+             (unsigned long)info.sequence,
+             (unsigned long)info.crc32,
+             (long long)((writtenUs - startUs) / 1000),
+             (long long)((doneUs - writtenUs) / 1000));
+    if (!swapped) {
+        httpd_resp_set_status(req, status == ModelImageStatus::Ok ? "422 Unprocessable Entity" : "400 Bad Request");
+    }
+    httpd_resp_set_type(req, "application/json");
+    return httpd_resp_send(req, body, HTTPD_RESP_USE_STRLEN);
+}
+
+// HTTP handler, the model partition slots and which model the interpreter runs on.
+// GET /inference/model
+esp_err_t CameraHttpServer::modelStatusCallback(httpd_req_t *req)
+{
+    if (!s_modelStore || !s_inference) {
+        httpd_resp_set_status(req, "503 Service Unavailable");
+        return httpd_resp_send(req, "Model partition not available", HTTPD_RESP_USE_STRLEN);
+    }
+
+    const bool fromPartition = s_modelStore->activeModel() &&
+                               s_inference->getModelData() == s_modelStore->activeModel();
+    char body[384];
+    int len = snprintf(body, sizeof(body), "{\"running\":\"%s\",\"active_slot\":%d,\"max_bytes\":%u,\"slots\":[",
+                       fromPartition ? "partition" : "built-in",
+                       s_modelStore->activeSlot(),
+                       (unsigned int)s_modelStore->maxModelBytes());
+    for (size_t i = 0; i < ModelStore::kSlotCount && len > 0 && (size_t)len < sizeof(body); i++) {
+        const ModelSlotInfo& info = s_modelStore->slotInfo(i);
+        len += snprintf(body + len, sizeof(body) - len,
+                        "%s{\"status\":\"%s\",\"bytes\":%lu,\"sequence\":%lu,\"crc32\":\"%08lx\"}",
+                        i ? "," : "",
+                        modelImageStatusName(info.status),
+                        (unsigned long)info.modelBytes,
+                        (unsigned long)info.sequence,
+                        (unsigned long)info.crc32);
+    }
+    if (len > 0 && (size_t)len < sizeof(body)) {
+        snprintf(body + len, sizeof(body) - len, "]}");
+    }
+    httpd_resp_set_type(req, "application/json");
+    httpd_resp_set_hdr(req, "Cache-Control", "no-store");
+    return httpd_resp_send(req, body, HTTPD_RESP_USE_STRLEN);
+}
+
 #pragma region INDEX_HTML
 // HTML page for live view using <canvas>
 #if USE_UDP
@@ -958,6 +1588,73 @@ esp_err_t CameraHttpServer::start(uint16_t port)
     };
     httpd_register_uri_handler(serverHandle, &uri_stream_rgb);
 
+    #if ENABLE_PRE_EVENT_CLIP
+        // --- Clip handler: serves the frozen pre-event ring as an MJPEG AVI ---
+        httpd_uri_t uri_clip_avi = {
+            .uri = "/clip.avi",
+            .method = HTTP_GET,
+            .handler = &CameraHttpServer::clipAviCallback,
+            .user_ctx = nullptr
+        };
+        httpd_register_uri_handler(serverHandle, &uri_clip_avi);
+    #endif
+
+    // --- Camera config handler: runtime frame size / format / quality / fps changes ---
+    httpd_uri_t uri_camera_config = {
+        .uri = "/camera/config",
+        .method = HTTP_GET,
+        .handler = &CameraHttpServer::cameraConfigCallback,
+        .user_ctx = nullptr
+    };
+    httpd_register_uri_handler(serverHandle, &uri_camera_config);
+
+    // --- Frame injection: upload frames and replay them instead of the camera ---
+    httpd_uri_t uri_frames_inject = {
+        .uri = "/frames/inject",
+        .method = HTTP_POST,
+        .handler = &CameraHttpServer::frameInjectCallback,
+        .user_ctx = nullptr
+    };
+    httpd_register_uri_handler(serverHandle, &uri_frames_inject);
+
+    httpd_uri_t uri_frames_source = {
+        .uri = "/frames/source",
+        .method = HTTP_GET,
+        .handler = &CameraHttpServer::frameSourceCallback,
+        .user_ctx = nullptr
+    };
+    httpd_register_uri_handler(serverHandle, &uri_frames_source);
+
+    #if ENABLE_INFERENCE && ENABLE_OP_PROFILER
+        // --- Per-operator inference profile ---
+        httpd_uri_t uri_inference_profile = {
+            .uri = "/inference/profile",
+            .method = HTTP_GET,
+            .handler = &CameraHttpServer::inferenceProfileCallback,
+            .user_ctx = nullptr
+        };
+        httpd_register_uri_handler(serverHandle, &uri_inference_profile);
+    #endif
+
+    #if ENABLE_INFERENCE && ENABLE_MODEL_PARTITION
+        // --- Model partition: upload and hot swap ---
+        httpd_uri_t uri_model_upload = {
+            .uri = "/inference/model",
+            .method = HTTP_POST,
+            .handler = &CameraHttpServer::modelUploadCallback,
+            .user_ctx = nullptr
+        };
+        httpd_register_uri_handler(serverHandle, &uri_model_upload);
+
+        httpd_uri_t uri_model_status = {
+            .uri = "/inference/model",
+            .method = HTTP_GET,
+            .handler = &CameraHttpServer::modelStatusCallback,
+            .user_ctx = nullptr
+        };
+        httpd_register_uri_handler(serverHandle, &uri_model_status);
+    #endif
+
     ESP_LOGI(TAG, "HTTP server started on port %u", port);
     return ESP_OK;
 }
@@ -983,6 +1680,21 @@ void CameraHttpServer::setStreamHandler(StreamCallback callback)
   s_streamCallback = callback;
 }
 
+void CameraHttpServer::setCameraDriver(CameraDriver* camera)
+{
+    s_cameraDriver = camera;
+}
+
+void CameraHttpServer::setInference(TfLiteWrapper* wrapper)
+{
+    s_inference = wrapper;
+}
+
+void CameraHttpServer::setModelStore(ModelStore* store)
+{
+    s_modelStore = store;
+}
+
 
 // generic capture handler
 esp_err_t CameraHttpServer::handleCapture(httpd_req_t *req, HttpFrameBuffer* frameBuffer, portMUX_TYPE* frameMetaLock)
@@ -1022,44 +1734,58 @@ void CameraHttpServer::http_stream_publish_task(void *arg)
 
     ESP_LOGI("HTTP_STREAM", "Stream publish task started");
 
-    uint8_t* grayscaleWorkspace = (uint8_t*)heap_caps_malloc(kAcquiredFrameMaxPixels, MALLOC_CAP_8BIT);
-    uint8_t* gray96Buffer = (uint8_t*)heap_caps_malloc(TF_IMAGE_INPUT_SIZE * TF_IMAGE_INPUT_SIZE, MALLOC_CAP_8BIT);
+    size_t grayscaleWorkspaceLen = kAcquiredFrameMaxPixels;
+    uint8_t* grayscaleWorkspace = (uint8_t*)bufferPlacement.allocate(PlacedBuffer::StreamWorkspace, grayscaleWorkspaceLen);
+    uint8_t* gray96Buffer = (uint8_t*)bufferPlacement.allocate(PlacedBuffer::StreamGray96, TF_IMAGE_INPUT_SIZE * TF_IMAGE_INPUT_SIZE);
     if (!grayscaleWorkspace || !gray96Buffer) {
         ESP_LOGE("HTTP_STREAM", "Failed to allocate stream publish workspace");
         vTaskDelete(NULL);
         return;
     }
 
-    uint32_t lastSeenSeq = 0;
     uint32_t publishedFrames = 0;
     int64_t publishWindowStartUs = esp_timer_get_time();
 
     while (true) {
         ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(100));
 
-        FrameSnapshot snapshot = {};
-        bool snapshotResult = streamManager->snapshot(&snapshot);
-        if (!snapshotResult || snapshot.seq == lastSeenSeq) {
+        // Only returns unread frames; the slot is ours until release().
+        const FrameSnapshot* acquired = streamManager->acquire();
+        if (!acquired) {
             continue;
         }
+        const FrameSnapshot& snapshot = *acquired;
 
         const uint8_t* publishSrc = nullptr;
         size_t publishLen = 0;
         uint16_t publishWidth = snapshot.width;
         uint16_t publishHeight = snapshot.height;
         pixformat_t publishFormat = snapshot.format;
+        bool lentPublished = false;
 
         if (snapshot.format == PIXFORMAT_JPEG) {
+            // Zero-copy: the HTTP store keeps a reference to the camera buffer.
+            frameBuffer->publishHttpFrame(snapshot, esp_timer_get_time());
             publishSrc = snapshot.data;
             publishLen = snapshot.len;
+            lentPublished = true;
         } else {
+            // The camera may have been reconfigured to a larger frame size: grow the scratch frame with it.
+            bufferPlacement.ensureCapacity(PlacedBuffer::StreamWorkspace,
+                                           &grayscaleWorkspace,
+                                           &grayscaleWorkspaceLen,
+                                           gray96WorkspaceBytes(snapshot.width, snapshot.height));
             #if STREAM_ORIGINALLY_ACQUIRED_IMAGE
                 if (snapshot.format == PIXFORMAT_GRAYSCALE) {
+                    FrameSnapshot grayFrame = snapshot;
+                    grayFrame.len = (size_t)snapshot.width * (size_t)snapshot.height;
+                    frameBuffer->publishHttpFrame(grayFrame, esp_timer_get_time());
                     publishSrc = snapshot.data;
-                    publishLen = (size_t)snapshot.width * (size_t)snapshot.height;
+                    publishLen = grayFrame.len;
+                    lentPublished = true;
                 } else if (buildGray96Frame(snapshot,
                                             grayscaleWorkspace,
-                                            kAcquiredFrameMaxPixels,
+                                            grayscaleWorkspaceLen,
                                             gray96Buffer,
                                             TF_IMAGE_INPUT_SIZE)) {
                     publishSrc = gray96Buffer;
@@ -1071,7 +1797,7 @@ void CameraHttpServer::http_stream_publish_task(void *arg)
             #else
                 if (buildGray96Frame(snapshot,
                                      grayscaleWorkspace,
-                                     kAcquiredFrameMaxPixels,
+                                     grayscaleWorkspaceLen,
                                      gray96Buffer,
                                      TF_IMAGE_INPUT_SIZE)) {
                 publishSrc = gray96Buffer;
@@ -1084,19 +1810,21 @@ void CameraHttpServer::http_stream_publish_task(void *arg)
         }
 
         if (!publishSrc || publishLen == 0) {
-            lastSeenSeq = snapshot.seq;
+            streamManager->release();
             continue;
         }
 
         const int64_t publishUs = esp_timer_get_time();
-        frameBuffer->publishHttpFrame(publishSrc,
-                                      publishLen,
-                                      publishWidth,
-                                      publishHeight,
-                                      publishFormat,
-                                      publishUs);
-
-        lastSeenSeq = snapshot.seq;
+        if (!lentPublished) {
+            frameBuffer->publishHttpFrame(publishSrc,
+                                          publishLen,
+                                          publishWidth,
+                                          publishHeight,
+                                          publishFormat,
+                                          publishUs);
+        }
+
+        streamManager->release();
         publishedFrames++;
 
         const int64_t elapsedUs = publishUs - publishWindowStartUs;
@@ -1110,6 +1838,7 @@ void CameraHttpServer::http_stream_publish_task(void *arg)
                      publishHeight,
                      publishFormat,
                      (unsigned int)publishLen);
+            framePool.logStatus("HTTP_STREAM");
             publishedFrames = 0;
             publishWindowStartUs = publishUs;
         }
@@ -1127,7 +1856,6 @@ void CameraHttpServer::udp_stream_task(void *arg)
   }
 
   HttpFrameBuffer* frameBuffer = ctx->httpFrameBuffer;
-  portMUX_TYPE* frameMetaLock = ctx->httpFrameMetaLock;
 
     const uint32_t kMagic = 0x47504455U; // 'UDPG'
     const int kMaxPayload = UDP_STREAM_MAX_PAYLOAD;
@@ -1163,15 +1891,13 @@ void CameraHttpServer::udp_stream_task(void *arg)
     struct sockaddr_in clientAddr = {};
     socklen_t clientAddrLen = sizeof(clientAddr);
 
-    uint8_t *frameSnapshot = (uint8_t *)heap_caps_malloc(kPublishedFrameMaxBytes, MALLOC_CAP_8BIT);
-    if (!frameSnapshot) {
-        ESP_LOGE("UDP_STREAM", "Failed to allocate frame snapshot buffer");
+    // Off the task stack so the policy can put it in DMA-capable internal SRAM.
+    uint8_t* packet = (uint8_t*)bufferPlacement.allocate(PlacedBuffer::UdpPacket, sizeof(UdpFrameHeader) + UDP_STREAM_MAX_PAYLOAD);
+    if (!packet) {
         close(sock);
         vTaskDelete(NULL);
         return;
     }
-
-    uint8_t packet[sizeof(UdpFrameHeader) + UDP_STREAM_MAX_PAYLOAD];
     uint32_t lastSentSeq = 0;
     uint32_t txFrames = 0;
     uint32_t txChunks = 0;
@@ -1199,40 +1925,23 @@ void CameraHttpServer::udp_stream_task(void *arg)
             continue;
         }
 
-        size_t frameLen = 0;
-        uint8_t frameIndex = 0;
-        uint32_t frameSeq = 0;
-        int64_t framePublishUs = 0;
-        if (frameMetaLock) {
-            taskENTER_CRITICAL(frameMetaLock);
-            frameLen = frameBuffer->getActiveHttpFrameLength();
-            frameIndex = frameBuffer->getActiveHttpFrameIndex();
-            frameSeq = frameBuffer->getActiveHttpFrameSeq();
-            framePublishUs = frameBuffer->getActiveHttpFramePublishUs();
-            taskEXIT_CRITICAL(frameMetaLock);
-        } else {
-            frameLen = frameBuffer->getActiveHttpFrameLength();
-            frameIndex = frameBuffer->getActiveHttpFrameIndex();
-            frameSeq = frameBuffer->getActiveHttpFrameSeq();
-            framePublishUs = frameBuffer->getActiveHttpFramePublishUs();
-        }
-
-        const uint8_t* activeBuffer = frameBuffer->getBuffer(frameIndex);
-        if (frameLen == 0 || !activeBuffer) {
+        // The frame stays pinned by frame.handle for the whole send, so it is transmitted in place.
+        FrameSnapshot frame = {};
+        if (!frameBuffer->acquireActiveHttpFrame(&frame)) {
             vTaskDelay(pdMS_TO_TICKS(10));
             continue;
         }
-
-        if (frameLen > kPublishedFrameMaxBytes) {
-            frameLen = kPublishedFrameMaxBytes;
-        }
+        const size_t frameLen = frame.len;
+        const uint32_t frameSeq = frame.seq;
+        const int64_t framePublishUs = frame.captureUs;
 
         if (frameSeq == lastSentSeq) {
+            frame.handle.reset();
             vTaskDelay(pdMS_TO_TICKS(5));
             continue;
         }
 
-        memcpy(frameSnapshot, activeBuffer, frameLen);
+        const uint8_t* sendSrc = frame.data;
 
         const uint16_t chunkCount = (uint16_t)((frameLen + kMaxPayload - 1) / kMaxPayload);
         const int64_t nowUs = esp_timer_get_time();
@@ -1256,7 +1965,7 @@ void CameraHttpServer::udp_stream_task(void *arg)
             header.frameAgeMs = htonl(frameAgeMs);
 
             memcpy(packet, &header, sizeof(header));
-            memcpy(packet + sizeof(header), frameSnapshot + offset, payloadLen);
+            memcpy(packet + sizeof(header), sendSrc + offset, payloadLen);
 
             int sent = sendto(sock,
                               packet,
@@ -1272,6 +1981,18 @@ void CameraHttpServer::udp_stream_task(void *arg)
             txChunks++;
         }
 
+        #if ENABLE_STREAM_BITRATE_CONTROL
+            const int64_t sendEndUs = esp_timer_get_time();
+            BitrateSample sample;
+            sample.nowUs = sendEndUs;
+            sample.frameAgeUs = (framePublishUs > 0 && sendEndUs > framePublishUs) ? (sendEndUs - framePublishUs) : 0;
+            sample.sendUs = sendEndUs - nowUs;
+            sample.frameBytes = (uint32_t)frameLen;
+            sample.skippedFrames = (lastSentSeq != 0 && frameSeq > lastSentSeq) ? (frameSeq - lastSentSeq - 1) : 0;
+            sample.failed = frameFailed;
+            reportStreamSend(sample, s_cameraDriver);
+        #endif
+
         if (!frameFailed) {
             lastSentSeq = frameSeq;
             txFrames++;
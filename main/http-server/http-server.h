@@ -6,6 +6,10 @@
 #include <functional>
 #include <string>
 
+class CameraDriver;
+class TfLiteWrapper;
+class ModelStore;
+
 class CameraHttpServer {
 public:
     using CaptureCallback = std::function<esp_err_t(httpd_req_t *req, HttpFrameBuffer* frameBuffer, portMUX_TYPE* frameMetaLock)>;
@@ -19,12 +23,26 @@ public:
 
     void setCaptureHandler(CaptureCallback callback);
     void setStreamHandler(StreamCallback callback);
+    // Camera that /camera/config reconfigures; the endpoint answers 503 until it is set.
+    void setCameraDriver(CameraDriver* camera);
+    // Interpreter whose per-operator profile /inference/profile serves and whose model /inference/model
+    // swaps; 503 until it is set.
+    void setInference(TfLiteWrapper* wrapper);
+    // Model partition behind /inference/model; 503 until it is set.
+    void setModelStore(ModelStore* store);
 
     void http_stream_publish_task(void *arg);
     void udp_stream_task(void *arg);
 
     static esp_err_t streamRgbTcpCallback(httpd_req_t *req, HttpFrameBuffer* frameBuffer, portMUX_TYPE* frameMetaLock);
     static esp_err_t captureRgbTcpCallback(httpd_req_t *req, HttpFrameBuffer* frameBuffer, portMUX_TYPE* frameMetaLock);
+    static esp_err_t clipAviCallback(httpd_req_t *req);
+    static esp_err_t cameraConfigCallback(httpd_req_t *req);
+    static esp_err_t frameInjectCallback(httpd_req_t *req);
+    static esp_err_t frameSourceCallback(httpd_req_t *req);
+    static esp_err_t inferenceProfileCallback(httpd_req_t *req);
+    static esp_err_t modelUploadCallback(httpd_req_t *req);
+    static esp_err_t modelStatusCallback(httpd_req_t *req);
 
 private:
     static esp_err_t handleCapture(httpd_req_t *req, HttpFrameBuffer* frameBuffer, portMUX_TYPE* frameMetaLock);
@@ -34,5 +52,8 @@ private:
 
     static CaptureCallback s_captureCallback;
     static StreamCallback s_streamCallback;
+    static CameraDriver* s_cameraDriver;
+    static TfLiteWrapper* s_inference;
+    static ModelStore* s_modelStore;
     httpd_handle_t serverHandle = nullptr;
 };
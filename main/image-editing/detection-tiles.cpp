@@ -0,0 +1,191 @@
+#include "image-editing/detection-tiles.h"
+#include <string.h>
+
+namespace {
+
+// Block-mean changes up to this size are sensor noise and JPEG requantization, not motion.
+constexpr int kMotionNoiseFloor = 6;
+
+// Windows along one side: enough steps of the overlap stride to reach the far edge.
+int windowsAlong(int span, int tileSize, int overlapPercent)
+{
+    if (span <= tileSize) {
+        return 1;
+    }
+    int stride = tileSize * (100 - overlapPercent) / 100;
+    if (stride < 1) {
+        stride = 1;
+    }
+    return (span - tileSize + stride - 1) / stride + 1;
+}
+
+int windowOrigin(int index, int windows, int span, int tileSize)
+{
+    if (windows == 1) {
+        return (span - tileSize) / 2;
+    }
+    return index * (span - tileSize) / (windows - 1);
+}
+
+// Blocks lying wholly inside [origin, origin + tileSize), clamped to the grid.
+void blocksInside(int origin, int tileSize, int gridLen, int* first, int* end)
+{
+    const int block = TileSaliencyMap::kBlock;
+    *first = (origin + block - 1) / block;
+    *end = (origin + tileSize) / block;
+    if (*end > gridLen) {
+        *end = gridLen;
+    }
+}
+
+bool ranksBefore(const DetectionTile& a, const DetectionTile& b)
+{
+    if (a.motion != b.motion) {
+        return a.motion > b.motion;
+    }
+    return a.contrast > b.contrast;
+}
+
+} // namespace
+
+size_t planDetectionTiles(int width,
+                          int height,
+                          int tileSize,
+                          int overlapPercent,
+                          DetectionTile* tiles,
+                          size_t maxTiles)
+{
+    if (!tiles || maxTiles == 0 || tileSize <= 0 || width < tileSize || height < tileSize) {
+        return 0;
+    }
+    if (overlapPercent < 0) {
+        overlapPercent = 0;
+    } else if (overlapPercent > 90) {
+        overlapPercent = 90;
+    }
+
+    int columns = windowsAlong(width, tileSize, overlapPercent);
+    int rows = windowsAlong(height, tileSize, overlapPercent);
+    while ((size_t)columns * rows > maxTiles) {
+        if (columns >= rows && columns > 1) {
+            columns--;
+        } else {
+            rows--;
+        }
+    }
+
+    size_t count = 0;
+    for (int row = 0; row < rows; row++) {
+        for (int column = 0; column < columns; column++) {
+            DetectionTile& tile = tiles[count++];
+            tile = DetectionTile();
+            tile.x = (uint16_t)windowOrigin(column, columns, width, tileSize);
+            tile.y = (uint16_t)windowOrigin(row, rows, height, tileSize);
+        }
+    }
+    return count;
+}
+
+void copyDetectionTile(const uint8_t* luma,
+                       int width,
+                       const DetectionTile& tile,
+                       int tileSize,
+                       uint8_t* dst,
+                       const uint8_t* lut)
+{
+    const uint8_t* src = luma + (size_t)tile.y * width + tile.x;
+    for (int y = 0; y < tileSize; y++, src += width, dst += tileSize) {
+        if (lut) {
+            for (int x = 0; x < tileSize; x++) {
+                dst[x] = lut[src[x]];
+            }
+        } else {
+            memcpy(dst, src, (size_t)tileSize);
+        }
+    }
+}
+
+size_t TileSaliencyMap::storageBytes(int width, int height)
+{
+    // Previous and current block means.
+    return 2 * (size_t)(width / kBlock) * (height / kBlock);
+}
+
+void TileSaliencyMap::bind(uint8_t* storage, size_t len)
+{
+    if (storage != storage_ || len != capacity_) {
+        history_ = false;
+    }
+    storage_ = storage;
+    capacity_ = len;
+}
+
+bool TileSaliencyMap::rank(const uint8_t* luma, int width, int height, int tileSize, DetectionTile* tiles, size_t count)
+{
+    const int gridWidth = width / kBlock;
+    const int gridHeight = height / kBlock;
+    const size_t cells = (size_t)gridWidth * gridHeight;
+    if (!luma || !storage_ || cells == 0 || 2 * cells > capacity_) {
+        return false;
+    }
+    if (gridWidth != gridWidth_ || gridHeight != gridHeight_) {
+        gridWidth_ = gridWidth;
+        gridHeight_ = gridHeight;
+        history_ = false;
+    }
+    const uint8_t* previous = storage_;
+    uint8_t* current = storage_ + cells;
+
+    for (int by = 0; by < gridHeight; by++) {
+        for (int bx = 0; bx < gridWidth; bx++) {
+            const uint8_t* src = luma + (size_t)by * kBlock * width + bx * kBlock;
+            uint32_t sum = 0;
+            for (int y = 0; y < kBlock; y++, src += width) {
+                for (int x = 0; x < kBlock; x++) {
+                    sum += src[x];
+                }
+            }
+            current[(size_t)by * gridWidth + bx] = (uint8_t)((sum + kBlock * kBlock / 2) / (kBlock * kBlock));
+        }
+    }
+
+    for (size_t i = 0; i < count; i++) {
+        DetectionTile& tile = tiles[i];
+        int bx0, bx1, by0, by1;
+        blocksInside(tile.x, tileSize, gridWidth, &bx0, &bx1);
+        blocksInside(tile.y, tileSize, gridHeight, &by0, &by1);
+        uint32_t motion = 0;
+        uint8_t lo = 255;
+        uint8_t hi = 0;
+        for (int by = by0; by < by1; by++) {
+            const size_t rowStart = (size_t)by * gridWidth;
+            for (int bx = bx0; bx < bx1; bx++) {
+                const uint8_t mean = current[rowStart + bx];
+                lo = mean < lo ? mean : lo;
+                hi = mean > hi ? mean : hi;
+                if (history_) {
+                    const int diff = mean > previous[rowStart + bx] ? mean - previous[rowStart + bx]
+                                                                   : previous[rowStart + bx] - mean;
+                    motion += diff > kMotionNoiseFloor ? (uint32_t)(diff - kMotionNoiseFloor) : 0;
+                }
+            }
+        }
+        tile.motion = motion;
+        tile.contrast = hi > lo ? (uint16_t)(hi - lo) : 0;
+    }
+
+    // Insertion sort: a handful of tiles, and it keeps plan order between equals.
+    for (size_t i = 1; i < count; i++) {
+        const DetectionTile tile = tiles[i];
+        size_t j = i;
+        while (j > 0 && ranksBefore(tile, tiles[j - 1])) {
+            tiles[j] = tiles[j - 1];
+            j--;
+        }
+        tiles[j] = tile;
+    }
+
+    memcpy(storage_, current, cells);
+    history_ = true;
+    return true;
+}
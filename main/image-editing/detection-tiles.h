@@ -0,0 +1,62 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+// Window placement and ordering for tiled inference (INFERENCE_INPUT_TILED): the model's square input
+// slides over a larger luma frame, and the windows most likely to hold a person are tried first. No
+// allocation and no ESP-IDF calls.
+
+struct DetectionTile {
+    uint16_t x = 0;
+    uint16_t y = 0;
+    uint32_t motion = 0;            // summed block-mean change since the previous frame, above the noise floor
+    uint16_t contrast = 0;          // block-mean range inside the window
+};
+
+// Places tileSize windows over a width x height frame with at least overlapPercent overlap between
+// neighbours. The first and last window of each row and column touch the frame edges and the rest are
+// spread evenly between them; a side that fits one window gets it centered. When the grid would need
+// more than maxTiles, fewer windows are spread over the same span (less overlap). Returns the number of
+// tiles written in row-major order, 0 when the frame is smaller than a tile.
+size_t planDetectionTiles(int width,
+                          int height,
+                          int tileSize,
+                          int overlapPercent,
+                          DetectionTile* tiles,
+                          size_t maxTiles);
+
+// Copies the tileSize x tileSize window at (tile.x, tile.y) of a luma frame width pixels wide into dst.
+// With lut, every pixel is stored as lut[luma] (quantized input tensor, TfLiteWrapper::getModelInput()).
+void copyDetectionTile(const uint8_t* luma,
+                       int width,
+                       const DetectionTile& tile,
+                       int tileSize,
+                       uint8_t* dst,
+                       const uint8_t* lut = nullptr);
+
+// Scores windows from 8x8 block means of consecutive frames. The previous frame's means live in
+// caller-provided storage (storageBytes()), so the map can sit in a placed buffer.
+class TileSaliencyMap
+{
+public:
+    static constexpr int kBlock = 8;
+
+    static size_t storageBytes(int width, int height);
+
+    // A different buffer or frame size forgets the previous frame.
+    void bind(uint8_t* storage, size_t len);
+
+    // Updates the block means from luma, fills motion and contrast for every tile and sorts the tiles:
+    // most motion first, then most contrast (the only criterion on the first frame). Ties keep plan order.
+    bool rank(const uint8_t* luma, int width, int height, int tileSize, DetectionTile* tiles, size_t count);
+
+    bool hasHistory() const { return history_; }
+
+private:
+    uint8_t* storage_ = nullptr;
+    size_t capacity_ = 0;
+    int gridWidth_ = 0;
+    int gridHeight_ = 0;
+    bool history_ = false;
+};
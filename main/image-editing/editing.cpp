@@ -1,47 +1,26 @@
 #include "editing.h"
+#include "image-editing/pixel-kernels.h"
+#include "image-editing/jpeg-gray-crop.h"
+#include "image-editing/gray-resample.h"
+#include "image-editing/preprocess-pipeline.h"
 #include <cstring>
-// jpeg
-//#include "esp_jpeg.h" //"esp_jpeg_decoder.h"   // or <esp_jpeg.h> depending on your SDK
-#include "esp_heap_caps.h"
 #include "esp_log.h"
 #include "debug.h"
 
 
 void resizeRgbNearestNeighbor(const uint8_t* src, int in_width, int in_height,
                            uint8_t* dst, int out_width, int out_height) {
-    for (int y = 0; y < out_height; y++) {
-        int src_y = y * in_height / out_height;
-        for (int x = 0; x < out_width; x++) {
-            int src_x = x * in_width / out_width;
-            for (int c = 0; c < 3; c++) { // R,G,B channels
-                dst[(y * out_width + x) * 3 + c] =
-                    src[(src_y * in_width + src_x) * 3 + c];
-            }
-        }
-    }
+    resizeRgb888NearestKernel(src, in_width, in_height, dst, out_width, out_height);
 }
 
 void convertRgb565ToGrayscale(const uint16_t* rgb565, uint8_t* gray, int width, int height) 
 { 
-    int pixel_count = width * height; 
-    for (int i = 0; i < pixel_count; ++i) { 
-        uint16_t pix = rgb565[i]; 
-        uint8_t r = ((pix >> 11) & 0x1F) * 255 / 31; 
-        uint8_t g = ((pix >> 5) & 0x3F) * 255 / 63; 
-        uint8_t b = (pix & 0x1F) * 255 / 31; 
-        gray[i] = (r * 30 + g * 59 + b * 11 + 50) / 100; 
-    } 
+    rgb565ToGrayKernel(rgb565, gray, (size_t)width * height);
 }
 
 void convertRgb888ToGrayscale(const uint8_t* rgb, uint8_t* gray, int width, int height) 
 {
-    int pixel_count = width * height;
-    for (int i = 0; i < pixel_count; ++i) {
-        uint8_t r = rgb[i * 3];
-        uint8_t g = rgb[i * 3 + 1];
-        uint8_t b = rgb[i * 3 + 2];
-        gray[i] = (r * 30 + g * 59 + b * 11) / 100;  // Weighted average
-    }
+    rgb888ToGrayKernel(rgb, gray, (size_t)width * height);
 }
 
 bool cropCenter(const uint8_t* src, int src_width, int src_height,
@@ -73,39 +52,81 @@ bool cropCenter(const uint8_t* src, int src_width, int src_height,
     return true;
 }
 
-uint8_t* allocatingDecodeCameraJpeg(camera_fb_t *fb, 
-                                            uint32_t memory_type,
-                                            esp_jpeg_image_format_t out_format,
-                                            esp_jpeg_image_scale_t scale)
-{
-    if (!fb || fb->format != PIXFORMAT_JPEG) return NULL;
-
-    int width  = fb->width;
-    int height = fb->height;
-    size_t out_size = width * height * 2;  // RGB565
+struct ThumbnailSink {
+    uint8_t* luma;
+    size_t capacityPixels;
+};
 
-    uint8_t* out_buf = (uint8_t*) heap_caps_malloc(out_size, memory_type );
-    if (!out_buf) {
-        ESP_LOGE("JPEG_CONVERT", "Malloc failed");
-        return NULL;
+static bool copyThumbnailStripe(const JpegGrayStripe& stripe, void* user)
+{
+    ThumbnailSink* sink = (ThumbnailSink*)user;
+    const size_t first = (size_t)stripe.top * stripe.width;
+    const size_t count = (size_t)stripe.rows * stripe.width;
+    if (first + count > sink->capacityPixels) {
+        return false;
     }
+    memcpy(sink->luma + first, stripe.luma, count);
+    return true;
+}
 
-    esp_jpeg_image_cfg_t cfg = {};
-    cfg.indata       = fb->buf;
-    cfg.indata_size  = fb->len;
-    cfg.outbuf       = out_buf;
-    cfg.outbuf_size  = out_size;
-    cfg.out_format   = out_format;
-    cfg.out_scale    = scale;
+bool decodeJpegLumaThumbnail(JpegDecoderContext& decoder,
+                             const uint8_t* jpeg,
+                             size_t len,
+                             uint8_t* luma,
+                             size_t capacityPixels,
+                             uint16_t* thumbWidth,
+                             uint16_t* thumbHeight)
+{
+    if (!jpeg || !luma) {
+        return false;
+    }
 
-    esp_jpeg_image_output_t out = {};
+    ThumbnailSink sink = { luma, capacityPixels };
+    JpegGrayCropResult result;
+    if (!decoder.decodeGrayStripes(jpeg, len, JPEG_IMAGE_SCALE_1_8, copyThumbnailStripe, &sink, &result) ||
+        result.stoppedEarly) {
+        return false;
+    }
+    *thumbWidth = result.outputWidth;
+    *thumbHeight = result.outputHeight;
+    return true;
+}
 
-    if (esp_jpeg_decode(&cfg, &out) != ESP_OK) {
-        heap_caps_free(out_buf);
-        return NULL;
+bool readJpegDimensions(const uint8_t* jpeg, size_t len, uint16_t* width, uint16_t* height)
+{
+    if (!jpeg || len < 4 || jpeg[0] != 0xFF || jpeg[1] != 0xD8) {
+        return false;
     }
 
-    return out_buf;   // caller frees
+    size_t pos = 2;
+    while (pos + 4 <= len) {
+        if (jpeg[pos] != 0xFF) {
+            return false;
+        }
+        const uint8_t marker = jpeg[pos + 1];
+        if (marker == 0xFF) {
+            pos++;  // fill byte
+            continue;
+        }
+        if (marker == 0x01 || (marker >= 0xD0 && marker <= 0xD7)) {
+            pos += 2;  // standalone marker, no length
+            continue;
+        }
+        if (marker == 0xDA) {
+            return false;  // scan started without a frame header
+        }
+        const size_t segmentLen = ((size_t)jpeg[pos + 2] << 8) | jpeg[pos + 3];
+        if (marker >= 0xC0 && marker <= 0xC3) {
+            if (pos + 9 > len) {
+                return false;
+            }
+            *height = (uint16_t)((jpeg[pos + 5] << 8) | jpeg[pos + 6]);
+            *width = (uint16_t)((jpeg[pos + 7] << 8) | jpeg[pos + 8]);
+            return true;
+        }
+        pos += 2 + segmentLen;
+    }
+    return false;
 }
 
 // Converts a grayscale buffer to RGB888
@@ -116,21 +137,141 @@ void convertGrayscaleToRgb888(const uint8_t* grayscale, uint8_t* rgb, int width,
 {
     if (!grayscale || !rgb) return;
 
-    int pixel_count = width * height;
-    for (int i = 0; i < pixel_count; ++i) {
-        uint8_t val = grayscale[i];
-        rgb[i * 3 + 0] = val;  // R
-        rgb[i * 3 + 1] = val;  // G
-        rgb[i * 3 + 2] = val;  // B
+    grayToRgb888Kernel(grayscale, rgb, (size_t)width * height);
+}
+
+
+size_t gray96WorkspaceBytes(uint16_t width, uint16_t height)
+{
+    // Raw formats need none. JPEG needs the decoder work area, plus the reduced-scale luma image and
+    // resampler scratch in full-view mode; a full-resolution frame bounds both.
+    return (size_t)width * height + kJpegGrayCropPoolBytes;
+}
+
+#if INFERENCE_INPUT_MODE == INFERENCE_INPUT_FULL_VIEW
+typedef AreaResizeGeometry RawInputGeometry;
+
+// Largest JPEG decoder reduction (0..3 = 1:1..1:8) that still leaves both sides at least target.
+static uint8_t jpegScaleForTarget(uint16_t width, uint16_t height, size_t target)
+{
+    uint8_t scale = 3;
+    while (scale > 0 && ((size_t)(width >> scale) < target || (size_t)(height >> scale) < target)) {
+        scale--;
     }
+    return scale;
 }
 
+static bool resizeFullViewStripe(const JpegGrayStripe& stripe, void* user)
+{
+    return ((GrayBilinearRowResizer*)user)->pushRows(stripe.luma, stripe.top, stripe.rows);
+}
+
+// JPEG frames in INFERENCE_INPUT_FULL_VIEW: decoded to luma at a reduced scale, then resized to the
+// model input. When the scaled frame is below twice the target (every OV2640 frame size) the resize
+// is a single bilinear pass that consumes MCU rows as they are decoded; larger frames are decoded
+// whole and go through downscaleGray().
+static bool buildJpegGray96FullView(const FrameSnapshot& snapshot,
+                                    uint8_t* grayscaleWorkspace,
+                                    size_t grayscaleWorkspaceLen,
+                                    uint8_t* gray96Buffer,
+                                    size_t tfImageInputSize,
+                                    const uint8_t* lut)
+{
+    // Decoder work area at the end of the workspace, luma image (or resize scratch and stripe) at the start.
+    if (grayscaleWorkspaceLen < 2 * kJpegGrayCropPoolBytes) {
+        ESP_LOGW(CAPTURE_TAG, "Workspace too small for the JPEG decoder (%u)", (unsigned int)grayscaleWorkspaceLen);
+        return false;
+    }
+    const size_t poolOffset = (grayscaleWorkspaceLen - kJpegGrayCropPoolBytes) & ~(size_t)3;
+    const uint8_t scale = jpegScaleForTarget(snapshot.width, snapshot.height, tfImageInputSize);
+    const int target = (int)tfImageInputSize;
+    const int scaledWidth = snapshot.width >> scale;
+    const int scaledHeight = snapshot.height >> scale;
+    JpegGrayCropResult decoded;
+
+    if (scaledWidth < 2 * target || scaledHeight < 2 * target) {
+        const size_t scratchLen = (GrayBilinearRowResizer::scratchBytes(scaledWidth, target) + 3) & ~(size_t)3;
+        const size_t stripeLen = jpegGrayStripeBytes(snapshot.width, scale);
+        GrayBilinearRowResizer resizer;
+        if (scratchLen + stripeLen > poolOffset ||
+            !resizer.begin(scaledWidth, scaledHeight, gray96Buffer, target, target, grayscaleWorkspace, scratchLen, lut)) {
+            ESP_LOGW(CAPTURE_TAG, "Cannot resize %dx%d to %dx%d", scaledWidth, scaledHeight, target, target);
+            return false;
+        }
+        if (!decodeJpegGrayStripes(snapshot.data,
+                                   snapshot.len,
+                                   scale,
+                                   grayscaleWorkspace + scratchLen,
+                                   stripeLen,
+                                   resizeFullViewStripe,
+                                   &resizer,
+                                   grayscaleWorkspace + poolOffset,
+                                   kJpegGrayCropPoolBytes,
+                                   &decoded) ||
+            !resizer.finished()) {
+            ESP_LOGE(CAPTURE_TAG, "JPEG decode failed");
+            return false;
+        }
+        return true;
+    }
+
+    if (!decodeJpegGrayScaled(snapshot.data,
+                              snapshot.len,
+                              scale,
+                              grayscaleWorkspace,
+                              poolOffset,
+                              grayscaleWorkspace + poolOffset,
+                              kJpegGrayCropPoolBytes,
+                              &decoded)) {
+        ESP_LOGE(CAPTURE_TAG, "JPEG decode failed");
+        return false;
+    }
+
+    if (!downscaleGray(grayscaleWorkspace, decoded.outputWidth, decoded.outputHeight,
+                       grayscaleWorkspace, grayscaleWorkspaceLen,
+                       gray96Buffer, target, target)) {
+        ESP_LOGW(CAPTURE_TAG, "Cannot downscale %ux%u to %dx%d",
+                 (unsigned int)decoded.outputWidth, (unsigned int)decoded.outputHeight, target, target);
+        return false;
+    }
+    if (lut) {
+        mapGrayLut(gray96Buffer, (size_t)target * target, lut);
+    }
+    return true;
+}
+
+#else
+typedef CenterCropGeometry RawInputGeometry;
+#endif
+
+template <class Destination>
+static bool buildRawGray96(const FrameSnapshot& snapshot, uint8_t* dst, int target, const Destination& destination)
+{
+    switch (snapshot.format) {
+        case PIXFORMAT_GRAYSCALE:
+            return preprocessFrame<Gray8Source, RawInputGeometry, Destination>(
+                snapshot.data, snapshot.width, snapshot.height, dst, target, target, destination);
+
+        case PIXFORMAT_RGB565:
+            return preprocessFrame<Rgb565Source, RawInputGeometry, Destination>(
+                snapshot.data, snapshot.width, snapshot.height, dst, target, target, destination);
+
+        case PIXFORMAT_RGB888:
+            return preprocessFrame<Rgb888Source, RawInputGeometry, Destination>(
+                snapshot.data, snapshot.width, snapshot.height, dst, target, target, destination);
+
+        default:
+            ESP_LOGW(CAPTURE_TAG, "Unsupported pixel format %d", snapshot.format);
+            return false;
+    }
+}
 
 bool buildGray96Frame(const FrameSnapshot& snapshot,
                         uint8_t* grayscaleWorkspace,
                         size_t grayscaleWorkspaceLen,
                         uint8_t* gray96Buffer,
-                        size_t tfImageInputSize)
+                        size_t tfImageInputSize,
+                        const uint8_t* lut)
 {
     if (!snapshot.data || !grayscaleWorkspace || !gray96Buffer) {
         return false;
@@ -141,87 +282,109 @@ bool buildGray96Frame(const FrameSnapshot& snapshot,
         return false;
     }
 
-    const size_t pixelCount = (size_t)snapshot.width * (size_t)snapshot.height;
-    if (pixelCount > grayscaleWorkspaceLen) {
-        ESP_LOGW(CAPTURE_TAG,
-                 "Frame scratch buffer too small (%u > %u)",
-                 (unsigned int)pixelCount,
-                 (unsigned int)grayscaleWorkspaceLen);
+    if (snapshot.format == PIXFORMAT_JPEG) {
+#if INFERENCE_INPUT_MODE == INFERENCE_INPUT_FULL_VIEW
+        return buildJpegGray96FullView(snapshot, grayscaleWorkspace, grayscaleWorkspaceLen, gray96Buffer, tfImageInputSize, lut);
+#else
+        // Fused path: only the MCUs under the crop are converted, straight into gray96Buffer. The
+        // workspace serves as the decoder's work area, so no full-frame RGB565 buffer is allocated.
+        if (grayscaleWorkspaceLen < kJpegGrayCropPoolBytes) {
+            ESP_LOGW(CAPTURE_TAG, "Workspace too small for the JPEG decoder (%u)", (unsigned int)grayscaleWorkspaceLen);
+            return false;
+        }
+        if (!decodeJpegGrayCenterCrop(snapshot.data,
+                                      snapshot.len,
+                                      gray96Buffer,
+                                      tfImageInputSize,
+                                      tfImageInputSize,
+                                      grayscaleWorkspace,
+                                      grayscaleWorkspaceLen,
+                                      nullptr,
+                                      lut)) {
+            ESP_LOGE(CAPTURE_TAG, "JPEG decode failed");
+            return false;
+        }
+        return true;
+#endif
+    }
+
+    // Raw formats: one fused pass from the camera buffer into gray96Buffer (preprocess-pipeline.h),
+    // specialized per format at compile time; the workspace is not touched.
+    if (lut) {
+        return buildRawGray96<LutTensor>(snapshot, gray96Buffer, (int)tfImageInputSize, LutTensor{ lut });
+    }
+    return buildRawGray96<Uint8Tensor>(snapshot, gray96Buffer, (int)tfImageInputSize, Uint8Tensor());
+}
+
+bool buildGrayTileFrame(const FrameSnapshot& snapshot,
+                        uint8_t* grayscaleWorkspace,
+                        size_t grayscaleWorkspaceLen,
+                        int maxSide,
+                        int minSide,
+                        uint16_t* width,
+                        uint16_t* height)
+{
+    if (!snapshot.data || !grayscaleWorkspace || !width || !height) {
+        return false;
+    }
+    if (snapshot.width < minSide || snapshot.height < minSide) {
+        ESP_LOGW(CAPTURE_TAG, "Frame too small to tile with %dx%d windows", minSide, minSide);
         return false;
     }
 
+    const size_t pixels = (size_t)snapshot.width * snapshot.height;
+    if (snapshot.format == PIXFORMAT_JPEG) {
+        if (grayscaleWorkspaceLen < 2 * kJpegGrayCropPoolBytes) {
+            ESP_LOGW(CAPTURE_TAG, "Workspace too small for the JPEG decoder (%u)", (unsigned int)grayscaleWorkspaceLen);
+            return false;
+        }
+        const uint16_t longSide = snapshot.width > snapshot.height ? snapshot.width : snapshot.height;
+        const uint16_t shortSide = snapshot.width > snapshot.height ? snapshot.height : snapshot.width;
+        uint8_t scale = 0;
+        while (scale < 3 && (longSide >> scale) > maxSide && (shortSide >> (scale + 1)) >= minSide) {
+            scale++;
+        }
+        const size_t poolOffset = (grayscaleWorkspaceLen - kJpegGrayCropPoolBytes) & ~(size_t)3;
+        JpegGrayCropResult decoded;
+        if (!decodeJpegGrayScaled(snapshot.data,
+                                  snapshot.len,
+                                  scale,
+                                  grayscaleWorkspace,
+                                  poolOffset,
+                                  grayscaleWorkspace + poolOffset,
+                                  kJpegGrayCropPoolBytes,
+                                  &decoded)) {
+            ESP_LOGE(CAPTURE_TAG, "JPEG decode failed");
+            return false;
+        }
+        *width = decoded.outputWidth;
+        *height = decoded.outputHeight;
+        return true;
+    }
+
+    if (grayscaleWorkspaceLen < pixels) {
+        ESP_LOGW(CAPTURE_TAG, "Workspace too small for a %ux%u frame", (unsigned int)snapshot.width, (unsigned int)snapshot.height);
+        return false;
+    }
+    // Raw capture sizes are capped at CAMERA_RECONFIG_MAX_RAW_FRAMESIZE, so no reduction here.
     switch (snapshot.format) {
         case PIXFORMAT_GRAYSCALE:
-            return cropCenter(snapshot.data,
-                              snapshot.width,
-                              snapshot.height,
-                              gray96Buffer,
-                              tfImageInputSize,
-                              tfImageInputSize,
-                              1);
+            memcpy(grayscaleWorkspace, snapshot.data, pixels);
+            break;
 
         case PIXFORMAT_RGB565:
-            convertRgb565ToGrayscale((const uint16_t*)snapshot.data,
-                                     grayscaleWorkspace,
-                                     snapshot.width,
-                                     snapshot.height);
-            return cropCenter(grayscaleWorkspace,
-                              snapshot.width,
-                              snapshot.height,
-                              gray96Buffer,
-                              tfImageInputSize,
-                              tfImageInputSize,
-                              1);
+            convertRgb565ToGrayscale((const uint16_t*)snapshot.data, grayscaleWorkspace, snapshot.width, snapshot.height);
+            break;
 
         case PIXFORMAT_RGB888:
-            convertRgb888ToGrayscale(snapshot.data,
-                                     grayscaleWorkspace,
-                                     snapshot.width,
-                                     snapshot.height);
-            return cropCenter(grayscaleWorkspace,
-                              snapshot.width,
-                              snapshot.height,
-                              gray96Buffer,
-                              tfImageInputSize,
-                              tfImageInputSize,
-                              1);
-
-        case PIXFORMAT_JPEG: {
-            camera_fb_t jpegFrame = {};
-            jpegFrame.buf = (uint8_t*)snapshot.data;
-            jpegFrame.len = snapshot.len;
-            jpegFrame.width = snapshot.width;
-            jpegFrame.height = snapshot.height;
-            jpegFrame.format = PIXFORMAT_JPEG;
-
-            uint8_t* decodedRgb565 = allocatingDecodeCameraJpeg(&jpegFrame,
-                                                                 MALLOC_CAP_SPIRAM,
-                                                                 JPEG_IMAGE_FORMAT_RGB565,
-                                                                 JPEG_IMAGE_SCALE_0);
-            if (!decodedRgb565) {
-                ESP_LOGE(CAPTURE_TAG, "JPEG decode failed");
-                return false;
-            }
-
-            convertRgb565ToGrayscale((const uint16_t*)decodedRgb565,
-                                     grayscaleWorkspace,
-                                     snapshot.width,
-                                     snapshot.height);
-            const bool ok = cropCenter(grayscaleWorkspace,
-                                       snapshot.width,
-                                       snapshot.height,
-                                       gray96Buffer,
-                                       tfImageInputSize,
-                                       tfImageInputSize,
-                                       1);
-            heap_caps_free(decodedRgb565);
-            return ok;
-        }
+            convertRgb888ToGrayscale(snapshot.data, grayscaleWorkspace, snapshot.width, snapshot.height);
+            break;
 
         default:
             ESP_LOGW(CAPTURE_TAG, "Unsupported pixel format %d", snapshot.format);
             return false;
     }
+    *width = snapshot.width;
+    *height = snapshot.height;
+    return true;
 }
-
-
@@ -1,6 +1,7 @@
 #pragma once
 
 #include "data-types/frame-snapshot.h"
+#include "image-editing/jpeg-decoder-context.h"
 #include <stdbool.h>
 #include <stdint.h>
 #include <esp_camera.h>
@@ -33,18 +34,45 @@ bool cropCenter(const uint8_t* src,
                 int crop_height,
                 int channels);
 
-uint8_t* allocatingDecodeCameraJpeg(camera_fb_t *fb, 
-                                    uint32_t memory_type,
-                                    esp_jpeg_image_format_t out_format,
-                                    esp_jpeg_image_scale_t scale);
+// Decodes a JPEG at 1:8 (DC coefficients only, no IDCT) into an 8-bit luma thumbnail of
+// (width / 8) x (height / 8). MCU rows are streamed straight into luma (capacityPixels pixels); decoder
+// only holds the tjpgd work area and one stripe.
+bool decodeJpegLumaThumbnail(JpegDecoderContext& decoder,
+                             const uint8_t* jpeg,
+                             size_t len,
+                             uint8_t* luma,
+                             size_t capacityPixels,
+                             uint16_t* thumbWidth,
+                             uint16_t* thumbHeight);
+
+// Reads the frame size from the JPEG SOF header. Returns false when no SOF precedes the scan data.
+bool readJpegDimensions(const uint8_t* jpeg, size_t len, uint16_t* width, uint16_t* height);
 
 void convertGrayscaleToRgb888(const uint8_t* grayscale, 
                                 uint8_t* rgb, 
                                 int width, 
                                 int height);
 
+// Workspace buildGray96Frame() needs for a width x height frame in either INFERENCE_INPUT_MODE.
+size_t gray96WorkspaceBytes(uint16_t width, uint16_t height);
+
+// Builds the tfImageInputSize^2 gray model input: a center crop, or the whole frame downscaled,
+// depending on INFERENCE_INPUT_MODE. With lut (256 entries), every pixel is stored as lut[luma] in the
+// same pass, so gray96Buffer can be a one-byte quantized input tensor (TfLiteWrapper::getModelInput()).
 bool buildGray96Frame(const FrameSnapshot& snapshot,
                       uint8_t* grayscaleWorkspace,
                       size_t grayscaleWorkspaceLen,
                       uint8_t* gray96Buffer,
-                      size_t tfImageInputSize);
\ No newline at end of file
+                      size_t tfImageInputSize,
+                      const uint8_t* lut = nullptr);
+
+// Luma frame for INFERENCE_INPUT_TILED, written to the start of grayscaleWorkspace (sized with
+// gray96WorkspaceBytes()). JPEG is decoded at the largest 1:2/1:4/1:8 reduction whose long side is
+// at most maxSide while both sides stay at least minSide; raw frames are converted at capture size.
+bool buildGrayTileFrame(const FrameSnapshot& snapshot,
+                        uint8_t* grayscaleWorkspace,
+                        size_t grayscaleWorkspaceLen,
+                        int maxSide,
+                        int minSide,
+                        uint16_t* width,
+                        uint16_t* height);
@@ -0,0 +1,185 @@
+#include "image-editing/gray-resample.h"
+#include "image-editing/pixel-kernels.h"
+#include <string.h>
+
+namespace {
+
+constexpr int kWeightBits = 8;
+constexpr int kWeightOne = 1 << kWeightBits;
+
+// Source coordinate of output pixel i in Q8, centers aligned: (i + 0.5) * src / dst - 0.5, clamped.
+inline void sourceTap(int i, int srcLen, int dstLen, uint16_t* index, uint16_t* frac)
+{
+    int32_t posQ8 = (int32_t)(((int64_t)(2 * i + 1) * srcLen * kWeightOne) / (2 * dstLen)) - kWeightOne / 2;
+    if (posQ8 < 0) {
+        posQ8 = 0;
+    }
+    const int32_t maxQ8 = (srcLen - 1) * kWeightOne;
+    if (posQ8 > maxQ8) {
+        posQ8 = maxQ8;
+    }
+    *index = (uint16_t)(posQ8 >> kWeightBits);
+    *frac = (uint16_t)(posQ8 & (kWeightOne - 1));
+}
+
+inline size_t alignUp(size_t value, size_t alignment)
+{
+    return (value + alignment - 1) & ~(alignment - 1);
+}
+
+// One output row of the bilinear resample from source rows a (weight 1 - fy) and b (weight fy).
+inline void bilinearRow(const uint8_t* a, const uint8_t* b, uint16_t fy, int srcWidth,
+                        uint16_t* row, const uint16_t* tapIndex, const uint16_t* tapFrac,
+                        uint8_t* out, int dstWidth)
+{
+    // Vertical pass over the whole source row: contiguous, 16-bit lanes (255 * 256 fits).
+    const uint16_t wa = (uint16_t)(kWeightOne - fy);
+    for (int x = 0; x < srcWidth; x++) {
+        row[x] = (uint16_t)(a[x] * wa + b[x] * fy);
+    }
+
+    // Horizontal pass: two taps per output pixel, 32-bit products, round to nearest.
+    for (int x = 0; x < dstWidth; x++) {
+        const int x0 = tapIndex[x];
+        const int x1 = (x0 + 1 < srcWidth) ? x0 + 1 : x0;
+        const uint32_t fx = tapFrac[x];
+        const uint32_t value = row[x0] * (kWeightOne - fx) + row[x1] * fx;
+        out[x] = (uint8_t)((value + (1u << (2 * kWeightBits - 1))) >> (2 * kWeightBits));
+    }
+}
+
+} // namespace
+
+void halveGray(const uint8_t* src, int srcWidth, int srcHeight, uint8_t* dst)
+{
+    const int dstWidth = srcWidth / 2;
+    const int dstHeight = srcHeight / 2;
+    for (int y = 0; y < dstHeight; y++) {
+        const uint8_t* row0 = src + (size_t)(2 * y) * srcWidth;
+        const uint8_t* row1 = row0 + srcWidth;
+        uint8_t* out = dst + (size_t)y * dstWidth;
+        for (int x = 0; x < dstWidth; x++) {
+            const uint32_t sum = (uint32_t)row0[2 * x] + row0[2 * x + 1] + row1[2 * x] + row1[2 * x + 1];
+            out[x] = (uint8_t)((sum + 2) >> 2);
+        }
+    }
+}
+
+size_t grayResizeScratchBytes(int srcWidth, int dstWidth)
+{
+    return (size_t)srcWidth * sizeof(uint16_t) + (size_t)dstWidth * 2 * sizeof(uint16_t);
+}
+
+void resizeGrayBilinear(const uint8_t* src, int srcWidth, int srcHeight,
+                        uint8_t* dst, int dstWidth, int dstHeight,
+                        void* scratch)
+{
+    uint16_t* row = (uint16_t*)scratch;             // vertically blended source row, Q8
+    uint16_t* tapIndex = row + srcWidth;
+    uint16_t* tapFrac = tapIndex + dstWidth;
+    for (int x = 0; x < dstWidth; x++) {
+        sourceTap(x, srcWidth, dstWidth, &tapIndex[x], &tapFrac[x]);
+    }
+
+    for (int y = 0; y < dstHeight; y++) {
+        uint16_t y0;
+        uint16_t fy;
+        sourceTap(y, srcHeight, dstHeight, &y0, &fy);
+        const int y1 = (y0 + 1 < srcHeight) ? y0 + 1 : y0;
+        bilinearRow(src + (size_t)y0 * srcWidth, src + (size_t)y1 * srcWidth, fy, srcWidth,
+                    row, tapIndex, tapFrac, dst + (size_t)y * dstWidth, dstWidth);
+    }
+}
+
+size_t GrayBilinearRowResizer::scratchBytes(int srcWidth, int dstWidth)
+{
+    return grayResizeScratchBytes(srcWidth, dstWidth) + alignUp((size_t)srcWidth, 2);
+}
+
+bool GrayBilinearRowResizer::begin(int srcWidth, int srcHeight,
+                                   uint8_t* dst, int dstWidth, int dstHeight,
+                                   void* scratch, size_t scratchLen,
+                                   const uint8_t* lut)
+{
+    if (!dst || !scratch || dstWidth <= 0 || dstHeight <= 0 || srcWidth < dstWidth || srcHeight < dstHeight ||
+        scratchLen < scratchBytes(srcWidth, dstWidth)) {
+        return false;
+    }
+    srcWidth_ = srcWidth;
+    srcHeight_ = srcHeight;
+    dst_ = dst;
+    dstWidth_ = dstWidth;
+    dstHeight_ = dstHeight;
+    row_ = (uint16_t*)scratch;
+    tapIndex_ = row_ + srcWidth;
+    tapFrac_ = tapIndex_ + dstWidth;
+    carry_ = (uint8_t*)(tapFrac_ + dstWidth);
+    lut_ = lut;
+    for (int x = 0; x < dstWidth; x++) {
+        sourceTap(x, srcWidth, dstWidth, &tapIndex_[x], &tapFrac_[x]);
+    }
+    nextSourceRow_ = 0;
+    nextRow_ = 0;
+    failed_ = false;
+    return true;
+}
+
+bool GrayBilinearRowResizer::pushRows(const uint8_t* rows, int top, int count)
+{
+    if (failed_ || !rows || top != nextSourceRow_ || count <= 0 || top + count > srcHeight_) {
+        failed_ = true;
+        return false;
+    }
+    const int end = top + count;
+    while (nextRow_ < dstHeight_) {
+        uint16_t y0;
+        uint16_t fy;
+        sourceTap(nextRow_, srcHeight_, dstHeight_, &y0, &fy);
+        const int y1 = (y0 + 1 < srcHeight_) ? y0 + 1 : y0;
+        if (y1 >= end) {
+            break;  // waits for the next stripe
+        }
+        // Output rows only move down, so y0 is in this stripe or is its predecessor's last row.
+        const uint8_t* a = (y0 >= top) ? rows + (size_t)(y0 - top) * srcWidth_ : carry_;
+        const uint8_t* b = (y1 >= top) ? rows + (size_t)(y1 - top) * srcWidth_ : carry_;
+        uint8_t* out = dst_ + (size_t)nextRow_ * dstWidth_;
+        bilinearRow(a, b, fy, srcWidth_, row_, tapIndex_, tapFrac_, out, dstWidth_);
+        if (lut_) {
+            mapGrayLut(out, (size_t)dstWidth_, lut_);
+        }
+        nextRow_++;
+    }
+    memcpy(carry_, rows + (size_t)(count - 1) * srcWidth_, srcWidth_);
+    nextSourceRow_ = end;
+    return true;
+}
+
+bool downscaleGray(const uint8_t* src, int srcWidth, int srcHeight,
+                   uint8_t* work, size_t workLen,
+                   uint8_t* dst, int dstWidth, int dstHeight)
+{
+    if (!src || !work || !dst || dstWidth <= 0 || dstHeight <= 0 || srcWidth < dstWidth || srcHeight < dstHeight) {
+        return false;
+    }
+
+    const uint8_t* image = src;
+    int width = srcWidth;
+    int height = srcHeight;
+    while (width >= 2 * dstWidth && height >= 2 * dstHeight) {
+        if ((size_t)(width / 2) * (height / 2) > workLen) {
+            return false;
+        }
+        halveGray(image, width, height, work);
+        image = work;
+        width /= 2;
+        height /= 2;
+    }
+
+    // The scratch goes behind the image when the image lives in work, else at its start.
+    const size_t scratchOffset = (image == work) ? alignUp((size_t)width * height, 4) : 0;
+    if (scratchOffset + grayResizeScratchBytes(width, dstWidth) > workLen) {
+        return false;
+    }
+    resizeGrayBilinear(image, width, height, dst, dstWidth, dstHeight, work + scratchOffset);
+    return true;
+}
@@ -0,0 +1,65 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+// Fixed-point downscaling of 8-bit gray images to the model input size. No allocation and no ESP-IDF
+// calls; the inner loops run over contiguous rows with 16/32-bit lanes so they vectorize on a host.
+
+// Averages 2x2 blocks into a (srcWidth / 2) x (srcHeight / 2) image, rounding to nearest; an odd last
+// row or column is dropped. dst may equal src (the write position never overtakes the reads).
+void halveGray(const uint8_t* src, int srcWidth, int srcHeight, uint8_t* dst);
+
+// Scratch bytes resizeGrayBilinear() needs: one blended source row plus the per-column taps.
+size_t grayResizeScratchBytes(int srcWidth, int dstWidth);
+
+// Bilinear resample with pixel-center alignment and 8-bit weights. Meant for ratios below 2; larger
+// reductions alias, so go through downscaleGray() which halves first. scratch must be 2-byte aligned.
+void resizeGrayBilinear(const uint8_t* src, int srcWidth, int srcHeight,
+                        uint8_t* dst, int dstWidth, int dstHeight,
+                        void* scratch);
+
+// Area-style reduction: halves while both sides stay at least twice the target, then finishes with
+// resizeGrayBilinear(). src may lie inside work (at its start) or elsewhere; halved images and the
+// bilinear scratch go to work, which must hold both. Returns false when workLen is too small.
+bool downscaleGray(const uint8_t* src, int srcWidth, int srcHeight,
+                   uint8_t* work, size_t workLen,
+                   uint8_t* dst, int dstWidth, int dstHeight);
+
+// Streaming form of resizeGrayBilinear() for a source that arrives top to bottom in row stripes
+// (decodeJpegGrayStripes). Each output row is produced as soon as the two source rows it blends have
+// arrived; only the last row of the previous stripe is carried over, so no source frame is stored.
+// Same pixels as resizeGrayBilinear().
+class GrayBilinearRowResizer
+{
+public:
+    // Scratch for begin(): the resizeGrayBilinear() scratch plus the carried row.
+    static size_t scratchBytes(int srcWidth, int dstWidth);
+
+    // scratch must be 2-byte aligned and hold scratchBytes(srcWidth, dstWidth). With lut, every
+    // output row is mapped through it as it is written (quantized model input).
+    bool begin(int srcWidth, int srcHeight,
+               uint8_t* dst, int dstWidth, int dstHeight,
+               void* scratch, size_t scratchLen,
+               const uint8_t* lut = nullptr);
+
+    // count rows of srcWidth bytes starting at source row top; stripes must arrive in order without gaps.
+    bool pushRows(const uint8_t* rows, int top, int count);
+
+    bool finished() const { return !failed_ && nextRow_ == dstHeight_; }
+
+private:
+    int srcWidth_ = 0;
+    int srcHeight_ = 0;
+    uint8_t* dst_ = nullptr;
+    int dstWidth_ = 0;
+    int dstHeight_ = 0;
+    uint16_t* row_ = nullptr;
+    uint16_t* tapIndex_ = nullptr;
+    uint16_t* tapFrac_ = nullptr;
+    uint8_t* carry_ = nullptr;
+    const uint8_t* lut_ = nullptr;
+    int nextSourceRow_ = 0;
+    int nextRow_ = 0;
+    bool failed_ = false;
+};
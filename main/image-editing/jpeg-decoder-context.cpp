@@ -0,0 +1,134 @@
+#include "image-editing/jpeg-decoder-context.h"
+#include "esp_timer.h"
+
+namespace {
+
+// esp_jpeg needs 3100 bytes with the ROM decoder; the gray-crop pool size covers that and the
+// component build, and keeps the output 4-byte aligned behind it.
+constexpr size_t kWorkAreaBytes = kJpegGrayCropPoolBytes;
+
+} // namespace
+
+JpegDecoderContext::JpegDecoderContext(PlacedBuffer placement)
+    : placement_(placement) {}
+
+JpegDecoderContext::~JpegDecoderContext()
+{
+    if (buffer_) {
+        bufferPlacement.release(placement_, buffer_, capacity_);
+    }
+}
+
+bool JpegDecoderContext::reserve(size_t outputBytes)
+{
+    const size_t previous = capacity_;
+    if (!bufferPlacement.ensureCapacity(placement_, &buffer_, &capacity_, kWorkAreaBytes + outputBytes)) {
+        return false;
+    }
+    if (capacity_ != previous) {
+        window_.growths++;
+    }
+    return true;
+}
+
+uint8_t* JpegDecoderContext::output() const
+{
+    return buffer_ + kWorkAreaBytes;
+}
+
+void* JpegDecoderContext::workArea()
+{
+    return reserve(0) ? buffer_ : nullptr;
+}
+
+size_t JpegDecoderContext::workAreaBytes() const
+{
+    return kWorkAreaBytes;
+}
+
+esp_err_t JpegDecoderContext::decode(const uint8_t* jpeg,
+                                     size_t len,
+                                     esp_jpeg_image_format_t format,
+                                     esp_jpeg_image_scale_t scale,
+                                     JpegDecodedImage* image)
+{
+    const int64_t startUs = esp_timer_get_time();
+    window_.decodes++;
+
+    esp_jpeg_image_cfg_t cfg = {};
+    cfg.indata = (uint8_t*)jpeg;
+    cfg.indata_size = len;
+    cfg.out_format = format;
+    cfg.out_scale = scale;
+
+    esp_jpeg_image_output_t info = {};
+    esp_err_t err = esp_jpeg_get_image_info(&cfg, &info);
+    if (err == ESP_OK) {
+        // Header-only parse: output_len already accounts for scale and format.
+        err = reserve(info.output_len) ? ESP_OK : ESP_ERR_NO_MEM;
+    }
+    if (err == ESP_OK) {
+        cfg.outbuf = output();
+        cfg.outbuf_size = capacity_ - kWorkAreaBytes;
+        cfg.advanced.working_buffer = buffer_;
+        cfg.advanced.working_buffer_size = kWorkAreaBytes;
+
+        esp_jpeg_image_output_t out = {};
+        err = esp_jpeg_decode(&cfg, &out);
+        if (err == ESP_OK && image) {
+            image->data = output();
+            image->len = out.output_len;
+            image->width = out.width;
+            image->height = out.height;
+        }
+    }
+
+    recordDecode(startUs, err == ESP_OK);
+    return err;
+}
+
+bool JpegDecoderContext::decodeGrayStripes(const uint8_t* jpeg,
+                                           size_t len,
+                                           esp_jpeg_image_scale_t scale,
+                                           JpegGrayStripeSink sink,
+                                           void* user,
+                                           JpegGrayCropResult* result)
+{
+    const int64_t startUs = esp_timer_get_time();
+    window_.decodes++;
+
+    esp_jpeg_image_cfg_t cfg = {};
+    cfg.indata = (uint8_t*)jpeg;
+    cfg.indata_size = len;
+    cfg.out_scale = scale;
+
+    esp_jpeg_image_output_t info = {};
+    bool ok = esp_jpeg_get_image_info(&cfg, &info) == ESP_OK;
+    const size_t stripeBytes = ok ? jpegGrayStripeBytes(info.width, (uint8_t)scale) : 0;
+    ok = ok && reserve(stripeBytes);
+    ok = ok && decodeJpegGrayStripes(jpeg, len, (uint8_t)scale, output(), stripeBytes, sink, user,
+                                     buffer_, kWorkAreaBytes, result);
+    recordDecode(startUs, ok);
+    return ok;
+}
+
+void JpegDecoderContext::recordDecode(int64_t startUs, bool ok)
+{
+    const int64_t elapsedUs = esp_timer_get_time() - startUs;
+    window_.totalUs += elapsedUs;
+    if (elapsedUs > window_.maxUs) {
+        window_.maxUs = elapsedUs;
+    }
+    if (!ok) {
+        window_.failures++;
+    }
+}
+
+void JpegDecoderContext::takeStats(JpegDecoderStats* stats)
+{
+    window_.capacityBytes = capacity_ > kWorkAreaBytes ? capacity_ - kWorkAreaBytes : 0;
+    if (stats) {
+        *stats = window_;
+    }
+    window_ = JpegDecoderStats();
+}
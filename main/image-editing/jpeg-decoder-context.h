@@ -0,0 +1,73 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include "esp_err.h"
+#include "jpeg_decoder.h"
+#include "image-editing/jpeg-gray-crop.h"
+#include "memory/buffer-placement.h"
+
+// Output of JpegDecoderContext::decode(); data stays valid until the next call on the same context.
+struct JpegDecodedImage {
+    const uint8_t* data = nullptr;
+    size_t len = 0;
+    uint16_t width = 0;
+    uint16_t height = 0;
+};
+
+// Counters since the previous takeStats().
+struct JpegDecoderStats {
+    uint32_t decodes = 0;
+    uint32_t failures = 0;
+    uint32_t growths = 0;           // buffer reallocations (frame size grew); 0 in steady state
+    int64_t totalUs = 0;
+    int64_t maxUs = 0;
+    size_t capacityBytes = 0;       // current output capacity
+};
+
+// Reusable esp_jpeg decoder state: one buffer from the placement registry holds the tjpgd work area
+// followed by the output image (or one luma stripe). decode() reads the frame header with esp_jpeg_get_image_info(), grows
+// the buffer only when the output would not fit and hands esp_jpeg the work area, so steady-state
+// decoding allocates nothing. Not thread-safe: one context per task.
+class JpegDecoderContext
+{
+public:
+    explicit JpegDecoderContext(PlacedBuffer placement);
+    ~JpegDecoderContext();
+
+    JpegDecoderContext(const JpegDecoderContext&) = delete;
+    JpegDecoderContext& operator=(const JpegDecoderContext&) = delete;
+
+    // Grows the output area to at least outputBytes ahead of the first frame.
+    bool reserve(size_t outputBytes);
+
+    esp_err_t decode(const uint8_t* jpeg,
+                     size_t len,
+                     esp_jpeg_image_format_t format,
+                     esp_jpeg_image_scale_t scale,
+                     JpegDecodedImage* image);
+
+    // Row-streaming luma decode (decodeJpegGrayStripes) with the stripe kept in this context's buffer,
+    // so it only grows with the frame width. Counted in the same stats as decode().
+    bool decodeGrayStripes(const uint8_t* jpeg,
+                           size_t len,
+                           esp_jpeg_image_scale_t scale,
+                           JpegGrayStripeSink sink,
+                           void* user,
+                           JpegGrayCropResult* result);
+
+    // tjpgd work area, for callers that drive the decoder directly (image-editing/jpeg-gray-crop.h).
+    void* workArea();
+    size_t workAreaBytes() const;
+
+    void takeStats(JpegDecoderStats* stats);
+
+private:
+    uint8_t* output() const;
+    void recordDecode(int64_t startUs, bool ok);
+
+    PlacedBuffer placement_;
+    uint8_t* buffer_ = nullptr;
+    size_t capacity_ = 0;           // whole buffer, work area included
+    JpegDecoderStats window_;
+};
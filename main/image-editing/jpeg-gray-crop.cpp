@@ -0,0 +1,267 @@
+#include "image-editing/jpeg-gray-crop.h"
+#include "image-editing/pixel-kernels.h"
+#include "sdkconfig.h"
+#include <cstring>
+
+#if CONFIG_JD_USE_ROM
+#include "rom/tjpgd.h"
+// The ROM build of tjpgd is older: both callbacks use unsigned int (see esp_jpeg's jpeg_decoder.c).
+typedef unsigned int JpegInCount;
+typedef unsigned int JpegOutResult;
+#else
+#include "tjpgd.h"
+typedef size_t JpegInCount;
+typedef int JpegOutResult;
+#endif
+
+namespace {
+
+// First member of every decode state, so the input callback can read any of them.
+struct JpegInputState {
+    const uint8_t* jpeg;
+    size_t len;
+    size_t read;
+};
+
+struct CropDecodeState {
+    JpegInputState input;
+    uint8_t* dst;
+    int cropLeft;
+    int cropTop;
+    int cropRight;      // inclusive
+    int cropBottom;     // inclusive
+    int cropWidth;
+    const uint8_t* lut;     // optional luma -> stored byte map
+    uint32_t mcus;
+    bool complete;
+};
+
+JpegInCount jpegInput(JDEC* decoder, uint8_t* buff, JpegInCount nbyte)
+{
+    JpegInputState* state = (JpegInputState*)decoder->device;
+    size_t count = nbyte;
+    if (count > state->len - state->read) {
+        count = state->len - state->read;
+    }
+    if (buff) {
+        memcpy(buff, state->jpeg + state->read, count);
+    }
+    state->read += count;
+    return (JpegInCount)count;
+}
+
+JpegOutResult cropOutput(JDEC* decoder, void* bitmap, JRECT* rect)
+{
+    CropDecodeState* state = (CropDecodeState*)decoder->device;
+    state->mcus++;
+
+    const int left = rect->left > state->cropLeft ? rect->left : state->cropLeft;
+    const int right = rect->right < state->cropRight ? rect->right : state->cropRight;
+    const int top = rect->top > state->cropTop ? rect->top : state->cropTop;
+    const int bottom = rect->bottom < state->cropBottom ? rect->bottom : state->cropBottom;
+    if (left <= right && top <= bottom) {
+        const int rectWidth = rect->right - rect->left + 1;
+        const uint8_t* rgb = (const uint8_t*)bitmap;
+        for (int y = top; y <= bottom; y++) {
+            const uint8_t* src = rgb + ((size_t)(y - rect->top) * rectWidth + (left - rect->left)) * 3;
+            uint8_t* out = state->dst + (size_t)(y - state->cropTop) * state->cropWidth + (left - state->cropLeft);
+            rgb888Via565ToGrayKernel(src, out, (size_t)(right - left + 1));
+            if (state->lut) {
+                mapGrayLut(out, (size_t)(right - left + 1), state->lut);
+            }
+        }
+    }
+
+    // MCUs arrive in raster order: the one holding the window's bottom-right pixel is the last we need.
+    if (rect->bottom >= state->cropBottom && rect->right >= state->cropRight) {
+        state->complete = true;
+        return 0;   // interrupts jd_decomp (JDR_INTR)
+    }
+    return 1;
+}
+
+// Shared by both entry points. cropWidth/cropHeight 0 select the whole (scaled) image.
+bool decodeGrayWindow(const uint8_t* jpeg,
+                      size_t len,
+                      uint8_t scale,
+                      int cropWidth,
+                      int cropHeight,
+                      uint8_t* dst,
+                      size_t dstCapacity,
+                      void* pool,
+                      size_t poolLen,
+                      const uint8_t* lut,
+                      JpegGrayCropResult* result)
+{
+    if (!jpeg || !dst || !pool || cropWidth < 0 || cropHeight < 0 || scale > 3) {
+        return false;
+    }
+
+    CropDecodeState state = {};
+    state.input.jpeg = jpeg;
+    state.input.len = len;
+    state.dst = dst;
+    state.lut = lut;
+
+    JDEC decoder;
+    if (jd_prepare(&decoder, jpegInput, pool, poolLen, &state) != JDR_OK) {
+        return false;
+    }
+    const int scaledWidth = decoder.width >> scale;
+    const int scaledHeight = decoder.height >> scale;
+    if (cropWidth == 0 || cropHeight == 0) {
+        cropWidth = scaledWidth;
+        cropHeight = scaledHeight;
+    }
+    if (cropWidth > scaledWidth || cropHeight > scaledHeight || (size_t)cropWidth * cropHeight > dstCapacity) {
+        return false;
+    }
+
+    // Same origin as cropCenter() on the full frame.
+    state.cropLeft = (scaledWidth - cropWidth) / 2;
+    state.cropTop = (scaledHeight - cropHeight) / 2;
+    state.cropRight = state.cropLeft + cropWidth - 1;
+    state.cropBottom = state.cropTop + cropHeight - 1;
+    state.cropWidth = cropWidth;
+
+    const JRESULT res = jd_decomp(&decoder, cropOutput, scale);
+    if (result) {
+        const uint32_t mcuWidth = decoder.msx * 8;
+        const uint32_t mcuHeight = decoder.msy * 8;
+        result->imageWidth = decoder.width;
+        result->imageHeight = decoder.height;
+        result->outputWidth = (uint16_t)cropWidth;
+        result->outputHeight = (uint16_t)cropHeight;
+        result->mcusDelivered = state.mcus;
+        result->mcusTotal = ((decoder.width + mcuWidth - 1) / mcuWidth) * ((decoder.height + mcuHeight - 1) / mcuHeight);
+        result->stoppedEarly = (res == JDR_INTR);
+    }
+    return state.complete && (res == JDR_OK || res == JDR_INTR);
+}
+
+struct StripeDecodeState {
+    JpegInputState input;
+    uint8_t* stripe;
+    int width;          // scaled image width, one stripe row
+    JpegGrayStripeSink sink;
+    void* user;
+    uint32_t mcus;
+    uint16_t rowsDelivered;
+    bool stopped;
+};
+
+JpegOutResult stripeOutput(JDEC* decoder, void* bitmap, JRECT* rect)
+{
+    StripeDecodeState* state = (StripeDecodeState*)decoder->device;
+    state->mcus++;
+
+    // Each MCU lands at its column in the stripe; rows are stripe-relative.
+    const int rectWidth = rect->right - rect->left + 1;
+    const int rows = rect->bottom - rect->top + 1;
+    const uint8_t* rgb = (const uint8_t*)bitmap;
+    for (int y = 0; y < rows; y++) {
+        rgb888Via565ToGrayKernel(rgb + (size_t)y * rectWidth * 3,
+                                 state->stripe + (size_t)y * state->width + rect->left,
+                                 (size_t)rectWidth);
+    }
+
+    // MCUs arrive left to right: the one reaching the right edge completes the stripe.
+    if (rect->right < state->width - 1) {
+        return 1;
+    }
+    JpegGrayStripe stripe;
+    stripe.luma = state->stripe;
+    stripe.width = (uint16_t)state->width;
+    stripe.top = (uint16_t)rect->top;
+    stripe.rows = (uint16_t)rows;
+    state->rowsDelivered = (uint16_t)(rect->bottom + 1);
+    if (!state->sink(stripe, state->user)) {
+        state->stopped = true;
+        return 0;   // interrupts jd_decomp (JDR_INTR)
+    }
+    return 1;
+}
+
+} // namespace
+
+size_t jpegGrayStripeBytes(uint16_t imageWidth, uint8_t scale)
+{
+    // Widest stripe: 16-line MCUs (4:2:0), scaled like the image.
+    return scale > 3 ? 0 : (size_t)(imageWidth >> scale) * (16 >> scale);
+}
+
+bool decodeJpegGrayStripes(const uint8_t* jpeg,
+                           size_t len,
+                           uint8_t scale,
+                           uint8_t* stripeBuffer,
+                           size_t stripeCapacity,
+                           JpegGrayStripeSink sink,
+                           void* user,
+                           void* pool,
+                           size_t poolLen,
+                           JpegGrayCropResult* result)
+{
+    if (!jpeg || !stripeBuffer || !sink || !pool || scale > 3) {
+        return false;
+    }
+
+    StripeDecodeState state = {};
+    state.input.jpeg = jpeg;
+    state.input.len = len;
+    state.stripe = stripeBuffer;
+    state.sink = sink;
+    state.user = user;
+
+    JDEC decoder;
+    if (jd_prepare(&decoder, jpegInput, pool, poolLen, &state) != JDR_OK) {
+        return false;
+    }
+    state.width = decoder.width >> scale;
+    const int stripeRows = (decoder.msy * 8) >> scale;
+    if (state.width == 0 || stripeRows == 0 || (size_t)state.width * stripeRows > stripeCapacity) {
+        return false;
+    }
+
+    const JRESULT res = jd_decomp(&decoder, stripeOutput, scale);
+    if (result) {
+        const uint32_t mcuWidth = decoder.msx * 8;
+        const uint32_t mcuHeight = decoder.msy * 8;
+        result->imageWidth = decoder.width;
+        result->imageHeight = decoder.height;
+        result->outputWidth = (uint16_t)state.width;
+        result->outputHeight = state.rowsDelivered;
+        result->mcusDelivered = state.mcus;
+        result->mcusTotal = ((decoder.width + mcuWidth - 1) / mcuWidth) * ((decoder.height + mcuHeight - 1) / mcuHeight);
+        result->stoppedEarly = state.stopped;
+    }
+    return res == JDR_OK || (res == JDR_INTR && state.stopped);
+}
+
+bool decodeJpegGrayCenterCrop(const uint8_t* jpeg,
+                              size_t len,
+                              uint8_t* dst,
+                              int cropWidth,
+                              int cropHeight,
+                              void* pool,
+                              size_t poolLen,
+                              JpegGrayCropResult* result,
+                              const uint8_t* lut)
+{
+    if (cropWidth <= 0 || cropHeight <= 0) {
+        return false;
+    }
+    return decodeGrayWindow(jpeg, len, 0, cropWidth, cropHeight, dst,
+                            (size_t)cropWidth * cropHeight, pool, poolLen, lut, result);
+}
+
+bool decodeJpegGrayScaled(const uint8_t* jpeg,
+                          size_t len,
+                          uint8_t scale,
+                          uint8_t* dst,
+                          size_t dstCapacity,
+                          void* pool,
+                          size_t poolLen,
+                          JpegGrayCropResult* result)
+{
+    return decodeGrayWindow(jpeg, len, scale, 0, 0, dst, dstCapacity, pool, poolLen, nullptr, result);
+}
@@ -0,0 +1,78 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+// tjpgd work area: the ROM decoder needs 3100 bytes (esp_jpeg's JPEG_WORK_BUF_SIZE), the component
+// build with JD_FASTDECODE 1 a little more for its Huffman lookup tables.
+constexpr size_t kJpegGrayCropPoolBytes = 4096;
+
+// Where the fused decode stopped, for the caller's logs.
+struct JpegGrayCropResult {
+    uint16_t imageWidth = 0;
+    uint16_t imageHeight = 0;
+    uint16_t outputWidth = 0;       // pixels written per row / rows written
+    uint16_t outputHeight = 0;
+    uint32_t mcusDelivered = 0;     // MCU blocks handed to the output callback before the decode stopped
+    uint32_t mcusTotal = 0;
+    bool stoppedEarly = false;      // decode interrupted: crop complete or stripe sink returned false
+};
+
+// Decodes the centered cropWidth x cropHeight window of a baseline JPEG straight into an 8-bit luma
+// buffer (cropWidth * cropHeight bytes), without an intermediate full-frame RGB buffer. Pixels match
+// the older decode-to-RGB565, convert-to-gray, crop path bit for bit. MCUs outside the window are still
+// entropy-decoded (the bitstream is sequential) but not converted, and the decode stops after the last
+// MCU that overlaps the window. pool is the decoder's work area (at least kJpegGrayCropPoolBytes);
+// nothing is allocated. With lut, each row is mapped through it right after conversion, so dst can be
+// a quantized model input tensor.
+bool decodeJpegGrayCenterCrop(const uint8_t* jpeg,
+                              size_t len,
+                              uint8_t* dst,
+                              int cropWidth,
+                              int cropHeight,
+                              void* pool,
+                              size_t poolLen,
+                              JpegGrayCropResult* result,
+                              const uint8_t* lut = nullptr);
+
+// Decodes the whole frame at 1 / 2^scale (scale 0..3, the JPEG_IMAGE_SCALE_* order; tjpgd then skips
+// part of the IDCT) into an 8-bit luma image of (width >> scale) x (height >> scale), reported in
+// result. Same conversion and pool rules as above; dstCapacity is checked before decoding.
+bool decodeJpegGrayScaled(const uint8_t* jpeg,
+                          size_t len,
+                          uint8_t scale,
+                          uint8_t* dst,
+                          size_t dstCapacity,
+                          void* pool,
+                          size_t poolLen,
+                          JpegGrayCropResult* result);
+
+// One MCU row of luma: rows x width pixels, image rows [top, top + rows), width bytes per row. Only
+// valid inside the sink call; the next stripe overwrites it.
+struct JpegGrayStripe {
+    const uint8_t* luma;
+    uint16_t width;
+    uint16_t top;
+    uint16_t rows;
+};
+
+// Called once per completed MCU row, top to bottom. Return false to stop the decode there.
+typedef bool (*JpegGrayStripeSink)(const JpegGrayStripe& stripe, void* user);
+
+// Stripe buffer size that fits any baseline JPEG imageWidth pixels wide at 1 / 2^scale.
+size_t jpegGrayStripeBytes(uint16_t imageWidth, uint8_t scale);
+
+// Streams the frame at 1 / 2^scale to sink one MCU row at a time. Each MCU is converted to luma (same
+// pixels as decodeJpegGrayScaled) into stripeBuffer while it is still hot, so scratch memory is one
+// stripe (at most jpegGrayStripeBytes) instead of a frame. result->outputHeight counts the rows handed
+// to sink. True when the whole frame was delivered or sink stopped it.
+bool decodeJpegGrayStripes(const uint8_t* jpeg,
+                           size_t len,
+                           uint8_t scale,
+                           uint8_t* stripeBuffer,
+                           size_t stripeCapacity,
+                           JpegGrayStripeSink sink,
+                           void* user,
+                           void* pool,
+                           size_t poolLen,
+                           JpegGrayCropResult* result);
@@ -0,0 +1,137 @@
+#include "image-editing/pixel-kernels.h"
+#include <cstring>
+
+#pragma region REFERENCE_KERNELS
+
+void referenceRgb565ToGray(const uint16_t* rgb565, uint8_t* gray, size_t pixels)
+{
+    for (size_t i = 0; i < pixels; ++i) {
+        uint16_t pix = rgb565[i];
+        uint8_t r = ((pix >> 11) & 0x1F) * 255 / 31;
+        uint8_t g = ((pix >> 5) & 0x3F) * 255 / 63;
+        uint8_t b = (pix & 0x1F) * 255 / 31;
+        gray[i] = (r * 30 + g * 59 + b * 11 + 50) / 100;
+    }
+}
+
+void referenceRgb888ToGray(const uint8_t* rgb, uint8_t* gray, size_t pixels)
+{
+    for (size_t i = 0; i < pixels; ++i) {
+        uint8_t r = rgb[i * 3];
+        uint8_t g = rgb[i * 3 + 1];
+        uint8_t b = rgb[i * 3 + 2];
+        gray[i] = (r * 30 + g * 59 + b * 11) / 100;
+    }
+}
+
+void referenceRgb888Via565ToGray(const uint8_t* rgb, uint8_t* gray, size_t pixels)
+{
+    for (size_t i = 0; i < pixels; ++i) {
+        const uint16_t pix = ((rgb[i * 3] & 0xF8) << 8) | ((rgb[i * 3 + 1] & 0xFC) << 3) | (rgb[i * 3 + 2] >> 3);
+        referenceRgb565ToGray(&pix, &gray[i], 1);
+    }
+}
+
+void referenceGrayToRgb888(const uint8_t* gray, uint8_t* rgb, size_t pixels)
+{
+    for (size_t i = 0; i < pixels; ++i) {
+        uint8_t val = gray[i];
+        rgb[i * 3 + 0] = val;
+        rgb[i * 3 + 1] = val;
+        rgb[i * 3 + 2] = val;
+    }
+}
+
+void referenceResizeRgb888Nearest(const uint8_t* src, int inWidth, int inHeight,
+                                  uint8_t* dst, int outWidth, int outHeight)
+{
+    for (int y = 0; y < outHeight; y++) {
+        int srcY = y * inHeight / outHeight;
+        for (int x = 0; x < outWidth; x++) {
+            int srcX = x * inWidth / outWidth;
+            for (int c = 0; c < 3; c++) {
+                dst[(y * outWidth + x) * 3 + c] = src[(srcY * inWidth + srcX) * 3 + c];
+            }
+        }
+    }
+}
+
+#pragma endregion
+
+#pragma region FIXED_POINT_KERNELS
+// Per-pixel arithmetic lives in pixel-kernels.h (fixedRgb565Luma / fixedRgb888Luma) so the fused
+// preprocessing templates share it; these loops only apply it over contiguous runs.
+
+void fixedRgb565ToGray(const uint16_t* __restrict rgb565, uint8_t* __restrict gray, size_t pixels)
+{
+    for (size_t i = 0; i < pixels; ++i) {
+        gray[i] = fixedRgb565Luma(rgb565[i]);
+    }
+}
+
+void fixedRgb888ToGray(const uint8_t* __restrict rgb, uint8_t* __restrict gray, size_t pixels)
+{
+    for (size_t i = 0; i < pixels; ++i) {
+        gray[i] = fixedRgb888Luma(rgb[i * 3], rgb[i * 3 + 1], rgb[i * 3 + 2]);
+    }
+}
+
+void fixedRgb888Via565ToGray(const uint8_t* __restrict rgb, uint8_t* __restrict gray, size_t pixels)
+{
+    for (size_t i = 0; i < pixels; ++i) {
+        const uint16_t pix = (uint16_t)(((rgb[i * 3] >> 3) << 11) | ((rgb[i * 3 + 1] >> 2) << 5) | (rgb[i * 3 + 2] >> 3));
+        gray[i] = fixedRgb565Luma(pix);
+    }
+}
+
+void fixedGrayToRgb888(const uint8_t* __restrict gray, uint8_t* __restrict rgb, size_t pixels)
+{
+    // Already division-free; restrict lets the compiler use interleaving stores where it has them.
+    for (size_t i = 0; i < pixels; ++i) {
+        const uint8_t val = gray[i];
+        rgb[i * 3 + 0] = val;
+        rgb[i * 3 + 1] = val;
+        rgb[i * 3 + 2] = val;
+    }
+}
+
+void fixedResizeRgb888Nearest(const uint8_t* __restrict src, int inWidth, int inHeight,
+                              uint8_t* __restrict dst, int outWidth, int outHeight)
+{
+    // Source coordinates advance with an integer accumulator (same floor(x * in / out) as the
+    // reference, without a division per pixel), and an output row that maps to the same source row
+    // as the previous one is copied instead of resampled.
+    const size_t outRowBytes = (size_t)outWidth * 3;
+    int srcY = 0;
+    int remY = 0;
+    int previousSrcY = -1;
+    for (int y = 0; y < outHeight; y++) {
+        uint8_t* dstRow = dst + (size_t)y * outRowBytes;
+        if (srcY == previousSrcY) {
+            memcpy(dstRow, dstRow - outRowBytes, outRowBytes);
+        } else {
+            const uint8_t* srcRow = src + (size_t)srcY * inWidth * 3;
+            int srcX = 0;
+            int remX = 0;
+            for (int x = 0; x < outWidth; x++) {
+                const uint8_t* px = srcRow + srcX * 3;
+                dstRow[x * 3 + 0] = px[0];
+                dstRow[x * 3 + 1] = px[1];
+                dstRow[x * 3 + 2] = px[2];
+                remX += inWidth;
+                while (remX >= outWidth) {
+                    remX -= outWidth;
+                    srcX++;
+                }
+            }
+            previousSrcY = srcY;
+        }
+        remY += inHeight;
+        while (remY >= outHeight) {
+            remY -= outHeight;
+            srcY++;
+        }
+    }
+}
+
+#pragma endregion
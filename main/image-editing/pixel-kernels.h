@@ -0,0 +1,82 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include "define.h"
+
+// Pixel conversion kernels behind image-editing/editing.h. Two implementations exist and are selected
+// at build time with PIXEL_KERNELS_REFERENCE:
+//  - reference*: the original per-pixel loops (integer divisions per channel and per pixel),
+//  - fixed*:     division-free fixed-point versions that produce the same bytes for every input.
+// No ESP-IDF dependencies, so both sets compile on a host and can be compared directly.
+
+// Exact division-free forms of the reference arithmetic (checked exhaustively in host/tests/pixel-kernels-test.cpp):
+//   v5 * 255 / 31  == (v5 * 1053) >> 7        v5 in [0, 31]
+//   v6 * 255 / 63  == (v6 * 4145) >> 10       v6 in [0, 63]
+//   s / 100        == (s * 5243) >> 19        s  in [0, 25550]
+// These have no divisions, tables or data-dependent branches, so loops over them also vectorize where
+// possible.
+constexpr uint32_t kExpand5Mul = 1053;
+constexpr uint32_t kExpand5Shift = 7;
+constexpr uint32_t kExpand6Mul = 4145;
+constexpr uint32_t kExpand6Shift = 10;
+constexpr uint32_t kDiv100Mul = 5243;
+constexpr uint32_t kDiv100Shift = 19;
+
+inline uint8_t fixedRgb565Luma(uint16_t pix)
+{
+    const uint32_t r = (((uint32_t)(pix >> 11) & 0x1F) * kExpand5Mul) >> kExpand5Shift;
+    const uint32_t g = (((uint32_t)(pix >> 5) & 0x3F) * kExpand6Mul) >> kExpand6Shift;
+    const uint32_t b = (((uint32_t)pix & 0x1F) * kExpand5Mul) >> kExpand5Shift;
+    return (uint8_t)(((r * 30 + g * 59 + b * 11 + 50) * kDiv100Mul) >> kDiv100Shift);
+}
+
+inline uint8_t fixedRgb888Luma(uint32_t r, uint32_t g, uint32_t b)
+{
+    return (uint8_t)(((r * 30 + g * 59 + b * 11) * kDiv100Mul) >> kDiv100Shift);
+}
+
+// In-place byte table lookup, e.g. luma -> quantized model input (LutTensor in preprocess-pipeline.h).
+inline void mapGrayLut(uint8_t* pixels, size_t count, const uint8_t* lut)
+{
+    for (size_t i = 0; i < count; i++) {
+        pixels[i] = lut[pixels[i]];
+    }
+}
+
+void referenceRgb565ToGray(const uint16_t* rgb565, uint8_t* gray, size_t pixels);
+void referenceRgb888ToGray(const uint8_t* rgb, uint8_t* gray, size_t pixels);
+// RGB888 truncated to RGB565 first (as esp_jpeg does for RGB565 output), then the RGB565 luma.
+void referenceRgb888Via565ToGray(const uint8_t* rgb, uint8_t* gray, size_t pixels);
+void referenceGrayToRgb888(const uint8_t* gray, uint8_t* rgb, size_t pixels);
+void referenceResizeRgb888Nearest(const uint8_t* src, int inWidth, int inHeight,
+                                  uint8_t* dst, int outWidth, int outHeight);
+
+void fixedRgb565ToGray(const uint16_t* rgb565, uint8_t* gray, size_t pixels);
+void fixedRgb888ToGray(const uint8_t* rgb, uint8_t* gray, size_t pixels);
+void fixedRgb888Via565ToGray(const uint8_t* rgb, uint8_t* gray, size_t pixels);
+void fixedGrayToRgb888(const uint8_t* gray, uint8_t* rgb, size_t pixels);
+void fixedResizeRgb888Nearest(const uint8_t* src, int inWidth, int inHeight,
+                              uint8_t* dst, int outWidth, int outHeight);
+
+#if PIXEL_KERNELS_REFERENCE
+inline const char* pixelKernelsName() { return "reference"; }
+inline void rgb565ToGrayKernel(const uint16_t* s, uint8_t* d, size_t n) { referenceRgb565ToGray(s, d, n); }
+inline void rgb888ToGrayKernel(const uint8_t* s, uint8_t* d, size_t n) { referenceRgb888ToGray(s, d, n); }
+inline void rgb888Via565ToGrayKernel(const uint8_t* s, uint8_t* d, size_t n) { referenceRgb888Via565ToGray(s, d, n); }
+inline void grayToRgb888Kernel(const uint8_t* s, uint8_t* d, size_t n) { referenceGrayToRgb888(s, d, n); }
+inline void resizeRgb888NearestKernel(const uint8_t* s, int iw, int ih, uint8_t* d, int ow, int oh)
+{
+    referenceResizeRgb888Nearest(s, iw, ih, d, ow, oh);
+}
+#else
+inline const char* pixelKernelsName() { return "fixed-point"; }
+inline void rgb565ToGrayKernel(const uint16_t* s, uint8_t* d, size_t n) { fixedRgb565ToGray(s, d, n); }
+inline void rgb888ToGrayKernel(const uint8_t* s, uint8_t* d, size_t n) { fixedRgb888ToGray(s, d, n); }
+inline void rgb888Via565ToGrayKernel(const uint8_t* s, uint8_t* d, size_t n) { fixedRgb888Via565ToGray(s, d, n); }
+inline void grayToRgb888Kernel(const uint8_t* s, uint8_t* d, size_t n) { fixedGrayToRgb888(s, d, n); }
+inline void resizeRgb888NearestKernel(const uint8_t* s, int iw, int ih, uint8_t* d, int ow, int oh)
+{
+    fixedResizeRgb888Nearest(s, iw, ih, d, ow, oh);
+}
+#endif
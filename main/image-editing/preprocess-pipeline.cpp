@@ -0,0 +1,15 @@
+#include "image-editing/preprocess-pipeline.h"
+
+// Combinations buildGray96Frame() dispatches to; everything else stays header-only.
+template bool preprocessFrame<Gray8Source, CenterCropGeometry, Uint8Tensor>(const uint8_t*, int, int, uint8_t*, int, int, const Uint8Tensor&);
+template bool preprocessFrame<Rgb565Source, CenterCropGeometry, Uint8Tensor>(const uint8_t*, int, int, uint8_t*, int, int, const Uint8Tensor&);
+template bool preprocessFrame<Rgb888Source, CenterCropGeometry, Uint8Tensor>(const uint8_t*, int, int, uint8_t*, int, int, const Uint8Tensor&);
+template bool preprocessFrame<Gray8Source, CenterCropGeometry, LutTensor>(const uint8_t*, int, int, uint8_t*, int, int, const LutTensor&);
+template bool preprocessFrame<Rgb565Source, CenterCropGeometry, LutTensor>(const uint8_t*, int, int, uint8_t*, int, int, const LutTensor&);
+template bool preprocessFrame<Rgb888Source, CenterCropGeometry, LutTensor>(const uint8_t*, int, int, uint8_t*, int, int, const LutTensor&);
+template bool preprocessFrame<Gray8Source, AreaResizeGeometry, Uint8Tensor>(const uint8_t*, int, int, uint8_t*, int, int, const Uint8Tensor&);
+template bool preprocessFrame<Rgb565Source, AreaResizeGeometry, Uint8Tensor>(const uint8_t*, int, int, uint8_t*, int, int, const Uint8Tensor&);
+template bool preprocessFrame<Rgb888Source, AreaResizeGeometry, Uint8Tensor>(const uint8_t*, int, int, uint8_t*, int, int, const Uint8Tensor&);
+template bool preprocessFrame<Gray8Source, AreaResizeGeometry, LutTensor>(const uint8_t*, int, int, uint8_t*, int, int, const LutTensor&);
+template bool preprocessFrame<Rgb565Source, AreaResizeGeometry, LutTensor>(const uint8_t*, int, int, uint8_t*, int, int, const LutTensor&);
+template bool preprocessFrame<Rgb888Source, AreaResizeGeometry, LutTensor>(const uint8_t*, int, int, uint8_t*, int, int, const LutTensor&);
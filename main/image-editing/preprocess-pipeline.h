@@ -0,0 +1,202 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+#include "image-editing/pixel-kernels.h"
+
+// Fused frame -> model input preprocessing. preprocessFrame<Source, Geometry, Destination> compiles to
+// one loop per combination: each output pixel is read from the raw frame, converted to luma and
+// encoded for the tensor in place, with no intermediate full-frame buffer and no per-pixel dispatch.
+// The combinations the firmware calls are instantiated once in preprocess-pipeline.cpp (see the
+// extern template list at the end); other combinations (host benchmarks) instantiate from here.
+// No ESP-IDF dependencies.
+
+#pragma region SOURCE_FORMATS
+// Source pixel formats: bytes per pixel and the luma of one pixel, bit-identical to pixel-kernels.
+
+struct Gray8Source {
+    static constexpr int kBytesPerPixel = 1;
+    static constexpr bool kIsLuma = true;      // pixels are stored as luma already
+    static inline uint8_t luma(const uint8_t* px) { return px[0]; }
+};
+
+struct Rgb565Source {
+    static constexpr int kBytesPerPixel = 2;
+    static constexpr bool kIsLuma = false;
+    static inline uint8_t luma(const uint8_t* px)
+    {
+        uint16_t pix;
+        memcpy(&pix, px, sizeof(pix));  // camera buffers are little-endian uint16
+        return fixedRgb565Luma(pix);
+    }
+};
+
+struct Rgb888Source {
+    static constexpr int kBytesPerPixel = 3;
+    static constexpr bool kIsLuma = false;
+    static inline uint8_t luma(const uint8_t* px) { return fixedRgb888Luma(px[0], px[1], px[2]); }
+};
+
+#pragma endregion
+
+#pragma region DESTINATION_TYPES
+// Tensor element encodings. encode() is called through the destination object, so a destination may
+// carry state (LutTensor); the stateless ones keep it static.
+
+struct Uint8Tensor {
+    typedef uint8_t Element;
+    static constexpr bool kIsLuma = true;      // stores luma bytes unchanged
+    static inline uint8_t encode(uint8_t luma) { return luma; }
+};
+
+// Fixed symmetric mapping; LutTensor applies a model's real scale and zero point.
+struct Int8Tensor {
+    typedef int8_t Element;
+    static constexpr bool kIsLuma = false;
+    static inline int8_t encode(uint8_t luma) { return (int8_t)((int)luma - 128); }
+};
+
+struct Float32Tensor {
+    typedef float Element;
+    static constexpr bool kIsLuma = false;
+    static inline float encode(uint8_t luma)
+    {
+        return TF_INPUT_REAL_MIN + luma * ((TF_INPUT_REAL_MAX - TF_INPUT_REAL_MIN) / 255.0f);
+    }
+};
+
+// One-byte tensor (uint8 or int8 bit patterns) through a 256-entry luma -> stored value table, which
+// folds the model's real input scale and zero point into the store (tf-lite/input-quantization.h).
+struct LutTensor {
+    typedef uint8_t Element;
+    static constexpr bool kIsLuma = false;
+    const uint8_t* table;
+    inline uint8_t encode(uint8_t luma) const { return table[luma]; }
+};
+
+#pragma endregion
+
+#pragma region GEOMETRY_POLICIES
+
+// Centered dstWidth x dstHeight window, same origin as cropCenter().
+struct CenterCropGeometry {
+    template <class Source, class Destination>
+    static bool run(const uint8_t* src, int srcWidth, int srcHeight,
+                    typename Destination::Element* dst, int dstWidth, int dstHeight,
+                    const Destination& destination)
+    {
+        if (dstWidth > srcWidth || dstHeight > srcHeight) {
+            return false;
+        }
+        const int left = (srcWidth - dstWidth) / 2;
+        const int top = (srcHeight - dstHeight) / 2;
+        const size_t stride = (size_t)srcWidth * Source::kBytesPerPixel;
+        for (int y = 0; y < dstHeight; y++) {
+            const uint8_t* row = src + (size_t)(top + y) * stride + (size_t)left * Source::kBytesPerPixel;
+            typename Destination::Element* out = dst + (size_t)y * dstWidth;
+            if (Source::kIsLuma && Destination::kIsLuma) {
+                memcpy(out, row, dstWidth);     // constant per instantiation, folded away
+                continue;
+            }
+            for (int x = 0; x < dstWidth; x++) {
+                out[x] = destination.encode(Source::luma(row + x * Source::kBytesPerPixel));
+            }
+        }
+        return true;
+    }
+};
+
+// Whole frame squeezed into dstWidth x dstHeight: every output pixel is the rounded mean luma of its
+// source rectangle [x * srcWidth / dstWidth, (x + 1) * srcWidth / dstWidth) (same for rows), so every
+// source pixel is read exactly once and nothing aliases at any reduction ratio. Column sums for one
+// output row live on the stack, which bounds dstWidth to kMaxWidth.
+struct AreaResizeGeometry {
+    static constexpr int kMaxWidth = 256;
+
+    template <class Source, class Destination>
+    static bool run(const uint8_t* src, int srcWidth, int srcHeight,
+                    typename Destination::Element* dst, int dstWidth, int dstHeight,
+                    const Destination& destination)
+    {
+        if (dstWidth > srcWidth || dstHeight > srcHeight || dstWidth <= 0 || dstHeight <= 0 || dstWidth > kMaxWidth) {
+            return false;
+        }
+
+        // Column spans [spanEnd[x - 1], spanEnd[x]) from an accumulator instead of a division per column.
+        uint16_t spanEnd[kMaxWidth];
+        uint32_t columnSum[kMaxWidth];
+        int end = 0;
+        int rem = 0;
+        for (int x = 0; x < dstWidth; x++) {
+            rem += srcWidth;
+            while (rem >= dstWidth) {
+                rem -= dstWidth;
+                end++;
+            }
+            spanEnd[x] = (uint16_t)end;
+        }
+
+        const size_t stride = (size_t)srcWidth * Source::kBytesPerPixel;
+        int y0 = 0;
+        int remY = 0;
+        for (int y = 0; y < dstHeight; y++) {
+            int y1 = y0;
+            remY += srcHeight;
+            while (remY >= dstHeight) {
+                remY -= dstHeight;
+                y1++;
+            }
+
+            memset(columnSum, 0, sizeof(columnSum[0]) * dstWidth);
+            for (int sy = y0; sy < y1; sy++) {
+                const uint8_t* row = src + (size_t)sy * stride;
+                int sx = 0;
+                for (int x = 0; x < dstWidth; x++) {
+                    uint32_t sum = 0;
+                    for (; sx < spanEnd[x]; sx++) {
+                        sum += Source::luma(row + sx * Source::kBytesPerPixel);
+                    }
+                    columnSum[x] += sum;
+                }
+            }
+
+            typename Destination::Element* out = dst + (size_t)y * dstWidth;
+            int x0 = 0;
+            for (int x = 0; x < dstWidth; x++) {
+                const uint32_t count = (uint32_t)(spanEnd[x] - x0) * (uint32_t)(y1 - y0);
+                out[x] = destination.encode((uint8_t)((columnSum[x] + count / 2) / count));
+                x0 = spanEnd[x];
+            }
+            y0 = y1;
+        }
+        return true;
+    }
+};
+
+#pragma endregion
+
+template <class Source, class Geometry, class Destination>
+bool preprocessFrame(const uint8_t* src, int srcWidth, int srcHeight,
+                     typename Destination::Element* dst, int dstWidth, int dstHeight,
+                     const Destination& destination = Destination())
+{
+    if (!src || !dst) {
+        return false;
+    }
+    return Geometry::template run<Source, Destination>(src, srcWidth, srcHeight, dst, dstWidth, dstHeight, destination);
+}
+
+// Instantiated in preprocess-pipeline.cpp for buildGray96Frame().
+extern template bool preprocessFrame<Gray8Source, CenterCropGeometry, Uint8Tensor>(const uint8_t*, int, int, uint8_t*, int, int, const Uint8Tensor&);
+extern template bool preprocessFrame<Rgb565Source, CenterCropGeometry, Uint8Tensor>(const uint8_t*, int, int, uint8_t*, int, int, const Uint8Tensor&);
+extern template bool preprocessFrame<Rgb888Source, CenterCropGeometry, Uint8Tensor>(const uint8_t*, int, int, uint8_t*, int, int, const Uint8Tensor&);
+extern template bool preprocessFrame<Gray8Source, CenterCropGeometry, LutTensor>(const uint8_t*, int, int, uint8_t*, int, int, const LutTensor&);
+extern template bool preprocessFrame<Rgb565Source, CenterCropGeometry, LutTensor>(const uint8_t*, int, int, uint8_t*, int, int, const LutTensor&);
+extern template bool preprocessFrame<Rgb888Source, CenterCropGeometry, LutTensor>(const uint8_t*, int, int, uint8_t*, int, int, const LutTensor&);
+extern template bool preprocessFrame<Gray8Source, AreaResizeGeometry, Uint8Tensor>(const uint8_t*, int, int, uint8_t*, int, int, const Uint8Tensor&);
+extern template bool preprocessFrame<Rgb565Source, AreaResizeGeometry, Uint8Tensor>(const uint8_t*, int, int, uint8_t*, int, int, const Uint8Tensor&);
+extern template bool preprocessFrame<Rgb888Source, AreaResizeGeometry, Uint8Tensor>(const uint8_t*, int, int, uint8_t*, int, int, const Uint8Tensor&);
+extern template bool preprocessFrame<Gray8Source, AreaResizeGeometry, LutTensor>(const uint8_t*, int, int, uint8_t*, int, int, const LutTensor&);
+extern template bool preprocessFrame<Rgb565Source, AreaResizeGeometry, LutTensor>(const uint8_t*, int, int, uint8_t*, int, int, const LutTensor&);
+extern template bool preprocessFrame<Rgb888Source, AreaResizeGeometry, LutTensor>(const uint8_t*, int, int, uint8_t*, int, int, const LutTensor&);
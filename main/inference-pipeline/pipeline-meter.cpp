@@ -0,0 +1,51 @@
+#include "inference-pipeline/pipeline-meter.h"
+
+void PipelineMeter::record(const PipelineSample& sample)
+{
+    if (windowStartUs_ < 0) {
+        windowStartUs_ = sample.preprocessStartUs;
+    }
+    frames_++;
+    preprocessUs_ += sample.queuedUs - sample.preprocessStartUs;
+    queueUs_ += sample.invokeStartUs - sample.queuedUs;
+    invokeUs_ += sample.doneUs - sample.invokeStartUs;
+    const int64_t latencyUs = sample.doneUs - sample.captureUs;
+    latencyUs_ += latencyUs;
+    if (latencyUs > maxLatencyUs_) {
+        maxLatencyUs_ = latencyUs;
+    }
+}
+
+void PipelineMeter::takeStats(PipelineStats* stats, int64_t nowUs)
+{
+    PipelineStats window;
+    window.frames = frames_;
+    const int64_t elapsedUs = windowStartUs_ >= 0 ? nowUs - windowStartUs_ : 0;
+    if (frames_ > 0) {
+        window.meanPreprocessUs = (float)preprocessUs_ / frames_;
+        window.meanQueueUs = (float)queueUs_ / frames_;
+        window.meanInvokeUs = (float)invokeUs_ / frames_;
+        window.meanLatencyUs = (float)latencyUs_ / frames_;
+        window.maxLatencyUs = maxLatencyUs_;
+
+        const float sequentialUs = window.meanPreprocessUs + window.meanInvokeUs;
+        const float slowerStageUs = window.meanPreprocessUs > window.meanInvokeUs ? window.meanPreprocessUs : window.meanInvokeUs;
+        window.sequentialLimitFps = sequentialUs > 0.0f ? 1.0e6f / sequentialUs : 0.0f;
+        window.pipelinedLimitFps = slowerStageUs > 0.0f ? 1.0e6f / slowerStageUs : 0.0f;
+    }
+    if (elapsedUs > 0) {
+        window.framesPerSecond = frames_ * (1.0e6f / (float)elapsedUs);
+        window.busyCores = (float)(preprocessUs_ + invokeUs_) / (float)elapsedUs;
+    }
+    if (stats) {
+        *stats = window;
+    }
+
+    frames_ = 0;
+    preprocessUs_ = 0;
+    queueUs_ = 0;
+    invokeUs_ = 0;
+    latencyUs_ = 0;
+    maxLatencyUs_ = 0;
+    windowStartUs_ = nowUs;
+}
@@ -0,0 +1,49 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+// Timestamps of one frame through the two inference stages (esp_timer microseconds).
+struct PipelineSample {
+    int64_t captureUs = 0;          // camera capture of the frame
+    int64_t preprocessStartUs = 0;  // preprocessing stage picked it up
+    int64_t queuedUs = 0;           // input published to the stage queue
+    int64_t invokeStartUs = 0;      // invoke stage took it from the queue
+    int64_t doneUs = 0;             // result available
+};
+
+struct PipelineStats {
+    uint32_t frames = 0;
+    float framesPerSecond = 0.0f;       // results per second of the stats window
+    float meanPreprocessUs = 0.0f;
+    float meanQueueUs = 0.0f;           // ready input waiting for the invoke stage
+    float meanInvokeUs = 0.0f;          // input encode + Invoke() + result
+    float meanLatencyUs = 0.0f;         // capture to result
+    int64_t maxLatencyUs = 0;
+    // What the same stage times allow: one task doing both stages back to back, and two overlapped
+    // stages, which are bounded by the slower one. framesPerSecond approaches the second only while the
+    // camera delivers faster than the slower stage.
+    float sequentialLimitFps = 0.0f;
+    float pipelinedLimitFps = 0.0f;
+    float busyCores = 0.0f;             // stage time summed over the window length; above 1 means overlap
+};
+
+// Collects PipelineSamples on the invoke stage and turns a window of them into PipelineStats. Not
+// thread-safe (one recording task); no ESP-IDF calls, so it runs in the host pthread build as well.
+class PipelineMeter
+{
+public:
+    void record(const PipelineSample& sample);
+
+    // Fills stats for the window since the previous call and starts a new one.
+    void takeStats(PipelineStats* stats, int64_t nowUs);
+
+private:
+    uint32_t frames_ = 0;
+    int64_t preprocessUs_ = 0;
+    int64_t queueUs_ = 0;
+    int64_t invokeUs_ = 0;
+    int64_t latencyUs_ = 0;
+    int64_t maxLatencyUs_ = 0;
+    int64_t windowStartUs_ = -1;
+};
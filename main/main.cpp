@@ -7,6 +7,7 @@
 #include "tf-lite/tf-lite.h"
 #include "tflite-person-detect/person_detect_model_data.h"
 #include "image-editing/editing.h"
+#include "image-editing/pixel-kernels.h"
 #include "led/rgb-led.h"
 #include "led/red-led.h"
 #include "app-globals.h"
@@ -16,7 +17,13 @@
 #include "util/misc.h"
 #include "define.h"
 #include "data-types/frame-mailbox.h"
+#include "data-types/frame-pool.h"
+#include "clip-recorder/pre-event-ring.h"
+#include "frame-source/injected-frame-store.h"
+#include "memory/buffer-placement.h"
 #include "http-server/http-frame-buffer.h"
+#include "model-store/model-store.h"
+#include "model-store/partition-model-storage.h"
 #include <stdio.h>
 #include <cstring>
 #include <freertos/FreeRTOS.h>
@@ -45,13 +52,24 @@ static WifiManager wifi;
 RgbLedController rgb(GPIO_NUM_48, RMT_CHANNEL_0); // 8 LEDs on GPIO48
 RedLedController redLed = RedLedController();
 static TfLiteWrapper tf_wrapper;
+#if ENABLE_INFERENCE && ENABLE_MODEL_PARTITION
+    static PartitionModelStorage modelPartition;
+    static ModelStore modelStore(modelPartition);
+#endif
 
 CheckpointTimer jpegTimer;
 CheckpointTimer cameraAcquisitionTimer;
 CheckpointTimer tensorFlowTimer;
 CheckpointTimer httpTimer;
 
-HttpFrameBuffer httpFrameBuffer(kPublishedFrameMaxBytes);
+BufferPlacement bufferPlacement(kBufferPlacementPolicies,
+                                sizeof(kBufferPlacementPolicies) / sizeof(kBufferPlacementPolicies[0]));
+FramePool framePool(kFramePoolClasses,
+                    sizeof(kFramePoolClasses) / sizeof(kFramePoolClasses[0]),
+                    kFramePoolOversizePolicy);
+HttpFrameBuffer httpFrameBuffer(&framePool);
+PreEventRing preEventRing;
+InjectedFrameStore injectedFrameStore(FRAME_INJECT_BUFFER_BYTES, PlacedBuffer::InjectedFrames);
 
 volatile bool pauseCameraAcquisition = false;
 
@@ -60,8 +78,8 @@ portMUX_TYPE httpFrameMetaLock = portMUX_INITIALIZER_UNLOCKED;
 
 FrameMailbox inferenceMailbox;
 FrameMailbox streamMailbox;
-FrameMailboxManager inferenceMailboxManager(&inferenceMailbox, kPublishedFrameMaxBytes);
-FrameMailboxManager streamMailboxManager(&streamMailbox, kPublishedFrameMaxBytes);
+FrameMailboxManager inferenceMailboxManager(&inferenceMailbox);
+FrameMailboxManager streamMailboxManager(&streamMailbox);
 
 
 extern "C" void app_main(void)
@@ -77,6 +95,7 @@ extern "C" void app_main(void)
     uint32_t flash_size;
     esp_chip_info(&chip_info);
     ESP_LOGI(OV2640_TAG, "This is %s chip with %d CPU core(s)", CONFIG_IDF_TARGET, (int)chip_info.cores);
+    ESP_LOGI(OV2640_TAG, "Pixel kernels: %s", pixelKernelsName());
 
     if (!PSRAM::isAvailable()) {
         ESP_LOGD(MAIN_TAG, "PSRAM NOT available.\n");
@@ -106,14 +125,27 @@ extern "C" void app_main(void)
         return;
     }
 
+    // --- Frame payload pool (copying frame stores draw from it) ---
+    if (!framePool.init(PlacedBuffer::FramePoolSlabs)) {
+        return;
+    }
+
+    #if ENABLE_PRE_EVENT_CLIP
+        // Not fatal: streaming works without the clip recorder.
+        preEventRing.init(PRE_EVENT_RING_BYTES,
+                          PlacedBuffer::PreEventRing,
+                          (int64_t)PRE_EVENT_CLIP_SECONDS * 1000000,
+                          (int64_t)PRE_EVENT_CLIP_HOLD_SECONDS * 1000000);
+    #endif
+
     // --- Camera initialization ---
     #if ENABLE_RGB_STREAM_TASK
-        if (!streamMailboxManager.initFrameMailbox("stream", MALLOC_CAP_SPIRAM)) {
+        if (!streamMailboxManager.initFrameMailbox("stream")) {
             return;
         }
     #endif
     #if ENABLE_INFERENCE
-        if (!inferenceMailboxManager.initFrameMailbox("inference", MALLOC_CAP_SPIRAM)) {
+        if (!inferenceMailboxManager.initFrameMailbox("inference")) {
             return;
         }
     #endif
@@ -124,7 +156,7 @@ extern "C" void app_main(void)
         return;
     }
 
-    if (!httpFrameBuffer.initPublishedHttpFrameStore(kPublishedFrameMaxBytes, MALLOC_CAP_SPIRAM)) {
+    if (!httpFrameBuffer.initPublishedHttpFrameStore()) {
         return;
     }
 
@@ -137,6 +169,10 @@ extern "C" void app_main(void)
 
     // HTTP server task (always on; transport-specific handlers are configured below).
     auto http_server_task = [](void* arg) {
+        server.setCameraDriver(&camera);
+        #if ENABLE_INFERENCE
+            server.setInference(&tf_wrapper);
+        #endif
         #if USE_TCP
             server.setCaptureHandler(CameraHttpServer::captureRgbTcpCallback);
             server.setStreamHandler(CameraHttpServer::streamRgbTcpCallback);
@@ -202,39 +238,90 @@ extern "C" void app_main(void)
     #endif
 
     #if ENABLE_INFERENCE
-        // --- Allocate TensorFlow Lite arena intelligently ---
-        uint8_t* tensor_arena = nullptr;
-        const size_t arena_size = ARENA_SIZE;
-        if (!tensor_arena) {
-            ESP_LOGW(TF_TAG, "Internal RAM low, allocating arena in PSRAM");
-            tensor_arena = (uint8_t*) heap_caps_malloc(arena_size, MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
-        }
-        if (!tensor_arena) {
-            ESP_LOGE(TF_TAG, "Failed to allocate tensor arena!");
-            return;
-        }
+        // --- Model: the newest valid partition slot, read in place from flash, else the compiled-in one ---
+        const unsigned char* modelData = g_person_detect_model_data;
+        #if ENABLE_MODEL_PARTITION
+            const bool partitionOpen = modelPartition.open(MODEL_PARTITION_LABEL);
+            if (partitionOpen && modelStore.mount()) {
+                const ModelSlotInfo& slot = modelStore.slotInfo((size_t)modelStore.activeSlot());
+                modelData = modelStore.activeModel();
+                ESP_LOGI(MODEL_TAG, "Model from partition slot %d: %lu bytes, sequence %lu, crc32 %08lx",
+                         modelStore.activeSlot(),
+                         (unsigned long)slot.modelBytes,
+                         (unsigned long)slot.sequence,
+                         (unsigned long)slot.crc32);
+            } else if (partitionOpen) {
+                ESP_LOGW(MODEL_TAG, "No valid model in the partition (slot 0: %s, slot 1: %s), using the compiled-in model",
+                         modelImageStatusName(modelStore.slotInfo(0).status),
+                         modelImageStatusName(modelStore.slotInfo(1).status));
+            }
+        #endif
 
-        // --- Initialize TensorFlow Lite wrapper using allocated arena ---
-        if (!tf_wrapper.init(g_person_detect_model_data, arena_size, tensor_arena)) {
+        // --- Initialize TensorFlow Lite: the wrapper sizes and places its own arena (internal SRAM first) ---
+        bool tfReady = tf_wrapper.init(modelData, ARENA_SIZE);
+        if (!tfReady && modelData != g_person_detect_model_data) {
+            ESP_LOGW(TF_TAG, "Partition model failed, falling back to the compiled-in model");
+            tfReady = tf_wrapper.swapModel(g_person_detect_model_data);
+        }
+        if (!tfReady) {
             ESP_LOGE(TF_TAG, "TfLite initialization failed!");
             return;
         }
+        #if ENABLE_MODEL_PARTITION
+            if (partitionOpen) {
+                server.setModelStore(&modelStore);
+            }
+        #endif
 
-        xTaskCreatePinnedToCore(
-            [](void* arg) {
-                TfLiteWrapper* wrapperPtr = static_cast<TfLiteWrapper*>(arg);
-                if (wrapperPtr) {
-                    wrapperPtr->inference_task(arg);
-                }
-            },
-            "inference_task",
-            6144,
-            &tf_wrapper,
-            5,
-            &inferenceMailbox.consumerTaskHandle,
-            tskNO_AFFINITY
-        );
-        ESP_LOGI(OV2640_TAG, "Started inference task");
+        #if INFERENCE_PIPELINED
+            // Preprocessing reads the camera mailbox; Invoke() runs on the other core.
+            xTaskCreatePinnedToCore(
+                [](void* arg) {
+                    TfLiteWrapper* wrapperPtr = static_cast<TfLiteWrapper*>(arg);
+                    if (wrapperPtr) {
+                        wrapperPtr->inference_preprocess_task(arg);
+                    }
+                },
+                "inference_prep",
+                6144,
+                &tf_wrapper,
+                5,
+                &inferenceMailbox.consumerTaskHandle,
+                INFERENCE_PREPROCESS_CORE
+            );
+            xTaskCreatePinnedToCore(
+                [](void* arg) {
+                    TfLiteWrapper* wrapperPtr = static_cast<TfLiteWrapper*>(arg);
+                    if (wrapperPtr) {
+                        wrapperPtr->inference_task(arg);
+                    }
+                },
+                "inference_task",
+                6144,
+                &tf_wrapper,
+                5,
+                NULL,
+                INFERENCE_INVOKE_CORE
+            );
+            ESP_LOGI(OV2640_TAG, "Started inference pipeline (preprocess core %d, invoke core %d)",
+                     INFERENCE_PREPROCESS_CORE, INFERENCE_INVOKE_CORE);
+        #else
+            xTaskCreatePinnedToCore(
+                [](void* arg) {
+                    TfLiteWrapper* wrapperPtr = static_cast<TfLiteWrapper*>(arg);
+                    if (wrapperPtr) {
+                        wrapperPtr->inference_task(arg);
+                    }
+                },
+                "inference_task",
+                6144,
+                &tf_wrapper,
+                5,
+                &inferenceMailbox.consumerTaskHandle,
+                tskNO_AFFINITY
+            );
+            ESP_LOGI(OV2640_TAG, "Started inference task");
+        #endif
     #else
         ESP_LOGW(TF_TAG, "Inference disabled for test build (ENABLE_INFERENCE=0)");
     #endif
@@ -259,6 +346,11 @@ extern "C" void app_main(void)
         ESP_LOGW(OV2640_TAG, "Camera acquisition task disabled");
     #endif
 
+    // --- Boot report: where every placed buffer landed ---
+    // Pipeline tasks outrank app_main and allocate their buffers on start-up, so they are normally listed.
+    bufferPlacement.logReport(RAM_TAG);
+    log_RAM_status("post task start");
+
     // --- Optional: run for a limited time, then reboot ---
     /*char buffer[1024]; 
     for (int i = 0; i < 30; i++) { // log task stats every 5 seconds for 25 seconds
@@ -0,0 +1,128 @@
+#include "memory/buffer-placement.h"
+#include "esp_heap_caps.h"
+#include "esp_memory_utils.h"
+#include "esp_log.h"
+#include "debug.h"
+
+BufferPlacement::BufferPlacement(const BufferPlacementPolicy* policies, size_t policyCount)
+    : policies_(policies), policyCount_(policyCount) {}
+
+const BufferPlacementPolicy* BufferPlacement::policyFor(PlacedBuffer id) const
+{
+    for (size_t i = 0; i < policyCount_; i++) {
+        if (policies_[i].id == id) {
+            return &policies_[i];
+        }
+    }
+    return nullptr;
+}
+
+void* BufferPlacement::allocate(PlacedBuffer id, size_t size)
+{
+    const BufferPlacementPolicy* policy = policyFor(id);
+    if (!policy || size == 0) {
+        ESP_LOGE(RAM_TAG, "No placement policy for buffer %u", (unsigned int)id);
+        return nullptr;
+    }
+    Record& record = records_[(size_t)id];
+
+    for (int tier = 0; tier < BUFFER_PLACEMENT_MAX_TIERS && policy->tiers[tier] != 0; tier++) {
+        void* ptr = heap_caps_aligned_alloc(policy->alignment, size, policy->tiers[tier]);
+        if (!ptr) {
+            continue;
+        }
+        const bool internal = esp_ptr_internal(ptr);
+        record.liveBytes.fetch_add(size, std::memory_order_relaxed);
+        record.allocations.fetch_add(1, std::memory_order_relaxed);
+        record.lastTier.store(tier, std::memory_order_relaxed);
+        record.lastInternal.store(internal, std::memory_order_relaxed);
+        if (tier > 0) {
+            record.fallbacks.fetch_add(1, std::memory_order_relaxed);
+            ESP_LOGW(RAM_TAG, "%s: %u B fell back to tier %d (%s)",
+                     policy->name,
+                     (unsigned int)size,
+                     tier,
+                     internal ? "internal" : "PSRAM");
+        }
+        return ptr;
+    }
+
+    record.failures.fetch_add(1, std::memory_order_relaxed);
+    ESP_LOGE(RAM_TAG, "%s: no tier can hold %u B", policy->name, (unsigned int)size);
+    return nullptr;
+}
+
+void BufferPlacement::release(PlacedBuffer id, void* ptr, size_t size)
+{
+    if (!ptr) {
+        return;
+    }
+    heap_caps_free(ptr);
+    if ((size_t)id < (size_t)PlacedBuffer::Count) {
+        records_[(size_t)id].liveBytes.fetch_sub(size, std::memory_order_relaxed);
+    }
+}
+
+void* BufferPlacement::reallocate(PlacedBuffer id, void* ptr, size_t oldSize, size_t newSize)
+{
+    // Free first: the old buffer is usually in the tier the new one should land in.
+    release(id, ptr, oldSize);
+    return allocate(id, newSize);
+}
+
+bool BufferPlacement::ensureCapacity(PlacedBuffer id, uint8_t** buffer, size_t* capacity, size_t needed)
+{
+    if (*buffer && *capacity >= needed) {
+        return true;
+    }
+    *buffer = (uint8_t*)reallocate(id, *buffer, *capacity, needed);
+    *capacity = *buffer ? needed : 0;
+    return *buffer != nullptr;
+}
+
+bool BufferPlacement::getStats(PlacedBuffer id, BufferPlacementStats* stats) const
+{
+    if ((size_t)id >= (size_t)PlacedBuffer::Count || !stats) {
+        return false;
+    }
+    const Record& record = records_[(size_t)id];
+    stats->liveBytes = record.liveBytes.load(std::memory_order_relaxed);
+    stats->allocations = record.allocations.load(std::memory_order_relaxed);
+    stats->fallbacks = record.fallbacks.load(std::memory_order_relaxed);
+    stats->failures = record.failures.load(std::memory_order_relaxed);
+    stats->lastTier = record.lastTier.load(std::memory_order_relaxed);
+    stats->lastInternal = record.lastInternal.load(std::memory_order_relaxed);
+    return true;
+}
+
+void BufferPlacement::logReport(const char* tag) const
+{
+    size_t internalBytes = 0;
+    size_t psramBytes = 0;
+    ESP_LOGI(tag, "------ BUFFER PLACEMENT ------");
+    for (size_t i = 0; i < policyCount_; i++) {
+        const BufferPlacementPolicy& policy = policies_[i];
+        BufferPlacementStats stats;
+        getStats(policy.id, &stats);
+        if (stats.allocations == 0 && stats.failures == 0) {
+            ESP_LOGI(tag, "%-20s not allocated yet", policy.name);
+            continue;
+        }
+        (stats.lastInternal ? internalBytes : psramBytes) += stats.liveBytes;
+        ESP_LOGI(tag, "%-20s %7u B align=%-3u tier=%ld %-8s allocs=%lu fallbacks=%lu failures=%lu",
+                 policy.name,
+                 (unsigned int)stats.liveBytes,
+                 (unsigned int)policy.alignment,
+                 (long)stats.lastTier,
+                 stats.lastTier < 0 ? "-" : (stats.lastInternal ? "internal" : "PSRAM"),
+                 (unsigned long)stats.allocations,
+                 (unsigned long)stats.fallbacks,
+                 (unsigned long)stats.failures);
+    }
+    ESP_LOGI(tag, "Placed: internal=%u B, PSRAM=%u B | free: internal=%u B, PSRAM=%u B",
+             (unsigned int)internalBytes,
+             (unsigned int)psramBytes,
+             (unsigned int)heap_caps_get_free_size(MALLOC_CAP_INTERNAL),
+             (unsigned int)heap_caps_get_free_size(MALLOC_CAP_SPIRAM));
+    ESP_LOGI(tag, "------------------------------");
+}
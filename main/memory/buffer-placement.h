@@ -0,0 +1,86 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+// Pipeline buffers with a placement policy (kBufferPlacementPolicies in app-globals.h).
+enum class PlacedBuffer : uint8_t {
+    InferenceGray96,
+    InferenceWorkspace,
+    StreamGray96,
+    StreamWorkspace,
+    TensorArena,
+    TensorArenaPersistent,
+    FramePoolSlabs,
+    PreEventRing,
+    UdpPacket,
+    MotionThumbnail,
+    InjectedFrames,
+    JpegDecoder,
+    DetectionTiles,
+    Count
+};
+
+#define BUFFER_PLACEMENT_MAX_TIERS 3
+
+// Where one buffer should live: heap caps tried in order (0 ends the list) and the start alignment.
+struct BufferPlacementPolicy {
+    PlacedBuffer id;
+    const char* name;
+    size_t alignment;
+    uint32_t tiers[BUFFER_PLACEMENT_MAX_TIERS];
+};
+
+// Where a buffer actually landed, safe to read from any task.
+struct BufferPlacementStats {
+    size_t liveBytes = 0;
+    uint32_t allocations = 0;
+    uint32_t fallbacks = 0;     // allocations that missed the first tier
+    uint32_t failures = 0;      // allocations that missed every tier
+    int32_t lastTier = -1;      // tier index of the latest allocation, -1 if none succeeded
+    bool lastInternal = false;  // latest allocation is in internal SRAM
+};
+
+// Single entry point for long-lived pipeline buffers. Every allocation walks its policy's tiers with
+// heap_caps_aligned_alloc, so small hot buffers get internal SRAM when it is available and only
+// spill to PSRAM when it is not; the report shows the outcome per buffer.
+class BufferPlacement
+{
+public:
+    BufferPlacement(const BufferPlacementPolicy* policies, size_t policyCount);
+
+    BufferPlacement(const BufferPlacement&) = delete;
+    BufferPlacement& operator=(const BufferPlacement&) = delete;
+
+    // Returns nullptr when no tier can hold the buffer.
+    void* allocate(PlacedBuffer id, size_t size);
+    void release(PlacedBuffer id, void* ptr, size_t size);
+    // Replaces a buffer with one of newSize under the same policy. Contents are not preserved.
+    void* reallocate(PlacedBuffer id, void* ptr, size_t oldSize, size_t newSize);
+    // Grows *buffer to hold at least needed bytes (contents not preserved); false when it cannot.
+    bool ensureCapacity(PlacedBuffer id, uint8_t** buffer, size_t* capacity, size_t needed);
+
+    bool getStats(PlacedBuffer id, BufferPlacementStats* stats) const;
+
+    // One line per buffer: size, alignment, tier and memory it landed in, plus free heap per region.
+    void logReport(const char* tag) const;
+
+private:
+    struct Record {
+        std::atomic<size_t> liveBytes{0};
+        std::atomic<uint32_t> allocations{0};
+        std::atomic<uint32_t> fallbacks{0};
+        std::atomic<uint32_t> failures{0};
+        std::atomic<int32_t> lastTier{-1};
+        std::atomic<bool> lastInternal{false};
+    };
+
+    const BufferPlacementPolicy* policyFor(PlacedBuffer id) const;
+
+    const BufferPlacementPolicy* policies_;
+    size_t policyCount_;
+    Record records_[(size_t)PlacedBuffer::Count];
+};
+
+extern BufferPlacement bufferPlacement;
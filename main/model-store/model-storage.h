@@ -0,0 +1,26 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+// Raw bytes behind a ModelStore: the model flash partition on the device, a file on a host. Offsets are
+// relative to the start of the storage; erase() works in eraseSize() units and must precede write().
+// No ESP-IDF types, so the store and its validation run against a file-backed stand-in on Linux.
+class ModelStorage
+{
+public:
+    virtual ~ModelStorage() = default;
+
+    virtual const char* name() const = 0;
+    // 0 while nothing is open.
+    virtual size_t size() const = 0;
+    virtual size_t eraseSize() const = 0;
+
+    virtual bool erase(size_t offset, size_t len) = 0;
+    virtual bool write(size_t offset, const void* data, size_t len) = 0;
+
+    // Read-only view of [offset, offset + len) that stays valid until unmap(handle); nullptr on failure.
+    // Views of different ranges may be held at the same time.
+    virtual const uint8_t* map(size_t offset, size_t len, uint32_t* handle) = 0;
+    virtual void unmap(uint32_t handle) = 0;
+};
@@ -0,0 +1,275 @@
+#include "model-store/model-store.h"
+#include <string.h>
+#include "tensorflow/lite/micro/micro_interpreter.h"
+#include "tensorflow/lite/schema/schema_generated.h"
+
+const char* modelImageStatusName(ModelImageStatus status)
+{
+    switch (status) {
+        case ModelImageStatus::Ok:               return "ok";
+        case ModelImageStatus::Empty:            return "empty";
+        case ModelImageStatus::BadHeader:        return "bad header";
+        case ModelImageStatus::TooLarge:         return "too large";
+        case ModelImageStatus::Misaligned:       return "misaligned";
+        case ModelImageStatus::ChecksumMismatch: return "checksum mismatch";
+        case ModelImageStatus::NotTflite:        return "not a tflite model";
+        case ModelImageStatus::SchemaVersion:    return "schema version mismatch";
+        case ModelImageStatus::Malformed:        return "malformed flatbuffer";
+        case ModelImageStatus::StorageError:     return "storage error";
+        case ModelImageStatus::Busy:             return "busy";
+        case ModelImageStatus::Incomplete:       return "incomplete";
+    }
+    return "unknown";
+}
+
+uint32_t modelImageCrc32(uint32_t crc, const void* data, size_t len)
+{
+    // Nibble table: 64 bytes instead of the usual 1 KB, at two lookups per byte.
+    static const uint32_t kNibble[16] = {
+        0x00000000, 0x1DB71064, 0x3B6E20C8, 0x26D930AC, 0x76DC4190, 0x6B6B51F4, 0x4DB26158, 0x5005713C,
+        0xEDB88320, 0xF00F9344, 0xD6D6A3E8, 0xCB61B38C, 0x9B64C2B0, 0x86D3D2D4, 0xA00AE278, 0xBDBDF21C,
+    };
+    const uint8_t* bytes = (const uint8_t*)data;
+    crc = ~crc;
+    for (size_t i = 0; i < len; i++) {
+        crc ^= bytes[i];
+        crc = (crc >> 4) ^ kNibble[crc & 0x0F];
+        crc = (crc >> 4) ^ kNibble[crc & 0x0F];
+    }
+    return ~crc;
+}
+
+ModelImageStatus validateModelImage(const uint8_t* slot, size_t slotBytes, ModelImageHeader* header)
+{
+    memset(header, 0, sizeof(*header));
+    if (!slot || slotBytes < kModelImageDataOffset) {
+        return ModelImageStatus::TooLarge;
+    }
+    memcpy(header, slot, sizeof(*header));
+    if (header->magic != kModelImageMagic) {
+        return ModelImageStatus::Empty;
+    }
+    if (header->formatVersion != kModelImageFormatVersion || header->headerBytes != sizeof(ModelImageHeader)) {
+        return ModelImageStatus::BadHeader;
+    }
+    if (header->modelBytes == 0 || header->modelBytes > slotBytes - kModelImageDataOffset) {
+        return ModelImageStatus::TooLarge;
+    }
+
+    const uint8_t* model = slot + kModelImageDataOffset;
+    if (((uintptr_t)model & (kModelImageAlignment - 1)) != 0) {
+        return ModelImageStatus::Misaligned;
+    }
+    if (modelImageCrc32(0, model, header->modelBytes) != header->crc32) {
+        return ModelImageStatus::ChecksumMismatch;
+    }
+    if (header->modelBytes < 8 || !tflite::ModelBufferHasIdentifier(model)) {
+        return ModelImageStatus::NotTflite;
+    }
+    flatbuffers::Verifier verifier(model, header->modelBytes);
+    if (!tflite::VerifyModelBuffer(verifier)) {
+        return ModelImageStatus::Malformed;
+    }
+    if (tflite::GetModel(model)->version() != TFLITE_SCHEMA_VERSION) {
+        return ModelImageStatus::SchemaVersion;
+    }
+    return ModelImageStatus::Ok;
+}
+
+ModelStore::ModelStore(ModelStorage& storage)
+    : storage_(storage) {}
+
+ModelStore::~ModelStore()
+{
+    for (size_t slot = 0; slot < kSlotCount; slot++) {
+        unmapSlot(slot);
+    }
+}
+
+size_t ModelStore::eraseBytes(size_t len) const
+{
+    const size_t unit = storage_.eraseSize() ? storage_.eraseSize() : 1;
+    return (len + unit - 1) / unit * unit;
+}
+
+bool ModelStore::mount()
+{
+    for (size_t slot = 0; slot < kSlotCount; slot++) {
+        unmapSlot(slot);
+        slots_[slot] = ModelSlotInfo();
+    }
+    activeSlot_ = -1;
+    uploadState_ = UploadState::Idle;
+    uploadSlot_ = -1;
+
+    const size_t unit = storage_.eraseSize() ? storage_.eraseSize() : 1;
+    slotBytes_ = storage_.size() / kSlotCount / unit * unit;
+    if (slotBytes_ <= kModelImageDataOffset) {
+        slotBytes_ = 0;
+        return false;
+    }
+
+    for (size_t slot = 0; slot < kSlotCount; slot++) {
+        if (!mapSlot(slot)) {
+            continue;
+        }
+        if (activeSlot_ < 0 || slots_[slot].sequence > slots_[activeSlot_].sequence) {
+            activeSlot_ = (int)slot;
+        }
+    }
+    // Only the active slot stays mapped.
+    for (size_t slot = 0; slot < kSlotCount; slot++) {
+        if ((int)slot != activeSlot_) {
+            unmapSlot(slot);
+        }
+    }
+    return activeSlot_ >= 0;
+}
+
+// Maps just the header first, then exactly the image it announces, and validates that.
+bool ModelStore::mapSlot(size_t slot)
+{
+    ModelSlotInfo& info = slots_[slot];
+    uint32_t handle = 0;
+    const uint8_t* view = storage_.map(slotOffset(slot), sizeof(ModelImageHeader), &handle);
+    if (!view) {
+        info.status = ModelImageStatus::StorageError;
+        return false;
+    }
+    ModelImageHeader header;
+    memcpy(&header, view, sizeof(header));
+    storage_.unmap(handle);
+
+    info.sequence = header.sequence;
+    info.modelBytes = header.modelBytes;
+    info.crc32 = header.crc32;
+    if (header.magic != kModelImageMagic) {
+        info.status = ModelImageStatus::Empty;
+        return false;
+    }
+    if (header.modelBytes > maxModelBytes()) {
+        info.status = ModelImageStatus::TooLarge;
+        return false;
+    }
+
+    const size_t imageBytes = kModelImageDataOffset + header.modelBytes;
+    view = storage_.map(slotOffset(slot), imageBytes, &handle);
+    if (!view) {
+        info.status = ModelImageStatus::StorageError;
+        return false;
+    }
+    info.status = validateModelImage(view, imageBytes, &header);
+    if (info.status != ModelImageStatus::Ok) {
+        storage_.unmap(handle);
+        return false;
+    }
+    mapped_[slot] = view;
+    mapHandles_[slot] = handle;
+    return true;
+}
+
+void ModelStore::unmapSlot(size_t slot)
+{
+    if (mapped_[slot]) {
+        storage_.unmap(mapHandles_[slot]);
+        mapped_[slot] = nullptr;
+        mapHandles_[slot] = 0;
+    }
+}
+
+ModelImageStatus ModelStore::beginUpload(size_t modelBytes)
+{
+    if (uploadState_ == UploadState::Committed) {
+        return ModelImageStatus::Busy;
+    }
+    if (slotBytes_ == 0) {
+        return ModelImageStatus::StorageError;
+    }
+    if (modelBytes == 0 || modelBytes > maxModelBytes()) {
+        return ModelImageStatus::TooLarge;
+    }
+
+    // With no valid slot, slot 0; otherwise the one the interpreter is not running on.
+    uploadSlot_ = activeSlot_ == 0 ? 1 : 0;
+    unmapSlot((size_t)uploadSlot_);
+    slots_[uploadSlot_] = ModelSlotInfo();
+    if (!storage_.erase(slotOffset((size_t)uploadSlot_), eraseBytes(kModelImageDataOffset + modelBytes))) {
+        uploadState_ = UploadState::Idle;
+        slots_[uploadSlot_].status = ModelImageStatus::StorageError;
+        return ModelImageStatus::StorageError;
+    }
+    uploadState_ = UploadState::Writing;
+    uploadBytes_ = modelBytes;
+    uploadWritten_ = 0;
+    uploadCrc_ = 0;
+    return ModelImageStatus::Ok;
+}
+
+ModelImageStatus ModelStore::appendUpload(const void* data, size_t len)
+{
+    if (uploadState_ != UploadState::Writing) {
+        return ModelImageStatus::Busy;
+    }
+    if (len > uploadBytes_ - uploadWritten_) {
+        return ModelImageStatus::TooLarge;
+    }
+    if (!storage_.write(slotOffset((size_t)uploadSlot_) + kModelImageDataOffset + uploadWritten_, data, len)) {
+        return ModelImageStatus::StorageError;
+    }
+    uploadCrc_ = modelImageCrc32(uploadCrc_, data, len);
+    uploadWritten_ += len;
+    return ModelImageStatus::Ok;
+}
+
+ModelImageStatus ModelStore::commitUpload(const uint8_t** model)
+{
+    if (uploadState_ != UploadState::Writing) {
+        return ModelImageStatus::Busy;
+    }
+    if (uploadWritten_ != uploadBytes_) {
+        return ModelImageStatus::Incomplete;
+    }
+
+    ModelImageHeader header;
+    memset(&header, 0, sizeof(header));
+    header.magic = kModelImageMagic;
+    header.formatVersion = kModelImageFormatVersion;
+    header.headerBytes = sizeof(ModelImageHeader);
+    header.modelBytes = (uint32_t)uploadBytes_;
+    header.crc32 = uploadCrc_;
+    header.sequence = activeSlot_ >= 0 ? slots_[activeSlot_].sequence + 1 : 1;
+    if (!storage_.write(slotOffset((size_t)uploadSlot_), &header, sizeof(header))) {
+        return ModelImageStatus::StorageError;
+    }
+
+    // Validated as mapped, so a bad flash write fails here and not inside the interpreter.
+    if (!mapSlot((size_t)uploadSlot_)) {
+        return slots_[uploadSlot_].status;
+    }
+    uploadState_ = UploadState::Committed;
+    *model = mapped_[uploadSlot_] + kModelImageDataOffset;
+    return ModelImageStatus::Ok;
+}
+
+void ModelStore::activateUpload()
+{
+    if (uploadState_ != UploadState::Committed) {
+        return;
+    }
+    if (activeSlot_ >= 0) {
+        unmapSlot((size_t)activeSlot_);
+    }
+    activeSlot_ = uploadSlot_;
+    uploadState_ = UploadState::Idle;
+}
+
+void ModelStore::discardUpload()
+{
+    if (uploadSlot_ < 0 || uploadState_ == UploadState::Idle) {
+        return;
+    }
+    unmapSlot((size_t)uploadSlot_);
+    storage_.erase(slotOffset((size_t)uploadSlot_), eraseBytes(sizeof(ModelImageHeader)));
+    slots_[uploadSlot_] = ModelSlotInfo();
+    uploadState_ = UploadState::Idle;
+}
@@ -0,0 +1,115 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include "model-store/model-storage.h"
+
+// Start of a model slot. The .tflite flatbuffer follows at kModelImageDataOffset, so a mapped model keeps
+// the 16-byte alignment tflite-micro expects from its buffers.
+struct ModelImageHeader {
+    uint32_t magic;             // kModelImageMagic; erased flash reads 0xFFFFFFFF
+    uint16_t formatVersion;     // kModelImageFormatVersion
+    uint16_t headerBytes;       // sizeof(ModelImageHeader)
+    uint32_t modelBytes;
+    uint32_t crc32;             // CRC-32 (IEEE) of the modelBytes model bytes
+    uint32_t sequence;          // the valid slot with the highest sequence is loaded at boot
+    uint32_t reserved[3];
+};
+
+constexpr uint32_t kModelImageMagic = 0x4D4C4654;   // "TFLM" in memory order
+constexpr uint16_t kModelImageFormatVersion = 1;
+constexpr size_t kModelImageDataOffset = 64;
+constexpr size_t kModelImageAlignment = 16;
+
+enum class ModelImageStatus : uint8_t {
+    Ok,
+    Empty,              // no header: erased or never written
+    BadHeader,          // unknown format version or header size
+    TooLarge,           // model does not fit its slot
+    Misaligned,         // mapped model not kModelImageAlignment aligned
+    ChecksumMismatch,
+    NotTflite,          // no "TFL3" file identifier
+    SchemaVersion,      // not TFLITE_SCHEMA_VERSION
+    Malformed,          // flatbuffer verifier rejected the model
+    StorageError,       // erase, write or map failed
+    Busy,               // upload call out of order
+    Incomplete,         // commit before every announced byte arrived
+};
+
+const char* modelImageStatusName(ModelImageStatus status);
+
+// Streaming CRC-32 (IEEE 802.3, reflected); start with crc = 0.
+uint32_t modelImageCrc32(uint32_t crc, const void* data, size_t len);
+
+// Checks a mapped slot: header, size, alignment, checksum, file identifier, schema version and the
+// flatbuffer verifier, so the interpreter never parses a torn or foreign image. header gets the slot
+// header whatever the outcome (zeroed when the slot is too small to hold one).
+ModelImageStatus validateModelImage(const uint8_t* slot, size_t slotBytes, ModelImageHeader* header);
+
+struct ModelSlotInfo {
+    ModelImageStatus status = ModelImageStatus::Empty;
+    uint32_t sequence = 0;
+    uint32_t modelBytes = 0;
+    uint32_t crc32 = 0;
+};
+
+// Two model slots in one storage area. The newest valid slot is kept memory-mapped and its flatbuffer
+// handed to the interpreter in place; uploads go to the other slot, whose header is written last, so an
+// interrupted upload leaves the slot invalid and the running model untouched. Once the interpreter runs
+// on a committed upload, activateUpload() makes it the active slot and drops the old mapping.
+// Not thread-safe: mount() runs at boot and every later call from the HTTP server task.
+class ModelStore
+{
+public:
+    static constexpr size_t kSlotCount = 2;
+
+    explicit ModelStore(ModelStorage& storage);
+    ~ModelStore();
+
+    ModelStore(const ModelStore&) = delete;
+    ModelStore& operator=(const ModelStore&) = delete;
+
+    // Validates both slots and maps the newest valid one. False when neither holds a model.
+    bool mount();
+
+    // Mapped flatbuffer of the active slot, nullptr when there is none.
+    const uint8_t* activeModel() const { return activeSlot_ >= 0 ? mapped_[activeSlot_] + kModelImageDataOffset : nullptr; }
+    int activeSlot() const { return activeSlot_; }
+    const ModelSlotInfo& slotInfo(size_t slot) const { return slots_[slot]; }
+    // Largest model a slot holds; 0 without storage.
+    size_t maxModelBytes() const { return slotBytes_ > kModelImageDataOffset ? slotBytes_ - kModelImageDataOffset : 0; }
+
+    // Erases the inactive slot for a modelBytes upload; the bytes follow through appendUpload().
+    ModelImageStatus beginUpload(size_t modelBytes);
+    ModelImageStatus appendUpload(const void* data, size_t len);
+    // Writes the header, maps the slot and validates it as read back. On Ok, *model points to the mapped
+    // flatbuffer, ready for the interpreter.
+    ModelImageStatus commitUpload(const uint8_t** model);
+    // The interpreter runs on the committed upload: it becomes the active slot.
+    void activateUpload();
+    // The interpreter refused the committed upload (or the upload failed): the slot is unmapped and its
+    // header erased, so the next boot does not pick it either.
+    void discardUpload();
+    int uploadSlot() const { return uploadSlot_; }
+
+private:
+    enum class UploadState : uint8_t { Idle, Writing, Committed };
+
+    size_t slotOffset(size_t slot) const { return slot * slotBytes_; }
+    size_t eraseBytes(size_t len) const;
+    bool mapSlot(size_t slot);
+    void unmapSlot(size_t slot);
+
+    ModelStorage& storage_;
+    size_t slotBytes_ = 0;
+    int activeSlot_ = -1;
+    ModelSlotInfo slots_[kSlotCount];
+    const uint8_t* mapped_[kSlotCount] = {};
+    uint32_t mapHandles_[kSlotCount] = {};
+
+    UploadState uploadState_ = UploadState::Idle;
+    int uploadSlot_ = -1;
+    size_t uploadBytes_ = 0;
+    size_t uploadWritten_ = 0;
+    uint32_t uploadCrc_ = 0;
+};
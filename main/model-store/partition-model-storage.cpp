@@ -0,0 +1,54 @@
+#include "model-store/partition-model-storage.h"
+#include "esp_log.h"
+#include "debug.h"
+
+bool PartitionModelStorage::open(const char* label)
+{
+    partition_ = esp_partition_find_first(ESP_PARTITION_TYPE_DATA, ESP_PARTITION_SUBTYPE_ANY, label);
+    if (!partition_) {
+        ESP_LOGW(MODEL_TAG, "No \"%s\" data partition", label);
+        return false;
+    }
+    ESP_LOGI(MODEL_TAG, "Model partition \"%s\": %u bytes at 0x%lx",
+             partition_->label, (unsigned int)partition_->size, (unsigned long)partition_->address);
+    return true;
+}
+
+bool PartitionModelStorage::erase(size_t offset, size_t len)
+{
+    const esp_err_t err = partition_ ? esp_partition_erase_range(partition_, offset, len) : ESP_ERR_INVALID_STATE;
+    if (err != ESP_OK) {
+        ESP_LOGE(MODEL_TAG, "Erase of %u bytes at %u failed: %s", (unsigned int)len, (unsigned int)offset, esp_err_to_name(err));
+    }
+    return err == ESP_OK;
+}
+
+bool PartitionModelStorage::write(size_t offset, const void* data, size_t len)
+{
+    const esp_err_t err = partition_ ? esp_partition_write(partition_, offset, data, len) : ESP_ERR_INVALID_STATE;
+    if (err != ESP_OK) {
+        ESP_LOGE(MODEL_TAG, "Write of %u bytes at %u failed: %s", (unsigned int)len, (unsigned int)offset, esp_err_to_name(err));
+    }
+    return err == ESP_OK;
+}
+
+const uint8_t* PartitionModelStorage::map(size_t offset, size_t len, uint32_t* handle)
+{
+    if (!partition_) {
+        return nullptr;
+    }
+    const void* view = nullptr;
+    esp_partition_mmap_handle_t mapHandle = 0;
+    const esp_err_t err = esp_partition_mmap(partition_, offset, len, ESP_PARTITION_MMAP_DATA, &view, &mapHandle);
+    if (err != ESP_OK) {
+        ESP_LOGE(MODEL_TAG, "Mapping %u bytes at %u failed: %s", (unsigned int)len, (unsigned int)offset, esp_err_to_name(err));
+        return nullptr;
+    }
+    *handle = (uint32_t)mapHandle;
+    return (const uint8_t*)view;
+}
+
+void PartitionModelStorage::unmap(uint32_t handle)
+{
+    esp_partition_munmap((esp_partition_mmap_handle_t)handle);
+}
@@ -0,0 +1,25 @@
+#pragma once
+
+#include "model-store/model-storage.h"
+#include "esp_partition.h"
+
+// ModelStorage on a data partition (partitions.csv), mapped into the data cache with esp_partition_mmap,
+// so the interpreter reads the flatbuffer straight from flash.
+class PartitionModelStorage : public ModelStorage
+{
+public:
+    // False when the partition table has no data partition called label.
+    bool open(const char* label);
+
+    const char* name() const override { return partition_ ? partition_->label : "none"; }
+    size_t size() const override { return partition_ ? partition_->size : 0; }
+    size_t eraseSize() const override { return partition_ ? partition_->erase_size : 0; }
+
+    bool erase(size_t offset, size_t len) override;
+    bool write(size_t offset, const void* data, size_t len) override;
+    const uint8_t* map(size_t offset, size_t len, uint32_t* handle) override;
+    void unmap(uint32_t handle) override;
+
+private:
+    const esp_partition_t* partition_ = nullptr;
+};
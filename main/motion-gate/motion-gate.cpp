@@ -0,0 +1,147 @@
+#include "motion-gate/motion-gate.h"
+
+namespace {
+
+// Luma within this distance of 0 or 255 is treated as clipped.
+constexpr int32_t kClipMargin = 8;
+
+inline bool isClipped(int32_t luma)
+{
+    return luma < kClipMargin || luma > 255 - kClipMargin;
+}
+
+} // namespace
+
+MotionGate::MotionGate(const MotionGateConfig& config)
+    : config_(config) {}
+
+void MotionGate::bindBackground(uint16_t* background, size_t capacityPixels)
+{
+    background_ = background;
+    capacityPixels_ = background ? capacityPixels : 0;
+    reset();
+}
+
+void MotionGate::reset()
+{
+    hasBackground_ = false;
+    width_ = 0;
+    height_ = 0;
+}
+
+void MotionGate::updateBackground(const uint8_t* luma, size_t pixels)
+{
+    for (size_t i = 0; i < pixels; i++) {
+        const int32_t target = (int32_t)luma[i] << 8;
+        const int32_t current = background_[i];
+        background_[i] = (uint16_t)(current + ((target - current) >> config_.backgroundShift));
+    }
+}
+
+MotionGateDecision MotionGate::evaluate(const uint8_t* luma, uint16_t width, uint16_t height, int64_t nowUs)
+{
+    MotionGateDecision decision;
+    const size_t pixels = (size_t)width * height;
+    window_.frames++;
+
+    if (!luma || pixels == 0 || pixels > capacityPixels_) {
+        // Cannot judge this frame: fail open.
+        decision.runInference = true;
+        decision.trigger = MotionTrigger::Warmup;
+        window_.warmupTriggers++;
+        lastInferenceUs_ = nowUs;
+        return decision;
+    }
+
+    if (!hasBackground_ || width != width_ || height != height_) {
+        for (size_t i = 0; i < pixels; i++) {
+            background_[i] = (uint16_t)(luma[i] << 8);
+        }
+        width_ = width;
+        height_ = height;
+        hasBackground_ = true;
+        decision.runInference = true;
+        decision.trigger = MotionTrigger::Warmup;
+        window_.warmupTriggers++;
+        lastInferenceUs_ = nowUs;
+        return decision;
+    }
+
+    // Auto exposure moves the whole frame; take the mean offset out before counting changed pixels.
+    // Pixels clipped at either rail cannot follow an exposure change and are left out of both passes.
+    int32_t offsetSum = 0;
+    uint32_t considered = 0;
+    for (size_t i = 0; i < pixels; i++) {
+        const int32_t backgroundLuma = background_[i] >> 8;
+        if (isClipped(luma[i]) || isClipped(backgroundLuma)) {
+            continue;
+        }
+        offsetSum += (int32_t)luma[i] - backgroundLuma;
+        considered++;
+    }
+    const int32_t offset = considered ? offsetSum / (int32_t)considered : 0;
+
+    uint32_t changed = 0;
+    for (size_t i = 0; i < pixels; i++) {
+        const int32_t backgroundLuma = background_[i] >> 8;
+        if (isClipped(luma[i]) || isClipped(backgroundLuma)) {
+            continue;
+        }
+        int32_t diff = (int32_t)luma[i] - backgroundLuma - offset;
+        if (diff < 0) {
+            diff = -diff;
+        }
+        if (diff > config_.pixelThreshold) {
+            changed++;
+        }
+    }
+    decision.changedPermille = considered ? (uint16_t)((changed * 1000) / considered) : 0;
+    window_.lastChangedPermille = decision.changedPermille;
+    if (decision.changedPermille > window_.peakChangedPermille) {
+        window_.peakChangedPermille = decision.changedPermille;
+    }
+
+    updateBackground(luma, pixels);
+
+    if (decision.changedPermille >= config_.changedPermille) {
+        decision.runInference = true;
+        decision.trigger = MotionTrigger::Motion;
+        window_.motionTriggers++;
+    } else if (nowUs - lastInferenceUs_ >= config_.maxIntervalUs) {
+        decision.runInference = true;
+        decision.trigger = MotionTrigger::Timeout;
+        window_.timeoutTriggers++;
+    } else {
+        window_.skipped++;
+        return decision;
+    }
+    lastInferenceUs_ = nowUs;
+    return decision;
+}
+
+void MotionGate::recordGateCost(int64_t gateUs)
+{
+    gateSumUs_ += gateUs;
+    gateSamples_++;
+}
+
+void MotionGate::recordInferenceCost(int64_t inferenceUs)
+{
+    // Slow EMA: the saving estimate should not follow a single slow Invoke().
+    inferenceEmaUs_ = (inferenceEmaUs_ == 0.0f)
+        ? (float)inferenceUs
+        : inferenceEmaUs_ + ((float)inferenceUs - inferenceEmaUs_) / 16.0f;
+}
+
+void MotionGate::takeStats(MotionGateStats* stats)
+{
+    window_.meanGateUs = gateSamples_ ? (float)gateSumUs_ / (float)gateSamples_ : 0.0f;
+    window_.meanInferenceUs = inferenceEmaUs_;
+    window_.savedUs = window_.skipped * inferenceEmaUs_ - (float)gateSumUs_;
+    if (stats) {
+        *stats = window_;
+    }
+    window_ = MotionGateStats();
+    gateSumUs_ = 0;
+    gateSamples_ = 0;
+}
@@ -0,0 +1,77 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+struct MotionGateConfig {
+    uint8_t pixelThreshold = 0;         // luma difference (after global brightness compensation) that counts as changed
+    uint16_t changedPermille = 0;       // changed thumbnail pixels, per mille, that trigger inference
+    uint8_t backgroundShift = 0;        // background EMA weight is 1 / 2^shift per frame
+    int64_t maxIntervalUs = 0;          // inference runs at least this often even in a static scene
+};
+
+enum class MotionTrigger : uint8_t {
+    None,       // skipped
+    Warmup,     // no background yet (first frame, new geometry, rebound buffer)
+    Motion,
+    Timeout,    // maxIntervalUs since the previous inference
+};
+
+struct MotionGateDecision {
+    bool runInference = false;
+    MotionTrigger trigger = MotionTrigger::None;
+    uint16_t changedPermille = 0;
+};
+
+struct MotionGateStats {
+    uint32_t frames = 0;
+    uint32_t skipped = 0;
+    uint32_t motionTriggers = 0;
+    uint32_t timeoutTriggers = 0;
+    uint32_t warmupTriggers = 0;
+    uint16_t lastChangedPermille = 0;
+    uint16_t peakChangedPermille = 0;
+    float meanGateUs = 0.0f;            // thumbnail decode + diff per frame
+    float meanInferenceUs = 0.0f;       // full decode, crop and Invoke() per inference
+    float savedUs = 0.0f;               // skipped * meanInferenceUs - gate cost of all frames
+};
+
+// Change detector in front of the person detector. The caller hands in a small luma thumbnail per
+// frame (a 1:8 DC-only JPEG decode); the gate compares it with a running background, compensating
+// global brightness shifts from auto exposure, and only lets the frame through when enough pixels
+// changed or maxIntervalUs passed. Background storage is supplied by the caller; no allocation and
+// no ESP-IDF calls, so recorded thumbnails replay on a host.
+class MotionGate
+{
+public:
+    explicit MotionGate(const MotionGateConfig& config);
+
+    // Background storage for up to capacityPixels thumbnail pixels. Resets the model.
+    void bindBackground(uint16_t* background, size_t capacityPixels);
+    void reset();
+
+    MotionGateDecision evaluate(const uint8_t* luma, uint16_t width, uint16_t height, int64_t nowUs);
+
+    // Cost accounting for the stats: gate time per evaluated frame, full path time per inference.
+    void recordGateCost(int64_t gateUs);
+    void recordInferenceCost(int64_t inferenceUs);
+
+    // Fills stats and starts a new window.
+    void takeStats(MotionGateStats* stats);
+
+private:
+    void updateBackground(const uint8_t* luma, size_t pixels);
+
+    MotionGateConfig config_;
+    uint16_t* background_ = nullptr;    // Q8.8 luma
+    size_t capacityPixels_ = 0;
+    uint16_t width_ = 0;
+    uint16_t height_ = 0;
+    bool hasBackground_ = false;
+    int64_t lastInferenceUs_ = 0;
+
+    MotionGateStats window_;
+    int64_t gateSumUs_ = 0;
+    uint32_t gateSamples_ = 0;
+    float inferenceEmaUs_ = 0.0f;
+};
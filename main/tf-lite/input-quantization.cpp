@@ -0,0 +1,24 @@
+#include "tf-lite/input-quantization.h"
+#include <math.h>
+
+void buildInputQuantizationLut(float realMin, float realMax, float scale, int32_t zeroPoint, bool isInt8, uint8_t lut[256])
+{
+    const int32_t low = isInt8 ? -128 : 0;
+    const int32_t high = isInt8 ? 127 : 255;
+    const double step = ((double)realMax - realMin) / 255.0;
+    for (int32_t luma = 0; luma < 256; luma++) {
+        int32_t q;
+        if (scale > 0.0f) {
+            q = (int32_t)lround((realMin + luma * step) / scale) + zeroPoint;
+        } else {
+            q = isInt8 ? luma - 128 : luma;
+        }
+        if (q < low) {
+            q = low;
+        }
+        if (q > high) {
+            q = high;
+        }
+        lut[luma] = (uint8_t)(q & 0xFF);   // int8 as its two's complement byte
+    }
+}
@@ -0,0 +1,10 @@
+#pragma once
+
+#include <stdint.h>
+
+// Luma -> stored byte for a one-byte model input tensor. Luma 0..255 stands for the real values
+// realMin..realMax (TF_INPUT_REAL_MIN / TF_INPUT_REAL_MAX); each is quantized like TFLite does,
+// round(real / scale) + zeroPoint with halves away from zero, clamped to the type's range, and int8
+// results are stored as their bit pattern. scale <= 0 (tensor without quantization parameters) keeps
+// the old fixed mapping: luma for uint8, luma - 128 for int8. No TFLM or ESP-IDF dependencies.
+void buildInputQuantizationLut(float realMin, float realMax, float scale, int32_t zeroPoint, bool isInt8, uint8_t lut[256]);
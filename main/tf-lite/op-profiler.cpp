@@ -0,0 +1,131 @@
+#include "tf-lite/op-profiler.h"
+#include <string.h>
+
+OpProfiler::OpProfiler(Clock clock)
+    : clock_(clock) {}
+
+uint32_t OpProfiler::BeginEvent(const char* tag)
+{
+    if (runningCount_ >= kOpProfilerMaxNodes) {
+        runningDropped_++;
+        return (uint32_t)kOpProfilerMaxNodes;
+    }
+    Running& event = running_[runningCount_];
+    event.tag = tag;
+    event.elapsedUs = -1;
+    event.startUs = clock_();
+    return (uint32_t)runningCount_++;
+}
+
+void OpProfiler::EndEvent(uint32_t event_handle)
+{
+    const int64_t nowUs = clock_();
+    if (event_handle >= runningCount_) {
+        return;
+    }
+    Running& event = running_[event_handle];
+    event.elapsedUs = (int32_t)(nowUs - event.startUs);
+}
+
+void OpProfiler::beginInvoke()
+{
+    runningCount_ = 0;
+    runningDropped_ = 0;
+}
+
+void OpProfiler::endInvoke()
+{
+    totals_.invocations++;
+    totals_.droppedEvents += runningDropped_;
+    if (runningCount_ > totals_.nodeCount) {
+        totals_.nodeCount = runningCount_;
+    }
+    for (size_t i = 0; i < runningCount_; i++) {
+        const Running& event = running_[i];
+        if (event.elapsedUs < 0) {
+            continue;   // node failed before EndEvent
+        }
+        OpProfileNode& node = totals_.nodes[i];
+        node.tag = event.tag;
+        node.count++;
+        node.totalUs += event.elapsedUs;
+        if (event.elapsedUs > node.maxUs) {
+            node.maxUs = event.elapsedUs;
+        }
+    }
+    runningCount_ = 0;
+}
+
+void OpProfiler::setNodeMacs(size_t index, uint32_t macs)
+{
+    if (index < kOpProfilerMaxNodes) {
+        totals_.nodes[index].macs = macs;
+    }
+}
+
+void OpProfiler::snapshot(OpProfile* profile) const
+{
+    if (profile) {
+        *profile = totals_;
+    }
+}
+
+void OpProfiler::reset()
+{
+    // MAC counts describe the model, not a measurement: keep them.
+    for (size_t i = 0; i < kOpProfilerMaxNodes; i++) {
+        OpProfileNode& node = totals_.nodes[i];
+        node.count = 0;
+        node.totalUs = 0;
+        node.maxUs = 0;
+    }
+    totals_.invocations = 0;
+    totals_.droppedEvents = 0;
+}
+
+void OpProfiler::clear()
+{
+    totals_ = OpProfile();
+    runningCount_ = 0;
+    runningDropped_ = 0;
+}
+
+size_t OpProfiler::summarizeByTag(const OpProfile& profile, OpProfileTag* tags, size_t maxTags)
+{
+    size_t count = 0;
+    for (size_t i = 0; i < profile.nodeCount; i++) {
+        const OpProfileNode& node = profile.nodes[i];
+        if (!node.tag || node.count == 0) {
+            continue;
+        }
+        size_t slot = 0;
+        while (slot < count && tags[slot].tag != node.tag && strcmp(tags[slot].tag, node.tag) != 0) {
+            slot++;
+        }
+        if (slot == count) {
+            if (count == maxTags) {
+                continue;
+            }
+            tags[count++] = OpProfileTag();
+            tags[slot].tag = node.tag;
+        }
+        OpProfileTag& entry = tags[slot];
+        entry.count += node.count;
+        entry.totalUs += node.totalUs;
+        if (node.maxUs > entry.maxUs) {
+            entry.maxUs = node.maxUs;
+        }
+    }
+
+    // Insertion sort: a model has a handful of distinct op types.
+    for (size_t i = 1; i < count; i++) {
+        const OpProfileTag entry = tags[i];
+        size_t j = i;
+        while (j > 0 && tags[j - 1].totalUs < entry.totalUs) {
+            tags[j] = tags[j - 1];
+            j--;
+        }
+        tags[j] = entry;
+    }
+    return count;
+}
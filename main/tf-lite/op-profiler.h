@@ -0,0 +1,75 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include "tensorflow/lite/micro/micro_profiler_interface.h"
+
+// Operators tracked per model; later nodes are counted in OpProfile::droppedEvents.
+constexpr size_t kOpProfilerMaxNodes = 48;
+
+// One graph node (operator) across invocations.
+struct OpProfileNode {
+    const char* tag = nullptr;      // builtin op name from the interpreter, e.g. "CONV_2D"
+    uint32_t count = 0;
+    uint32_t macs = 0;              // multiply-accumulates per run (CONV_2D, DEPTHWISE_CONV_2D, FULLY_CONNECTED), else 0
+    int64_t totalUs = 0;
+    int32_t maxUs = 0;
+};
+
+// The same node times summed per tag.
+struct OpProfileTag {
+    const char* tag = nullptr;
+    uint32_t count = 0;
+    int64_t totalUs = 0;
+    int32_t maxUs = 0;
+};
+
+struct OpProfile {
+    uint32_t invocations = 0;
+    uint32_t droppedEvents = 0;
+    size_t nodeCount = 0;
+    OpProfileNode nodes[kOpProfilerMaxNodes];
+};
+
+// Per-operator profiler for tflite::MicroInterpreter. The interpreter brackets every node's Invoke with
+// BeginEvent/EndEvent (unless built with TF_LITE_STRIP_ERROR_STRINGS); events are keyed by their order
+// inside one Invoke(), so each graph node keeps its own count, total and max. Times of the running
+// invocation are folded into the totals by endInvoke(), which with snapshot() is the only part that
+// needs the caller's lock against readers. The clock is injected, so there are no ESP-IDF calls.
+class OpProfiler : public tflite::MicroProfilerInterface
+{
+public:
+    typedef int64_t (*Clock)();
+
+    explicit OpProfiler(Clock clock);
+
+    uint32_t BeginEvent(const char* tag) override;
+    void EndEvent(uint32_t event_handle) override;
+
+    void beginInvoke();
+    void endInvoke();
+
+    // Static cost of node index, shown next to its timings.
+    void setNodeMacs(size_t index, uint32_t macs);
+
+    void snapshot(OpProfile* profile) const;
+    void reset();
+    // reset() plus the MACs and node count, for a new model.
+    void clear();
+
+    // Folds profile.nodes into one entry per tag, heaviest total first. Returns the number of tags written.
+    static size_t summarizeByTag(const OpProfile& profile, OpProfileTag* tags, size_t maxTags);
+
+private:
+    struct Running {
+        const char* tag;
+        int64_t startUs;
+        int32_t elapsedUs;
+    };
+
+    Clock clock_;
+    OpProfile totals_;
+    Running running_[kOpProfilerMaxNodes];
+    size_t runningCount_ = 0;
+    uint32_t runningDropped_ = 0;
+};
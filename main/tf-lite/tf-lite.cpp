@@ -1,30 +1,83 @@
 
 #include "tf-lite/tf-lite.h"
+#include "tf-lite/input-quantization.h"
 #include "tensorflow/lite/micro/micro_interpreter.h"
+#include "tensorflow/lite/micro/micro_allocator.h"
+#include "tensorflow/lite/micro/recording_micro_allocator.h"
 #include "tensorflow/lite/micro/micro_mutable_op_resolver.h"
 #include "tensorflow/lite/schema/schema_generated.h"
+#include "tensorflow/lite/schema/schema_utils.h"
 #include "esp_heap_caps.h"
 #include "esp_system.h"
+#include "esp_timer.h"
 #include "app-globals.h"
 #include "data-types/frame-snapshot.h"
 #include "data-types/frame-mailbox.h"
 #include "image-editing/editing.h"
+#include "image-editing/detection-tiles.h"
+#include "clip-recorder/pre-event-ring.h"
+#include "motion-gate/motion-gate.h"
+#include "detection-scheduler/detection-scheduler.h"
+#include "data-types/stage-queue.h"
+#include "inference-pipeline/pipeline-meter.h"
 #include "util/misc.h"
 #include "debug.h"
 
-bool TfLiteWrapper::init(const unsigned char* model_data, size_t arena_size_, uint8_t* arena_buffer)
+// Multiply-accumulates of one run of a conv, depthwise conv or fully connected node: every output
+// element takes one filter slice (filter elements / output channels). 0 for other operators.
+static uint32_t operatorMacs(const tflite::Model* model, const tflite::SubGraph* subgraph, const tflite::Operator* op)
 {
-    tensor_arena = arena_buffer;
-    arena_size = arena_size_;
+    const tflite::BuiltinOperator code = tflite::GetBuiltinCode(model->operator_codes()->Get(op->opcode_index()));
+    if (code != tflite::BuiltinOperator_CONV_2D &&
+        code != tflite::BuiltinOperator_DEPTHWISE_CONV_2D &&
+        code != tflite::BuiltinOperator_FULLY_CONNECTED) {
+        return 0;
+    }
+    if (!op->inputs() || op->inputs()->size() < 2 || !op->outputs() || op->outputs()->size() < 1) {
+        return 0;
+    }
+    const auto* filterShape = subgraph->tensors()->Get(op->inputs()->Get(1))->shape();
+    const auto* outputShape = subgraph->tensors()->Get(op->outputs()->Get(0))->shape();
+    if (!filterShape || !outputShape || outputShape->size() == 0) {
+        return 0;
+    }
+    uint64_t filterElements = 1;
+    for (uint32_t i = 0; i < filterShape->size(); i++) {
+        filterElements *= (uint64_t)filterShape->Get(i);
+    }
+    uint64_t outputElements = 1;
+    for (uint32_t i = 0; i < outputShape->size(); i++) {
+        outputElements *= (uint64_t)outputShape->Get(i);
+    }
+    const uint64_t channels = (uint64_t)outputShape->Get(outputShape->size() - 1);
+    return channels ? (uint32_t)(outputElements * (filterElements / channels)) : 0;
+}
 
-    // Map model
-    model = tflite::GetModel(model_data);
-    if (model->version() != TFLITE_SCHEMA_VERSION) {
-        ESP_LOGE(TF_TAG, "Model schema version mismatch!");
-        return false;
+// Measured arena part plus ARENA_MARGIN_BYTES, rounded to the arena alignment.
+[[maybe_unused]] static size_t arenaBytesWithMargin(size_t measured)
+{
+    const size_t alignment = 16;
+    return (measured + ARENA_MARGIN_BYTES + alignment - 1) & ~(alignment - 1);
+}
+
+static const char* placementName(PlacedBuffer id)
+{
+    BufferPlacementStats placement;
+    if (!bufferPlacement.getStats(id, &placement) || placement.lastTier < 0) {
+        return "nowhere";
     }
+    return placement.lastInternal ? "internal SRAM" : "PSRAM";
+}
 
-    // Add only the ops your model uses
+bool TfLiteWrapper::init(const unsigned char* model_data_, size_t arena_size_, uint8_t* arena_buffer)
+{
+    tensor_arena = arena_buffer;
+    owns_arena = arena_buffer == nullptr;
+    arena_size = owns_arena ? 0 : arena_size_;
+    arena_probe_size = arena_size_;
+    model_swap_done = xSemaphoreCreateBinary();
+
+    // Add only the ops your model uses (models swapped in later get the same set)
     resolver.AddConv2D();
     resolver.AddDepthwiseConv2D();
     resolver.AddMaxPool2D();
@@ -37,35 +90,296 @@ bool TfLiteWrapper::init(const unsigned char* model_data, size_t arena_size_, ui
     resolver.AddRelu();
     resolver.AddRelu6();
 
-    // Allocate tensor arena
     ESP_LOGD(TF_TAG, "Largest allocatable block: %d", heap_caps_get_largest_free_block(MALLOC_CAP_8BIT));
-    ESP_LOGD(TF_TAG, "Free heap before arena allocation: %d, arena size: %d", (int)esp_get_free_heap_size(), (int)arena_size);
+    ESP_LOGD(TF_TAG, "Free heap before arena allocation: %d, arena size: %d", (int)esp_get_free_heap_size(), (int)arena_size_);
+
+    return buildInterpreter(model_data_);
+}
 
-    if (tensor_arena) {
+// Sizes the arena(s) for the mapped model and, for an arena this object owns, grows it when the model
+// needs more than the last one. Expects no live interpreter: the recording pass reuses its storage.
+bool TfLiteWrapper::prepareArena()
+{
+    arena_allocator = nullptr;
+    if (!owns_arena) {
         ESP_LOGI(TF_TAG, "Using caller-provided tensor arena at %p", tensor_arena);
-    } else {
-        tensor_arena = (uint8_t*)heap_caps_malloc(arena_size, MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT);
-        if (!tensor_arena) {
+        snprintf(arena_placement, sizeof(arena_placement), "single, caller buffer");
+        return true;
+    }
+
+    #if ENABLE_ARENA_MEASUREMENT
+        ArenaUsage usage;
+        const bool measured = measureArenaUsage(arena_probe_size, &usage);
+        if (!measured) {
+            ESP_LOGW(TF_TAG, "Arena measurement failed, keeping the configured sizes");
+        }
+    #endif
+
+    #if TENSOR_ARENA_LAYOUT == TENSOR_ARENA_SPLIT
+        size_t persistentNeeded = ARENA_PERSISTENT_SIZE;
+        size_t nonPersistentNeeded = ARENA_NON_PERSISTENT_SIZE;
+        #if ENABLE_ARENA_MEASUREMENT
+            if (measured) {
+                persistentNeeded = arenaBytesWithMargin(usage.persistent);
+                nonPersistentNeeded = arenaBytesWithMargin(usage.nonPersistent);
+            }
+        #endif
+        if (!bufferPlacement.ensureCapacity(PlacedBuffer::TensorArenaPersistent, &persistent_arena,
+                                            &persistent_arena_size, persistentNeeded) ||
+            !bufferPlacement.ensureCapacity(PlacedBuffer::TensorArena, &tensor_arena, &arena_size, nonPersistentNeeded)) {
+            ESP_LOGE(TF_TAG, "Failed to allocate split tensor arena!");
+            return false;
+        }
+        // The allocator (and its two arena allocators) lives at the start of the persistent arena.
+        arena_allocator = tflite::MicroAllocator::Create(persistent_arena, persistent_arena_size,
+                                                         tensor_arena, arena_size);
+        if (!arena_allocator) {
+            ESP_LOGE(TF_TAG, "Failed to create split arena allocator!");
+            return false;
+        }
+        snprintf(arena_placement, sizeof(arena_placement), "split, non-persistent %s, persistent %s",
+                 placementName(PlacedBuffer::TensorArena),
+                 placementName(PlacedBuffer::TensorArenaPersistent));
+        ESP_LOGI(TF_TAG, "Tensor arena split: non-persistent %u bytes in %s, persistent %u bytes in %s",
+                 (unsigned int)arena_size,
+                 placementName(PlacedBuffer::TensorArena),
+                 (unsigned int)persistent_arena_size,
+                 placementName(PlacedBuffer::TensorArenaPersistent));
+    #else
+        size_t needed = arena_probe_size;
+        #if ENABLE_ARENA_MEASUREMENT
+            if (measured) {
+                needed = arenaBytesWithMargin(usage.used);
+            }
+        #endif
+        if (!bufferPlacement.ensureCapacity(PlacedBuffer::TensorArena, &tensor_arena, &arena_size, needed)) {
             ESP_LOGE(TF_TAG, "Failed to allocate tensor arena!");
             return false;
         }
+        snprintf(arena_placement, sizeof(arena_placement), "single, %s", placementName(PlacedBuffer::TensorArena));
+        ESP_LOGI(TF_TAG, "Tensor arena: %u bytes in %s (ARENA_SIZE %u)",
+                 (unsigned int)arena_size,
+                 placementName(PlacedBuffer::TensorArena),
+                 (unsigned int)arena_probe_size);
+    #endif
+    return true;
+}
+
+bool TfLiteWrapper::buildInterpreter(const unsigned char* model_data_)
+{
+    // Map model: the flatbuffer is used in place (flash-mapped or compiled in), never copied
+    model = tflite::GetModel(model_data_);
+    if (model->version() != TFLITE_SCHEMA_VERSION) {
+        ESP_LOGE(TF_TAG, "Model schema version mismatch!");
+        return false;
+    }
+    if (!prepareArena()) {
+        return false;
     }
 
     // Create interpreter via placement new — lives in this object's storage
-    interpreter = new (interpreter_storage) tflite::MicroInterpreter(
-        model, resolver, tensor_arena, arena_size);
+    #if ENABLE_OP_PROFILER
+        tflite::MicroProfilerInterface* profiler = &op_profiler;
+    #else
+        tflite::MicroProfilerInterface* profiler = nullptr;
+    #endif
+    if (arena_allocator) {
+        interpreter = new (interpreter_storage) tflite::MicroInterpreter(
+            model, resolver, arena_allocator, nullptr, profiler);
+    } else {
+        interpreter = new (interpreter_storage) tflite::MicroInterpreter(
+            model, resolver, tensor_arena, arena_size, nullptr, profiler);
+    }
 
     TfLiteStatus status = interpreter->AllocateTensors();
     if (status != kTfLiteOk) {
         ESP_LOGE(TF_TAG, "Tensor allocation failed, err: %d", (int)status);
+        interpreter->~MicroInterpreter();
         interpreter = nullptr;
         return false;
     }
+    model_data = model_data_;
+
+    // Static MACs per node, so the profile shows throughput next to time (graph order = event order).
+    // Timings of a previous model no longer apply.
+    const tflite::SubGraph* subgraph = model->subgraphs()->Get(0);
+    taskENTER_CRITICAL(&op_profile_lock);
+    op_profiler.clear();
+    if (subgraph->operators()) {
+        for (uint32_t i = 0; i < subgraph->operators()->size() && i < kOpProfilerMaxNodes; i++) {
+            op_profiler.setNodeMacs(i, operatorMacs(model, subgraph, subgraph->operators()->Get(i)));
+        }
+    }
+    invoke_stats = InvokeStats();
+    taskEXIT_CRITICAL(&op_profile_lock);
+
+    // Quantized inputs get their luma -> tensor value table once; preprocessing stores through it.
+    input_lut_ready = false;
+    TfLiteTensor* input = interpreter->input(0);
+    if (input && (input->type == kTfLiteInt8 || input->type == kTfLiteUInt8)) {
+        buildInputQuantizationLut(TF_INPUT_REAL_MIN, TF_INPUT_REAL_MAX,
+                                  input->params.scale, input->params.zero_point,
+                                  input->type == kTfLiteInt8, input_lut);
+        input_lut_ready = true;
+        ESP_LOGI(TF_TAG, "Input %s scale=%f zero_point=%d (luma 0 -> %d, 255 -> %d)",
+                 input->type == kTfLiteInt8 ? "int8" : "uint8",
+                 input->params.scale,
+                 (int)input->params.zero_point,
+                 input->type == kTfLiteInt8 ? (int)(int8_t)input_lut[0] : (int)input_lut[0],
+                 input->type == kTfLiteInt8 ? (int)(int8_t)input_lut[255] : (int)input_lut[255]);
+    }
 
     return true;
 }
 
-bool TfLiteWrapper::runInference(const uint8_t* image_data, int width, int height) 
+bool TfLiteWrapper::rebuildInterpreter(const unsigned char* model_data_)
+{
+    const unsigned char* previous = interpreter ? model_data : nullptr;
+    const int64_t startUs = esp_timer_get_time();
+    if (interpreter) {
+        interpreter->~MicroInterpreter();
+        interpreter = nullptr;
+    }
+    if (buildInterpreter(model_data_)) {
+        ESP_LOGW(TF_TAG, "Model swapped in %lld ms (flatbuffer at %p)",
+                 (long long)((esp_timer_get_time() - startUs) / 1000), model_data_);
+        return true;
+    }
+    ESP_LOGE(TF_TAG, "Model at %p refused by the interpreter", model_data_);
+    if (previous && !buildInterpreter(previous)) {
+        ESP_LOGE(TF_TAG, "Previous model could not be rebuilt either");
+    }
+    return false;
+}
+
+bool TfLiteWrapper::swapModel(const unsigned char* model_data_)
+{
+    TaskHandle_t inferenceTask = inference_task_handle.load(std::memory_order_acquire);
+    if (!inferenceTask) {
+        // Nothing calls Invoke() yet.
+        return rebuildInterpreter(model_data_);
+    }
+
+    xSemaphoreTake(model_swap_done, 0);
+    pending_model.store(model_data_, std::memory_order_release);
+    xTaskNotifyGive(inferenceTask);
+    if (xSemaphoreTake(model_swap_done, pdMS_TO_TICKS(MODEL_SWAP_TIMEOUT_MS)) != pdTRUE) {
+        const unsigned char* expected = model_data_;
+        if (pending_model.compare_exchange_strong(expected, nullptr, std::memory_order_acq_rel)) {
+            ESP_LOGE(TF_TAG, "Model swap not picked up within %d ms", MODEL_SWAP_TIMEOUT_MS);
+            return false;
+        }
+        // Taken just now: the rebuild is running and will report.
+        xSemaphoreTake(model_swap_done, portMAX_DELAY);
+    }
+    return model_swap_ok.load(std::memory_order_acquire);
+}
+
+// Called by the inference task between frames. True when the interpreter was rebuilt (on the new model
+// or, when that failed, on the previous one), so the caller's input tensor pointers are stale.
+bool TfLiteWrapper::applyPendingModelSwap()
+{
+    const unsigned char* next = pending_model.exchange(nullptr, std::memory_order_acq_rel);
+    if (!next) {
+        return false;
+    }
+    model_swap_ok.store(rebuildInterpreter(next), std::memory_order_release);
+    xSemaphoreGive(model_swap_done);
+    return true;
+}
+
+// Recording pass: builds the interpreter once through a RecordingMicroAllocator in a probeSize scratch
+// arena and reports what AllocateTensors() really took: head (non-persistent) and tail (persistent). The
+// recording allocator's own bookkeeping is a little larger than the plain one's, so this errs high.
+bool TfLiteWrapper::measureArenaUsage(size_t probeSize, ArenaUsage* usage)
+{
+    // Scratch for the pass only: PSRAM first, so internal SRAM stays free for the real arena.
+    uint8_t* probe = (uint8_t*)heap_caps_aligned_alloc(16, probeSize, MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
+    if (!probe) {
+        probe = (uint8_t*)heap_caps_aligned_alloc(16, probeSize, MALLOC_CAP_8BIT);
+    }
+    if (!probe) {
+        return false;
+    }
+
+    bool measured = false;
+    tflite::RecordingMicroAllocator* recorder = tflite::RecordingMicroAllocator::Create(probe, probeSize);
+    if (recorder) {
+        tflite::MicroInterpreter* probeInterpreter = new (interpreter_storage) tflite::MicroInterpreter(model, resolver, recorder);
+        if (probeInterpreter->AllocateTensors() == kTfLiteOk) {
+            const auto* arenaAllocator = recorder->GetSimpleMemoryAllocator();
+            usage->used = probeInterpreter->arena_used_bytes();
+            usage->persistent = arenaAllocator->GetPersistentUsedBytes();
+            usage->nonPersistent = arenaAllocator->GetNonPersistentUsedBytes();
+            measured = true;
+
+            ESP_LOGI(TF_TAG, "Arena measured: %u bytes used of %u (persistent %u, non-persistent %u), margin %u",
+                     (unsigned int)usage->used,
+                     (unsigned int)probeSize,
+                     (unsigned int)usage->persistent,
+                     (unsigned int)usage->nonPersistent,
+                     (unsigned int)ARENA_MARGIN_BYTES);
+            static const struct {
+                tflite::RecordedAllocationType type;
+                const char* name;
+            } kRecorded[] = {
+                { tflite::RecordedAllocationType::kTfLiteEvalTensorData, "eval tensors" },
+                { tflite::RecordedAllocationType::kPersistentTfLiteTensorData, "persistent tensors" },
+                { tflite::RecordedAllocationType::kPersistentTfLiteTensorQuantizationData, "quantization" },
+                { tflite::RecordedAllocationType::kPersistentBufferData, "kernel buffers" },
+                { tflite::RecordedAllocationType::kTfLiteTensorVariableBufferData, "variable tensors" },
+                { tflite::RecordedAllocationType::kNodeAndRegistrationArray, "nodes" },
+                { tflite::RecordedAllocationType::kOpData, "op data" },
+            };
+            for (const auto& entry : kRecorded) {
+                const tflite::RecordedAllocation allocation = recorder->GetRecordedAllocation(entry.type);
+                ESP_LOGI(TF_TAG, "  %-18s %6u bytes in %u allocations",
+                         entry.name, (unsigned int)allocation.used_bytes, (unsigned int)allocation.count);
+            }
+        }
+        probeInterpreter->~MicroInterpreter();
+    }
+    heap_caps_free(probe);
+    return measured;
+}
+
+bool TfLiteWrapper::inputShapeMatches(const TfLiteTensor* input, int width, int height) const
+{
+    // Expected input tensor shape: [1, height, width, 1]
+    return input->dims && input->dims->size == 4 &&
+           input->dims->data[0] == 1 &&
+           input->dims->data[1] == height &&
+           input->dims->data[2] == width &&
+           input->dims->data[3] == 1;
+}
+
+bool TfLiteWrapper::getModelInput(ModelInput* modelInput)
+{
+    TfLiteTensor* input = interpreter ? interpreter->input(0) : nullptr;
+    if (!modelInput || !input || !input_lut_ready || !input->dims || input->dims->size != 4) {
+        return false;
+    }
+    const int height = input->dims->data[1];
+    const int width = input->dims->data[2];
+    if (!inputShapeMatches(input, width, height)) {
+        return false;
+    }
+    modelInput->pixels = input->data.uint8;
+    modelInput->width = width;
+    modelInput->height = height;
+    modelInput->lut = input_lut;
+    return true;
+}
+
+bool TfLiteWrapper::runInference(const uint8_t* image_data, int width, int height, float* confidence)
+{
+    if (confidence) {
+        *confidence = 0.0f;
+    }
+    return setInput(image_data, width, height) && runInference(confidence);
+}
+
+bool TfLiteWrapper::setInput(const uint8_t* image_data, int width, int height)
 {
     if (!interpreter) {
         ESP_LOGE(TF_TAG, "Interpreter is null");
@@ -78,12 +392,7 @@ bool TfLiteWrapper::runInference(const uint8_t* image_data, int width, int heigh
         return false;
     }
 
-    // Validate input tensor shape: [1, height, width, 1]
-    if (input->dims->size != 4 ||
-        input->dims->data[0] != 1 ||
-        input->dims->data[1] != height ||
-        input->dims->data[2] != width ||
-        input->dims->data[3] != 1) {
+    if (!inputShapeMatches(input, width, height)) {
         ESP_LOGE(TF_TAG, "Unexpected input tensor shape: [%d, %d, %d, %d]",
                  input->dims->data[0],
                  input->dims->data[1],
@@ -96,29 +405,50 @@ bool TfLiteWrapper::runInference(const uint8_t* image_data, int width, int heigh
 
     // Copy image data into input tensor
     int expected_size = width * height;
-    if (input->type == kTfLiteUInt8) {
-        memcpy(input->data.uint8, image_data, expected_size);
-    } else if (input->type == kTfLiteFloat32) {
+    if (input->type == kTfLiteFloat32) {
         float* input_f = input->data.f;
+        const float step = (TF_INPUT_REAL_MAX - TF_INPUT_REAL_MIN) / 255.0f;
         for (int i = 0; i < expected_size; i++) {
-            input_f[i] = image_data[i] / 255.0f;
+            input_f[i] = TF_INPUT_REAL_MIN + image_data[i] * step;
         }
-    } else if (input->type == kTfLiteInt8) {
-        // kTfLiteInt8 expects values in the range [-128, 127], so we subtract 128 from each pixel.
-        // This assumes symmetric quantization. If your model uses asymmetric quantization, you should apply:
-        // input_i8[i] = static_cast<int8_t>((image_data[i] - zero_point) / scale);
-        int8_t* input_i8 = input->data.int8;
+    } else if (input_lut_ready) {
+        // uint8 / int8: the tensor's own scale and zero point, folded into input_lut at init().
+        uint8_t* input_q = input->data.uint8;
         for (int i = 0; i < expected_size; i++) {
-            // Convert [0,255] to [-128,127] using symmetric quantization
-            input_i8[i] = static_cast<int8_t>((image_data[i] - 128));
+            input_q[i] = input_lut[image_data[i]];
         }
     } else {
         ESP_LOGE(TF_TAG, "Unsupported input tensor type: %d", input->type);
         return false;
     }
+    return true;
+}
+
+bool TfLiteWrapper::runInference(float* confidenceOut)
+{
+    if (confidenceOut) {
+        *confidenceOut = 0.0f;
+    }
+    if (!interpreter) {
+        ESP_LOGE(TF_TAG, "Interpreter is null");
+        return false;
+    }
 
     // Run inference
+    op_profiler.beginInvoke();
+    const int64_t invokeStartUs = esp_timer_get_time();
     TfLiteStatus status = interpreter->Invoke();
+    const int32_t invokeUs = (int32_t)(esp_timer_get_time() - invokeStartUs);
+    taskENTER_CRITICAL(&op_profile_lock);
+    op_profiler.endInvoke();
+    if (status == kTfLiteOk) {
+        invoke_stats.count++;
+        invoke_stats.totalUs += invokeUs;
+        if (invokeUs > invoke_stats.maxUs) {
+            invoke_stats.maxUs = invokeUs;
+        }
+    }
+    taskEXIT_CRITICAL(&op_profile_lock);
     if (status != kTfLiteOk) {
         ESP_LOGE(TF_TAG, "Model invocation failed with status %d", status);
         return false;
@@ -178,6 +508,9 @@ bool TfLiteWrapper::runInference(const uint8_t* image_data, int width, int heigh
     }
 
     ESP_LOGD(TF_TAG, "Person confidence: %f", confidence);
+    if (confidenceOut) {
+        *confidenceOut = confidence;
+    }
     bool detected = confidence > DETECTION_THRESHOLD;
     return detected;
 }
@@ -188,65 +521,720 @@ uint8_t* TfLiteWrapper::getOutputDataUint8() const {
     return 0;
 }
 
+void TfLiteWrapper::getOpProfile(OpProfile* profile, bool reset)
+{
+    taskENTER_CRITICAL(&op_profile_lock);
+    op_profiler.snapshot(profile);
+    if (reset) {
+        op_profiler.reset();
+    }
+    taskEXIT_CRITICAL(&op_profile_lock);
+}
+
+void TfLiteWrapper::getInvokeStats(InvokeStats* stats, bool reset)
+{
+    taskENTER_CRITICAL(&op_profile_lock);
+    if (stats) {
+        *stats = invoke_stats;
+    }
+    if (reset) {
+        invoke_stats = InvokeStats();
+    }
+    taskEXIT_CRITICAL(&op_profile_lock);
+}
+
 TfLiteTensor* TfLiteWrapper::getInputTensor() {
     return interpreter ? interpreter->input(0) : nullptr;
 }
 
 
+#if ENABLE_INFERENCE && ENABLE_MOTION_GATE
+static MotionGateConfig makeMotionGateConfig()
+{
+    MotionGateConfig gateConfig;
+    gateConfig.pixelThreshold = MOTION_GATE_PIXEL_THRESHOLD;
+    gateConfig.changedPermille = MOTION_GATE_CHANGED_PERMILLE;
+    gateConfig.backgroundShift = MOTION_GATE_BACKGROUND_SHIFT;
+    gateConfig.maxIntervalUs = (int64_t)MOTION_GATE_MAX_INTERVAL_MS * 1000;
+    return gateConfig;
+}
+
+// Decodes a JPEG frame at 1:8 and runs the change detector on it. Returns true when the frame should go
+// on to inference; frames the gate cannot judge (no buffer, decode error) go through. motion is set
+// when the frame was admitted for changed pixels rather than warmup or timeout.
+// buffer holds background and luma back to back and grows with the frame size; decoder keeps the
+// RGB565 thumbnail and tjpgd work area across frames.
+static bool motionGateAdmits(MotionGate& gate,
+                             JpegDecoderContext& decoder,
+                             const FrameSnapshot& snapshot,
+                             uint8_t** buffer,
+                             size_t* bufferLen,
+                             bool* motion)
+{
+    const int64_t gateStartUs = esp_timer_get_time();
+    const size_t thumbPixels = (size_t)(snapshot.width / 8) * (snapshot.height / 8);
+    const uint8_t* previousBuffer = *buffer;
+    if (!bufferPlacement.ensureCapacity(PlacedBuffer::MotionThumbnail,
+                                        buffer,
+                                        bufferLen,
+                                        thumbPixels * kMotionThumbnailBytesPerPixel)) {
+        gate.bindBackground(nullptr, 0);
+        return true;
+    }
+
+    const size_t capacityPixels = *bufferLen / kMotionThumbnailBytesPerPixel;
+    uint16_t* background = (uint16_t*)*buffer;
+    uint8_t* luma = (uint8_t*)(background + capacityPixels);
+    if (*buffer != previousBuffer) {
+        gate.bindBackground(background, capacityPixels);
+    }
+
+    uint16_t thumbWidth = 0;
+    uint16_t thumbHeight = 0;
+    if (!decodeJpegLumaThumbnail(decoder, snapshot.data, snapshot.len, luma, capacityPixels, &thumbWidth, &thumbHeight)) {
+        return true;
+    }
+    const MotionGateDecision decision = gate.evaluate(luma, thumbWidth, thumbHeight, gateStartUs);
+    gate.recordGateCost(esp_timer_get_time() - gateStartUs);
+    *motion = decision.trigger == MotionTrigger::Motion;
+    return decision.runInference;
+}
+
+static void logMotionGateStats(MotionGate& gate, int64_t elapsedUs)
+{
+    MotionGateStats stats;
+    gate.takeStats(&stats);
+    ESP_LOGI(TF_TAG,
+             "Motion gate: skipped=%lu/%lu (%.0f%%) motion=%lu timeout=%lu warmup=%lu | change=%u/%u permille | gate=%.2f ms inference=%.1f ms | cpu saved=%.0f ms (%.0f%%)",
+             (unsigned long)stats.skipped,
+             (unsigned long)stats.frames,
+             stats.frames ? (100.0f * stats.skipped) / stats.frames : 0.0f,
+             (unsigned long)stats.motionTriggers,
+             (unsigned long)stats.timeoutTriggers,
+             (unsigned long)stats.warmupTriggers,
+             (unsigned int)stats.lastChangedPermille,
+             (unsigned int)stats.peakChangedPermille,
+             stats.meanGateUs / 1000.0f,
+             stats.meanInferenceUs / 1000.0f,
+             stats.savedUs / 1000.0f,
+             elapsedUs > 0 ? (100.0f * stats.savedUs) / (float)elapsedUs : 0.0f);
+}
+
+static void logJpegDecoderStats(JpegDecoderContext& decoder)
+{
+    JpegDecoderStats stats;
+    decoder.takeStats(&stats);
+    ESP_LOGI(TF_TAG,
+             "JPEG decoder: decodes=%lu failures=%lu mean=%.2f ms max=%.2f ms | buffer=%u bytes growths=%lu",
+             (unsigned long)stats.decodes,
+             (unsigned long)stats.failures,
+             stats.decodes ? (stats.totalUs / 1000.0f) / stats.decodes : 0.0f,
+             stats.maxUs / 1000.0f,
+             (unsigned int)stats.capacityBytes,
+             (unsigned long)stats.growths);
+}
+#endif
+
+#if ENABLE_INFERENCE && ENABLE_ADAPTIVE_SCHEDULING
+static DetectionSchedulerConfig makeDetectionSchedulerConfig()
+{
+    DetectionSchedulerConfig schedulerConfig;
+    schedulerConfig.emaAlpha = DETECTION_EMA_ALPHA;
+    schedulerConfig.enterThreshold = DETECTION_ENTER_THRESHOLD;
+    schedulerConfig.exitThreshold = DETECTION_EXIT_THRESHOLD;
+    schedulerConfig.settledMargin = DETECTION_SETTLED_MARGIN;
+    schedulerConfig.settleInferences = DETECTION_SETTLE_INFERENCES;
+    schedulerConfig.firstBackoffUs = (int64_t)DETECTION_BACKOFF_FIRST_MS * 1000;
+    schedulerConfig.maxIntervalUs = (int64_t)DETECTION_BACKOFF_MAX_MS * 1000;
+    return schedulerConfig;
+}
+
+// Feeds one inference to the scheduler and returns the smoothed, hysteresis-filtered presence. lock
+// guards a scheduler shared by the two pipeline stages.
+static bool scheduleDetection(DetectionScheduler& scheduler, float confidence, portMUX_TYPE* lock = nullptr)
+{
+    const int64_t nowUs = esp_timer_get_time();
+    DetectionUpdate update;
+    if (lock) {
+        taskENTER_CRITICAL(lock);
+        update = scheduler.update(confidence, nowUs);
+        taskEXIT_CRITICAL(lock);
+    } else {
+        update = scheduler.update(confidence, nowUs);
+    }
+    ESP_LOGI(TF_TAG, "Detection: confidence=%.2f smoothed=%.2f present=%s%s | next inference in %lld ms",
+             confidence,
+             update.smoothed,
+             update.present ? "yes" : "no",
+             update.changed ? " (changed)" : "",
+             (long long)(update.intervalUs / 1000));
+    return update.present;
+}
+
+static void logDetectionSchedulerStats(DetectionScheduler& scheduler, int64_t nowUs, portMUX_TYPE* lock = nullptr)
+{
+    DetectionSchedulerStats stats;
+    if (lock) {
+        taskENTER_CRITICAL(lock);
+        scheduler.takeStats(&stats, nowUs);
+        taskEXIT_CRITICAL(lock);
+    } else {
+        scheduler.takeStats(&stats, nowUs);
+    }
+    ESP_LOGI(TF_TAG,
+             "Scheduler: ran=%lu skipped=%lu/%lu motion wakeups=%lu transitions=%lu | smoothed=%.2f present=%s interval=%lld ms | saved=%.1f inferences/min",
+             (unsigned long)stats.inferences,
+             (unsigned long)stats.skipped,
+             (unsigned long)stats.frames,
+             (unsigned long)stats.motionWakeups,
+             (unsigned long)stats.transitions,
+             stats.smoothed,
+             stats.present ? "yes" : "no",
+             (long long)(stats.intervalUs / 1000),
+             stats.savedPerMinute);
+}
+#endif
+
+#if ENABLE_INFERENCE
+static void logInvokeStats(TfLiteWrapper& wrapper)
+{
+    InvokeStats stats;
+    wrapper.getInvokeStats(&stats, true);
+    ESP_LOGI(TF_TAG, "Invoke: runs=%lu mean=%.1f ms max=%.1f ms | arena %s",
+             (unsigned long)stats.count,
+             stats.count ? (stats.totalUs / 1000.0f) / stats.count : 0.0f,
+             stats.maxUs / 1000.0f,
+             wrapper.arenaPlacement());
+}
+
+// True when preprocessing can write straight into the model's input tensor (filled into input).
+static bool takesDirectInput(TfLiteWrapper& wrapper, ModelInput* input)
+{
+    const bool direct = wrapper.getModelInput(input) &&
+                        input->width == TF_IMAGE_INPUT_SIZE &&
+                        input->height == TF_IMAGE_INPUT_SIZE;
+    ESP_LOGI(TF_TAG, "Model input: %s", direct ? "preprocessed into the input tensor" : "copied from gray96Buffer");
+    return direct;
+}
+
+static void showDetection(bool personPresent, bool* lastPersonPresent)
+{
+    #if ENABLE_PRE_EVENT_CLIP
+        // Rising edge only: keep the seconds leading up to the detection as a clip.
+        if (personPresent && !*lastPersonPresent && preEventRing.requestFreeze()) {
+            ESP_LOGW(TF_TAG, "Person appeared, freezing pre-event clip");
+        }
+    #endif
+    *lastPersonPresent = personPresent;
+    if (personPresent) {
+        redLed.setLedGpio2(0);
+        rgb.turnBlueLedOn();
+    } else {
+        redLed.setLedGpio2(1);
+        rgb.turnRedLedOn();
+    }
+}
+#endif
+
+#if ENABLE_INFERENCE && INFERENCE_INPUT_MODE == INFERENCE_INPUT_TILED
+// Runs the model over the windows of a luma frame, most salient first, until one reports a person or
+// the next Invoke() (predicted from the mean so far) would overrun TILED_INFERENCE_BUDGET_MS. The first
+// window always runs. directInput is null for float models, which go through gray96Buffer instead.
+// saliencyBuffer keeps the previous frame's block means and grows with the frame size. confidence gets
+// the highest person confidence of the windows run.
+static bool detectInTiles(TfLiteWrapper& wrapper,
+                          TileSaliencyMap& saliency,
+                          uint8_t** saliencyBuffer,
+                          size_t* saliencyBufferLen,
+                          const uint8_t* luma,
+                          uint16_t width,
+                          uint16_t height,
+                          const ModelInput* directInput,
+                          uint8_t* gray96Buffer,
+                          float* confidence)
+{
+    *confidence = 0.0f;
+    DetectionTile tiles[TILED_INFERENCE_MAX_TILES];
+    const size_t tileCount = planDetectionTiles(width, height, TF_IMAGE_INPUT_SIZE, TILED_INFERENCE_OVERLAP_PERCENT,
+                                                tiles, TILED_INFERENCE_MAX_TILES);
+    if (tileCount == 0) {
+        ESP_LOGW(TF_TAG, "No %dx%d window fits a %ux%u frame", TF_IMAGE_INPUT_SIZE, TF_IMAGE_INPUT_SIZE,
+                 (unsigned int)width, (unsigned int)height);
+        return false;
+    }
+    // Without the map (no memory) the tiles simply run in plan order.
+    if (bufferPlacement.ensureCapacity(PlacedBuffer::DetectionTiles,
+                                       saliencyBuffer,
+                                       saliencyBufferLen,
+                                       TileSaliencyMap::storageBytes(width, height))) {
+        saliency.bind(*saliencyBuffer, *saliencyBufferLen);
+        saliency.rank(luma, width, height, TF_IMAGE_INPUT_SIZE, tiles, tileCount);
+    }
+
+    const int64_t budgetUs = (int64_t)TILED_INFERENCE_BUDGET_MS * 1000;
+    const int64_t startUs = esp_timer_get_time();
+    int64_t elapsedUs = 0;
+    size_t tilesRun = 0;
+    int fired = -1;
+    while (tilesRun < tileCount) {
+        if (tilesRun > 0 && elapsedUs + elapsedUs / (int64_t)tilesRun > budgetUs) {
+            break;
+        }
+        const DetectionTile& tile = tiles[tilesRun];
+        bool personPresent;
+        float tileConfidence = 0.0f;
+        if (directInput) {
+            copyDetectionTile(luma, width, tile, TF_IMAGE_INPUT_SIZE, directInput->pixels, directInput->lut);
+            personPresent = wrapper.runInference(&tileConfidence);
+        } else {
+            copyDetectionTile(luma, width, tile, TF_IMAGE_INPUT_SIZE, gray96Buffer);
+            personPresent = wrapper.runInference(gray96Buffer, TF_IMAGE_INPUT_SIZE, TF_IMAGE_INPUT_SIZE, &tileConfidence);
+        }
+        if (tileConfidence > *confidence) {
+            *confidence = tileConfidence;
+        }
+        tilesRun++;
+        elapsedUs = esp_timer_get_time() - startUs;
+        if (personPresent) {
+            fired = (int)tilesRun - 1;
+            break;
+        }
+    }
+
+    if (fired >= 0) {
+        ESP_LOGW(TF_TAG, "Person detected? YES | tile (%u,%u) of %ux%u, %u/%u windows run (motion=%lu contrast=%u) | %.1f ms",
+                 (unsigned int)tiles[fired].x, (unsigned int)tiles[fired].y,
+                 (unsigned int)width, (unsigned int)height,
+                 (unsigned int)tilesRun, (unsigned int)tileCount,
+                 (unsigned long)tiles[fired].motion, (unsigned int)tiles[fired].contrast,
+                 elapsedUs / 1000.0f);
+    } else {
+        ESP_LOGW(TF_TAG, "Person detected? NO | %u/%u windows of %ux%u run%s | %.1f ms",
+                 (unsigned int)tilesRun, (unsigned int)tileCount,
+                 (unsigned int)width, (unsigned int)height,
+                 tilesRun < tileCount ? " (budget reached)" : "",
+                 elapsedUs / 1000.0f);
+    }
+    return fired >= 0;
+}
+#endif
+
+#if INFERENCE_PIPELINED
+// One prepared model input on its way from the preprocessing stage to Invoke(). pixels is raw luma:
+// the Invoke() stage encodes it with setInput(), so a model swap never invalidates a queued input.
+struct PreparedInput {
+    uint8_t* pixels = nullptr;      // TF_IMAGE_INPUT_SIZE x TF_IMAGE_INPUT_SIZE
+    uint32_t seq = 0;
+    PipelineSample sample;          // capture and preprocessing times; the Invoke() stage adds its own
+};
+
+// What the two stages share. The queue is lock-free; the scheduler (shouldRun() on the preprocessing
+// side, update() on the Invoke() side) is guarded by schedulerLock.
+struct InferencePipeline {
+    StageQueue<PreparedInput, INFERENCE_PIPELINE_DEPTH> inputs;
+    std::atomic<TaskHandle_t> preprocessTask{nullptr};
+    std::atomic<int32_t> lastInvokeUs{0};           // what a frame skipped by the motion gate saves on top of preprocessing
+    std::atomic<uint32_t> droppedFrames{0};         // camera frames replaced in the mailbox before the preprocessing stage took them
+    #if ENABLE_ADAPTIVE_SCHEDULING
+        DetectionScheduler scheduler{makeDetectionSchedulerConfig()};
+        portMUX_TYPE schedulerLock = portMUX_INITIALIZER_UNLOCKED;
+    #endif
+};
+
+static InferencePipeline inferencePipeline;
+
+static void logPipelineStats(PipelineMeter& meter, int64_t nowUs)
+{
+    PipelineStats stats;
+    meter.takeStats(&stats, nowUs);
+    ESP_LOGI(TF_TAG,
+             "Pipeline: %.2f inferences/s (limit %.2f/s in one task, %.2f/s in two stages; %.2f cores busy) | preprocess=%.1f queue=%.1f invoke=%.1f ms | capture-to-result mean=%.0f max=%.0f ms | dropped=%lu",
+             stats.framesPerSecond,
+             stats.sequentialLimitFps,
+             stats.pipelinedLimitFps,
+             stats.busyCores,
+             stats.meanPreprocessUs / 1000.0f,
+             stats.meanQueueUs / 1000.0f,
+             stats.meanInvokeUs / 1000.0f,
+             stats.meanLatencyUs / 1000.0f,
+             stats.maxLatencyUs / 1000.0f,
+             (unsigned long)inferencePipeline.droppedFrames.exchange(0, std::memory_order_relaxed));
+}
+#endif
+
+void TfLiteWrapper::inference_preprocess_task(void *arg)
+{
+    #if INFERENCE_PIPELINED
+        ESP_LOGI(TF_TAG, "Inference preprocessing stage started on core %d", xPortGetCoreID());
+        InferencePipeline& pipeline = inferencePipeline;
+        pipeline.preprocessTask.store(xTaskGetCurrentTaskHandle(), std::memory_order_release);
+
+        const size_t inputBytes = TF_IMAGE_INPUT_SIZE * TF_IMAGE_INPUT_SIZE;
+        size_t grayscaleWorkspaceLen = kAcquiredFrameMaxPixels;
+        uint8_t* grayscaleWorkspace = (uint8_t*)bufferPlacement.allocate(PlacedBuffer::InferenceWorkspace, grayscaleWorkspaceLen);
+        // One input per queue slot, carved from a single InferenceGray96 block.
+        uint8_t* inputBuffers = (uint8_t*)bufferPlacement.allocate(PlacedBuffer::InferenceGray96, inputBytes * pipeline.inputs.depth());
+        if (!grayscaleWorkspace || !inputBuffers) {
+            ESP_LOGE(TF_TAG, "Failed to allocate inference workspace");
+            vTaskDelete(NULL);
+            return;
+        }
+        for (size_t i = 0; i < pipeline.inputs.depth(); i++) {
+            pipeline.inputs.slot(i).pixels = inputBuffers + i * inputBytes;
+        }
+        uint32_t lastSeq = 0;
+
+        #if ENABLE_ADAPTIVE_SCHEDULING
+            int64_t schedulerStatsStartUs = esp_timer_get_time();
+        #endif
+
+        #if ENABLE_MOTION_GATE
+            MotionGate motionGate(makeMotionGateConfig());
+            JpegDecoderContext jpegDecoder(PlacedBuffer::JpegDecoder);
+            uint8_t* motionBuffer = nullptr;
+            size_t motionBufferLen = 0;
+            int64_t motionStatsStartUs = esp_timer_get_time();
+        #endif
+
+        while (true) {
+            ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+
+            // Every slot queued or in Invoke(): leave the frame in the mailbox. The Invoke() stage wakes this
+            // task when it frees a slot, and the newest frame is taken then.
+            PreparedInput* prepared = pipeline.inputs.beginWrite();
+            if (!prepared) {
+                continue;
+            }
+            const FrameSnapshot* snapshot = inferenceMailboxManager.acquire();
+            if (!snapshot) {
+                continue;
+            }
+            if (lastSeq != 0 && snapshot->seq > lastSeq + 1) {
+                pipeline.droppedFrames.fetch_add(snapshot->seq - lastSeq - 1, std::memory_order_relaxed);
+            }
+            lastSeq = snapshot->seq;
+
+            [[maybe_unused]] bool motion = false;
+            #if ENABLE_MOTION_GATE
+                const int64_t nowUs = esp_timer_get_time();
+                if (nowUs - motionStatsStartUs >= 2000000) {
+                    logMotionGateStats(motionGate, nowUs - motionStatsStartUs);
+                    logJpegDecoderStats(jpegDecoder);
+                    motionStatsStartUs = nowUs;
+                }
+                if (snapshot->format == PIXFORMAT_JPEG &&
+                    !motionGateAdmits(motionGate, jpegDecoder, *snapshot, &motionBuffer, &motionBufferLen, &motion)) {
+                    inferenceMailboxManager.release();
+                    continue;
+                }
+            #endif
+
+            #if ENABLE_ADAPTIVE_SCHEDULING
+                const int64_t scheduleNowUs = esp_timer_get_time();
+                if (scheduleNowUs - schedulerStatsStartUs >= 2000000) {
+                    logDetectionSchedulerStats(pipeline.scheduler, scheduleNowUs, &pipeline.schedulerLock);
+                    schedulerStatsStartUs = scheduleNowUs;
+                }
+                // Inputs already queued are not yet in the scheduler, so a backoff starts up to
+                // INFERENCE_PIPELINE_DEPTH inferences late.
+                taskENTER_CRITICAL(&pipeline.schedulerLock);
+                const bool scheduled = pipeline.scheduler.shouldRun(scheduleNowUs, motion);
+                taskEXIT_CRITICAL(&pipeline.schedulerLock);
+                if (!scheduled) {
+                    inferenceMailboxManager.release();
+                    continue;
+                }
+            #endif
+
+            const int64_t preprocessStartUs = esp_timer_get_time();
+            jpegTimer.checkpoint();
+            // The camera may have been reconfigured to a larger frame size: grow the scratch frame with it.
+            bufferPlacement.ensureCapacity(PlacedBuffer::InferenceWorkspace,
+                                           &grayscaleWorkspace,
+                                           &grayscaleWorkspaceLen,
+                                           gray96WorkspaceBytes(snapshot->width, snapshot->height));
+            const bool built = buildGray96Frame(*snapshot,
+                                                grayscaleWorkspace,
+                                                grayscaleWorkspaceLen,
+                                                prepared->pixels,
+                                                TF_IMAGE_INPUT_SIZE,
+                                                nullptr);
+            prepared->seq = snapshot->seq;
+            prepared->sample = PipelineSample();
+            prepared->sample.captureUs = snapshot->captureUs;
+            inferenceMailboxManager.release();
+            jpegTimer.logCheckpoint(JPEG_TAG, "inference input prepared");
+            if (!built) {
+                continue;
+            }
+
+            const int64_t queuedUs = esp_timer_get_time();
+            prepared->sample.preprocessStartUs = preprocessStartUs;
+            prepared->sample.queuedUs = queuedUs;
+            // The slot belongs to the Invoke() stage from here on.
+            pipeline.inputs.publish();
+            TaskHandle_t invokeTask = inference_task_handle.load(std::memory_order_acquire);
+            if (invokeTask) {
+                xTaskNotifyGive(invokeTask);
+            }
+
+            #if ENABLE_MOTION_GATE
+                motionGate.recordInferenceCost(queuedUs - preprocessStartUs + pipeline.lastInvokeUs.load(std::memory_order_relaxed));
+            #endif
+        }
+    #endif
+}
+
+void TfLiteWrapper::runInvokeStage()
+{
+    #if INFERENCE_PIPELINED
+        ESP_LOGI(TF_TAG, "Inference invoke stage started on core %d", xPortGetCoreID());
+        InferencePipeline& pipeline = inferencePipeline;
+        inference_task_handle.store(xTaskGetCurrentTaskHandle(), std::memory_order_release);
+
+        PipelineMeter meter;
+        bool lastPersonPresent = false;
+        int64_t statsStartUs = esp_timer_get_time();
+
+        // Drains the queue before waiting, so inputs published before this task was up are not stranded.
+        while (true) {
+            if (applyPendingModelSwap()) {
+                #if ENABLE_ADAPTIVE_SCHEDULING
+                    taskENTER_CRITICAL(&pipeline.schedulerLock);
+                    pipeline.scheduler.reset();
+                    taskEXIT_CRITICAL(&pipeline.schedulerLock);
+                #endif
+            }
+
+            PreparedInput* prepared;
+            while ((prepared = pipeline.inputs.acquire()) != nullptr) {
+                PipelineSample sample = prepared->sample;
+                const uint32_t seq = prepared->seq;
+                sample.invokeStartUs = esp_timer_get_time();
+                tensorFlowTimer.checkpoint();
+                logFirstPixels(TF_TAG, "prepared input", prepared->pixels, 10);
+                const bool encoded = setInput(prepared->pixels, TF_IMAGE_INPUT_SIZE, TF_IMAGE_INPUT_SIZE);
+                // The input is in the tensor: hand the slot back so the next frame is prepared during Invoke().
+                pipeline.inputs.release();
+                TaskHandle_t preprocessTask = pipeline.preprocessTask.load(std::memory_order_acquire);
+                if (preprocessTask) {
+                    xTaskNotifyGive(preprocessTask);
+                }
+                if (!encoded) {
+                    continue;
+                }
+
+                float confidence = 0.0f;
+                bool person_present = runInference(&confidence);
+                sample.doneUs = esp_timer_get_time();
+                pipeline.lastInvokeUs.store((int32_t)(sample.doneUs - sample.invokeStartUs), std::memory_order_relaxed);
+                meter.record(sample);
+                ESP_LOGW(TF_TAG, "Person detected? %s | frame %lu, %.0f ms after capture",
+                         person_present ? "YES" : "NO",
+                         (unsigned long)seq,
+                         (sample.doneUs - sample.captureUs) / 1000.0f);
+                #if ENABLE_ADAPTIVE_SCHEDULING
+                    person_present = scheduleDetection(pipeline.scheduler, confidence, &pipeline.schedulerLock);
+                #endif
+                showDetection(person_present, &lastPersonPresent);
+                tensorFlowTimer.logCheckpoint(TF_TAG, "tf inference done");
+            }
+
+            const int64_t nowUs = esp_timer_get_time();
+            if (nowUs - statsStartUs >= 2000000) {
+                logInvokeStats(*this);
+                logPipelineStats(meter, nowUs);
+                statsStartUs = nowUs;
+            }
+            ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+        }
+    #endif
+}
+
 void TfLiteWrapper::inference_task(void *arg)
 {
-    #if ENABLE_INFERENCE
+    #if INFERENCE_PIPELINED
+        runInvokeStage();
+    #elif ENABLE_INFERENCE
         ESP_LOGI(TF_TAG, "Inference task started");
 
-        uint8_t* grayscaleWorkspace = (uint8_t*)heap_caps_malloc(kAcquiredFrameMaxPixels, MALLOC_CAP_8BIT);
-        uint8_t* gray96Buffer = (uint8_t*)heap_caps_malloc(TF_IMAGE_INPUT_SIZE * TF_IMAGE_INPUT_SIZE, MALLOC_CAP_8BIT);
-        if (!grayscaleWorkspace || !gray96Buffer) {
+        inference_task_handle.store(xTaskGetCurrentTaskHandle(), std::memory_order_release);
+
+        // Quantized models take the preprocessed pixels straight into their input tensor; only float
+        // inputs (or a tensor not shaped for TF_IMAGE_INPUT_SIZE) still go through gray96Buffer.
+        ModelInput modelInput;
+        bool directInput = takesDirectInput(*this, &modelInput);
+
+        size_t grayscaleWorkspaceLen = kAcquiredFrameMaxPixels;
+        uint8_t* grayscaleWorkspace = (uint8_t*)bufferPlacement.allocate(PlacedBuffer::InferenceWorkspace, grayscaleWorkspaceLen);
+        uint8_t* gray96Buffer = directInput
+            ? nullptr
+            : (uint8_t*)bufferPlacement.allocate(PlacedBuffer::InferenceGray96, TF_IMAGE_INPUT_SIZE * TF_IMAGE_INPUT_SIZE);
+        if (!grayscaleWorkspace || (!directInput && !gray96Buffer)) {
             ESP_LOGE(TF_TAG, "Failed to allocate inference workspace");
             vTaskDelete(NULL);
             return;
         }
 
-        uint32_t lastSeenSeq = 0;
+        bool lastPersonPresent = false;
+        int64_t invokeStatsStartUs = esp_timer_get_time();
+
+        #if ENABLE_ADAPTIVE_SCHEDULING
+            DetectionScheduler detectionScheduler(makeDetectionSchedulerConfig());
+            int64_t schedulerStatsStartUs = esp_timer_get_time();
+        #endif
+
+        #if INFERENCE_INPUT_MODE == INFERENCE_INPUT_TILED
+            TileSaliencyMap tileSaliency;
+            uint8_t* tileSaliencyBuffer = nullptr;
+            size_t tileSaliencyBufferLen = 0;
+        #endif
+
+        #if ENABLE_MOTION_GATE
+            MotionGate motionGate(makeMotionGateConfig());
+            JpegDecoderContext jpegDecoder(PlacedBuffer::JpegDecoder);
+            uint8_t* motionBuffer = nullptr;
+            size_t motionBufferLen = 0;
+            int64_t motionStatsStartUs = esp_timer_get_time();
+        #endif
 
         while (true) {
             ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
 
-            FrameSnapshot snapshot = {};
-            if (!inferenceMailboxManager.snapshot(&snapshot) || snapshot.seq == lastSeenSeq) {
+            if (applyPendingModelSwap()) {
+                // New interpreter, new input tensor; a float model may now need gray96Buffer.
+                directInput = takesDirectInput(*this, &modelInput);
+                if (!directInput && !gray96Buffer) {
+                    gray96Buffer = (uint8_t*)bufferPlacement.allocate(PlacedBuffer::InferenceGray96, TF_IMAGE_INPUT_SIZE * TF_IMAGE_INPUT_SIZE);
+                }
+                #if ENABLE_ADAPTIVE_SCHEDULING
+                    detectionScheduler.reset();
+                #endif
+            }
+            if (!directInput && !gray96Buffer) {
+                continue;
+            }
+
+            // Only returns unread frames; the producer cannot touch this slot until release().
+            const FrameSnapshot* snapshot = inferenceMailboxManager.acquire();
+            if (!snapshot) {
                 continue;
             }
 
+            const int64_t statsNowUs = esp_timer_get_time();
+            if (statsNowUs - invokeStatsStartUs >= 2000000) {
+                logInvokeStats(*this);
+                invokeStatsStartUs = statsNowUs;
+            }
+
+            [[maybe_unused]] bool motion = false;
+            #if ENABLE_MOTION_GATE
+                const int64_t nowUs = esp_timer_get_time();
+                if (nowUs - motionStatsStartUs >= 2000000) {
+                    logMotionGateStats(motionGate, nowUs - motionStatsStartUs);
+                    logJpegDecoderStats(jpegDecoder);
+                    motionStatsStartUs = nowUs;
+                }
+                // Raw formats are not gated: there is no cheap compressed-domain thumbnail for them.
+                if (snapshot->format == PIXFORMAT_JPEG &&
+                    !motionGateAdmits(motionGate, jpegDecoder, *snapshot, &motionBuffer, &motionBufferLen, &motion)) {
+                    inferenceMailboxManager.release();
+                    continue;
+                }
+            #endif
+
+            #if ENABLE_ADAPTIVE_SCHEDULING
+                const int64_t scheduleNowUs = esp_timer_get_time();
+                if (scheduleNowUs - schedulerStatsStartUs >= 2000000) {
+                    logDetectionSchedulerStats(detectionScheduler, scheduleNowUs);
+                    schedulerStatsStartUs = scheduleNowUs;
+                }
+                // A settled result: skip this frame without touching the decoder or the model.
+                if (!detectionScheduler.shouldRun(scheduleNowUs, motion)) {
+                    inferenceMailboxManager.release();
+                    continue;
+                }
+            #endif
+
+            #if ENABLE_MOTION_GATE
+                const int64_t inferenceStartUs = esp_timer_get_time();
+            #endif
+
             tensorFlowTimer.checkpoint();
             jpegTimer.checkpoint();
-            const bool prepared = buildGray96Frame(snapshot,
+            // The camera may have been reconfigured to a larger frame size: grow the scratch frame with it.
+            bufferPlacement.ensureCapacity(PlacedBuffer::InferenceWorkspace,
+                                           &grayscaleWorkspace,
+                                           &grayscaleWorkspaceLen,
+                                           gray96WorkspaceBytes(snapshot->width, snapshot->height));
+
+            #if INFERENCE_INPUT_MODE == INFERENCE_INPUT_TILED
+                uint16_t frameWidth = 0;
+                uint16_t frameHeight = 0;
+                const bool prepared = buildGrayTileFrame(*snapshot,
+                                                         grayscaleWorkspace,
+                                                         grayscaleWorkspaceLen,
+                                                         TILED_INFERENCE_MAX_SIDE,
+                                                         TF_IMAGE_INPUT_SIZE,
+                                                         &frameWidth,
+                                                         &frameHeight);
+                // The luma frame is ours: give the camera buffer back before the Invoke() calls.
+                inferenceMailboxManager.release();
+                jpegTimer.logCheckpoint(JPEG_TAG, "tile frame prepared");
+                if (!prepared) {
+                    continue;
+                }
+                float confidence = 0.0f;
+                bool person_present = detectInTiles(*this,
+                                                    tileSaliency,
+                                                    &tileSaliencyBuffer,
+                                                    &tileSaliencyBufferLen,
                                                     grayscaleWorkspace,
-                                                    kAcquiredFrameMaxPixels,
+                                                    frameWidth,
+                                                    frameHeight,
+                                                    directInput ? &modelInput : nullptr,
                                                     gray96Buffer,
-                                                    TF_IMAGE_INPUT_SIZE);
+                                                    &confidence);
+                #if ENABLE_ADAPTIVE_SCHEDULING
+                    person_present = scheduleDetection(detectionScheduler, confidence);
+                #endif
+                showDetection(person_present, &lastPersonPresent);
+            #else
+            uint8_t* inputPixels = directInput ? modelInput.pixels : gray96Buffer;
+            const bool prepared = buildGray96Frame(*snapshot,
+                                                    grayscaleWorkspace,
+                                                    grayscaleWorkspaceLen,
+                                                    inputPixels,
+                                                    TF_IMAGE_INPUT_SIZE,
+                                                    directInput ? modelInput.lut : nullptr);
+            // The input pixels are ours: give the camera buffer back before the long Invoke().
+            inferenceMailboxManager.release();
             jpegTimer.logCheckpoint(JPEG_TAG, "inference input prepared");
             if (!prepared) {
-                lastSeenSeq = snapshot.seq;
                 continue;
             }
 
             TfLiteTensor* input = getInputTensor();
             if (input && input->dims && input->dims->size >= 4) {
-                logFirstPixels(TF_TAG, "gray96Buffer", gray96Buffer, 10);
-                bool person_present = runInference(gray96Buffer, TF_IMAGE_INPUT_SIZE, TF_IMAGE_INPUT_SIZE);
+                logFirstPixels(TF_TAG, directInput ? "input tensor" : "gray96Buffer", inputPixels, 10);
+                float confidence = 0.0f;
+                bool person_present = directInput
+                    ? runInference(&confidence)
+                    : runInference(gray96Buffer, TF_IMAGE_INPUT_SIZE, TF_IMAGE_INPUT_SIZE, &confidence);
                 ESP_LOGW(TF_TAG, "Person detected? %s", person_present ? "YES" : "NO");
-                if (person_present) {
-                    redLed.setLedGpio2(0);
-                    rgb.turnBlueLedOn();
-                } else {
-                    redLed.setLedGpio2(1);
-                    rgb.turnRedLedOn();
-                }
+                #if ENABLE_ADAPTIVE_SCHEDULING
+                    person_present = scheduleDetection(detectionScheduler, confidence);
+                #endif
+                showDetection(person_present, &lastPersonPresent);
             } else {
                 ESP_LOGE(TF_TAG, "Input tensor is null or malformed");
             }
+            #endif
 
             tensorFlowTimer.logCheckpoint(TF_TAG, "tf inference done");
-            lastSeenSeq = snapshot.seq;
+            #if ENABLE_MOTION_GATE
+                motionGate.recordInferenceCost(esp_timer_get_time() - inferenceStartUs);
+            #endif
         }
     #endif
 }
@@ -1,5 +1,6 @@
 
 #pragma once
+#include <atomic>
 #include <vector>
 #include <cstdint>
 #include "debug.h"
@@ -7,12 +8,33 @@
 #include "tensorflow/lite/micro/micro_mutable_op_resolver.h"
 #include "tensorflow/lite/schema/schema_generated.h"
 #include "esp_log.h"
+#include "esp_timer.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+#include "freertos/task.h"
+#include "tf-lite/op-profiler.h"
 //#include "tflite-person-detect/person_detect_model_data.h"
 #include <cstdint>
 #include "tensorflow/lite/micro/micro_mutable_op_resolver.h"
 
 #define DETECTION_THRESHOLD 0.6f
 
+// The interpreter's input tensor as a preprocessing target: buildGray96Frame() writes lut[luma] straight
+// into pixels, so no separate image buffer or copy pass is needed before Invoke().
+struct ModelInput {
+    uint8_t* pixels = nullptr;      // input tensor data, one byte per pixel (uint8, or int8 bit patterns)
+    int width = 0;
+    int height = 0;
+    const uint8_t* lut = nullptr;   // luma -> stored byte with the tensor's scale and zero point
+};
+
+// Wall time of Interpreter::Invoke() since start or the last reset.
+struct InvokeStats {
+    uint32_t count = 0;
+    int64_t totalUs = 0;
+    int32_t maxUs = 0;
+};
+
 class TfLiteWrapper {
 public:
     TfLiteWrapper() = default;
@@ -24,20 +46,77 @@ public:
     TfLiteWrapper(TfLiteWrapper&&) = delete;
     TfLiteWrapper& operator=(TfLiteWrapper&&) = delete;
 
+    // Without arena_buffer, the arena comes from the TensorArena placement (and TensorArenaPersistent with
+    // TENSOR_ARENA_SPLIT); with ENABLE_ARENA_MEASUREMENT, arena_size only bounds the recording pass and the
+    // arenas are allocated at the measured sizes. A caller's arena_buffer is always used as a single arena.
     bool init(const unsigned char* model_data, size_t arena_size, uint8_t* arena_buffer = nullptr);
+    // Rebuilds the interpreter on another flatbuffer, used in place (e.g. mapped from the model partition),
+    // so it must stay valid while it is the current model. Once inference_task runs, the rebuild happens
+    // there between frames and this waits up to MODEL_SWAP_TIMEOUT_MS. On failure the previous model is
+    // rebuilt and false returned.
+    bool swapModel(const unsigned char* model_data);
+    const unsigned char* getModelData() const { return model_data; }
 
-    bool runInference(const uint8_t* image_data, int width, int height);
+    // False unless the input is a [1, h, w, 1] uint8 or int8 tensor (float inputs take the copy path).
+    bool getModelInput(ModelInput* input);
+    // Invoke() on an input already written through getModelInput(). True when the person confidence
+    // (also stored in confidence when given) is above DETECTION_THRESHOLD.
+    bool runInference(float* confidence = nullptr);
+    // Encodes image_data into the input tensor (any supported type), then runInference().
+    bool runInference(const uint8_t* image_data, int width, int height, float* confidence = nullptr);
+    // Just the encode half: image_data may be reused as soon as this returns.
+    bool setInput(const uint8_t* image_data, int width, int height);
     uint8_t* getOutputDataUint8() const;
     TfLiteTensor* getInputTensor();
+    // Per-operator timings since start or the last reset (ENABLE_OP_PROFILER). Safe from other tasks.
+    void getOpProfile(OpProfile* profile, bool reset = false);
+    // Invoke() latency since start or the last reset, and where the arenas it ran on live.
+    void getInvokeStats(InvokeStats* stats, bool reset = false);
+    const char* arenaPlacement() const { return arena_placement; }
 
+    // Runs the whole inference loop, or with INFERENCE_PIPELINED only the Invoke() stage, fed by
+    // inference_preprocess_task on the other core.
     void inference_task(void *arg);
+    // INFERENCE_PIPELINED: consumes inferenceMailbox and prepares inputs for inference_task.
+    void inference_preprocess_task(void *arg);
 
 private:
+    bool inputShapeMatches(const TfLiteTensor* input, int width, int height) const;
+    struct ArenaUsage {
+        size_t used = 0;
+        size_t persistent = 0;
+        size_t nonPersistent = 0;
+    };
+    bool measureArenaUsage(size_t probeSize, ArenaUsage* usage);
+    bool prepareArena();
+    bool buildInterpreter(const unsigned char* model_data);
+    bool rebuildInterpreter(const unsigned char* model_data);
+    bool applyPendingModelSwap();
+    void runInvokeStage();
+
     const tflite::Model* model = nullptr;
+    const unsigned char* model_data = nullptr;
     tflite::MicroInterpreter* interpreter = nullptr;
     tflite::MicroMutableOpResolver<16> resolver; // max 16 ops
     uint8_t* tensor_arena = nullptr;
     size_t arena_size = 0;
+    size_t arena_probe_size = 0;                // ARENA_SIZE passed to init()
+    bool owns_arena = true;
+    uint8_t* persistent_arena = nullptr;        // TENSOR_ARENA_SPLIT only; tensor_arena is then non-persistent
+    size_t persistent_arena_size = 0;
+    tflite::MicroAllocator* arena_allocator = nullptr;
+    char arena_placement[64] = "none";
+    uint8_t input_lut[256];
+    bool input_lut_ready = false;
+    OpProfiler op_profiler{ esp_timer_get_time };
+    InvokeStats invoke_stats;
+    portMUX_TYPE op_profile_lock = portMUX_INITIALIZER_UNLOCKED;     // op_profiler and invoke_stats
+
+    // Model hot swap: swapModel() posts pending_model, inference_task rebuilds and gives model_swap_done.
+    std::atomic<const unsigned char*> pending_model{nullptr};
+    std::atomic<bool> model_swap_ok{false};
+    std::atomic<TaskHandle_t> inference_task_handle{nullptr};
+    SemaphoreHandle_t model_swap_done = nullptr;
 
     // Storage for the interpreter — aligned, owned by this object
     alignas(alignof(tflite::MicroInterpreter)) uint8_t interpreter_storage[sizeof(tflite::MicroInterpreter)];